@@ -0,0 +1,100 @@
+//======================================================================
+// ActiveBands.cpp
+// Author: James McCormick
+// Description:
+//	Solves generated flowsheets on finer and finer size grids and
+//	reports how much of each stream is in its active band, with the
+//	solve time.  The screen decks in the generated flowsheets only carry
+//	the sizes between their cut points, and streams with no solids have
+//	an empty band, so most of the fractions are zero and are skipped.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: ActiveBands [solves]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+
+//-----------------------------------------------------------------------
+// BandCoverage
+// Description
+//	The mean over every port of the flowsheet of its active band width
+//	as a fraction of the grid, and the same over the ports that carry
+//	solids.
+//-----------------------------------------------------------------------
+double BandCoverage(C_Flowsheet& fs, double& carrying)
+{
+	std::vector<BlockID> ids;
+	fs.GetBlockIDs(ids);
+
+	double covered = 0.0;
+	unsigned ports = 0, nonEmpty = 0;
+	for(size_t b = 0; b < ids.size(); b++)
+	{
+		C_BlockPorts& bp = fs.GetBlock(ids[b])->GetPorts();
+		for(unsigned short p = 0; p < bp.GetNumPorts(); p++)
+		{
+			const C_FlowData* fd = bp.GetFlowData(p);
+			unsigned short first, end;
+			fd->GetActiveBand(first, end);
+			if(first < end)
+			{
+				covered += (double)(end - first) / fd->GetNumFractions();
+				nonEmpty++;
+			}
+			ports++;
+		}
+	}
+	carrying = nonEmpty ? covered / nonEmpty : 0.0;
+	return ports ? covered / ports : 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned solves = (argc > 1) ? (unsigned)atoi(argv[1]) : 20;
+	const unsigned short counts[] = { 25, 50, 100, 200 };
+
+	std::cout << "fractions  band %  carrying band %  solve ms\n";
+	for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		S_GeneratorParams params;
+		params.uiNumBlocks = 500;
+		params.fRecycleRatio = 0.1f;
+		params.usNumFractions = counts[c];
+
+		C_Flowsheet fs;
+		fs.SetMetric(false);
+		fs.SetDelta(0.01f);
+		fs.SetMaxIterations(500);
+		fs.SetRoundToWater(2);
+		fs.SetUpdateSolids(true);
+		fs.SetUpdateWater(true);
+
+		C_FlowsheetGenerator generator(params);
+		generator.Generate(fs);
+		fs.SolveFlowSheet();
+
+		double seconds = 0.0;
+		for(unsigned i = 0; i < solves; i++)
+		{
+			fs.ZeroFlows();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			fs.SolveFlowSheet();
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		double carrying;
+		double all = BandCoverage(fs, carrying);
+		std::cout << std::setw(9) << counts[c] << std::fixed
+			<< std::setw(8) << std::setprecision(1) << 100.0 * all
+			<< std::setw(17) << 100.0 * carrying
+			<< std::setw(10) << std::setprecision(3) << seconds * 1e3 / solves << "\n";
+	}
+
+	return 0;
+}
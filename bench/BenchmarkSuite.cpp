@@ -0,0 +1,256 @@
+//======================================================================
+// BenchmarkSuite.cpp
+// Author: James McCormick
+// Description:
+//	Solves a fixed set of generated flowsheets and reports solves per
+//	second, iterations, allocations and memory.  The JSON output keeps
+//	the same keys in the same order from release to release so results
+//	can be diffed; bump SCHEMA_VERSION if that ever has to change.
+//	Allocations are only counted when built with FS_PROFILING.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: BenchmarkSuite [-solves N] [-threads T] [-json file] [-only name]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+static const int SCHEMA_VERSION = 1;
+
+struct S_Scenario
+{
+	const char* name;
+	S_GeneratorParams params;
+};
+
+struct S_Result
+{
+	std::string name;
+	unsigned uiBlocks;
+	unsigned uiLoops;
+	unsigned short usFractions;
+	unsigned uiSolves;
+	double dSolvesPerSec;
+	double dMeanIterations;
+	unsigned uiConverged;
+	double dAllocationsPerSolve;
+	long lPeakRSSKB;
+	long lRSSGrowthKB;
+};
+
+//-----------------------------------------------------------------------
+// PeakRSS
+// Description
+//	The peak resident set size of the process in kilobytes.
+//-----------------------------------------------------------------------
+long PeakRSS()
+{
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return usage.ru_maxrss;
+}
+
+//-----------------------------------------------------------------------
+// MakeScenarios
+// Description
+//	The fixed benchmark set.  Do not change the existing entries, add new
+//	ones at the end, or results stop being comparable between releases.
+//-----------------------------------------------------------------------
+std::vector<S_Scenario> MakeScenarios()
+{
+	std::vector<S_Scenario> list;
+	S_Scenario s;
+
+	s.name = "small_open";
+	s.params = S_GeneratorParams();
+	s.params.uiNumBlocks = 50;
+	list.push_back(s);
+
+	s.name = "medium_recycle";
+	s.params = S_GeneratorParams();
+	s.params.uiNumBlocks = 500;
+	s.params.uiNumFeeds = 2;
+	s.params.fRecycleRatio = 0.1f;
+	s.params.uiLoopDepth = 2;
+	s.params.uiFanIn = 2;
+	list.push_back(s);
+
+	s.name = "large_nested";
+	s.params = S_GeneratorParams();
+	s.params.uiNumBlocks = 5000;
+	s.params.uiNumFeeds = 8;
+	s.params.fRecycleRatio = 0.05f;
+	s.params.uiLoopDepth = 3;
+	s.params.uiFanIn = 3;
+	s.params.usNumFractions = 32;
+	list.push_back(s);
+
+	s.name = "fine_grid";
+	s.params = S_GeneratorParams();
+	s.params.uiNumBlocks = 500;
+	s.params.fRecycleRatio = 0.05f;
+	s.params.usNumFractions = 200;
+	list.push_back(s);
+
+	s.name = "sump_heavy_fanin";
+	s.params = S_GeneratorParams();
+	s.params.uiNumBlocks = 1000;
+	s.params.uiNumFeeds = 4;
+	s.params.fSumpWeight = 4.0f;
+	s.params.uiFanIn = 4;
+	list.push_back(s);
+
+	return list;
+}
+
+//-----------------------------------------------------------------------
+// RunScenario
+// Description
+//	Generates the flowsheet, solves it once to warm up, then times the
+//	requested number of cold solves.
+//-----------------------------------------------------------------------
+S_Result RunScenario(const S_Scenario& scenario, unsigned solves, unsigned threads)
+{
+	long rssBefore = PeakRSS();
+
+	C_Flowsheet fs;
+	fs.SetMetric(false);
+	fs.SetDelta(0.01f);
+	fs.SetMaxIterations(500);
+	fs.SetRoundToWater(2);
+	fs.SetUpdateSolids(true);
+	fs.SetUpdateWater(true);
+	fs.SetParallel(threads > 0);
+	fs.SetNumThreads(threads);
+
+	C_FlowsheetGenerator generator(scenario.params);
+	generator.Generate(fs);
+
+	S_Result r;
+	r.name = scenario.name;
+	r.uiBlocks = generator.GetNumBlocks() + scenario.params.uiNumFeeds;
+	r.uiLoops = generator.GetNumLoops();
+	r.usFractions = scenario.params.usNumFractions;
+	r.uiSolves = solves;
+	r.uiConverged = 0;
+
+	fs.SolveFlowSheet();
+
+	unsigned long totalIterations = 0;
+	unsigned long totalAllocations = 0;
+	double seconds = 0.0;
+
+	for(unsigned i = 0; i < solves; i++)
+	{
+		fs.ZeroFlows();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool converged = fs.SolveFlowSheet();
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		totalIterations += fs.GetNumIterations();
+		totalAllocations += fs.GetSolverStats().ulAllocations;
+		if(converged)
+			r.uiConverged++;
+	}
+
+	r.dSolvesPerSec = (seconds > 0.0) ? solves / seconds : 0.0;
+	r.dMeanIterations = solves ? (double)totalIterations / solves : 0.0;
+	r.dAllocationsPerSolve = solves ? (double)totalAllocations / solves : 0.0;
+	r.lPeakRSSKB = PeakRSS();
+	r.lRSSGrowthKB = r.lPeakRSSKB - rssBefore;
+
+	return r;
+}
+
+//-----------------------------------------------------------------------
+// WriteJSON
+// Description
+//	Writes the results with a fixed key order and number format.
+//-----------------------------------------------------------------------
+void WriteJSON(std::ostream& out, const std::vector<S_Result>& results, unsigned threads)
+{
+	out << std::fixed;
+	out << "{\n";
+	out << "  \"schema\": " << SCHEMA_VERSION << ",\n";
+	out << "  \"profiling\": " << (C_SolverStats::IsEnabled() ? "true" : "false") << ",\n";
+	out << "  \"threads\": " << threads << ",\n";
+	out << "  \"results\": [\n";
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const S_Result& r = results[i];
+		out << "    {"
+			<< "\"name\": \"" << r.name << "\", "
+			<< "\"blocks\": " << r.uiBlocks << ", "
+			<< "\"loops\": " << r.uiLoops << ", "
+			<< "\"fractions\": " << r.usFractions << ", "
+			<< "\"solves\": " << r.uiSolves << ", "
+			<< "\"solves_per_sec\": " << std::setprecision(3) << r.dSolvesPerSec << ", "
+			<< "\"mean_iterations\": " << std::setprecision(2) << r.dMeanIterations << ", "
+			<< "\"converged\": " << r.uiConverged << ", "
+			<< "\"allocations_per_solve\": " << std::setprecision(1) << r.dAllocationsPerSolve << ", "
+			<< "\"peak_rss_kb\": " << r.lPeakRSSKB << ", "
+			<< "\"rss_growth_kb\": " << r.lRSSGrowthKB
+			<< "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned solves = 20;
+	unsigned threads = 0;
+	const char* jsonFile = 0;
+	const char* only = 0;
+
+	for(int i = 1; i + 1 < argc; i += 2)
+	{
+		if(strcmp(argv[i], "-solves") == 0)
+			solves = (unsigned)atoi(argv[i + 1]);
+		else if(strcmp(argv[i], "-threads") == 0)
+			threads = (unsigned)atoi(argv[i + 1]);
+		else if(strcmp(argv[i], "-json") == 0)
+			jsonFile = argv[i + 1];
+		else if(strcmp(argv[i], "-only") == 0)
+			only = argv[i + 1];
+	}
+
+	std::vector<S_Scenario> scenarios = MakeScenarios();
+	std::vector<S_Result> results;
+
+	for(size_t i = 0; i < scenarios.size(); i++)
+	{
+		if(only && strcmp(only, scenarios[i].name) != 0)
+			continue;
+
+		results.push_back(RunScenario(scenarios[i], solves, threads));
+
+		const S_Result& r = results.back();
+		std::cerr << std::left << std::setw(18) << r.name << std::right
+			<< " blocks " << std::setw(6) << r.uiBlocks
+			<< "  solves/s " << std::setw(10) << std::fixed << std::setprecision(1) << r.dSolvesPerSec
+			<< "  iter " << std::setw(6) << std::setprecision(1) << r.dMeanIterations
+			<< "  converged " << r.uiConverged << "/" << r.uiSolves << "\n";
+	}
+
+	if(jsonFile)
+	{
+		std::ofstream file(jsonFile);
+		WriteJSON(file, results, threads);
+	}
+	else
+		WriteJSON(std::cout, results, threads);
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+//======================================================================
+// ParallelScaling.cpp
+// Author: James McCormick
+// Description:
+//	Times SolveFlowSheet on a wide synthetic flowsheet for a range of
+//	thread counts and checks that every run gives the same answer as
+//	the sequential sweep.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: ParallelScaling [sizeDistFile] [width] [solves]
+//======================================================================
+
+#include "C_FeedBlock.h"
+#include "C_DeslimeScreenSD.h"
+#include "C_DeslimeScreenDD.h"
+#include "C_SumpPump.h"
+#include "C_Flowsheet.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+
+//-----------------------------------------------------------------------
+// BuildWideFlowsheet
+// Description
+//	A feed and a double deck deslime screen that feeds width branches of
+//	sump -> single deck screen -> sump.  Every branch depends only on the
+//	first screen so each level is width blocks wide.
+//
+// Arguments:	fs - the flowsheet to build into, width - number of branches
+// Returns:		None.
+//-----------------------------------------------------------------------
+void BuildWideFlowsheet(C_Flowsheet& fs, unsigned width)
+{
+	BlockID feed = fs.CreateBlock(PROCID_FEED);
+	BlockID deslime = fs.CreateBlock(PROCID_DESLIME_DOUBLEDECK);
+	fs.MakeLink(feed, 0, deslime);
+
+	fs.PushParameters( new C_FeedBlockParams(feed, PROCID_FEED, 700.0f, 0.7f) );
+	fs.PushParameters( new C_DeslimeScreenDDParams(deslime, PROCID_DESLIME_DOUBLEDECK, 0.10f, 0.14f, 25.4f, 6.35f, 300.0f) );
+
+	for(unsigned i = 0; i < width; i++)
+	{
+		BlockID sump = fs.CreateBlock(PROCID_SUMPPUMP);
+		BlockID screen = fs.CreateBlock(PROCID_DESLIME_SINGLEDECK);
+		BlockID sump2 = fs.CreateBlock(PROCID_SUMPPUMP);
+
+		fs.MakeLink(deslime, (PortNo)(1 + i % 3), sump);
+		fs.MakeLink(sump, 0, screen);
+		fs.MakeLink(screen, 1, sump2);
+
+		fs.PushParameters( new C_SumpPumpParams(sump, PROCID_SUMPPUMP, 100.0f + i % 7) );
+		fs.PushParameters( new C_DeslimeScreenSDParams(screen, PROCID_DESLIME_SINGLEDECK, 0.12f, 0.495f, 50.0f) );
+		fs.PushParameters( new C_SumpPumpParams(sump2, PROCID_SUMPPUMP, 50.0f) );
+	}
+}
+
+//-----------------------------------------------------------------------
+// Checksum
+// Description
+//	Sums the blocks' ports so runs can be compared bit for bit.
+//-----------------------------------------------------------------------
+double Checksum(C_Flowsheet& fs, BlockID first, BlockID last)
+{
+	double sum = 0.0;
+	for(BlockID id = first; id <= last; id++)
+	{
+		C_BlockPorts& ports = fs.GetBlock(id)->GetPorts();
+		for(unsigned short p = 0; p < ports.GetNumPorts(); p++)
+			sum += ports.GetFlowData(p)->d_SolidRate + ports.GetFlowData(p)->d_FluidRate;
+	}
+	return sum;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* sizeFile = (argc > 1) ? argv[1] : "Test.txt";
+	unsigned width = (argc > 2) ? (unsigned)atoi(argv[2]) : 2000;
+	unsigned solves = (argc > 3) ? (unsigned)atoi(argv[3]) : 20;
+
+	const unsigned threadCounts[] = { 0, 1, 2, 4, 8 };
+	double baseTime = 0.0;
+	double sequentialSum = 0.0;
+
+	std::cout << "width " << width << ", blocks " << (3 * width + 2) << ", solves " << solves << "\n";
+	std::cout << "threads\tms/solve\tspeedup\tchecksum\n";
+
+	for(unsigned t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++)
+	{
+		C_Flowsheet fs;
+		fs.SetMetric(false);
+		fs.SetDelta(0.01f);
+		fs.SetMaxIterations(100);
+		fs.SetRoundToWater(2);
+		fs.SetUpdateSolids(true);
+		fs.SetUpdateWater(true);
+
+		if(!fs.LoadSizeDistribution(sizeFile))
+		{
+			std::cout << "Failed to load size distribution!!\n";
+			return 1;
+		}
+
+		BuildWideFlowsheet(fs, width);
+
+		// 0 is the original sequential sweep
+		fs.SetParallel(threadCounts[t] != 0);
+		fs.SetNumThreads(threadCounts[t]);
+
+		// Warm up and compile the schedule
+		fs.SolveFlowSheet();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(unsigned s = 0; s < solves; s++)
+			fs.SolveFlowSheet();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / solves;
+
+		if(t == 0)
+			baseTime = ms;
+
+		double sum = Checksum(fs, 100, 100 + 3 * width + 1);
+		if(t == 0)
+			sequentialSum = sum;
+
+		std::cout << (t == 0 ? "seq" : "") << threadCounts[t] << "\t" << ms << "\t\t" << (baseTime / ms) << "\t" << sum << "\n";
+
+		// A speedup on a different answer means nothing
+		if(sum != sequentialSum)
+		{
+			std::cout << "MISMATCH with the sequential sweep!\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
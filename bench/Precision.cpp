@@ -0,0 +1,96 @@
+//======================================================================
+// Precision.cpp
+// Author: James McCormick
+// Description:
+//	Solves generated plants with recycles to a tight delta with each
+//	precision option - sums in the stored type or in double, with and
+//	without a relative delta - and reports the iterations to converge
+//	and the throughput.  Build once as is and once with
+//	-DFS_DOUBLE_PRECISION to compare against the flows stored in double.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: Precision [solves] [delta] [relDelta]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+
+struct S_Mode
+{
+	const char* name;
+	bool bWideSums;
+	bool bRelative;
+};
+
+int main(int argc, char* argv[])
+{
+	unsigned solves = (argc > 1) ? (unsigned)atoi(argv[1]) : 5;
+	float delta = (argc > 2) ? (float)atof(argv[2]) : 0.0001f;
+	float relDelta = (argc > 3) ? (float)atof(argv[3]) : 1e-6f;
+
+	const S_Mode modes[] = {
+		{ "stored sums", false, false },
+		{ "double sums", true, false },
+		{ "stored sums + rel", false, true },
+		{ "double sums + rel", true, true },
+	};
+	const unsigned sizes[] = { 500, 2000 };
+
+	std::cout << "flows stored in " << ((sizeof(FlowValue) == sizeof(double)) ? "double" : "float")
+		<< ", delta " << delta << ", relative delta " << relDelta << "\n";
+	std::cout << "blocks  mode                 converged  iterations  solve ms  block updates/s\n";
+
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+		{
+			S_GeneratorParams params;
+			params.uiNumBlocks = sizes[s];
+			params.uiNumFeeds = 4;
+			params.fRecycleRatio = 0.3f;
+			params.uiLoopDepth = 2;
+			params.uiFanIn = 3;
+			params.uiSeed = 3;
+
+			C_Flowsheet fs;
+			fs.SetMetric(false);
+			fs.SetDelta(delta);
+			fs.SetRelativeDelta(modes[m].bRelative ? relDelta : 0.0f);
+			fs.SetWideSums(modes[m].bWideSums);
+			fs.SetMaxIterations(500);
+			fs.SetRoundToWater(2);
+			fs.SetUpdateSolids(true);
+			fs.SetUpdateWater(true);
+			fs.SetMemoize(false);
+
+			C_FlowsheetGenerator generator(params);
+			generator.Generate(fs);
+
+			bool converged = true;
+			unsigned iterations = 0;
+			unsigned long updates = 0;
+			double seconds = 0.0;
+			for(unsigned i = 0; i < solves; i++)
+			{
+				fs.ZeroFlows();
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				converged = fs.SolveFlowSheet() && converged;
+				seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				iterations = fs.GetNumIterations();
+				updates += fs.GetNumBlockUpdates();
+			}
+
+			std::cout << std::setw(6) << sizes[s] << "  " << std::left << std::setw(21) << modes[m].name << std::right
+				<< std::setw(9) << (converged ? "yes" : "no") << std::setw(12) << iterations
+				<< std::fixed << std::setprecision(2) << std::setw(10) << seconds * 1e3 / solves
+				<< std::setprecision(0) << std::setw(17) << updates / seconds << "\n";
+			std::cout.unsetf(std::ios::fixed);
+		}
+	}
+
+	return 0;
+}
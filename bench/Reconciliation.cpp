@@ -0,0 +1,150 @@
+//======================================================================
+// Reconciliation.cpp
+// Author: James McCormick
+// Description:
+//	Fits generated plants to synthetic plant data.  Each feed's sizing
+//	is moved off the size distribution and the plant solved for the
+//	"true" flows, then every stream carrying solids has its size
+//	analysis and tonnage measured with 2% noise.  The fit starts from
+//	the feeds on the size distribution and adjusts the solids in every
+//	size fraction of every feed.  Reports the size of the problem, the
+//	fit time, chi-square over its degrees of freedom (near 1 for a good
+//	fit) and the worst error in the fitted feed fractions.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: Reconciliation [noise]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+#include "C_Reconciliation.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+
+// The state of the noise generator
+static unsigned long long s_ullRandom = 7;
+
+static double Uniform()
+{
+	s_ullRandom = s_ullRandom * 6364136223846793005ULL + 1442695040888963407ULL;
+	return ((s_ullRandom >> 11) + 0.5) / 9007199254740992.0;
+}
+
+// A standard normal number by Box-Muller
+static double Gaussian()
+{
+	return sqrt(-2.0 * log(Uniform())) * cos(6.283185307179586 * Uniform());
+}
+
+int main(int argc, char* argv[])
+{
+	float noise = (argc > 1) ? (float)atof(argv[1]) : 0.02f;
+
+	const unsigned blocks[] = { 500, 2000, 2000 };
+	const unsigned short fractions[] = { 25, 50, 100 };
+	const unsigned feeds[] = { 4, 8, 8 };
+
+	std::cout << "blocks  fractions  measurements  variables  tangents  non-zeros  iterations  chi2/dof  worst feed %  fit ms\n";
+	for(size_t c = 0; c < sizeof(blocks) / sizeof(blocks[0]); c++)
+	{
+		S_GeneratorParams params;
+		params.uiNumBlocks = blocks[c];
+		params.uiNumFeeds = feeds[c];
+		params.usNumFractions = fractions[c];
+		params.fRecycleRatio = 0.1f;
+		params.uiSeed = 5;
+
+		C_Flowsheet fs;
+		fs.SetMetric(false);
+		fs.SetDelta(0.0001f);
+		fs.SetMaxIterations(500);
+		fs.SetRoundToWater(2);
+		fs.SetUpdateSolids(true);
+		fs.SetUpdateWater(true);
+
+		C_FlowsheetGenerator generator(params);
+		generator.Generate(fs);
+
+		std::vector<BlockID> ids, feedIDs;
+		fs.GetBlockIDs(ids);
+		for(size_t i = 0; i < ids.size(); i++)
+		{
+			if(fs.GetBlock(ids[i])->IsFeedBlock())
+				feedIDs.push_back(ids[i]);
+		}
+
+		// The true feeds, each fraction moved by up to 30%
+		std::vector<float> nominal, truth;
+		for(size_t f = 0; f < feedIDs.size(); f++)
+		{
+			for(unsigned short i = 0; i < fractions[c]; i++)
+			{
+				std::string name = I_FSBlock::IndexedName("FractionRate", i);
+				float value;
+				fs.GetParameter(feedIDs[f], name, value);
+				nominal.push_back(value);
+				truth.push_back(value * (1.0f + 0.3f * sinf(0.7f * i + f)));
+				fs.SetParameter(feedIDs[f], name, truth.back());
+			}
+		}
+		fs.SolveFlowSheet();
+
+		C_Reconciliation rec;
+		for(size_t b = 0; b < ids.size(); b++)
+		{
+			if(fs.GetBlock(ids[b])->IsFeedBlock())
+				continue;
+
+			C_BlockPorts& bp = fs.GetBlock(ids[b])->GetPorts();
+			for(unsigned short p = 1; p < bp.GetNumPorts(); p++)
+			{
+				const C_FlowData* fd = bp.GetFlowData(p);
+				if(fd->d_SolidRate < 1.0f)
+					continue;
+
+				for(unsigned short i = 0; i < fd->GetNumFractions(); i++)
+				{
+					float sd = noise * (float)(*fd)[i] + 0.01f;
+					rec.AddSizeMeasurement(ids[b], p, C_Reconciliation::SIZE_RATE, i, (float)((*fd)[i] + sd * Gaussian()), sd);
+				}
+				float sd = noise * (float)fd->d_SolidRate + 0.01f;
+				rec.AddMeasurement(ids[b], p, C_Flowsheet::SENS_SOLIDS, (float)(fd->d_SolidRate + sd * Gaussian()), sd);
+			}
+		}
+
+		// Start from the feeds on the size distribution
+		size_t v = 0;
+		for(size_t f = 0; f < feedIDs.size(); f++)
+		{
+			rec.AddFeedVariables(fs, feedIDs[f]);
+			for(unsigned short i = 0; i < fractions[c]; i++)
+				fs.SetParameter(feedIDs[f], I_FSBlock::IndexedName("FractionRate", i), nominal[v++]);
+		}
+		fs.SolveFlowSheet();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool converged = rec.Solve(fs);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double worst = 0.0;
+		for(size_t j = 0; j < truth.size(); j++)
+		{
+			if(truth[j] > 1.0f)
+				worst = std::max(worst, 100.0 * fabs(rec.GetVariable((unsigned)j) - truth[j]) / truth[j]);
+		}
+
+		std::cout << std::setw(6) << blocks[c] << std::setw(11) << fractions[c]
+			<< std::setw(14) << rec.GetNumMeasurements() << std::setw(11) << rec.GetNumVariables()
+			<< std::setw(10) << rec.GetNumTangents() << std::setw(11) << rec.GetNumNonZeros()
+			<< std::setw(12) << rec.GetNumIterations() << (converged ? " " : "*")
+			<< std::fixed << std::setprecision(2) << std::setw(9) << rec.GetCost() / std::max(rec.GetDegreesOfFreedom(), 1)
+			<< std::setw(14) << worst << std::setw(8) << std::setprecision(0) << seconds * 1e3 << "\n";
+		std::cout.unsetf(std::ios::fixed);
+	}
+
+	return 0;
+}
@@ -0,0 +1,276 @@
+//======================================================================
+// ServerLatency.cpp
+// Author: James McCormick
+// Description:
+//	Times incremental re-solves through the solver server.  Generated
+//	plants are hosted in an in-process server, and a client nudges one
+//	parameter and asks for the changed streams over and over: a feed
+//	rate, which moves everything downstream of that feed, or the water
+//	added to the sump whose nudge changes the fewest streams.  Reports the round
+//	trip latency, the same re-solve called directly for comparison, and
+//	how many streams each reply carried.  The last row has a client per
+//	plant all working at once.  The number of requests is for the
+//	smallest plant and is scaled down for the bigger ones.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: ServerLatency [requests] [socket]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+#include "C_SolverServer.h"
+#include "C_SolverClient.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <vector>
+
+static C_Flowsheet* Generate(unsigned blocks, bool loops, unsigned seed)
+{
+	S_GeneratorParams params;
+	params.uiNumBlocks = blocks;
+	params.uiNumFeeds = 4;
+	params.fRecycleRatio = loops ? 0.1f : 0.0f;
+	params.uiSeed = seed;
+
+	C_Flowsheet* fs = new C_Flowsheet;
+	fs->SetMetric(false);
+	fs->SetDelta(0.0001f);
+	fs->SetMaxIterations(500);
+	fs->SetRoundToWater(2);
+	fs->SetUpdateSolids(true);
+	fs->SetUpdateWater(true);
+
+	C_FlowsheetGenerator generator(params);
+	generator.Generate(*fs);
+	return fs;
+}
+
+static float Nudge(float value, unsigned request)
+{
+	return (request & 1) ? value : value * 1.01f + 1.0f;
+}
+
+static BlockID FirstFeed(C_Flowsheet& fs)
+{
+	std::vector<BlockID> ids;
+	fs.GetBlockIDs(ids);
+	for(size_t i = 0; i < ids.size(); i++)
+	{
+		if(fs.GetBlock(ids[i])->IsFeedBlock())
+			return ids[i];
+	}
+	return 0;
+}
+
+// Solids, water and percent solids of every stream, to see which moved
+static void ReadStreams(C_Flowsheet& fs, std::vector<FlowValue>& values)
+{
+	C_SmartPointer<C_PortStore> store = fs.GetPortStore();
+	values.resize(store->GetNumPorts() * 3);
+	for(unsigned i = 0; i < store->GetNumPorts(); i++)
+	{
+		values[i * 3] = store->GetFlows()[i].d_SolidRate;
+		values[i * 3 + 1] = store->GetFlows()[i].d_FluidRate;
+		values[i * 3 + 2] = store->GetFlows()[i].d_PerSolids;
+	}
+}
+
+// The sump whose added water changes the fewest streams when nudged, the
+// same streams a reply would carry.  Counting block updates does not tell
+// them apart: without recycles every solve visits every block.
+static BlockID QuietestSump(C_Flowsheet& fs)
+{
+	std::vector<BlockID> ids;
+	fs.GetBlockIDs(ids);
+	fs.SolveFlowSheet();
+
+	std::vector<FlowValue> before, after;
+	ReadStreams(fs, before);
+
+	BlockID best = 0;
+	size_t fewest = (size_t)-1;
+	float value;
+	for(size_t i = 0; i < ids.size(); i++)
+	{
+		if(!fs.GetParameter(ids[i], "AddWater", value))
+			continue;
+		fs.SetParameter(ids[i], "AddWater", Nudge(value, 0));
+		fs.SolveFlowSheet();
+		ReadStreams(fs, after);
+
+		size_t changed = 0;
+		for(size_t v = 0; v < before.size(); v += 3)
+		{
+			for(size_t k = v; k < v + 3; k++)
+			{
+				// An empty stream's percent solids is NaN and never equal
+				if(after[k] != before[k] && (after[k] == after[k] || before[k] == before[k]))
+				{
+					changed++;
+					break;
+				}
+			}
+		}
+		if(changed < fewest)
+		{
+			fewest = changed;
+			best = ids[i];
+		}
+
+		fs.SetParameter(ids[i], "AddWater", value);
+		fs.SolveFlowSheet();
+	}
+	return best;
+}
+
+// One client nudging a parameter on one hosted plant
+struct S_ClientRun
+{
+	std::string name;
+	BlockID blockID;
+	std::string param;
+	float fValue;
+	unsigned uiRequests;
+	std::vector<double> latencies;
+	unsigned long ulStreams;
+	bool bOk;
+};
+
+static void RunClient(const char* path, S_ClientRun& run)
+{
+	C_SolverClient client;
+	run.bOk = client.Connect(path);
+	run.ulStreams = 0;
+	if(!run.bOk)
+		return;
+
+	std::vector<S_StreamResult> results;
+	std::vector<S_ParameterValue> params(1);
+	params[0].blockID = run.blockID;
+	params[0].name = run.param;
+	params[0].fValue = run.fValue;
+	run.bOk = client.Solve(run.name, params, RESULT_ALL, results) == STATUS_OK;
+
+	for(unsigned r = 0; r < run.uiRequests && run.bOk; r++)
+	{
+		params[0].fValue = Nudge(run.fValue, r);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		run.bOk = client.Solve(run.name, params, 0, results) == STATUS_OK;
+		run.latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		run.ulStreams += results.size();
+	}
+}
+
+static void Report(const char* loops, const char* label, const char* change, unsigned blocks, std::vector<double> latencies, unsigned long streams, double direct)
+{
+	std::sort(latencies.begin(), latencies.end());
+	const size_t n = latencies.size();
+	std::cout << std::setw(6) << blocks << "  " << std::left << std::setw(7) << loops << std::setw(10) << label << std::setw(7) << change << std::right
+		<< std::fixed << std::setprecision(1)
+		<< std::setw(9) << latencies[n / 2] * 1e6 << std::setw(9) << latencies[n * 99 / 100] * 1e6
+		<< std::setw(11) << direct * 1e6 << std::setw(14) << (double)streams / n << "\n";
+	std::cout.unsetf(std::ios::fixed);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned requests = (argc > 1) ? (unsigned)atoi(argv[1]) : 500;
+	const char* path = (argc > 2) ? argv[2] : "/tmp/flowsheet-bench.sock";
+
+	const unsigned sizes[] = { 100, 500, 2000 };
+	const unsigned numSizes = sizeof(sizes) / sizeof(sizes[0]);
+	const unsigned numConcurrent = 4;
+
+	// About the same time on each size
+	unsigned scaled[numSizes];
+	for(unsigned s = 0; s < numSizes; s++)
+		scaled[s] = std::max(10u, requests * sizes[0] / sizes[s]);
+
+	C_SolverServer server;
+	server.SetNumThreads(numConcurrent);
+	if(!server.Listen(path))
+	{
+		std::cout << "Could not listen on " << path << "\n";
+		return 1;
+	}
+
+	const char* changes[] = { "feed", "sump" };
+	std::vector<S_ClientRun> runs;
+	std::vector<double> direct;
+	for(unsigned s = 0; s < numSizes; s++)
+	{
+		for(unsigned run = 0; run < 4; run++)
+		{
+			const bool loops = run >= 2;
+			const bool sump = (run & 1) != 0;
+
+			// The same re-solve called directly, on a plant of its own
+			C_Flowsheet* local = Generate(sizes[s], loops, 7);
+			S_ClientRun client;
+			client.param = sump ? "AddWater" : "FeedRate";
+			client.blockID = sump ? QuietestSump(*local) : FirstFeed(*local);
+			local->GetParameter(client.blockID, client.param, client.fValue);
+			local->SolveFlowSheet();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for(unsigned r = 0; r < scaled[s]; r++)
+			{
+				local->SetParameter(client.blockID, client.param, Nudge(client.fValue, r));
+				local->SolveFlowSheet();
+			}
+			direct.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / scaled[s]);
+			delete local;
+
+			client.name = "plant" + std::to_string(runs.size());
+			client.uiRequests = scaled[s];
+			server.AddFlowsheet(client.name, Generate(sizes[s], loops, 7));
+			runs.push_back(client);
+		}
+	}
+
+	const size_t numSingle = runs.size();
+	for(unsigned c = 0; c < numConcurrent; c++)
+	{
+		C_Flowsheet* fs = Generate(sizes[1], false, 100 + c);
+		S_ClientRun client;
+		client.name = "concurrent" + std::to_string(c);
+		client.param = "FeedRate";
+		client.blockID = FirstFeed(*fs);
+		fs->GetParameter(client.blockID, client.param, client.fValue);
+		client.uiRequests = scaled[1];
+		server.AddFlowsheet(client.name, fs);
+		runs.push_back(client);
+	}
+
+	std::thread serving(&C_SolverServer::Run, &server);
+
+	std::cout << "blocks  loops  clients   change   p50 us   p99 us  direct us  streams/reply\n";
+	for(size_t r = 0; r < numSingle; r++)
+	{
+		RunClient(path, runs[r]);
+		if(!runs[r].bOk)
+			std::cout << "request failed\n";
+		Report((r & 2) ? "yes" : "no", "1", changes[r & 1], sizes[r / 4], runs[r].latencies, runs[r].ulStreams, direct[r]);
+	}
+
+	std::vector<std::thread> clients;
+	for(unsigned c = 0; c < numConcurrent; c++)
+		clients.push_back(std::thread(RunClient, path, std::ref(runs[numSingle + c])));
+
+	std::vector<double> latencies;
+	unsigned long streams = 0;
+	for(unsigned c = 0; c < numConcurrent; c++)
+	{
+		clients[c].join();
+		latencies.insert(latencies.end(), runs[numSingle + c].latencies.begin(), runs[numSingle + c].latencies.end());
+		streams += runs[numSingle + c].ulStreams;
+	}
+	Report("no", "4 at once", "feed", sizes[1], latencies, streams, direct[4]);
+
+	server.Stop();
+	serving.join();
+	return 0;
+}
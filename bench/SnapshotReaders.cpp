@@ -0,0 +1,193 @@
+//======================================================================
+// SnapshotReaders.cpp
+// Author: James McCormick
+// Description:
+//	Reads published result snapshots from other threads while a
+//	generated plant is re-solved over and over.  Each reader takes the
+//	current snapshot, sums every stream's solids and gives it back; the
+//	sums are checked afterwards against the ports of the solve that
+//	published each one, so a torn snapshot would show.  Reports the
+//	solve time with and without publishing, the cost of a publish on
+//	its own, the time a reader takes to take and give back a snapshot,
+//	and how many publishes were skipped because readers held every slot.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: SnapshotReaders [solves] [max readers]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+#include "C_ResultPublisher.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <utility>
+
+typedef std::chrono::steady_clock Clock;
+
+static double Seconds(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void Generate(C_Flowsheet& fs, unsigned blocks)
+{
+	S_GeneratorParams params;
+	params.uiNumBlocks = blocks;
+	params.uiNumFeeds = 4;
+	params.fRecycleRatio = 0.0f;
+	params.uiSeed = 1;
+
+	fs.SetMetric(false);
+	fs.SetDelta(0.0001f);
+	fs.SetMaxIterations(500);
+	fs.SetRoundToWater(2);
+	fs.SetUpdateSolids(true);
+	fs.SetUpdateWater(true);
+
+	C_FlowsheetGenerator generator(params);
+	generator.Generate(fs);
+}
+
+static BlockID FirstFeed(C_Flowsheet& fs)
+{
+	std::vector<BlockID> ids;
+	fs.GetBlockIDs(ids);
+	for(size_t i = 0; i < ids.size(); i++)
+	{
+		if(fs.GetBlock(ids[i])->IsFeedBlock())
+			return ids[i];
+	}
+	return 0;
+}
+
+// The sum a reader should find in the snapshot of this solve
+static double SumSolids(const C_PortStore& store)
+{
+	double sum = 0.0;
+	for(unsigned i = 0; i < store.GetNumPorts(); i++)
+		sum += store.GetFlows()[i].d_SolidRate;
+	return sum;
+}
+
+struct S_Reader
+{
+	std::vector<std::pair<unsigned long, double> > seen;	// Serial and sum of each new snapshot
+	unsigned long ulReads;
+	double dHoldTime;									// Taking and giving back, over all reads
+};
+
+static void Read(C_ResultPublisher& publisher, std::atomic<bool>& stop, S_Reader& reader)
+{
+	unsigned long last = 0;
+	reader.ulReads = 0;
+	reader.dHoldTime = 0.0;
+	while(!stop.load(std::memory_order_relaxed))
+	{
+		// Time a batch of bare takes so the clock does not swamp them
+		Clock::time_point start = Clock::now();
+		for(unsigned k = 0; k < 64; k++)
+			C_SnapshotReader(publisher).Get();
+		reader.dHoldTime += Seconds(start);
+		reader.ulReads += 64;
+
+		C_SnapshotReader snapshot(publisher);
+		if(snapshot.Get() == NULL || snapshot->GetSerial() == last)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		double sum = 0.0;
+		for(unsigned i = 0; i < snapshot->GetNumStreams(); i++)
+			sum += snapshot->GetSolids(i);
+		last = snapshot->GetSerial();
+		reader.seen.push_back(std::make_pair(last, sum));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned solves = (argc > 1) ? (unsigned)atoi(argv[1]) : 500;
+	const unsigned maxReaders = (argc > 2) ? (unsigned)atoi(argv[2]) : 8;
+	const unsigned blocks = 500;
+
+	C_Flowsheet fs;
+	Generate(fs, blocks);
+	const BlockID feed = FirstFeed(fs);
+	float rate = 0.0f;
+	fs.GetParameter(feed, "FeedRate", rate);
+	fs.SolveFlowSheet();
+
+	// The solve on its own, and a publish on its own
+	Clock::time_point start = Clock::now();
+	for(unsigned r = 0; r < solves; r++)
+	{
+		fs.SetParameter(feed, "FeedRate", (r & 1) ? rate : rate * 1.01f);
+		fs.SolveFlowSheet();
+	}
+	const double direct = Seconds(start) / solves;
+
+	C_ResultPublisher alone;
+	C_SmartPointer<C_PortStore> store = fs.GetPortStore();
+	start = Clock::now();
+	for(unsigned r = 0; r < solves; r++)
+		alone.Publish(*store, fs.GetWaterUnit(), fs.GetNumIterations());
+	const double publish = Seconds(start) / solves;
+
+	std::cout << blocks << " blocks, " << store->GetNumPorts() << " streams of " << store->GetNumFractions() << " fractions\n";
+	std::cout << "solve " << std::fixed << std::setprecision(1) << direct * 1e6 << " us, publish " << publish * 1e6 << " us\n\n";
+	std::cout << "readers  solve us  published  skipped  snapshots  take+give ns  torn\n";
+
+	for(unsigned numReaders = 1; numReaders <= maxReaders; numReaders *= 2)
+	{
+		C_ResultPublisher publisher;
+		fs.SetPublisher(&publisher);
+
+		std::atomic<bool> stop(false);
+		std::vector<S_Reader> readers(numReaders);
+		std::vector<std::thread> threads;
+		for(unsigned t = 0; t < numReaders; t++)
+			threads.push_back(std::thread(Read, std::ref(publisher), std::ref(stop), std::ref(readers[t])));
+
+		// What each publish should hold, by serial
+		std::vector<double> expected(1, 0.0);
+		start = Clock::now();
+		for(unsigned r = 0; r < solves; r++)
+		{
+			fs.SetParameter(feed, "FeedRate", (r & 1) ? rate : rate * 1.01f);
+			fs.SolveFlowSheet();
+			if(publisher.GetNumPublished() == expected.size())
+				expected.push_back(SumSolids(*fs.GetPortStore()));
+		}
+		const double solve = Seconds(start) / solves;
+
+		stop = true;
+		for(unsigned t = 0; t < numReaders; t++)
+			threads[t].join();
+		fs.SetPublisher(NULL);
+
+		unsigned long snapshots = 0, reads = 0, torn = 0;
+		double hold = 0.0;
+		for(unsigned t = 0; t < numReaders; t++)
+		{
+			for(size_t i = 0; i < readers[t].seen.size(); i++)
+			{
+				if(readers[t].seen[i].first >= expected.size() || readers[t].seen[i].second != expected[readers[t].seen[i].first])
+					torn++;
+			}
+			snapshots += readers[t].seen.size();
+			reads += readers[t].ulReads;
+			hold += readers[t].dHoldTime;
+		}
+
+		std::cout << std::setw(7) << numReaders << std::setw(10) << solve * 1e6 << std::setw(11) << publisher.GetNumPublished()
+			<< std::setw(9) << publisher.GetNumSkipped() << std::setw(11) << snapshots
+			<< std::setw(14) << (reads ? hold * 1e9 / reads : 0.0) << std::setw(6) << torn << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,122 @@
+//======================================================================
+// StreamKernels.cpp
+// Author: James McCormick
+// Description:
+//	Times the size fraction loops compiled for a fixed number of
+//	fractions against the general ones, for the counts that have a
+//	fixed set, then solves a generated flowsheet on each grid.  Checks
+//	that both sets give the same answer to the bit.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: StreamKernels [repeats]
+//======================================================================
+
+#include "C_FlowKernels.h"
+#include "C_FlowsheetGenerator.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+// Keeps the results live so the loops are not optimized away
+static volatile FlowValue g_fSink;
+
+//-----------------------------------------------------------------------
+// TimeKernels
+// Description
+//	Runs a sum of sources, a scaled split and a convergence check, the
+//	same mix as a block update, and returns nanoseconds per round.
+//-----------------------------------------------------------------------
+double TimeKernels(const S_FlowKernels* k, unsigned short n, unsigned repeats, std::vector<FlowValue>& result)
+{
+	std::vector<FlowValue> a(n), b(n), dst(n), rest(n);
+	std::vector<float> factors(n);
+	for(unsigned short i = 0; i < n; i++)
+	{
+		a[i] = 1.0f + i * 0.37f;
+		b[i] = 0.5f + i * 0.11f;
+		factors[i] = (float)i / n;
+	}
+
+	FlowValue total = 0.0f;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(unsigned r = 0; r < repeats; r++)
+	{
+		memset(&dst[0], 0, n * sizeof(FlowValue));
+		total += k->Add(&dst[0], &a[0], n);
+		total += k->Add(&dst[0], &b[0], n);
+		total += k->ScaleEach(&rest[0], &dst[0], &factors[0], n);
+		total += k->Subtract(&rest[0], &dst[0], &rest[0], n);
+		total += k->Scale(&dst[0], &rest[0], 0.999f, n);
+		total += k->MaxAbsDiff(&dst[0], &rest[0], n);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	g_fSink = total;
+
+	result = dst;
+	result.push_back(total);
+	return seconds * 1e9 / repeats;
+}
+
+//-----------------------------------------------------------------------
+// TimeSolve
+// Description
+//	Solves a 500 block flowsheet with recycles on an n fraction grid and
+//	returns milliseconds per solve.
+//-----------------------------------------------------------------------
+double TimeSolve(unsigned short n, unsigned solves)
+{
+	S_GeneratorParams params;
+	params.uiNumBlocks = 500;
+	params.fRecycleRatio = 0.1f;
+	params.usNumFractions = n;
+
+	C_Flowsheet fs;
+	fs.SetMetric(false);
+	fs.SetDelta(0.01f);
+	fs.SetMaxIterations(500);
+	fs.SetRoundToWater(2);
+	fs.SetUpdateSolids(true);
+	fs.SetUpdateWater(true);
+
+	C_FlowsheetGenerator generator(params);
+	generator.Generate(fs);
+	fs.SolveFlowSheet();
+
+	double seconds = 0.0;
+	for(unsigned i = 0; i < solves; i++)
+	{
+		fs.ZeroFlows();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		fs.SolveFlowSheet();
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return seconds * 1e3 / solves;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned repeats = (argc > 1) ? (unsigned)atoi(argv[1]) : 2000000;
+	const unsigned short counts[] = { 16, 25, 32, 64 };
+
+	std::cout << "fractions  general ns  fixed ns  speedup  same  solve ms\n";
+	for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		const unsigned short n = counts[c];
+		std::vector<FlowValue> general, fixed;
+		double tGeneral = TimeKernels(S_FlowKernels::General(), n, repeats, general);
+		double tFixed = TimeKernels(S_FlowKernels::Select(n), n, repeats, fixed);
+		bool same = memcmp(&general[0], &fixed[0], general.size() * sizeof(FlowValue)) == 0;
+
+		std::cout << std::setw(9) << n << std::fixed << std::setprecision(1)
+			<< std::setw(12) << tGeneral << std::setw(10) << tFixed
+			<< std::setw(8) << std::setprecision(2) << tGeneral / tFixed << "x"
+			<< std::setw(6) << (same ? "yes" : "NO")
+			<< std::setw(10) << std::setprecision(3) << TimeSolve(n, 20) << "\n";
+	}
+
+	return 0;
+}
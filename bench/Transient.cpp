@@ -0,0 +1,108 @@
+//======================================================================
+// Transient.cpp
+// Author: James McCormick
+// Description:
+//	Runs generated plants through time.  Every sump carrying flow is
+//	given five minutes of holdup and a pump set to its steady flow, so
+//	the levels hold until every feed steps up 10% ten minutes in and
+//	the sumps start to fill.  Reports the steps and solves each run
+//	took, the wall time and how much faster than real time it ran, with
+//	fixed steps and with adaptive ones.  The levels are written out
+//	once a minute of plant time to a stream that is thrown away.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: Transient [hours]
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+#include "C_Transient.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	double hours = (argc > 1) ? atof(argv[1]) : 4.0;
+
+	const unsigned sizes[] = { 200, 1000, 4000 };
+
+	std::cout << "simulated " << hours << " h\n";
+	std::cout << "blocks  sumps  states  steps     step     solves  updates/solve  wall ms  x real time\n";
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		for(int adaptive = 0; adaptive < 2; adaptive++)
+		{
+			S_GeneratorParams params;
+			params.uiNumBlocks = sizes[s];
+			params.uiNumFeeds = 4;
+			params.fRecycleRatio = 0.1f;
+			params.uiSeed = 11;
+
+			C_Flowsheet fs;
+			fs.SetMetric(true);
+			fs.SetDelta(0.0001f);
+			fs.SetMaxIterations(500);
+			fs.SetRoundToWater(2);
+			fs.SetUpdateSolids(true);
+			fs.SetUpdateWater(true);
+
+			C_FlowsheetGenerator generator(params);
+			generator.Generate(fs);
+			fs.SolveFlowSheet();
+
+			C_Transient transient;
+			std::vector<BlockID> ids;
+			fs.GetBlockIDs(ids);
+			unsigned sumps = 0;
+			for(size_t i = 0; i < ids.size(); i++)
+			{
+				BlockPtr block = fs.GetBlock(ids[i]);
+				if(block->IsFeedBlock())
+				{
+					float rate;
+					fs.GetParameter(ids[i], "FeedRate", rate);
+					transient.AddEvent(600.0, ids[i], "FeedRate", rate * 1.1f);
+					continue;
+				}
+				if(block->GetProcessID() != PROCID_SUMPPUMP)
+					continue;
+
+				const C_FlowData* fd = block->GetFlowData(0);
+				const float flow = (float)(fd->GetFluidRate() + fd->d_SolidRate / 1.5f);
+				if(flow <= 1.0f)
+					continue;
+
+				fs.SetParameter(ids[i], "Volume", flow / 12.0f);
+				fs.SetParameter(ids[i], "PumpRate", flow);
+				transient.AddOutput(ids[i], "Level");
+				sumps++;
+			}
+
+			if(adaptive)
+				transient.SetAdaptive(1.0, 120.0, 0.02f);
+			else
+				transient.SetTimeStep(5.0);
+
+			std::ostringstream out;
+			transient.SetOutput(&out, 60.0);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bool ok = transient.Start(fs) && transient.Advance(hours * 3600.0);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << std::setw(6) << sizes[s] << std::setw(7) << sumps << std::setw(8) << transient.GetNumStates()
+				<< std::setw(7) << transient.GetNumSteps() << (ok ? " " : "*") << std::setw(9) << (adaptive ? "adaptive" : "5 s")
+				<< std::setw(10) << transient.GetNumSolves()
+				<< std::setw(15) << transient.GetNumBlockUpdates() / std::max(transient.GetNumSolves(), 1ul)
+				<< std::fixed << std::setprecision(0) << std::setw(9) << seconds * 1e3
+				<< std::setw(13) << hours * 3600.0 / seconds << "\n";
+			std::cout.unsetf(std::ios::fixed);
+		}
+	}
+
+	return 0;
+}
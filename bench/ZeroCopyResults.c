@@ -0,0 +1,159 @@
+//======================================================================
+// ZeroCopyResults.c
+// Author: James McCormick
+// Description:
+//	A C host for FlowsheetAPI.h.  Builds plants of feed, screen and sump
+//	chains through the C interface, then times a solve, fetching the
+//	view of the results, and reading every stream through the view.
+//	Built as C to keep the header honest; link with the files in src/
+//	(except Main.cpp) and the C++ runtime.
+//
+//	Usage: ZeroCopyResults [sizes file] [repeats]
+//======================================================================
+
+// For clock_gettime under -std=c99
+#define _POSIX_C_SOURCE 199309L
+
+#include "FlowsheetAPI.h"
+#include "ProcessIDs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double Value(const char* p, unsigned bytes)
+{
+	return (bytes == sizeof(double)) ? *(const double*)p : *(const float*)p;
+}
+
+// Sums every stream's values, the way a host copying them out would read them
+static double ReadAll(const fs_results* r)
+{
+	double total = 0.0;
+	size_t i;
+	unsigned j;
+	for(i = 0; i < r->num_streams; i++)
+	{
+		const char* flow = r->flows + i * r->flow_stride;
+		const char* row = r->fractions + i * r->fraction_stride;
+		total += Value(flow + r->solids_offset, r->value_bytes);
+		total += Value(flow + r->water_offset, r->value_bytes) * r->water_scale;
+		total += Value(flow + r->percent_solids_offset, r->value_bytes);
+		for(j = 0; j < r->num_fractions; j++)
+			total += Value(row + j * r->value_bytes, r->value_bytes);
+	}
+	return total;
+}
+
+// A feed into a screen, with a sump on each screen product
+static int AddChain(fs_flowsheet* fs, float rate, unsigned* feed)
+{
+	unsigned screen, over, under;
+	fs_parameter params[3];
+	int status = FS_OK;
+
+	status |= fs_add_block(fs, PROCID_FEED, feed);
+	status |= fs_add_block(fs, PROCID_DESLIME_SINGLEDECK, &screen);
+	status |= fs_add_block(fs, PROCID_SUMPPUMP, &over);
+	status |= fs_add_block(fs, PROCID_SUMPPUMP, &under);
+	if(status != FS_OK)
+		return status;
+
+	status |= fs_link(fs, *feed, 0, screen);
+	status |= fs_link(fs, screen, 1, over);
+	status |= fs_link(fs, screen, 2, under);
+
+	params[0].block = *feed;
+	params[0].name = "FeedRate";
+	params[0].value = rate;
+	params[1].block = screen;
+	params[1].name = "CutPoint0";
+	params[1].value = 10.0f;
+	params[2].block = under;
+	params[2].name = "AddWater";
+	params[2].value = 50.0f;
+	status |= fs_set_parameters(fs, params, 3, NULL);
+	return status;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* sizes = (argc > 1) ? argv[1] : "data/TestData.txt";
+	const unsigned repeats = (argc > 2) ? (unsigned)atoi(argv[2]) : 1000;
+	const unsigned chains[] = { 25, 250, 1000 };
+	unsigned c, r, k;
+
+	printf("api version %u\n", fs_api_version());
+	printf("blocks  streams   solve us  results us  read all us  ns/stream  resolve+read us\n");
+	for(c = 0; c < sizeof(chains) / sizeof(chains[0]); c++)
+	{
+		fs_flowsheet* fs = fs_create(1);
+		fs_results results;
+		const fs_results* volatile view = &results;	// Read afresh every time
+		fs_parameter nudge;
+		double start, solve, fetch, read, resolve, check = 0.0;
+
+		if(!fs || fs_load_sizes(fs, sizes) != FS_OK)
+		{
+			printf("Could not load %s\n", sizes);
+			return 1;
+		}
+		fs_set_options(fs, 0.0001f, 500, 2);
+
+		nudge.block = 0;
+		for(k = 0; k < chains[c]; k++)
+		{
+			unsigned feed;
+			if(AddChain(fs, 100.0f + k, &feed) != FS_OK)
+			{
+				printf("Could not build the plant\n");
+				return 1;
+			}
+			if(k == 0)
+				nudge.block = feed;
+		}
+
+		start = Now();
+		if(fs_solve(fs) != FS_OK)
+			printf("did not converge\n");
+		solve = Now() - start;
+
+		results.size = sizeof(results);
+		start = Now();
+		for(r = 0; r < repeats; r++)
+			fs_get_results(fs, &results);
+		fetch = (Now() - start) / repeats;
+
+		start = Now();
+		for(r = 0; r < repeats; r++)
+			check += ReadAll(view);
+		read = (Now() - start) / repeats;
+
+		// An incremental solve and a fresh read of everything, the view kept
+		nudge.name = "FeedRate";
+		start = Now();
+		for(r = 0; r < repeats; r++)
+		{
+			nudge.value = (r & 1) ? 100.0f : 101.0f;
+			fs_set_parameters(fs, &nudge, 1, NULL);
+			fs_solve(fs);
+			check += ReadAll(view);
+		}
+		resolve = (Now() - start) / repeats;
+
+		printf("%6u  %7u  %9.1f  %10.3f  %11.2f  %9.2f  %15.1f\n", chains[c] * 4, (unsigned)results.num_streams,
+			solve * 1e6, fetch * 1e6, read * 1e6, read * 1e9 / results.num_streams, resolve * 1e6);
+		if(check != check)
+			printf("bad values\n");
+
+		fs_destroy(fs);
+	}
+	return 0;
+}
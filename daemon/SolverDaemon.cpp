@@ -0,0 +1,60 @@
+//======================================================================
+// SolverDaemon.cpp
+// Author: James McCormick
+// Description:
+//	Runs a C_SolverServer until it is sent SIGINT or SIGTERM.  Clients
+//	create and build their flowsheets over the socket, and the server
+//	keeps them loaded between requests.
+//	Build with the files in src/ (except Main.cpp) on the include path.
+//
+//	Usage: SolverDaemon socket [threads]
+//======================================================================
+
+#include "C_SolverServer.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <csignal>
+#include <thread>
+#include <pthread.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		std::cout << "Usage: SolverDaemon socket [threads]\n";
+		return 1;
+	}
+
+	// The signals are taken by one thread, so the pool's threads never see them
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, 0);
+
+	C_SolverServer server;
+	server.SetNumThreads((argc > 2) ? (unsigned)atoi(argv[2]) : 4);
+	if(!server.Listen(argv[1]))
+	{
+		std::cout << "Could not listen on " << argv[1] << "\n";
+		return 1;
+	}
+
+	std::thread waiter([&]()
+	{
+		int signal;
+		sigwait(&signals, &signal);
+		server.Stop();
+	});
+
+	server.Run();
+
+	// Wake the waiting thread if the server stopped on its own
+	kill(getpid(), SIGTERM);
+	waiter.join();
+
+	std::cout << "Served " << server.GetNumRequests() << " requests\n";
+	return 0;
+}
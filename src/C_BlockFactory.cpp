@@ -11,42 +11,112 @@
 #include "C_BlockFactory.h"
 #include "C_SumpPump.h"
 #include "C_DeslimeScreenDD.h"
+#include "C_Splitter.h"
+#include "C_HMCyclone.h"
+#include "C_ClassifyingCyclone.h"
+#include "C_DRScreen.h"
+#include "C_InletBlock.h"
+#include "C_SubFlowsheet.h"
 
 //-----------------------------------------------------------------------
 // CreateBlock - Public C_BlockFactory
 // Description 
-//	Creates the block.
+//	Creates the block with the next free id.
 // 
 // Arguments:	procID - The id of the type of process the block represents.
 // Returns:		A pointer to the block, null if unsucessful.
 //-----------------------------------------------------------------------
 BlockPtr C_BlockFactory::CreateBlock(const ProcessID &procID)
 {
+	// Copy the id, CreateBlock moves d_uiCurrID on
+	BlockID id = d_uiCurrID;
+	return CreateBlock(procID, id);
+}
+
+
+//-----------------------------------------------------------------------
+// CreateBlock - Public C_BlockFactory
+// Description 
+//	Creates the block.
+// 
+// Arguments:	procID - The id of the type of process the block represents.
+//				id - The id to give the block.
+// Returns:		A pointer to the block, null if unsucessful.
+//-----------------------------------------------------------------------
+BlockPtr C_BlockFactory::CreateBlock(const ProcessID &procID, const BlockID& id)
+{
+	BlockPtr block;
+
 	switch(procID)
 	{
 		case PROCID_FEED:
 		{
-			return new C_FeedBlock(d_fspFSParams, d_uiCurrID++);
+			block = new C_FeedBlock(d_fspFSParams, id);
+			break;
 		}
 		case PROCID_PRINTBLOCK:
 		{
-			return new C_PrintBlock(d_fspFSParams, d_uiCurrID++);
+			block = new C_PrintBlock(d_fspFSParams, id);
+			break;
 		}
 		case PROCID_DESLIME_SINGLEDECK:
 		{
-			return new C_DeslimeScreenSD(d_fspFSParams, d_uiCurrID++);
+			block = new C_DeslimeScreenSD(d_fspFSParams, id);
+			break;
 		}
 		case PROCID_SUMPPUMP:
 		{
-			return new C_SumpPump(d_fspFSParams, d_uiCurrID++);
+			block = new C_SumpPump(d_fspFSParams, id);
+			break;
 		}
 		case PROCID_DESLIME_DOUBLEDECK:
 		{
-			return new C_DeslimeScreenDD(d_fspFSParams, d_uiCurrID++);
+			block = new C_DeslimeScreenDD(d_fspFSParams, id);
+			break;
+		}
+		case PROCID_SPLITTER:
+		{
+			block = new C_Splitter(d_fspFSParams, id);
+			break;
+		}
+		case PROCID_HMC:
+		{
+			block = new C_HMCyclone(d_fspFSParams, id);
+			break;
+		}
+		case PROCID_DRSCREEN_SINGLEDECK:
+		{
+			block = new C_DRScreen(d_fspFSParams, id, 1);
+			break;
+		}
+		case PROCID_DRSCREEN_DOUBLEDECK:
+		{
+			block = new C_DRScreen(d_fspFSParams, id, 2);
+			break;
+		}
+		case PROCID_CLASSIFYING:
+		{
+			block = new C_ClassifyingCyclone(d_fspFSParams, id);
+			break;
+		}
+		case PROCID_INLET:
+		{
+			block = new C_InletBlock(d_fspFSParams, id);
+			break;
+		}
+		case PROCID_SUBFLOWSHEET:
+		{
+			block = new C_SubFlowsheet(d_fspFSParams, id);
+			break;
 		}
 		default:
 		{
 			return NULL;
 		}
 	}
+
+	if(id >= d_uiCurrID)
+		d_uiCurrID = id + 1;
+
+	return block;
 }
\ No newline at end of file
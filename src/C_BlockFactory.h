@@ -31,8 +31,15 @@ public:
 
 	 BlockPtr CreateBlock(const ProcessID &procID);
 
+	 // Creates a block with a given id.  Later blocks are numbered after it.
+	 BlockPtr CreateBlock(const ProcessID &procID, const BlockID& id);
+
 	 void Reset() { d_uiCurrID = d_uiStartID; }
 
+	 // The id the next block will get
+	 BlockID GetNextID() const { return d_uiCurrID; }
+	 void SetNextID(const BlockID& id) { d_uiCurrID = id; }
+
 };
 
 //-----------------------------------------------------------------------
@@ -9,7 +9,7 @@
 #ifndef _BLOCKPORTS_
 #define _BLOCKPORTS_
 
-#include "C_FlowData.h"
+#include "C_PortStore.h"
 
 class C_BlockPorts : public C_SmartPointerObject
 {
@@ -22,11 +22,28 @@ protected:
 	// The number of ports
 	unsigned short d_usNumPorts;
 
+	// Holds the ports once they have been moved into a store, null while
+	// the ports are allocated here
+	C_SmartPointer<C_PortStore> d_Store;
+
 	// PROTECTED METHODS=======================================================
 
 	// Clean the memory allocated
 	void Clean();
 
+	// |a - b| less rel times the larger of |a| and |b|.  NaN if either is.
+	static FlowValue Change(const FlowValue& a, const FlowValue& b, const float& rel)
+	{
+		FlowValue diff = (a < b) ? b - a : a - b;
+		if(rel > 0.0f)
+		{
+			FlowValue absA = (a < 0.0f) ? -a : a;
+			FlowValue absB = (b < 0.0f) ? -b : b;
+			diff -= rel * ((absA > absB) ? absA : absB);
+		}
+		return diff;
+	}
+
 public:
 	// PUBLIC DATA MEMBERS=====================================================
 
@@ -40,6 +57,16 @@ public:
 	// Resets all of the flow data objects and zero's them
 	void Reset();
 
+	// Zero's the flow data without reallocating it
+	void Zero();
+
+	// Allocates the sensitivity tangents on every port
+	void SetNumTangents(const unsigned short& num)
+	{
+		for(int i = 0; i < d_usNumPorts; i++)
+			d_Ports[i].SetNumTangents(num);
+	}
+
 	// Copys the bp variable into the current variable
 	C_BlockPorts& operator=(const C_BlockPorts& bp);
 
@@ -47,15 +74,29 @@ public:
 
 	// Init the ports - Must be called before they can be used
 	bool Init(FSParamsPtr fsParams, const unsigned short& NumPorts);
+
+	// Moves the ports, and their values, into the next ports of store
+	bool MoveTo(C_SmartPointer<C_PortStore> store, const BlockID& id);
 	
 	C_FlowData* GetFlowData(const unsigned short& port = 0)
 	{
 		return &d_Ports[port];
 	}
+	const C_FlowData* GetFlowData(const unsigned short& port = 0) const
+	{
+		return &d_Ports[port];
+	}
 
 	void UpdatePercentSolids();
 
 	C_SmartPointer<C_BlockPorts> Difference(const C_BlockPorts& b); 
+
+	// Checks if every value is within delta of b, plus rel times the larger
+	// of the two values, without allocating a difference
+	bool WithinDelta(const C_BlockPorts& b, const float& delta, const float& rel = 0.0f) const;
+
+	// The largest absolute change in any size fraction or fluid rate compared to b
+	float MaxDelta(const C_BlockPorts& b) const;
 };
 
 
@@ -78,6 +119,14 @@ inline void C_BlockPorts::UpdatePercentSolids()
 //-----------------------------------------------------------------------
 inline void C_BlockPorts::Clean()
 {
+	// Ports in a store are freed with it
+	if(d_Store != NULL)
+	{
+		d_Ports = 0;
+		d_usNumPorts = 0;
+		d_Store = 0;
+	}
+
 	// Delete the array of ports
 	if(d_Ports != 0)
 	{
@@ -114,6 +163,39 @@ inline bool C_BlockPorts::Init(FSParamsPtr fsParams, const unsigned short& numPo
 }
 
 
+//-----------------------------------------------------------------------
+// MoveTo - Public C_BlockPorts
+// Description 
+//	Copies the ports into the next ports of store and works on them
+//	there from then on.  They stay there until the ports are allocated
+//	again.
+// 
+// Arguments:	store - the store to move to
+//				id - the block's id
+// Returns:		false if the store has no room or a different number of
+//				size fractions, and the ports stay here.
+//-----------------------------------------------------------------------
+inline bool C_BlockPorts::MoveTo(C_SmartPointer<C_PortStore> store, const BlockID& id)
+{
+	if(d_usNumPorts == 0 || d_Ports[0].d_usNumFractions != store->GetNumFractions())
+		return false;
+
+	C_FlowData* ports = store->Take(id, d_usNumPorts);
+	if(ports == 0)
+		return false;
+
+	const unsigned short numPorts = d_usNumPorts;
+	for(int i = 0; i < numPorts; i++)
+		ports[i] = d_Ports[i];
+
+	Clean();
+	d_Ports = ports;
+	d_usNumPorts = numPorts;
+	d_Store = store;
+	return true;
+}
+
+
 //-----------------------------------------------------------------------
 // Reset - Public C_BlockPorts
 // Description 
@@ -129,6 +211,20 @@ inline void C_BlockPorts::Reset()
 		d_Ports[i].Reset();
 }
 
+//-----------------------------------------------------------------------
+// Zero - Public C_BlockPorts
+// Description 
+//	Zeros all of the flow data objects.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline void C_BlockPorts::Zero()
+{
+	for(int i = 0; i < d_usNumPorts; i++)
+		d_Ports[i].Zero();
+}
+
 //-----------------------------------------------------------------------
 // Copy Constructor - Public C_BlockPorts
 // Description 
@@ -147,6 +243,30 @@ inline C_BlockPorts::C_BlockPorts(C_BlockPorts& b)
 }
 
 
+//-----------------------------------------------------------------------
+// operator= - Public C_BlockPorts
+// Description 
+//	Copies the flow data of bp into the current set of ports.  The ports
+//	are only reallocated if the number of ports is different.
+// 
+// Arguments:	bp - The ports to copy.
+// Returns:		A reference to this C_BlockPorts
+//-----------------------------------------------------------------------
+inline C_BlockPorts& C_BlockPorts::operator=(const C_BlockPorts& bp)
+{
+	if(this == &bp)
+		return *this;
+
+	if(d_usNumPorts != bp.d_usNumPorts)
+		Init(bp.d_Ports[0].d_fspFSParams, bp.d_usNumPorts);
+
+	for(int i = 0; i < d_usNumPorts; i++)
+		d_Ports[i] = bp.d_Ports[i];
+
+	return *this;
+}
+
+
 //-----------------------------------------------------------------------
 // Difference - Public C_BlockPorts
 // Description 
@@ -172,10 +292,103 @@ inline C_SmartPointer<C_BlockPorts> C_BlockPorts::Difference(const C_BlockPorts&
 		deltaPort->d_Ports[i].d_FluidRate = d_Ports[i].d_FluidRate - b.d_Ports[i].d_FluidRate;
 		deltaPort->d_Ports[i].d_SolidRate = d_Ports[i].d_SolidRate - b.d_Ports[i].d_SolidRate;
 		for(int j = 0; j < d_Ports->d_usNumFractions; j++)
-			deltaPort->d_Ports[i].d_fpSizeFractions[j] = d_Ports[i].d_fpSizeFractions[j] - b.d_Ports[i].d_fpSizeFractions[j];
+			deltaPort->d_Ports[i][j] = d_Ports[i].d_fpSizeFractions[j] - b.d_Ports[i].d_fpSizeFractions[j];
 	}
 	return deltaPort;
 }
 
 
+//-----------------------------------------------------------------------
+// WithinDelta - Public C_BlockPorts
+// Description 
+//	Compares the size fractions and fluid rate of every port against b.
+//	Does the same test as checking the Difference, without building it.
+//	With a relative tolerance a value may also move by rel times the
+//	larger of its two values, so a big stream is not held to a change
+//	smaller than its round-off.
+// 
+// Arguments:	b - The other port data to compare against.
+//				delta - The largest change allowed.
+//				rel - The relative tolerance, 0 for none.
+// Returns:		true if no value has moved more than delta.
+//-----------------------------------------------------------------------
+inline bool C_BlockPorts::WithinDelta(const C_BlockPorts& b, const float& delta, const float& rel) const
+{
+	if(b.d_usNumPorts != d_usNumPorts)
+		return false;
+
+	for(int i = 0; i < d_usNumPorts; i++)
+	{
+		if(d_Ports[i].MaxFractionDiff(b.d_Ports[i], rel) > delta)
+			return false;
+
+		// delta is in the report units for the water
+		if(Change(d_Ports[i].d_FluidRate, b.d_Ports[i].d_FluidRate, rel) * d_Ports[i].d_fspFSParams->d_fWaterUnit > delta)
+			return false;
+
+		// The density classes and sensitivities have to settle as well
+		if(d_Ports[i].d_fpDensity)
+		{
+			if(!b.d_Ports[i].d_fpDensity || b.d_Ports[i].d_usDensityStride != d_Ports[i].d_usDensityStride)
+				return false;
+			const unsigned cells = d_Ports[i].d_usNumFractions * d_Ports[i].d_usDensityStride;
+			for(unsigned j = 0; j < cells; j++)
+			{
+				if(Change(d_Ports[i].d_fpDensity[j], b.d_Ports[i].d_fpDensity[j], rel) > delta)
+					return false;
+			}
+		}
+
+		if(d_Ports[i].d_usNumTangents != b.d_Ports[i].d_usNumTangents)
+			return false;
+		if(d_Ports[i].d_usNumTangents && d_Ports[i].MaxTangentDiff(b.d_Ports[i], rel) > delta)
+			return false;
+	}
+	return true;
+}
+
+
+
+//-----------------------------------------------------------------------
+// MaxDelta - Public C_BlockPorts
+// Description 
+//	Finds the largest change in a size fraction or fluid rate between
+//	this set of ports and b, including any sensitivities.  Used for
+//	reporting the residual.
+// 
+// Arguments:	b - The other port data to compare against.
+// Returns:		The largest absolute difference.
+//-----------------------------------------------------------------------
+inline float C_BlockPorts::MaxDelta(const C_BlockPorts& b) const
+{
+	FlowValue maxDiff = 0.0f;
+	FlowValue diff;
+	for(int i = 0; i < d_usNumPorts && i < b.d_usNumPorts; i++)
+	{
+		diff = d_Ports[i].MaxFractionDiff(b.d_Ports[i]);
+		if(diff > maxDiff) maxDiff = diff;
+
+		diff = (d_Ports[i].d_FluidRate - b.d_Ports[i].d_FluidRate) * d_Ports[i].d_fspFSParams->d_fWaterUnit;
+		if(diff < 0.0f) diff = -diff;
+		if(diff > maxDiff) maxDiff = diff;
+
+		if(d_Ports[i].d_fpDensity && b.d_Ports[i].d_fpDensity && b.d_Ports[i].d_usDensityStride == d_Ports[i].d_usDensityStride)
+		{
+			const unsigned cells = d_Ports[i].d_usNumFractions * d_Ports[i].d_usDensityStride;
+			for(unsigned j = 0; j < cells; j++)
+			{
+				diff = d_Ports[i].d_fpDensity[j] - b.d_Ports[i].d_fpDensity[j];
+				if(diff < 0.0f) diff = -diff;
+				if(diff > maxDiff) maxDiff = diff;
+			}
+		}
+
+		if(d_Ports[i].d_usNumTangents != b.d_Ports[i].d_usNumTangents)
+			continue;
+		diff = d_Ports[i].MaxTangentDiff(b.d_Ports[i]);
+		if(diff > maxDiff) maxDiff = diff;
+	}
+	return maxDiff;
+}
+
 #endif // _BLOCKPORTS_
\ No newline at end of file
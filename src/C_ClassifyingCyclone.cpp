@@ -0,0 +1,220 @@
+//======================================================================
+// C_ClassifyingCyclone.cpp 
+// Author: James McCormick
+// Description:
+//	A block that represents a classifying cyclone
+//
+//======================================================================
+
+#include "C_ClassifyingCyclone.h"
+#include <cmath>
+
+// The size distribution has been updated
+void C_ClassifyingCyclone::OnNewSizeDistribution()
+{
+	d_bPartitionValid = false;
+	d_Ports.Reset();
+}
+
+// Is called to pass the parameters to the block
+void C_ClassifyingCyclone::OnParameters(BlockParamsPtr p)
+{
+	// If the process id of the parameters does not match the id for this
+	// block, then exit
+	if(p->d_ProcessID != d_ProccessID)
+		return;
+
+	C_ClassifyingCycloneParams* castParams = static_cast<C_ClassifyingCycloneParams*>((I_FSBlockParameters*)p);
+
+	d_fD50c = castParams->d_fD50c;
+	d_fSharpness = castParams->d_fSharpness;
+	d_fWaterSplit = castParams->d_fWaterSplit;
+	d_bPartitionValid = false;
+}
+
+
+//-----------------------------------------------------------------------
+// UpdatePartition - Protected C_ClassifyingCyclone
+// Description 
+//	Works out E for every size fraction and its derivatives with respect
+//	to d50c, the sharpness and the water split.  The exponentials are
+//	written in terms of exp(-u) so coarse sizes go to 1 without
+//	overflowing.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ClassifyingCyclone::UpdatePartition()
+{
+	const C_SizeDistribution& sd = d_fspFSParams->d_sdSizeDistribution;
+	const unsigned short n = sd.GetNumSizeFractions();
+	const double ln2 = 0.6931471805599453;
+	const double rf = d_fWaterSplit;
+	const double d50c = (d_fD50c > 0.0f) ? d_fD50c : 1e-6;
+	const double a = d_fSharpness;
+
+	d_Partition.resize(n);
+	d_PartitionByD50c.resize(n);
+	d_PartitionBySharpness.resize(n);
+	d_PartitionBySplit.resize(n);
+
+	d_fpTable = GetPartitionNumbers();
+
+	for(unsigned short i = 0; i < n; i++)
+	{
+		double x = sd.GetFractionSize(i);
+		double ec, byD50c = 0.0, bySharpness = 0.0;
+
+		if(d_fpTable)
+			ec = d_fpTable[i];
+		else if(d_ucCurve == CURVE_PLITT)
+		{
+			double z = (x > 0.0) ? pow(x / d50c, a) : 0.0;
+			double g = exp(-ln2 * z);
+			ec = 1.0 - g;
+			byD50c = ln2 * g * -a * z / d50c;
+			bySharpness = (x > 0.0) ? ln2 * g * z * log(x / d50c) : 0.0;
+		}
+		else
+		{
+			// Ec = (1 - e) / (1 + (B - 2) e), e = exp(-u), u = a x / d50c, B = exp(a)
+			double u = a * x / d50c;
+			double e = exp(-u);
+			double B = exp(a);
+			double D = 1.0 + (B - 2.0) * e;
+			double byU = e * (B - 1.0) / (D * D);
+			ec = (1.0 - e) / D;
+			byD50c = byU * -u / d50c;
+			bySharpness = byU * x / d50c - (1.0 - e) * e * B / (D * D);
+		}
+
+		d_Partition[i] = (float)(rf + (1.0 - rf) * ec);
+		d_PartitionByD50c[i] = (float)((1.0 - rf) * byD50c);
+		d_PartitionBySharpness[i] = (float)((1.0 - rf) * bySharpness);
+		d_PartitionBySplit[i] = (float)(1.0 - ec);
+	}
+
+	d_bPartitionValid = true;
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateWater - Protected C_ClassifyingCyclone
+// Description 
+//	The feed water is split between the underflow and overflow by
+//	d_fWaterSplit.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ClassifyingCyclone::UpdateWater()
+{
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	C_FlowData* over = d_Ports.GetFlowData(1);
+	C_FlowData* under = d_Ports.GetFlowData(2);
+
+	under->d_FluidRate = feed->d_FluidRate * d_fWaterSplit;
+	over->d_FluidRate = feed->d_FluidRate - under->d_FluidRate;
+
+	if(d_usNumTangents)
+	{
+		const float* splitSeed = GetSeed("WaterSplit");
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			under->FluidTangent(k) = feed->FluidTangent(k) * d_fWaterSplit + 
+				feed->d_FluidRate * (splitSeed ? splitSeed[k] : 0.0f);
+			over->FluidTangent(k) = feed->FluidTangent(k) - under->FluidTangent(k);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateSolids - Protected C_ClassifyingCyclone
+// Description 
+//	Splits the feed by the partition, rebuilding it first if the
+//	parameters, size distribution or partition numbers have changed.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ClassifyingCyclone::UpdateSolids()
+{
+	if(!d_bPartitionValid || d_fpTable != GetPartitionNumbers())
+		UpdatePartition();
+
+	PartitionSolids(&d_Partition[0], 2, 1);
+
+	if(d_usNumTangents)
+	{
+		const float* d50cSeed = GetSeed("D50c");
+		const float* sharpSeed = GetSeed("Sharpness");
+		const float* splitSeed = GetSeed("WaterSplit");
+		if(!d50cSeed && !sharpSeed && !splitSeed)
+			return;
+
+		const C_FlowData* feed = d_Ports.GetFlowData(0);
+		C_FlowData* over = d_Ports.GetFlowData(1);
+		C_FlowData* under = d_Ports.GetFlowData(2);
+		const unsigned short n = feed->GetNumFractions();
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			float dD50c = d50cSeed ? d50cSeed[k] : 0.0f;
+			float dSharp = sharpSeed ? sharpSeed[k] : 0.0f;
+			float dSplit = splitSeed ? splitSeed[k] : 0.0f;
+			FlowValue* ut = under->GetTangent(k);
+			FlowValue* ot = over->GetTangent(k);
+			for(unsigned short i = 0; i < n; i++)
+			{
+				FlowValue dMass = (*feed)[i] * (d_PartitionByD50c[i] * dD50c + 
+					d_PartitionBySharpness[i] * dSharp + d_PartitionBySplit[i] * dSplit);
+				ut[i] += dMass;
+				ot[i] -= dMass;
+				ut[n] += dMass;
+				ot[n] -= dMass;
+			}
+		}
+	}
+}
+
+
+bool C_ClassifyingCyclone::SetParameter(const std::string& name, const float& value)
+{
+	if(name == "D50c")
+		d_fD50c = value;
+	else if(name == "Sharpness")
+		d_fSharpness = value;
+	else if(name == "WaterSplit")
+		d_fWaterSplit = value;
+	else if(name == "Curve")
+		d_ucCurve = (value >= 0.5f) ? CURVE_PLITT : CURVE_WHITEN;
+	else
+		return false;
+
+	d_bPartitionValid = false;
+	return true;
+}
+
+bool C_ClassifyingCyclone::GetParameter(const std::string& name, float& value) const
+{
+	if(name == "D50c")
+		value = d_fD50c;
+	else if(name == "Sharpness")
+		value = d_fSharpness;
+	else if(name == "WaterSplit")
+		value = d_fWaterSplit;
+	else if(name == "Curve")
+		value = d_ucCurve;
+	else
+		return false;
+
+	return true;
+}
+
+void C_ClassifyingCyclone::GetParameterNames(std::vector<std::string>& names) const
+{
+	names.push_back("D50c");
+	names.push_back("Sharpness");
+	names.push_back("WaterSplit");
+	names.push_back("Curve");
+}
@@ -0,0 +1,107 @@
+//======================================================================
+// C_ClassifyingCyclone.h 
+// Author: James McCormick
+// Description:
+//	A block that represents a classifying cyclone
+//	The first port is the feed.
+//	The second port is the overflow (fines).
+//	The third port is the underflow (coarse).
+//
+//	The chance of a size reporting to the underflow is
+//		E = Rf + (1 - Rf) * Ec
+//	where Rf is the fraction of the water to the underflow, which carries
+//	its share of every size with it, and Ec is the corrected efficiency:
+//		Whiten	Ec = (exp(a x / d50c) - 1) / (exp(a x / d50c) + exp(a) - 2)
+//		Plitt	Ec = 1 - exp(-ln2 (x / d50c)^m)
+//	with the sharpness a or m.  If partition numbers are loaded for
+//	classifying cyclones they are used for Ec instead.
+//
+//	E is worked out for every size fraction, along with its derivatives,
+//	only when d50c, the sharpness, the curve or the water split change,
+//	so an update is a multiply per size fraction.
+//======================================================================
+
+#ifndef _CLASSIFYINGCYCLONE_
+#define _CLASSIFYINGCYCLONE_
+
+#include "I_FSBlock.h"
+
+
+class C_ClassifyingCycloneParams : public I_FSBlockParameters
+{
+private:
+	C_ClassifyingCycloneParams();
+	C_ClassifyingCycloneParams(C_ClassifyingCycloneParams&);
+
+public:
+	C_ClassifyingCycloneParams(BlockID id, ProcessID p, float d50c, float sharpness, float waterSplit) : 
+		I_FSBlockParameters(id, p), d_fD50c(d50c), d_fSharpness(sharpness), d_fWaterSplit(waterSplit)
+	{}
+
+	float d_fD50c;				// The corrected cut size in mm
+	float d_fSharpness;
+	float d_fWaterSplit;		// The fraction of the water that goes to the underflow
+};
+
+
+class C_ClassifyingCyclone : public I_FSBlock
+{
+public:
+	// The corrected efficiency curve
+	enum { CURVE_WHITEN = 0, CURVE_PLITT };
+
+protected:
+
+	// PROTECTED DATA MEMBERS==================================================
+	float d_fD50c;
+	float d_fSharpness;
+	float d_fWaterSplit;
+	unsigned char d_ucCurve;
+
+	// The chance of each size fraction reporting to the underflow and its
+	// derivatives.  Rebuilt when d_bPartitionValid is false.
+	bool d_bPartitionValid;
+	const float* d_fpTable;			// The partition numbers it was built from, if any
+	std::vector<float> d_Partition;
+	std::vector<float> d_PartitionByD50c;
+	std::vector<float> d_PartitionBySharpness;
+	std::vector<float> d_PartitionBySplit;
+
+	// PROTECTED METHODS=======================================================
+
+	// Rebuilds the partition
+	void UpdatePartition();
+
+	virtual void UpdateWater();
+	virtual void UpdateSolids();
+
+	// The overflow takes the rounding
+	virtual int WaterBalancePort() const { return 1; }
+
+public:
+
+	// PUBLIC DATA MEMBERS=====================================================
+
+	// PUBLIC METHODS==========================================================
+
+	// Constructor
+	C_ClassifyingCyclone(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID), d_fD50c(0.1f),
+		d_fSharpness(3.0f), d_fWaterSplit(0.2f), d_ucCurve(CURVE_WHITEN), d_bPartitionValid(false), d_fpTable(0)
+	{
+		d_ProccessID = PROCID_CLASSIFYING;
+		d_Ports.Init(fsp, 3); 
+	}
+
+	// The size distribution has been updated
+	virtual void OnNewSizeDistribution();
+
+	// Is called to pass the parameters to the block
+	virtual void OnParameters(BlockParamsPtr);
+
+	// Named parameters - "D50c", "Sharpness", "WaterSplit" and "Curve"
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
+};
+
+#endif // _CLASSIFYINGCYCLONE_
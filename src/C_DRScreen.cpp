@@ -0,0 +1,205 @@
+//======================================================================
+// C_DRScreen.cpp 
+// Author: James McCormick
+// Description:
+//	A block that represents a drain and rinse screen
+//
+//======================================================================
+
+#include "C_DRScreen.h"
+
+// The size distribution has been updated
+void C_DRScreen::OnNewSizeDistribution()
+{
+	d_bFactorsValid = false;
+	d_Ports.Reset();
+}
+
+// Is called to pass the parameters to the block
+void C_DRScreen::OnParameters(BlockParamsPtr p)
+{
+	// If the process id of the parameters does not match the id for this
+	// block, then exit
+	if(p->d_ProcessID != d_ProccessID)
+		return;
+
+	C_DRScreenParams* castParams = static_cast<C_DRScreenParams*>((I_FSBlockParameters*)p);
+
+	for(short i = 0; i < d_NumDecks; i++)
+	{
+		d_DeckCutPoints[i] = castParams->d_fCutPoint[i];
+		d_SMPerDeck[i] = castParams->d_fDeckSM[i];
+		d_DeckSharpness[i] = castParams->d_fSharpness[i];
+	}
+	d_AddWater = WaterFromReport(castParams->d_fRinseWater);
+	d_fDrainSplit = castParams->d_fDrainSplit;
+	d_fBleedSplit = castParams->d_fBleedSplit;
+	d_bPartitionValid = false;
+	d_bFactorsValid = false;
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateWater - Protected C_DRScreen
+// Description 
+//	The decks carry off their surface moisture and the rest of the feed
+//	and rinse water is split between the drain, bleed and rinse.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_DRScreen::UpdateWater()
+{
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	C_FlowData* drain = d_Ports.GetFlowData(1);
+	C_FlowData* bleed = d_Ports.GetFlowData(2);
+	C_FlowData* rinse = d_Ports.GetFlowData(3);
+
+	FluidRate under = feed->d_FluidRate + d_AddWater;
+	for(short i = 0; i < d_NumDecks; i++)
+	{
+		d_Ports.GetFlowData(4 + i)->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[i], d_SMSeeds[i]);
+		under -= d_Ports.GetFlowData(4 + i)->d_FluidRate;
+	}
+
+	FluidRate drainSide = under * d_fDrainSplit;
+	bleed->d_FluidRate = drainSide * d_fBleedSplit;
+	drain->d_FluidRate = drainSide - bleed->d_FluidRate;
+	rinse->d_FluidRate = under - drain->d_FluidRate - bleed->d_FluidRate;
+
+	if(d_usNumTangents)
+	{
+		const float* drainSeed = GetSeed("DrainSplit");
+		const float* bleedSeed = GetSeed("BleedSplit");
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			FlowValue dUnder = feed->FluidTangent(k) + (d_AddWaterSeed ? d_AddWaterSeed[k] : 0.0f);
+			for(short i = 0; i < d_NumDecks; i++)
+				dUnder -= d_Ports.GetFlowData(4 + i)->FluidTangent(k);
+
+			FlowValue dDrainSide = dUnder * d_fDrainSplit + under * (drainSeed ? drainSeed[k] : 0.0f);
+			bleed->FluidTangent(k) = dDrainSide * d_fBleedSplit + drainSide * (bleedSeed ? bleedSeed[k] : 0.0f);
+			drain->FluidTangent(k) = dDrainSide - bleed->FluidTangent(k);
+			rinse->FluidTangent(k) = dUnder - dDrainSide;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateSolids - Protected C_DRScreen
+// Description 
+//	Spreads the undersize row of the deck partition over the drain,
+//	bleed and rinse, then screens the feed onto all of the ports in one
+//	pass of the screening kernel.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_DRScreen::UpdateSolids()
+{
+	if(!d_bPartitionValid || d_uiPartitionGridVersion != d_fspFSParams->d_uiGridVersion)
+		d_bFactorsValid = false;
+
+	UpdateDeckPartition();
+
+	const C_FlowData* feed = d_Ports.GetFlowData(0);
+	const unsigned short n = feed->GetNumFractions();
+	const float* under = &d_DeckPartition[0];
+
+	if(!d_bFactorsValid)
+	{
+		d_PortFactors.resize((d_NumDecks + 3) * n);
+		for(unsigned short j = 0; j < n; j++)
+		{
+			d_PortFactors[j] = under[j] * d_fDrainSplit * (1.0f - d_fBleedSplit);
+			d_PortFactors[n + j] = under[j] * d_fDrainSplit * d_fBleedSplit;
+			d_PortFactors[2 * n + j] = under[j] * (1.0f - d_fDrainSplit);
+		}
+		for(int o = 1; o <= d_NumDecks; o++)
+			for(unsigned short j = 0; j < n; j++)
+				d_PortFactors[(o + 2) * n + j] = d_DeckPartition[o * n + j];
+		d_bFactorsValid = true;
+	}
+
+	SplitFeed(&d_PortFactors[0], 1, d_NumDecks + 3);
+
+	if(d_usNumTangents)
+	{
+		const float* drainSeed = GetSeed("DrainSplit");
+		const float* bleedSeed = GetSeed("BleedSplit");
+		if(!drainSeed && !bleedSeed)
+			return;
+
+		C_FlowData* ports[3] = { d_Ports.GetFlowData(1), d_Ports.GetFlowData(2), d_Ports.GetFlowData(3) };
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			float dDrain = drainSeed ? drainSeed[k] : 0.0f;
+			float dBleed = bleedSeed ? bleedSeed[k] : 0.0f;
+
+			// d(factor) / d(split) for the drain, bleed and rinse
+			float coef[3];
+			coef[0] = dDrain * (1.0f - d_fBleedSplit) - d_fDrainSplit * dBleed;
+			coef[1] = dDrain * d_fBleedSplit + d_fDrainSplit * dBleed;
+			coef[2] = -dDrain;
+
+			for(int p = 0; p < 3; p++)
+			{
+				FlowValue* t = ports[p]->GetTangent(k);
+				for(unsigned short j = 0; j < n; j++)
+				{
+					FlowValue dMass = (*feed)[j] * under[j] * coef[p];
+					t[j] += dMass;
+					t[n] += dMass;
+				}
+			}
+		}
+	}
+}
+
+
+bool C_DRScreen::SetParameter(const std::string& name, const float& value)
+{
+	int deck;
+	if(name == "DrainSplit")
+		d_fDrainSplit = value;
+	else if(name == "BleedSplit")
+		d_fBleedSplit = value;
+	else if((deck = ParseIndex(name, "Sharpness", d_NumDecks)) >= 0)
+	{
+		d_DeckSharpness[deck] = value;
+		d_bPartitionValid = false;
+	}
+	else
+		return I_Screen::SetParameter(name, value);
+
+	d_bFactorsValid = false;
+	return true;
+}
+
+bool C_DRScreen::GetParameter(const std::string& name, float& value) const
+{
+	int deck;
+	if(name == "DrainSplit")
+		value = d_fDrainSplit;
+	else if(name == "BleedSplit")
+		value = d_fBleedSplit;
+	else if((deck = ParseIndex(name, "Sharpness", d_NumDecks)) >= 0)
+		value = d_DeckSharpness[deck];
+	else
+		return I_Screen::GetParameter(name, value);
+
+	return true;
+}
+
+void C_DRScreen::GetParameterNames(std::vector<std::string>& names) const
+{
+	I_Screen::GetParameterNames(names);
+	names.push_back("DrainSplit");
+	names.push_back("BleedSplit");
+	for(short i = 0; i < d_NumDecks; i++)
+	{
+		char digit[2] = { (char)('0' + i), 0 };
+		names.push_back(std::string("Sharpness") + digit);
+	}
+}
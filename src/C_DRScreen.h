@@ -0,0 +1,111 @@
+//======================================================================
+// C_DRScreen.h
+// Author: James McCormick
+// Description:
+//	A block that represents a single or double deck drain and rinse
+//	screen
+//	The first port is the feed.
+//	The second is the drain.
+//	The third is the bleed from the drain.
+//	The fourth is the rinse.
+//	The fifth, sixth are the deck discharges, bottom deck first.
+//
+//	The decks screen the feed with efficiency curves (see I_Screen).
+//	What passes the bottom deck, water and solids alike, is split
+//	between the drain section, which recovers the medium, and the rinse
+//	by DrainSplit, and BleedSplit of the drain is bled off.  The rinse
+//	sprays are the add water.
+//======================================================================
+
+#ifndef _DRSCREEN_
+#define _DRSCREEN_
+
+#include "I_Screen.h"
+
+
+class C_DRScreenParams : public I_FSBlockParameters
+{
+private:
+	C_DRScreenParams();
+	C_DRScreenParams(C_DRScreenParams&);
+
+public:
+	// Single deck
+	C_DRScreenParams(BlockID id, ProcessID p, float deckSM, float cutPoint, float sharpness,
+		float rinseWater, float drainSplit, float bleedSplit) : I_FSBlockParameters(id, p),
+		d_fRinseWater(rinseWater), d_fDrainSplit(drainSplit), d_fBleedSplit(bleedSplit)
+	{
+		d_fDeckSM[0] = d_fDeckSM[1] = deckSM;
+		d_fCutPoint[0] = d_fCutPoint[1] = cutPoint;
+		d_fSharpness[0] = d_fSharpness[1] = sharpness;
+	}
+
+	// Double deck
+	C_DRScreenParams(BlockID id, ProcessID p, float deckSMTop, float deckSMBottom, float cutPointTop, float cutPointBottom,
+		float sharpnessTop, float sharpnessBottom, float rinseWater, float drainSplit, float bleedSplit) : I_FSBlockParameters(id, p),
+		d_fRinseWater(rinseWater), d_fDrainSplit(drainSplit), d_fBleedSplit(bleedSplit)
+	{
+		d_fDeckSM[0] = deckSMBottom;
+		d_fDeckSM[1] = deckSMTop;
+		d_fCutPoint[0] = cutPointBottom;
+		d_fCutPoint[1] = cutPointTop;
+		d_fSharpness[0] = sharpnessBottom;
+		d_fSharpness[1] = sharpnessTop;
+	}
+
+	float d_fRinseWater;
+	float d_fDrainSplit;		// The fraction of the undersize to the drain section
+	float d_fBleedSplit;		// The fraction of the drain section that is bled
+	float d_fDeckSM[2];
+	float d_fCutPoint[2];
+	float d_fSharpness[2];		// 0 for a sharp cut
+};
+
+
+class C_DRScreen : public I_Screen
+{
+protected:
+
+	// PROTECTED DATA MEMBERS==================================================
+	float d_fDrainSplit;
+	float d_fBleedSplit;
+
+	// The deck partition spread over the drain, bleed, rinse and deck ports
+	bool d_bFactorsValid;
+	std::vector<float> d_PortFactors;
+
+	// PROTECTED METHODS=======================================================
+
+	virtual void UpdateWater();
+	virtual void UpdateSolids();
+
+	// The rinse takes the rounding
+	virtual int WaterBalancePort() const { return 3; }
+
+public:
+
+	// PUBLIC DATA MEMBERS=====================================================
+
+	// PUBLIC METHODS==========================================================
+
+	// Constructor
+	C_DRScreen(FSParamsPtr fsp, const BlockID& ID, short numDecks) : I_Screen(fsp, ID, numDecks),
+		d_fDrainSplit(1.0f), d_fBleedSplit(0.0f), d_bFactorsValid(false)
+	{
+		d_ProccessID = (numDecks == 1) ? PROCID_DRSCREEN_SINGLEDECK : PROCID_DRSCREEN_DOUBLEDECK;
+		d_Ports.Init(fsp, 4 + numDecks);
+	}
+
+	// The size distribution has been updated
+	virtual void OnNewSizeDistribution();
+
+	// Is called to pass the parameters to the block
+	virtual void OnParameters(BlockParamsPtr);
+
+	// Named parameters - "DrainSplit", "BleedSplit", "Sharpness<deck>" and the screen's
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
+};
+
+#endif // _DRSCREEN_
@@ -0,0 +1,300 @@
+//======================================================================
+// C_DesignSpec.cpp
+// Author: James McCormick
+// Description:
+//	Adjusts named block parameters until streams hit their targets.
+//======================================================================
+
+#include "C_DesignSpec.h"
+#include <cmath>
+
+using namespace std;
+
+//-----------------------------------------------------------------------
+// SolveLinear
+// Description
+//	Solves the n x n system A x = b in place by Gaussian elimination with
+//	partial pivoting.  b is replaced by x.
+//
+// Returns:		false if A is singular.
+//-----------------------------------------------------------------------
+static bool SolveLinear(unsigned n, vector<double>& A, vector<double>& b)
+{
+	for(unsigned c = 0; c < n; c++)
+	{
+		unsigned pivot = c;
+		for(unsigned r = c + 1; r < n; r++)
+			if(fabs(A[r * n + c]) > fabs(A[pivot * n + c]))
+				pivot = r;
+
+		if(A[pivot * n + c] == 0.0)
+			return false;
+
+		if(pivot != c)
+		{
+			for(unsigned k = 0; k < n; k++)
+				swap(A[c * n + k], A[pivot * n + k]);
+			swap(b[c], b[pivot]);
+		}
+
+		for(unsigned r = c + 1; r < n; r++)
+		{
+			double f = A[r * n + c] / A[c * n + c];
+			for(unsigned k = c; k < n; k++)
+				A[r * n + k] -= f * A[c * n + k];
+			b[r] -= f * b[c];
+		}
+	}
+
+	for(unsigned c = n; c-- > 0; )
+	{
+		for(unsigned k = c + 1; k < n; k++)
+			b[c] -= A[c * n + k] * b[k];
+		b[c] /= A[c * n + c];
+	}
+	return true;
+}
+
+
+static double SumOfSquares(const vector<double>& r)
+{
+	double sum = 0.0;
+	for(size_t i = 0; i < r.size(); i++)
+		sum += r[i] * r[i];
+	return sum;
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_DesignSpec
+//-----------------------------------------------------------------------
+C_DesignSpec::C_DesignSpec() : d_uiMaxIterations(50),
+	d_uiNumIterations(0), d_uiNumSolves(0), d_ulNumBlockUpdates(0)
+{
+}
+
+
+void C_DesignSpec::AddTarget(const BlockID& id, const PortNo& port, unsigned char quantity, float value, float tolerance)
+{
+	S_Target t;
+	t.stream.blockID = id;
+	t.stream.port = port;
+	t.ucQuantity = quantity;
+	t.fValue = value;
+	t.fTolerance = tolerance;
+	d_Targets.push_back(t);
+}
+
+
+void C_DesignSpec::AddVariable(const BlockID& id, const std::string& name, float min, float max)
+{
+	S_DesignVariable v;
+	v.param.blockID = id;
+	v.param.name = name;
+	v.fMin = min;
+	v.fMax = max;
+	d_Variables.push_back(v);
+}
+
+
+float C_DesignSpec::GetValue(C_Flowsheet& fs, const S_Target& t) const
+{
+	C_FlowData* fd = fs.GetBlock(t.stream.blockID)->GetFlowData(t.stream.port);
+	switch(t.ucQuantity)
+	{
+		case C_Flowsheet::SENS_SOLIDS:		return fd->d_SolidRate;
+		case C_Flowsheet::SENS_WATER:		return fd->GetFluidRate();
+		default:							return fd->d_PerSolids;
+	}
+}
+
+
+bool C_DesignSpec::TargetsMet(C_Flowsheet& fs) const
+{
+	for(size_t i = 0; i < d_Targets.size(); i++)
+	{
+		if(fabs(GetValue(fs, d_Targets[i]) - d_Targets[i].fValue) > d_Targets[i].fTolerance)
+			return false;
+	}
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// Evaluate - Private C_DesignSpec
+// Description
+//	Sets the variables and solves the flowsheet from wherever its flows
+//	are now, without rounding or reporting; Solve reports once at the
+//	end.  The residuals are measured in tolerances, so a target is
+//	met when its residual is within 1, and the Jacobian is scaled by each
+//	variable's range so the step sizes are comparable.
+//
+// Arguments:	fs - the flowsheet, x - the variables
+//				r - the scaled residuals, J - targets x variables, row major
+// Returns:		false if the flowsheet did not converge.
+//-----------------------------------------------------------------------
+bool C_DesignSpec::Evaluate(C_Flowsheet& fs, const vector<double>& x, vector<double>& r, vector<double>& J)
+{
+	const unsigned numVars = (unsigned)d_Variables.size();
+	const unsigned numTargets = (unsigned)d_Targets.size();
+
+	for(unsigned j = 0; j < numVars; j++)
+		fs.SetParameter(d_Variables[j].param.blockID, d_Variables[j].param.name, (float)x[j]);
+
+	bool converged = fs.Solve(false);
+	d_uiNumSolves++;
+	d_ulNumBlockUpdates += fs.GetNumBlockUpdates();
+	if(!converged)
+		return false;
+
+	r.resize(numTargets);
+	J.resize(numTargets * numVars);
+	for(unsigned i = 0; i < numTargets; i++)
+	{
+		double scale = (d_Targets[i].fTolerance > 0.0f) ? d_Targets[i].fTolerance : 1e-6;
+		r[i] = (GetValue(fs, d_Targets[i]) - d_Targets[i].fValue) / scale;
+		for(unsigned j = 0; j < numVars; j++)
+		{
+			double range = d_Variables[j].fMax - d_Variables[j].fMin;
+			J[i * numVars + j] = fs.GetSensitivity(d_Targets[i].stream, d_Targets[i].ucQuantity, (unsigned short)j) * range / scale;
+		}
+	}
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// Solve - Public C_DesignSpec
+// Description
+//	Levenberg-Marquardt on the scaled residuals.  A step that makes the
+//	residuals worse is thrown away and the damping raised, which moves
+//	the next step toward steepest descent.  Steps are clipped to the
+//	variable bounds.  The flowsheet's own sensitivity settings are put
+//	back afterwards, and it is solved once more at the best point to
+//	round the water and update the report blocks.
+//
+// Arguments:	fs - the flowsheet to adjust
+// Returns:		true if every target was met, false as well if a target's
+//				block or port or a variable's parameter is not there.
+//-----------------------------------------------------------------------
+bool C_DesignSpec::Solve(C_Flowsheet& fs)
+{
+	const unsigned numVars = (unsigned)d_Variables.size();
+
+	d_uiNumIterations = 0;
+	d_uiNumSolves = 0;
+	d_ulNumBlockUpdates = 0;
+	d_Values.assign(numVars, 0.0f);
+
+	// The targets are read without checks inside the iterations
+	for(size_t i = 0; i < d_Targets.size(); i++)
+	{
+		BlockPtr block = fs.GetBlock(d_Targets[i].stream.blockID);
+		if(block == NULL || d_Targets[i].stream.port >= block->GetPorts().GetNumPorts())
+			return false;
+	}
+
+	vector<S_ParameterRef> saved = fs.GetSensitivities();
+	vector<S_ParameterRef> params;
+	vector<double> x(numVars);
+	for(unsigned j = 0; j < numVars; j++)
+	{
+		float value = 0.0f;
+		if(!fs.GetParameter(d_Variables[j].param.blockID, d_Variables[j].param.name, value))
+			return false;
+		if(value < d_Variables[j].fMin) value = d_Variables[j].fMin;
+		if(value > d_Variables[j].fMax) value = d_Variables[j].fMax;
+		x[j] = value;
+		d_Values[j] = value;
+		params.push_back(d_Variables[j].param);
+	}
+
+	if(d_Targets.empty() || numVars == 0)
+		return TargetsMet(fs);
+
+	fs.SetSensitivities(params);
+
+	vector<double> r, J, rTrial, JTrial;
+	bool met = false;
+	if(Evaluate(fs, x, r, J))
+	{
+		const unsigned numTargets = (unsigned)d_Targets.size();
+		double cost = SumOfSquares(r);
+		double lambda = 1e-3;
+		bool atBest = true;
+
+		vector<double> A(numVars * numVars), g(numVars), xTrial(numVars);
+		while(!(met = TargetsMet(fs) && atBest) && d_uiNumIterations < d_uiMaxIterations)
+		{
+			d_uiNumIterations++;
+
+			// (J'J + lambda diag(J'J)) step = -J'r
+			for(unsigned a = 0; a < numVars; a++)
+			{
+				g[a] = 0.0;
+				for(unsigned i = 0; i < numTargets; i++)
+					g[a] -= J[i * numVars + a] * r[i];
+
+				for(unsigned b = 0; b < numVars; b++)
+				{
+					double sum = 0.0;
+					for(unsigned i = 0; i < numTargets; i++)
+						sum += J[i * numVars + a] * J[i * numVars + b];
+					A[a * numVars + b] = sum;
+				}
+
+				double diag = A[a * numVars + a];
+				A[a * numVars + a] += lambda * ((diag > 1e-9) ? diag : 1e-9);
+			}
+
+			if(!SolveLinear(numVars, A, g))
+				break;
+
+			bool moved = false;
+			for(unsigned j = 0; j < numVars; j++)
+			{
+				xTrial[j] = x[j] + g[j] * (d_Variables[j].fMax - d_Variables[j].fMin);
+				if(xTrial[j] < d_Variables[j].fMin) xTrial[j] = d_Variables[j].fMin;
+				if(xTrial[j] > d_Variables[j].fMax) xTrial[j] = d_Variables[j].fMax;
+				if((float)xTrial[j] != (float)x[j])
+					moved = true;
+			}
+
+			// Stuck against the bounds
+			if(!moved)
+				break;
+
+			double trialCost = 0.0;
+			if(Evaluate(fs, xTrial, rTrial, JTrial) && (trialCost = SumOfSquares(rTrial)) < cost)
+			{
+				x.swap(xTrial);
+				r.swap(rTrial);
+				J.swap(JTrial);
+				cost = trialCost;
+				lambda = (lambda > 1e-7) ? lambda * 0.1 : lambda;
+				atBest = true;
+			}
+			else
+			{
+				lambda *= 10.0;
+				atBest = false;
+				if(lambda > 1e10)
+					break;
+			}
+		}
+
+		for(unsigned j = 0; j < numVars; j++)
+			d_Values[j] = (float)x[j];
+	}
+
+	// Leave the flowsheet solved and reported at the best point, with its
+	// own sensitivities.  The targets are checked again on the rounded water.
+	fs.SetSensitivities(saved);
+	for(unsigned j = 0; j < numVars; j++)
+		fs.SetParameter(d_Variables[j].param.blockID, d_Variables[j].param.name, (float)x[j]);
+
+	bool converged = fs.SolveFlowSheet();
+	d_uiNumSolves++;
+	d_ulNumBlockUpdates += fs.GetNumBlockUpdates();
+	return met && converged && TargetsMet(fs);
+}
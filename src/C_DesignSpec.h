@@ -0,0 +1,96 @@
+//======================================================================
+// C_DesignSpec.h
+// Author: James McCormick
+// Description:
+//	Adjusts named block parameters until streams hit their targets, e.g.
+//	the sump add water that gives 35% solids to the HMC pump.
+//
+//	All of the variables are solved for at once with a damped
+//	Gauss-Newton method.  The Jacobian comes from the flowsheet's
+//	sensitivities, so each step costs one solve whatever the number of
+//	variables, and every solve starts from the last one's flows so it
+//	only has to move them as far as the parameters changed.
+//======================================================================
+
+#ifndef _DESIGNSPEC_
+#define _DESIGNSPEC_
+
+#include "C_Flowsheet.h"
+#include <string>
+#include <vector>
+
+// A stream value to hit
+struct S_Target
+{
+	S_StreamKey stream;
+	unsigned char ucQuantity;		// C_Flowsheet::SENS_SOLIDS, SENS_WATER or SENS_PERSOLIDS
+	float fValue;
+	float fTolerance;				// Met when within this of fValue
+};
+
+// A parameter that can be adjusted, kept between fMin and fMax
+struct S_DesignVariable
+{
+	S_ParameterRef param;
+	float fMin;
+	float fMax;
+};
+
+
+class C_DesignSpec
+{
+private:
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	std::vector<S_Target> d_Targets;
+	std::vector<S_DesignVariable> d_Variables;
+
+	unsigned d_uiMaxIterations;
+
+	// Results of the last Solve
+	unsigned d_uiNumIterations;
+	unsigned d_uiNumSolves;
+	unsigned long d_ulNumBlockUpdates;
+	std::vector<float> d_Values;
+
+	// PRIVATE METHODS=========================================================
+
+	// Sets the variables, solves and fills the scaled residuals and Jacobian
+	bool Evaluate(C_Flowsheet& fs, const std::vector<double>& x, std::vector<double>& r, std::vector<double>& J);
+
+	// Are all of the targets met by the last evaluation
+	bool TargetsMet(C_Flowsheet& fs) const;
+
+	float GetValue(C_Flowsheet& fs, const S_Target& t) const;
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_DesignSpec();
+
+	void AddTarget(const S_Target& t) { d_Targets.push_back(t); }
+	void AddTarget(const BlockID& id, const PortNo& port, unsigned char quantity, float value, float tolerance);
+
+	void AddVariable(const S_DesignVariable& v) { d_Variables.push_back(v); }
+	void AddVariable(const BlockID& id, const std::string& name, float min, float max);
+
+	void Clear() { d_Targets.clear(); d_Variables.clear(); }
+
+	void SetMaxIterations(unsigned n) { d_uiMaxIterations = n; }
+
+	// Adjusts the variables on fs, starting from their current values, until
+	// the targets are met.  fs is left solved at the best point found.
+	// Returns true if every target was met, and false without solving if
+	// a target's block or port or a variable's parameter is not on fs.
+	bool Solve(C_Flowsheet& fs);
+
+	// Results of the last Solve
+	unsigned GetNumIterations() const { return d_uiNumIterations; }
+	unsigned GetNumSolves() const { return d_uiNumSolves; }
+	unsigned long GetNumBlockUpdates() const { return d_ulNumBlockUpdates; }
+	float GetVariable(unsigned i) const { return d_Values[i]; }
+};
+
+#endif // _DESIGNSPEC_
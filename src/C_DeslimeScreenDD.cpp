@@ -28,16 +28,17 @@ void C_DeslimeScreenDD::OnParameters(BlockParamsPtr p)
 	d_DeckCutPoints[1] = castParams->d_fCutPoint[1];
 	d_SMPerDeck[0] = castParams->d_fDeckSM[0];
 	d_SMPerDeck[1] = castParams->d_fDeckSM[1];
-	d_AddWater = castParams->d_fWashWater;
+	d_AddWater = WaterFromReport(castParams->d_fWashWater);
+	d_bPartitionValid = false;
 }
 
 
 void C_DeslimeScreenDD::UpdateWater()
 {
-	(d_Ports.GetFlowData(2))->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[0]);
-	(d_Ports.GetFlowData(3))->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[1]);
+	(d_Ports.GetFlowData(2))->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[0], d_SMSeeds[0]);
+	(d_Ports.GetFlowData(3))->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[1], d_SMSeeds[1]);
 	(d_Ports.GetFlowData(1))->d_FluidRate = (d_AddWater + (d_Ports.GetFlowData(0))->d_FluidRate) - (d_Ports.GetFlowData(2))->d_FluidRate - (d_Ports.GetFlowData(3))->d_FluidRate;
-	(d_Ports.GetFlowData(1))->RoundWater();
+	UpdateDrainTangents(2);
 }
 
 
@@ -26,15 +26,16 @@ void C_DeslimeScreenSD::OnParameters(BlockParamsPtr p)
 	
 	d_DeckCutPoints[0] = castParams->d_fCutPoint;
 	d_SMPerDeck[0] = castParams->d_fDeckSM;
-	d_AddWater = castParams->d_fWashWater;
+	d_AddWater = WaterFromReport(castParams->d_fWashWater);
+	d_bPartitionValid = false;
 }
 
 
 void C_DeslimeScreenSD::UpdateWater()
 {
-	(d_Ports.GetFlowData(2))->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[0]);
+	(d_Ports.GetFlowData(2))->CalculateFluidsBasedOnSurfaceMoisture(d_SMPerDeck[0], d_SMSeeds[0]);
 	(d_Ports.GetFlowData(1))->d_FluidRate = (d_AddWater + (d_Ports.GetFlowData(0))->d_FluidRate) - (d_Ports.GetFlowData(2))->d_FluidRate;
-	(d_Ports.GetFlowData(1))->RoundWater();
+	UpdateDrainTangents(2);
 }
 
 
@@ -42,6 +42,9 @@ protected:
 	virtual void UpdateWater();
 	virtual void UpdateSolids();
 
+	// The drain takes the rounding
+	virtual int WaterBalancePort() const { return 1; }
+
 public:
 
 	// PUBLIC DATA MEMBERS=====================================================
@@ -36,9 +36,20 @@ protected:
 	// Stores the incoming surface moisture.
 	float d_fFeedSurfaceMoisture;
 
+	// The solids in each size fraction when they have been set one by one,
+	// e.g. by a reconciliation.  Empty while the feed follows the loaded
+	// size distribution.
+	std::vector<float> d_FractionRates;
+
+	// The sensitivities of d_FractionRates, one row of tangents per fraction
+	std::vector<float> d_RateTangents;
+
 	// Has the feed been defined
 	bool d_bUpdatedFeed;
 
+	// Fills d_FractionRates from the size distribution and the feed rate
+	void SplitFeedRate();
+
 	// Update the feed flowdata before updating
 	//virtual void UpdateFeedData();
 
@@ -62,6 +73,36 @@ public:
 
 	// The size distribution has been updated
 	virtual void OnNewSizeDistribution();
+
+	virtual bool IsFeedBlock() const { return true; }
+
+	// The feed is where the water comes from, so it is rounded as it is
+	virtual void RoundWater() 
+	{ 
+		d_Ports.GetFlowData()->RoundWater(); 
+		d_Ports.UpdatePercentSolids();
+	}
+
+	// Named parameters - "FeedRate", "SurfaceMoisture" and "FractionRate0"
+	// to "FractionRate<n-1>", the solids in each size fraction.  Setting a
+	// fraction's rate moves the feed off the size distribution until the
+	// next one is loaded; the feed rate is then their sum, and setting it
+	// scales them.  "FractionRates" can only be read, as the feed rate.
+	// Differentiating against it gives the sensitivity to every fraction's
+	// rate in one tangent: each fraction's rate only moves its own
+	// fraction, so fraction i of a stream's tangent is the sensitivity to
+	// fraction i of this feed.
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
+
+	// The feed is redistributed with the new seeds on the next update
+	virtual void SetSensitivity(const unsigned short& numTangents, 
+		const std::vector<std::pair<std::string, unsigned short> >& seeds)
+	{
+		I_FSBlock::SetSensitivity(numTangents, seeds);
+		d_bUpdatedFeed = false;
+	}
 };
 
 //-----------------------------------------------------------------------
@@ -92,15 +133,48 @@ inline void C_FeedBlock::UpdateSolids()
 {
 	if(!d_bUpdatedFeed)
 	{
-		float temp = d_fspFSParams->d_sdSizeDistribution.GetTopSize(); 
-		(d_Ports.GetFlowData())->DistributeSolids(temp, 0, d_fFeedSolidRate);
+		const float* fractionsSeed = GetSeed("FractionRates");
+		if(fractionsSeed && d_FractionRates.empty())
+			SplitFeedRate();
+
+		if(d_FractionRates.empty())
+		{
+			float temp = d_fspFSParams->d_sdSizeDistribution.GetTopSize(); 
+			(d_Ports.GetFlowData())->DistributeSolids(temp, 0, d_fFeedSolidRate, GetSeed("FeedRate"));
+		}
+		else if(d_usNumTangents == 0)
+			(d_Ports.GetFlowData())->DistributeSolids(&d_FractionRates[0]);
+		else
+		{
+			// The feed rate scales every fraction, and each fraction's rate
+			// only moves its own fraction
+			const unsigned short numFractions = (unsigned short)d_FractionRates.size();
+			d_RateTangents.assign(numFractions * d_usNumTangents, 0.0f);
+
+			const float* feedSeed = GetSeed("FeedRate");
+			for(unsigned short i = 0; i < numFractions; i++)
+			{
+				float* row = &d_RateTangents[i * d_usNumTangents];
+				const float* seed = GetSeed(IndexedName("FractionRate", i));
+				for(unsigned short k = 0; k < d_usNumTangents; k++)
+				{
+					if(feedSeed && d_fFeedSolidRate != 0.0f)
+						row[k] += feedSeed[k] * d_FractionRates[i] / d_fFeedSolidRate;
+					if(seed)
+						row[k] += seed[k];
+					if(fractionsSeed)
+						row[k] += fractionsSeed[k];
+				}
+			}
+			(d_Ports.GetFlowData())->DistributeSolids(&d_FractionRates[0], &d_RateTangents[0]);
+		}
 		d_bUpdatedFeed = true;
 	}
 }
 
 inline void C_FeedBlock::UpdateWater()
 {
-	(d_Ports.GetFlowData())->CalculateFluidsBasedOnSurfaceMoisture(d_fFeedSurfaceMoisture);
+	(d_Ports.GetFlowData())->CalculateFluidsBasedOnSurfaceMoisture(d_fFeedSurfaceMoisture, GetSeed("SurfaceMoisture"));
 }
 
 
@@ -123,6 +197,7 @@ inline void C_FeedBlock::OnParameters(BlockParamsPtr p)
 
 	d_fFeedSolidRate = castParams->d_feedRate;
 	d_fFeedSurfaceMoisture = castParams->d_surfaceMoisture;
+	d_FractionRates.clear();
 	d_bUpdatedFeed = false;
 }
 
@@ -131,15 +206,123 @@ inline void C_FeedBlock::OnParameters(BlockParamsPtr p)
 // OnNewSizeDistribution - Public C_FeedBlock
 // Description 
 //	Updates the FlowData for this block based on the size distribution.
+//	Rates set for single fractions were for the old grid, so the feed
+//	goes back to following the distribution.
 // 
 // Arguments:	None.
 // Returns:		None.
 //-----------------------------------------------------------------------
 inline void C_FeedBlock::OnNewSizeDistribution()
 {
+	d_FractionRates.clear();
 	d_bUpdatedFeed = false;
 	d_Ports.Reset();
 }
 
 
+
+//-----------------------------------------------------------------------
+// SplitFeedRate - Protected C_FeedBlock
+// Description 
+//	Splits the feed rate into the size fractions the way DistributeSolids
+//	does, so the feed is unchanged when it stops following the size
+//	distribution.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline void C_FeedBlock::SplitFeedRate()
+{
+	const C_SizeDistribution& sd = d_fspFSParams->d_sdSizeDistribution;
+	short start, stop;
+	sd.GetRange(sd.GetTopSize(), 0, start, stop);
+
+	d_FractionRates.assign(sd.GetNumSizeFractions(), 0.0f);
+	for(int i = start; i <= stop; i++)
+		d_FractionRates[i] = sd.GetFractionWt((unsigned short)i) * d_fFeedSolidRate / 100.0f;
+}
+
+
+//-----------------------------------------------------------------------
+// SetParameter - Public C_FeedBlock
+// Description 
+//	Sets the feed rate, surface moisture or the solids in one size
+//	fraction.  The feed is redistributed on the next update.
+// 
+// Arguments:	name - the parameter, value - the new value
+// Returns:		true if the parameter was found.
+//-----------------------------------------------------------------------
+inline bool C_FeedBlock::SetParameter(const std::string& name, const float& value)
+{
+	int fraction;
+	if(name == "FeedRate")
+	{
+		if(!d_FractionRates.empty())
+		{
+			if(d_fFeedSolidRate != 0.0f)
+			{
+				for(size_t i = 0; i < d_FractionRates.size(); i++)
+					d_FractionRates[i] *= value / d_fFeedSolidRate;
+			}
+			else
+				d_FractionRates.clear();
+		}
+		d_fFeedSolidRate = value;
+	}
+	else if(name == "SurfaceMoisture")
+		d_fFeedSurfaceMoisture = value;
+	else if((fraction = ParseIndex(name, "FractionRate", d_fspFSParams->d_sdSizeDistribution.GetNumSizeFractions())) >= 0)
+	{
+		if(d_FractionRates.empty())
+			SplitFeedRate();
+		d_FractionRates[fraction] = value;
+
+		float sum = 0.0f;
+		for(size_t i = 0; i < d_FractionRates.size(); i++)
+			sum += d_FractionRates[i];
+		d_fFeedSolidRate = sum;
+	}
+	else
+		return false;
+
+	d_bUpdatedFeed = false;
+	return true;
+}
+
+inline bool C_FeedBlock::GetParameter(const std::string& name, float& value) const
+{
+	int fraction;
+	if(name == "FeedRate" || name == "FractionRates")
+		value = d_fFeedSolidRate;
+	else if(name == "SurfaceMoisture")
+		value = d_fFeedSurfaceMoisture;
+	else if((fraction = ParseIndex(name, "FractionRate", d_fspFSParams->d_sdSizeDistribution.GetNumSizeFractions())) >= 0)
+	{
+		if(!d_FractionRates.empty())
+			value = d_FractionRates[fraction];
+		else
+		{
+			const C_SizeDistribution& sd = d_fspFSParams->d_sdSizeDistribution;
+			short start, stop;
+			sd.GetRange(sd.GetTopSize(), 0, start, stop);
+			value = (fraction >= start && fraction <= stop) ? 
+				sd.GetFractionWt((unsigned short)fraction) * d_fFeedSolidRate / 100.0f : 0.0f;
+		}
+	}
+	else
+		return false;
+
+	return true;
+}
+
+// The fraction rates are only listed once they have been set, so a copy
+// of a feed that follows the size distribution does too
+inline void C_FeedBlock::GetParameterNames(std::vector<std::string>& names) const
+{
+	names.push_back("FeedRate");
+	names.push_back("SurfaceMoisture");
+	for(size_t i = 0; i < d_FractionRates.size(); i++)
+		names.push_back(IndexedName("FractionRate", (int)i));
+}
+
 #endif // _FEEDBLOCK_
\ No newline at end of file
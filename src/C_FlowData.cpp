@@ -25,13 +25,26 @@ using namespace std;
 //		return (num - rem);
 //}
 
+//-----------------------------------------------------------------------
+// RoundWater - Public C_FlowData
+// Description 
+//	Rounds the fluid rate, as it is reported in m3/h or US gpm, to the
+//	flowsheet's water rounding.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
 void C_FlowData::RoundWater()
 {
-	int rem = ((int)d_FluidRate) % d_fspFSParams->d_iWaterRoundTo;
-	if(rem > (d_fspFSParams->d_iWaterRoundTo / 2))
-		d_FluidRate = ((int)d_FluidRate + d_fspFSParams->d_iWaterRoundTo - rem);
+	const float unit = d_fspFSParams->d_fWaterUnit;
+	const int roundTo = d_fspFSParams->d_iWaterRoundTo;
+	int water = (int)(d_FluidRate * unit);
+	int rem = water % roundTo;
+	if(rem > (roundTo / 2))
+		water += roundTo - rem;
 	else
-		d_FluidRate = (int)d_FluidRate - rem;
+		water -= rem;
+	d_FluidRate = (FlowValue)water / unit;
 }
 
 //-----------------------------------------------------------------------
@@ -45,14 +58,84 @@ void C_FlowData::RoundWater()
 C_FlowData::C_FlowData(const C_FlowData& fd)
 {
 	d_fpSizeFractions = 0;
+	d_bBorrowed = false;
+	d_usNumFractions = 0;
+	d_pKernels = S_FlowKernels::General();
+	d_usFirst = d_usEnd = 0;
+	d_fpTangents = 0;
+	d_usNumTangents = 0;
+	d_fpDensity = 0;
+	d_usNumDensities = 0;
+	d_usDensityStride = 0;
 	SetNumFractions(fd.d_usNumFractions);
 	d_fspFSParams = fd.d_fspFSParams;
 
 	// Copy the array from fd into the current array
-	memcpy(d_fpSizeFractions, fd.d_fpSizeFractions, d_usNumFractions * sizeof(float));
+	memcpy(d_fpSizeFractions, fd.d_fpSizeFractions, d_usNumFractions * sizeof(FlowValue));
+	d_usFirst = fd.d_usFirst;
+	d_usEnd = fd.d_usEnd;
 	d_FluidRate = fd.d_FluidRate;
 	d_SolidRate = fd.d_SolidRate;
 	d_PerSolids = fd.d_PerSolids;
+
+	SetNumTangents(fd.d_usNumTangents);
+	if(d_usNumTangents)
+		memcpy(d_fpTangents, fd.d_fpTangents, d_usNumTangents * TangentStride() * sizeof(FlowValue));
+
+	if(fd.d_fpDensity)
+	{
+		AllocateDensity(fd.d_usNumDensities);
+		memcpy(d_fpDensity, fd.d_fpDensity, d_usNumFractions * d_usDensityStride * sizeof(FlowValue));
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// InitBorrowed - Private C_FlowData
+// Description 
+//	Initializes the flowdata like Init, but on size fractions it does
+//	not own, so a C_PortStore can keep every port's in one array.
+// 
+// Arguments:	params - the flowsheet parameters
+//				fractions - the storage for the size fractions
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::InitBorrowed(FSParamsPtr params, FlowValue* fractions)
+{
+	Clean();
+	d_fspFSParams = params;
+	d_usNumFractions = d_fspFSParams->d_sdSizeDistribution.GetNumSizeFractions();
+	d_pKernels = S_FlowKernels::Select(d_usNumFractions, d_fspFSParams->d_bWideSums);
+	d_fpSizeFractions = fractions;
+	d_bBorrowed = (fractions != 0);
+	d_usFirst = 0;
+	d_usEnd = d_usNumFractions;
+	Zero();
+}
+
+
+//-----------------------------------------------------------------------
+// SetNumTangents - Public C_FlowData
+// Description 
+//	Allocates zeroed storage for the sensitivities to num parameters.
+//	Zero frees it and turns the sensitivities off.
+// 
+// Arguments:	num - the number of parameters
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::SetNumTangents(const unsigned short& num)
+{
+	if(num != d_usNumTangents)
+	{
+		delete [] d_fpTangents;
+		d_fpTangents = 0;
+		d_usNumTangents = num;
+		if(num)
+			d_fpTangents = new FlowValue[num * TangentStride()];
+	}
+
+	if(d_usNumTangents)
+		memset(d_fpTangents, 0, d_usNumTangents * TangentStride() * sizeof(FlowValue));
 }
 
 
@@ -68,7 +151,7 @@ void C_FlowData::PrintFlowData() const
 {
 	cout << "-------------------\n";
 	cout << "SolidsRate: " << d_SolidRate << endl;
-	cout << "FluidsRate: " << d_FluidRate << endl;
+	cout << "FluidsRate: " << GetFluidRate() << endl;
 	cout << "% SOL: " << d_PerSolids << endl;
 
 	for(int i = 0; i < d_usNumFractions; i++)
@@ -98,15 +181,46 @@ C_FlowData& C_FlowData::operator=(const C_FlowData& fd)
 		}
 	}
 
-	// Copy the array from fd into the current array
-	memcpy(d_fpSizeFractions, fd.d_fpSizeFractions, d_usNumFractions * sizeof(float));
-	d_SolidRate = fd.d_SolidRate;
+	CopyBand(fd);
 	d_FluidRate = fd.d_FluidRate;
 	d_PerSolids = fd.d_PerSolids;
+
+	if(d_usNumTangents != fd.d_usNumTangents)
+		SetNumTangents(fd.d_usNumTangents);
+	if(d_usNumTangents)
+		memcpy(d_fpTangents, fd.d_fpTangents, d_usNumTangents * TangentStride() * sizeof(FlowValue));
+
 	return *this;
 }
 
 
+//-----------------------------------------------------------------------
+// SameAs - Public C_FlowData
+// Description 
+//	Compares the contents of fd with the current one.
+// 
+// Arguments:	fd - the flowdata to compare against
+// Returns:		true if they are the same.
+//-----------------------------------------------------------------------
+bool C_FlowData::SameAs(const C_FlowData& fd) const
+{
+	if(d_usNumFractions != fd.d_usNumFractions || d_usNumTangents != fd.d_usNumTangents ||
+		(d_fpDensity == 0) != (fd.d_fpDensity == 0) || d_usNumDensities != fd.d_usNumDensities)
+		return false;
+
+	if(d_SolidRate != fd.d_SolidRate || d_FluidRate != fd.d_FluidRate || d_PerSolids != fd.d_PerSolids)
+		return false;
+
+	if(memcmp(d_fpSizeFractions, fd.d_fpSizeFractions, d_usNumFractions * sizeof(FlowValue)) != 0)
+		return false;
+
+	if(d_usNumTangents && memcmp(d_fpTangents, fd.d_fpTangents, d_usNumTangents * TangentStride() * sizeof(FlowValue)) != 0)
+		return false;
+
+	return !d_fpDensity || memcmp(d_fpDensity, fd.d_fpDensity, d_usNumFractions * d_usDensityStride * sizeof(FlowValue)) == 0;
+}
+
+
 //-----------------------------------------------------------------------
 // operator+= - Public C_FlowData
 // Description 
@@ -119,17 +233,44 @@ C_FlowData& C_FlowData::operator+=(const C_FlowData& fd)
 {
 	if(d_fspFSParams->d_bUpdateSolids)
 	{
-		d_SolidRate = 0.0f;
-		for(int i = 0; i < d_usNumFractions; i++)
+		// Solids without density classes are split by the washability
+		if(fd.d_fpDensity && !d_fpDensity)
+			EnableDensity();
+		if(d_fpDensity)
 		{
-			d_fpSizeFractions[i] += fd.d_fpSizeFractions[i];
-			d_SolidRate += d_fpSizeFractions[i];
+			for(unsigned short i = fd.d_usFirst; i < fd.d_usEnd; i++)
+			{
+				if(fd.d_fpDensity)
+				{
+					FlowValue* row = GetDensityRow(i);
+					const FlowValue* add = fd.GetDensityRow(i);
+					for(unsigned short d = 0; d < d_usDensityStride; d++)
+						row[d] += add[d];
+				}
+				else
+					AddToDensityRow(i, fd.d_fpSizeFractions[i]);
+			}
+		}
+
+		// The sum covers both bands, outside them is zero
+		if(fd.d_usFirst < fd.d_usEnd)
+		{
+			if(fd.d_usFirst < d_usFirst) d_usFirst = fd.d_usFirst;
+			if(fd.d_usEnd > d_usEnd) d_usEnd = fd.d_usEnd;
+		}
+		const unsigned short count = (d_usFirst < d_usEnd) ? d_usEnd - d_usFirst : 0;
+		d_SolidRate = KernelsFor(count)->Add(d_fpSizeFractions + d_usFirst, fd.d_fpSizeFractions + d_usFirst, count);
+
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			FlowValue* t = GetTangent(k);
+			t[d_usNumFractions] = d_pKernels->Add(t, fd.GetTangent(k), d_usNumFractions);
 		}
 	}
 
 	if(d_fspFSParams->d_bUpdateWater)
 	{
-		d_FluidRate += fd.d_FluidRate;
+		AddFluid(fd);
 		UpdatePerSolids();
 	}
 
@@ -137,6 +278,23 @@ C_FlowData& C_FlowData::operator+=(const C_FlowData& fd)
 }
 
 
+//-----------------------------------------------------------------------
+// AddFluid - Public C_FlowData
+// Description 
+//	Adds the fluid rate of fd, and its tangents, to the current one.
+//	The percent solids is left for the caller to update.
+// 
+// Arguments:	fd - the flowdata to take the fluid from.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::AddFluid(const C_FlowData& fd)
+{
+	d_FluidRate += fd.d_FluidRate;
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+		FluidTangent(k) += fd.GetTangent(k)[fd.d_usNumFractions + 1];
+}
+
+
 //-----------------------------------------------------------------------
 // DistrubuteSolids - Public C_FlowData
 // Description 
@@ -145,9 +303,10 @@ C_FlowData& C_FlowData::operator+=(const C_FlowData& fd)
 // Arguments:	pass - the size fraction that is passing
 //				retained - the size fraction that is retained
 //				solidRate - The total amount of solids in the flow 
+//				rateTangent - the sensitivities of solidRate, or null
 // Returns:		none.
 //-----------------------------------------------------------------------
-void C_FlowData::DistributeSolids(const float& pass, const float& retained, const float& solidRate)
+void C_FlowData::DistributeSolids(const float& pass, const float& retained, const float& solidRate, const float* rateTangent)
 {
 	short start, stop;
 
@@ -156,19 +315,76 @@ void C_FlowData::DistributeSolids(const float& pass, const float& retained, cons
 	// Zero the flowdata
 	this->Zero();
 
-	float total = 0.0f;
-
 	for(int i = start; i <= stop; i++)
-	{
 		d_fpSizeFractions[i] = d_fspFSParams->d_sdSizeDistribution.d_sfFractions[i].fFractionalWt * solidRate / 100.0f;
-		total += d_fpSizeFractions[i];
+
+	if(start <= stop)
+	{
+		d_usFirst = (unsigned short)start;
+		d_usEnd = (unsigned short)(stop + 1);
 	}
+	UpdateSolidRate();
+
+	// Feeds carry the density classes whenever there is a washability table
+	if(d_fspFSParams->d_wbWashability.IsMapped())
+		EnableDensity();
 
-	d_SolidRate = total;
+	if(rateTangent)
+	{
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			FlowValue* t = GetTangent(k);
+			for(int i = start; i <= stop; i++)
+			{
+				t[i] = d_fspFSParams->d_sdSizeDistribution.d_sfFractions[i].fFractionalWt * rateTangent[k] / 100.0f;
+				t[d_usNumFractions] += t[i];
+			}
+		}
+	}
 }
 
 
 
+//-----------------------------------------------------------------------
+// DistrubuteSolids - Public C_FlowData
+// Description 
+//	Sets the tph in each size fraction directly, for a feed whose sizing
+//	does not follow the loaded size distribution.
+//
+// Arguments:	rates - the solids in each size fraction
+//				rateTangents - the sensitivities of rates, fraction i's
+//				tangents at i * the number of tangents, or null
+// Returns:		none.
+//-----------------------------------------------------------------------
+void C_FlowData::DistributeSolids(const float* rates, const float* rateTangents)
+{
+	this->Zero();
+
+	for(unsigned short i = 0; i < d_usNumFractions; i++)
+	{
+		if(rates[i] != 0.0f)
+			(*this)[i] = rates[i];
+	}
+	UpdateSolidRate();
+
+	if(d_fspFSParams->d_wbWashability.IsMapped())
+		EnableDensity();
+
+	if(rateTangents)
+	{
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			FlowValue* t = GetTangent(k);
+			for(unsigned short i = 0; i < d_usNumFractions; i++)
+			{
+				t[i] = rateTangents[i * d_usNumTangents + k];
+				t[d_usNumFractions] += t[i];
+			}
+		}
+	}
+}
+
+
 void C_FlowData::CopySolids(const FlowDataPtr fd)
 {
 	if(d_fspFSParams != fd->d_fspFSParams)
@@ -181,10 +397,37 @@ void C_FlowData::CopySolids(const FlowDataPtr fd)
 		}
 	}
 
-	// Copy the array from fd into the current array
-	memcpy(d_fpSizeFractions, fd->d_fpSizeFractions, d_usNumFractions * sizeof(float));
-	d_SolidRate = fd->d_SolidRate;
-	
+	CopyBand(*fd);
+}
+
+
+//-----------------------------------------------------------------------
+// CopyBand - Private C_FlowData
+// Description 
+//	Copies fd's active band of size fractions and density rows.  The
+//	number of fractions must already match.
+// 
+// Arguments:	fd - the flowdata to copy
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::CopyBand(const C_FlowData& fd)
+{
+	if(fd.d_fpDensity)
+	{
+		if(d_usNumDensities != fd.d_usNumDensities || !d_fpDensity)
+			AllocateDensity(fd.d_usNumDensities);
+	}
+	else if(d_fpDensity)
+		DisableDensity();
+
+	SetBand(fd.d_usFirst, fd.d_usEnd);
+	if(d_usFirst < d_usEnd)
+	{
+		memcpy(d_fpSizeFractions + d_usFirst, fd.d_fpSizeFractions + d_usFirst, (d_usEnd - d_usFirst) * sizeof(FlowValue));
+		if(d_fpDensity)
+			memcpy(GetDensityRow(d_usFirst), fd.GetDensityRow(d_usFirst), (d_usEnd - d_usFirst) * d_usDensityStride * sizeof(FlowValue));
+	}
+	d_SolidRate = fd.d_SolidRate;
 }
 	
 
@@ -198,13 +441,438 @@ void C_FlowData::CopyWater(const FlowDataPtr fd)
 void C_FlowData::ZeroSolids()
 {
 	d_SolidRate = 0.0f;
-	// Set the array to zero
-	memset(d_fpSizeFractions, 0, d_usNumFractions * sizeof(float));
+	// Only the active band can be non-zero
+	ZeroBand(d_usFirst, d_usEnd);
+	d_usFirst = d_usNumFractions;
+	d_usEnd = 0;
 
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+		memset(GetTangent(k), 0, (d_usNumFractions + 1) * sizeof(FlowValue));
 }
 
 void C_FlowData::ZeroWater()
 {
 	d_FluidRate = 0.0f;
 	d_PerSolids = 0.0f;
+
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+	{
+		FluidTangent(k) = 0.0f;
+		PerSolidsTangent(k) = 0.0f;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// AllocateDensity - Private C_FlowData
+// Description 
+//	Allocates a zeroed size fraction x density class matrix.  Rows are
+//	padded to a multiple of 8 values and the padding stays zero.
+// 
+// Arguments:	numDensities - the number of density classes
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::AllocateDensity(const unsigned short& numDensities)
+{
+	unsigned short stride = DensityStride(numDensities);
+	if(!d_fpDensity || stride != d_usDensityStride)
+	{
+		DisableDensity();
+		d_fpDensity = new FlowValue[d_usNumFractions * stride];
+		d_usDensityStride = stride;
+	}
+
+	d_usNumDensities = numDensities;
+	memset(d_fpDensity, 0, d_usNumFractions * d_usDensityStride * sizeof(FlowValue));
+}
+
+
+void C_FlowData::DisableDensity()
+{
+	delete [] d_fpDensity;
+	d_fpDensity = 0;
+	d_usNumDensities = 0;
+	d_usDensityStride = 0;
+}
+
+
+void C_FlowData::AddToDensityRow(const unsigned short& i, const FlowValue& mass)
+{
+	const float* split = d_fspFSParams->d_wbWashability.GetFractions(i);
+	FlowValue* row = GetDensityRow(i);
+	for(unsigned short d = 0; d < d_usNumDensities; d++)
+		row[d] += mass * split[d];
+}
+
+
+//-----------------------------------------------------------------------
+// EnableDensity - Public C_FlowData
+// Description 
+//	Splits each size fraction between the density classes by the
+//	washability table.
+// 
+// Arguments:	None.
+// Returns:		false if there is no washability table.
+//-----------------------------------------------------------------------
+bool C_FlowData::EnableDensity()
+{
+	const C_Washability& wb = d_fspFSParams->d_wbWashability;
+	if(!wb.IsMapped())
+		return false;
+
+	AllocateDensity(wb.GetNumDensities());
+	for(unsigned short i = d_usFirst; i < d_usEnd; i++)
+		AddToDensityRow(i, d_fpSizeFractions[i]);
+
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// CopyRows - Public C_FlowData
+// Description 
+//	Copies size fractions first to last, with their density rows, from
+//	src and adds them to the solid rate.  The other fractions are left
+//	alone, so the flowdata is normally zeroed first.
+// 
+// Arguments:	src - the flowdata to copy from
+//				first, last - the size fractions to copy
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::CopyRows(const C_FlowData& src, const short& first, const short& last)
+{
+	if(src.d_fpDensity && !d_fpDensity)
+		AllocateDensity(src.d_usNumDensities);
+	else if(!src.d_fpDensity && d_fpDensity)
+		DisableDensity();
+
+	for(int j = first; j <= last; j++)
+	{
+		d_fpSizeFractions[j] = src.d_fpSizeFractions[j];
+		d_SolidRate += src.d_fpSizeFractions[j];
+	}
+
+	if(last >= first)
+	{
+		if(first < d_usFirst || d_usFirst >= d_usEnd) d_usFirst = (unsigned short)first;
+		if(last >= d_usEnd) d_usEnd = (unsigned short)(last + 1);
+		if(d_fpDensity)
+			memcpy(GetDensityRow(first), src.GetDensityRow(first), (last - first + 1) * d_usDensityStride * sizeof(FlowValue));
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ScaleFrom - Public C_FlowData
+// Description 
+//	Sets the solids to src's multiplied by a factor.
+// 
+// Arguments:	src - the flowdata to scale
+//				factor - the factor
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::ScaleFrom(const C_FlowData& src, const float& factor)
+{
+	if(src.d_fpDensity && (!d_fpDensity || d_usNumDensities != src.d_usNumDensities))
+		AllocateDensity(src.d_usNumDensities);
+	else if(!src.d_fpDensity && d_fpDensity)
+		DisableDensity();
+
+	SetBand(src.d_usFirst, src.d_usEnd);
+	const unsigned short count = (d_usFirst < d_usEnd) ? d_usEnd - d_usFirst : 0;
+	d_SolidRate = KernelsFor(count)->Scale(d_fpSizeFractions + d_usFirst, src.d_fpSizeFractions + d_usFirst, factor, count);
+
+	if(d_fpDensity && count)
+	{
+		const unsigned begin = d_usFirst * d_usDensityStride;
+		const unsigned end = d_usEnd * d_usDensityStride;
+		for(unsigned c = begin; c < end; c++)
+			d_fpDensity[c] = src.d_fpDensity[c] * factor;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ScaleFrom - Public C_FlowData
+// Description 
+//	Sets the solids to src's with each size fraction, and its whole
+//	density row, multiplied by its own factor.  The band is src's less
+//	any zero factors at either end, e.g. outside a screen deck's sizes.
+// 
+// Arguments:	src - the flowdata to scale
+//				factors - a factor per size fraction
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::ScaleFrom(const C_FlowData& src, const float* factors)
+{
+	if(src.d_fpDensity && (!d_fpDensity || d_usNumDensities != src.d_usNumDensities))
+		AllocateDensity(src.d_usNumDensities);
+	else if(!src.d_fpDensity && d_fpDensity)
+		DisableDensity();
+
+	unsigned short first = src.d_usFirst, end = src.d_usEnd;
+	while(first < end && factors[first] == 0.0f)
+		first++;
+	while(end > first && factors[end - 1] == 0.0f)
+		end--;
+
+	SetBand(first, end);
+	const unsigned short count = (first < end) ? end - first : 0;
+	d_SolidRate = KernelsFor(count)->ScaleEach(d_fpSizeFractions + first, src.d_fpSizeFractions + first, factors + first, count);
+
+	if(d_fpDensity)
+	{
+		for(unsigned short i = first; i < end; i++)
+		{
+			FlowValue* row = GetDensityRow(i);
+			const FlowValue* srcRow = src.GetDensityRow(i);
+			const float f = factors[i];
+			for(unsigned short d = 0; d < d_usDensityStride; d++)
+				row[d] = srcRow[d] * f;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ScaleFlow - Public C_FlowData
+// Description 
+//	Multiplies the stream by a factor, e.g. to go between one of a set
+//	of identical units and all of them.  The water is not rounded again.
+// 
+// Arguments:	factor - the factor
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::ScaleFlow(const float& factor)
+{
+	for(unsigned short i = d_usFirst; i < d_usEnd; i++)
+		d_fpSizeFractions[i] *= factor;
+	d_SolidRate *= factor;
+	d_FluidRate *= factor;
+
+	if(d_fpDensity && d_usFirst < d_usEnd)
+	{
+		const unsigned end = d_usEnd * d_usDensityStride;
+		for(unsigned c = d_usFirst * d_usDensityStride; c < end; c++)
+			d_fpDensity[c] *= factor;
+	}
+
+	// Everything but the percent solids tangent scales
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+	{
+		FlowValue* t = GetTangent(k);
+		for(unsigned short i = 0; i < d_usNumFractions + 2; i++)
+			t[i] *= factor;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetToDifference - Public C_FlowData
+// Description 
+//	Sets the solids to a's minus b's, e.g. what is left of a feed after
+//	a split.
+// 
+// Arguments:	a, b - the flowdata
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::SetToDifference(const C_FlowData& a, const C_FlowData& b)
+{
+	if(a.d_fpDensity && (!d_fpDensity || d_usNumDensities != a.d_usNumDensities))
+		AllocateDensity(a.d_usNumDensities);
+	else if(!a.d_fpDensity && d_fpDensity)
+		DisableDensity();
+
+	// The union of the two bands
+	unsigned short first = a.d_usFirst, end = a.d_usEnd;
+	if(b.d_usFirst < b.d_usEnd)
+	{
+		if(first >= end || b.d_usFirst < first) first = b.d_usFirst;
+		if(b.d_usEnd > end) end = b.d_usEnd;
+	}
+
+	SetBand(first, end);
+	const unsigned short count = (first < end) ? end - first : 0;
+	d_SolidRate = KernelsFor(count)->Subtract(d_fpSizeFractions + first, a.d_fpSizeFractions + first, b.d_fpSizeFractions + first, count);
+
+	if(d_fpDensity && count)
+	{
+		if(b.d_fpDensity)
+		{
+			const unsigned cellEnd = end * d_usDensityStride;
+			for(unsigned c = first * d_usDensityStride; c < cellEnd; c++)
+				d_fpDensity[c] = a.d_fpDensity[c] - b.d_fpDensity[c];
+		}
+		else
+		{
+			memcpy(GetDensityRow(first), a.GetDensityRow(first), count * d_usDensityStride * sizeof(FlowValue));
+			for(unsigned short i = first; i < end; i++)
+				AddToDensityRow(i, -b.d_fpSizeFractions[i]);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ScaleCellsFrom - Public C_FlowData
+// Description 
+//	Scales each density cell of src by its own factor, e.g. a partition
+//	curve evaluated at every size and density.  The size fractions are
+//	the row sums.
+// 
+// Arguments:	src - the flowdata to scale, it must carry density
+//				cellFactors - size fractions x density stride factors
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::ScaleCellsFrom(const C_FlowData& src, const float* cellFactors)
+{
+	if(!d_fpDensity || d_usNumDensities != src.d_usNumDensities)
+		AllocateDensity(src.d_usNumDensities);
+
+	SetBand(src.d_usFirst, src.d_usEnd);
+
+	for(unsigned short i = d_usFirst; i < d_usEnd; i++)
+	{
+		FlowValue* row = GetDensityRow(i);
+		const FlowValue* srcRow = src.GetDensityRow(i);
+		const float* f = cellFactors + i * d_usDensityStride;
+		FlowValue sum = 0.0f;
+		for(unsigned short d = 0; d < d_usDensityStride; d++)
+		{
+			row[d] = srcRow[d] * f[d];
+			sum += row[d];
+		}
+		d_fpSizeFractions[i] = sum;
+	}
+	UpdateSolidRate();
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateSolidRate - Public C_FlowData
+// Description 
+//	Sums the active band into the solid rate, in fraction order.  For a
+//	block that writes the size fractions itself.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::UpdateSolidRate()
+{
+	const unsigned short count = (d_usFirst < d_usEnd) ? d_usEnd - d_usFirst : 0;
+	d_SolidRate = KernelsFor(count)->Sum(d_fpSizeFractions + d_usFirst, count);
+}
+
+
+//-----------------------------------------------------------------------
+// SetBand - Private C_FlowData
+// Description 
+//	Moves the active band.  The fractions and density rows of the old
+//	band that are not in the new one are zeroed, the ones in it are left
+//	for the caller to write.
+// 
+// Arguments:	first, end - the new band, end is one past the last
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::SetBand(const unsigned short& first, const unsigned short& end)
+{
+	if(first < end)
+	{
+		ZeroBand(d_usFirst, (first < d_usEnd) ? first : d_usEnd);
+		ZeroBand((end > d_usFirst) ? end : d_usFirst, d_usEnd);
+		d_usFirst = first;
+		d_usEnd = end;
+	}
+	else
+	{
+		ZeroBand(d_usFirst, d_usEnd);
+		d_usFirst = d_usNumFractions;
+		d_usEnd = 0;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ZeroBand - Private C_FlowData
+// Description 
+//	Zeros size fractions first up to end and their density rows.
+// 
+// Arguments:	first, end - the fractions, end is one past the last
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowData::ZeroBand(const unsigned short& first, const unsigned short& end)
+{
+	if(first >= end)
+		return;
+
+	memset(d_fpSizeFractions + first, 0, (end - first) * sizeof(FlowValue));
+	if(d_fpDensity)
+		memset(GetDensityRow(first), 0, (end - first) * d_usDensityStride * sizeof(FlowValue));
+}
+
+
+//-----------------------------------------------------------------------
+// MaxFractionDiff - Private C_FlowData
+// Description 
+//	The largest change in a size fraction between this flowdata and b.
+//	Both are zero outside the union of their bands.  With a relative
+//	tolerance each change is less rel times the larger of the values.
+// 
+// Arguments:	b - the flowdata to compare against
+//				rel - the relative tolerance, 0 for none
+// Returns:		The largest absolute difference, less the relative tolerance.
+//-----------------------------------------------------------------------
+FlowValue C_FlowData::MaxFractionDiff(const C_FlowData& b, const float& rel) const
+{
+	unsigned short first = d_usFirst, end = d_usEnd;
+	if(b.d_usFirst < b.d_usEnd)
+	{
+		if(first >= end || b.d_usFirst < first) first = b.d_usFirst;
+		if(b.d_usEnd > end) end = b.d_usEnd;
+	}
+	if(first >= end)
+		return 0.0f;
+
+	if(rel > 0.0f)
+		return KernelsFor(end - first)->MaxExcess(d_fpSizeFractions + first, b.d_fpSizeFractions + first, rel, end - first);
+	return KernelsFor(end - first)->MaxAbsDiff(d_fpSizeFractions + first, b.d_fpSizeFractions + first, end - first);
+}
+
+
+//-----------------------------------------------------------------------
+// MaxTangentDiff - Private C_FlowData
+// Description 
+//	The largest change in a sensitivity between this flowdata and b.
+//	The fluid rate's is scaled to the report units, like the fluid
+//	rate is when it is checked.  A NaN difference is ignored.
+// 
+// Arguments:	b - the flowdata to compare against
+//				rel - the relative tolerance, 0 for none
+// Returns:		The largest absolute difference, less the relative tolerance.
+//-----------------------------------------------------------------------
+FlowValue C_FlowData::MaxTangentDiff(const C_FlowData& b, const float& rel) const
+{
+	const unsigned short n = d_usNumFractions;
+	const float unit = d_fspFSParams->d_fWaterUnit;
+	FlowValue maxDiff = 0.0f;
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+	{
+		const FlowValue* ta = GetTangent(k);
+		const FlowValue* tb = b.GetTangent(k);
+		for(unsigned short j = 0; j < n + 3; j++)
+		{
+			FlowValue diff = ta[j] - tb[j];
+			if(diff < 0.0f) diff = -diff;
+			if(rel > 0.0f)
+			{
+				FlowValue absA = (ta[j] < 0.0f) ? -ta[j] : ta[j];
+				FlowValue absB = (tb[j] < 0.0f) ? -tb[j] : tb[j];
+				diff -= rel * ((absA > absB) ? absA : absB);
+			}
+			if(j == n + 1)
+				diff *= unit;
+			if(diff > maxDiff) maxDiff = diff;
+		}
+	}
+	return maxDiff;
 }
@@ -11,6 +11,7 @@
 
 #include "C_SmartPointer.h"
 #include "C_FlowSheetParameters.h"
+#include "C_FlowKernels.h"
 #include "Typedefs.h"
 
 class C_FlowData;
@@ -25,34 +26,108 @@ private:
 	FSParamsPtr d_fspFSParams;
 
 	// Stores the solid rate per size fraction
-	float* d_fpSizeFractions;		
+	FlowValue* d_fpSizeFractions;		
+
+	// The size fractions are a row of a C_PortStore, which frees them
+	bool d_bBorrowed;
 
 	// The number of elements in the sizeFraction array
 	unsigned short d_usNumFractions;
 
+	// The loops over the size fractions, compiled for d_usNumFractions if
+	// it is one of the common counts, summing as the flowsheet asks
+	const S_FlowKernels* d_pKernels;
+
+	// The active band of size fractions, d_usFirst up to but not including
+	// d_usEnd.  Every fraction outside it, and its density row, is zero, so
+	// sums, differences and splits only work on the band.  Empty when
+	// d_usFirst >= d_usEnd.  The sensitivities are not banded.
+	unsigned short d_usFirst;
+	unsigned short d_usEnd;
+
+	// The sensitivities of the flow to d_usNumTangents parameters.  Each
+	// parameter has the size fractions followed by the solid rate, fluid
+	// rate and percent solids.  Null unless sensitivities are turned on.
+	FlowValue* d_fpTangents;
+	unsigned short d_usNumTangents;
+
+	// The solids in each size fraction split by density class, for
+	// streams that carry the washability.  Null otherwise.  Each size
+	// fraction is a row padded to a multiple of 8 values so a row can be
+	// worked on as a whole and a density cut runs along every row.
+	FlowValue* d_fpDensity;
+	unsigned short d_usNumDensities;
+	unsigned short d_usDensityStride;
+
 	// PRIVATE METHODS=========================================================
 
 	// Sets the number of fractions and allocates the memory
 	bool SetNumFractions(const unsigned short numFract);
 
+	// Initializes the flowdata on size fractions held by a C_PortStore and
+	// zero's it.  fractions holds the size distribution's fractions.
+	void InitBorrowed(FSParamsPtr params, FlowValue* fractions);
+
 	// Removes any memory allocated
 	void Clean() 
 	{ 
 		if(d_fpSizeFractions != 0)
 		{
-			delete [] d_fpSizeFractions;
+			if(!d_bBorrowed)
+				delete [] d_fpSizeFractions;
+			d_bBorrowed = false;
 			d_fpSizeFractions = 0;
 			d_usNumFractions = 0;
+			d_usFirst = d_usEnd = 0;
 		}
+		SetNumTangents(0);
+		DisableDensity();
 	} 
 
+	// Allocates a zeroed density matrix with the washability's classes
+	void AllocateDensity(const unsigned short& numDensities);
+
+	// Adds mass to size fraction i's density row, split by the washability
+	void AddToDensityRow(const unsigned short& i, const FlowValue& mass);
+
+	// Moves the active band to first..end, zeroing what falls out of it.
+	// The caller then writes every fraction in the new band.
+	void SetBand(const unsigned short& first, const unsigned short& end);
+	void ZeroBand(const unsigned short& first, const unsigned short& end);
+
+	// Copies fd's band of solids, the number of fractions must match
+	void CopyBand(const C_FlowData& fd);
+
+	// The kernels for count fractions, the compiled set if it is all of them
+	const S_FlowKernels* KernelsFor(const unsigned short& count) const
+	{
+		return (count == d_usNumFractions) ? d_pKernels : S_FlowKernels::General(d_pKernels->bWideSums);
+	}
+
+	// The largest change in a size fraction from b, over both bands.  With
+	// rel the change less rel times the larger of the two values.
+	FlowValue MaxFractionDiff(const C_FlowData& b, const float& rel = 0.0f) const;
+
+	// The largest change in a sensitivity from b, the water's in the
+	// report units, less rel times the larger value.  b must have the
+	// same number of tangents.
+	FlowValue MaxTangentDiff(const C_FlowData& b, const float& rel = 0.0f) const;
+
+	// The number of values stored for each tangent
+	unsigned TangentStride() const { return d_usNumFractions + 3; }
+
+	// Fluid rate from percent solids, without the rounding
+	void CalculateFluids(const float& ps);
+	void UpdateFluidTangents(const float& ps, const float* psTangent, const float& sign);
+
 public:
 	// PUBLIC DATA MEMBERS=====================================================
 
 	// Stores the total solid rate
 	SolidsRate d_SolidRate;	
 	
-	// Stores the fluid rate
+	// Stores the fluid rate, in the same mass units as the solids.
+	// GetFluidRate gives it in m3/h or US gpm.
 	FluidRate d_FluidRate;
 
 	// Percent Solids
@@ -87,6 +162,7 @@ public:
 		Zero();
 	}
 
+	// Rounds the fluid rate for reporting.  The solve works on unrounded water.
 	void RoundWater();
 
 	void CopySolids(const FlowDataPtr fd);
@@ -94,8 +170,18 @@ public:
 
 	unsigned short GetNumFractions() const { return d_usNumFractions; }
 
-	// Distributes the solids into the size fractions
-	void DistributeSolids(const float& pass, const float& retained, const float& solidRate);
+	// The fluid rate in the report units
+	FluidRate GetFluidRate() const { return d_FluidRate * d_fspFSParams->d_fWaterUnit; }
+
+	// Distributes the solids into the size fractions.  rateTangent is the sensitivity
+	// of solidRate to each parameter, or null if it has none.
+	void DistributeSolids(const float& pass, const float& retained, const float& solidRate, const float* rateTangent = 0);
+	// Sets the solids in each size fraction to rates[i].  rateTangents, if given,
+	// holds the sensitivities of each fraction's rate, one row of tangents per fraction.
+	void DistributeSolids(const float* rates, const float* rateTangents = 0);
+
+	// Is every value, sensitivities and density cells included, the same as fd's
+	bool SameAs(const C_FlowData& fd) const;
 
 	// Copys the fd variable into the current variable
 	C_FlowData& operator=(const C_FlowData& fd);
@@ -103,13 +189,65 @@ public:
 	// Adds fd to the current variable and stores the result in the current
 	C_FlowData& operator+=(const C_FlowData& fd);
 
-	// Accessors
-	float& operator[] (int i) { return d_fpSizeFractions[i]; }
-	float operator[] (int i) const { return d_fpSizeFractions[i]; }
+	// Adds only the fluid of fd, and its tangents
+	void AddFluid(const C_FlowData& fd);
 
-	// Fluid calculations
-	void CalculateFluidsBasedOnSurfaceMoisture(const float& sm);
-	void CalculateFluidsBasedOnPerSolids(const float& ps);
+	// Accessors.  Writing a fraction widens the active band to take it in.
+	FlowValue& operator[] (int i) 
+	{ 
+		if(i < d_usFirst) d_usFirst = (unsigned short)i;
+		if(i >= d_usEnd) d_usEnd = (unsigned short)(i + 1);
+		return d_fpSizeFractions[i]; 
+	}
+	FlowValue operator[] (int i) const { return d_fpSizeFractions[i]; }
+
+	// The active band, first up to but not including end.  The fractions
+	// outside it are zero.
+	void GetActiveBand(unsigned short& first, unsigned short& end) const { first = d_usFirst; end = d_usEnd; }
+
+	// Fluid calculations.  The tangents are the sensitivities of sm or ps to each
+	// parameter, or null if they have none.
+	void CalculateFluidsBasedOnSurfaceMoisture(const float& sm, const float* smTangent = 0);
+	void CalculateFluidsBasedOnPerSolids(const float& ps, const float* psTangent = 0);
+
+	// Sensitivities
+	void SetNumTangents(const unsigned short& num);
+	unsigned short GetNumTangents() const { return d_usNumTangents; }
+	FlowValue* GetTangent(const unsigned short& k) { return d_fpTangents + k * TangentStride(); }
+	const FlowValue* GetTangent(const unsigned short& k) const { return d_fpTangents + k * TangentStride(); }
+	FlowValue& SolidTangent(const unsigned short& k) { return GetTangent(k)[d_usNumFractions]; }
+	FlowValue& FluidTangent(const unsigned short& k) { return GetTangent(k)[d_usNumFractions + 1]; }
+	FlowValue& PerSolidsTangent(const unsigned short& k) { return GetTangent(k)[d_usNumFractions + 2]; }
+
+	// Density classes
+	bool HasDensity() const { return d_fpDensity != 0; }
+	unsigned short GetNumDensities() const { return d_usNumDensities; }
+	unsigned short GetDensityStride() const { return d_usDensityStride; }
+	FlowValue* GetDensityRow(const unsigned short& i) { return d_fpDensity + i * d_usDensityStride; }
+	const FlowValue* GetDensityRow(const unsigned short& i) const { return d_fpDensity + i * d_usDensityStride; }
+
+	// Splits the solids by the washability table.  Returns false if none is loaded.
+	bool EnableDensity();
+	void DisableDensity();
+
+	// Solids operations that keep the density rows in step with the size
+	// fractions.  The result carries density if src does.
+	// Copies size fractions first to last of src and adds them to the solid rate
+	void CopyRows(const C_FlowData& src, const short& first, const short& last);
+	// Sets the solids to src's times factor, or times factors[i] per size fraction
+	void ScaleFrom(const C_FlowData& src, const float& factor);
+	void ScaleFrom(const C_FlowData& src, const float* factors);
+	// Sets the solids to a minus b
+	void SetToDifference(const C_FlowData& a, const C_FlowData& b);
+	// Multiplies the whole stream, solids, water and sensitivities, by factor.
+	// The percent solids does not change.
+	void ScaleFlow(const float& factor);
+	// Sets every density cell to src's times its own factor, laid out like the
+	// density matrix.  src must carry density.
+	void ScaleCellsFrom(const C_FlowData& src, const float* cellFactors);
+
+	// The padded row length used for numDensities classes
+	static unsigned short DensityStride(const unsigned short& numDensities) { return (unsigned short)((numDensities + 7) & ~7); }
 
 	// Prints the flowdata to the console
 	void PrintFlowData() const;
@@ -117,7 +255,11 @@ public:
 	// Updates the percent solids
 	void UpdatePerSolids();
 
+	// Sums the size fractions into the solid rate
+	void UpdateSolidRate();
+
 	friend class C_BlockPorts;
+	friend class C_PortStore;
 };
 
 //-----------------------------------------------------------------------
@@ -131,7 +273,15 @@ public:
 inline C_FlowData::C_FlowData()
 {
 	d_fpSizeFractions = 0;
+	d_bBorrowed = false;
 	d_usNumFractions = 0;
+	d_pKernels = S_FlowKernels::General();
+	d_usFirst = d_usEnd = 0;
+	d_fpTangents = 0;
+	d_usNumTangents = 0;
+	d_fpDensity = 0;
+	d_usNumDensities = 0;
+	d_usDensityStride = 0;
 	d_PerSolids = 0.0f;
 }
 
@@ -148,7 +298,8 @@ inline bool C_FlowData::SetNumFractions(const unsigned short numFract)
 	if(d_fpSizeFractions) return true;
 
 	d_usNumFractions = numFract; 
-	d_fpSizeFractions = new float[numFract];
+	d_pKernels = S_FlowKernels::Select(numFract, d_fspFSParams->d_bWideSums);
+	d_fpSizeFractions = new FlowValue[numFract];
 
 	if(!d_fpSizeFractions)  // Memory was not allocated
 	{
@@ -156,6 +307,10 @@ inline bool C_FlowData::SetNumFractions(const unsigned short numFract)
 		return false;
 	}
 
+	// Nothing is known about new memory
+	d_usFirst = 0;
+	d_usEnd = numFract;
+
 	return true;
 }
 
@@ -168,11 +323,17 @@ inline bool C_FlowData::SetNumFractions(const unsigned short numFract)
 // Arguments:	sm - surface moisture. as a percent
 // Returns:		None.
 //-----------------------------------------------------------------------
-inline void C_FlowData::CalculateFluidsBasedOnSurfaceMoisture(const float& sm)
+inline void C_FlowData::CalculateFluidsBasedOnSurfaceMoisture(const float& sm, const float* smTangent)
 {
 	float ps = 1 - sm;
 
-	this->CalculateFluidsBasedOnPerSolids(ps);
+	CalculateFluids(ps);
+
+	// d(ps) = -d(sm)
+	if(d_usNumTangents)
+		UpdateFluidTangents(ps, smTangent, -1.0f);
+
+	d_PerSolids = ps;
 }
 
 //-----------------------------------------------------------------------
@@ -183,19 +344,53 @@ inline void C_FlowData::CalculateFluidsBasedOnSurfaceMoisture(const float& sm)
 // Arguments:	ps - percent solids. as a percent.
 // Returns:		None.
 //-----------------------------------------------------------------------
-inline void C_FlowData::CalculateFluidsBasedOnPerSolids(const float& ps)
+inline void C_FlowData::CalculateFluidsBasedOnPerSolids(const float& ps, const float* psTangent)
 {
-	if(d_fspFSParams->d_bMetric)
-		d_FluidRate = ((d_SolidRate / ps) - d_SolidRate);
-	else
-		d_FluidRate = ((d_SolidRate / ps) - d_SolidRate) * 4;
+	CalculateFluids(ps);
 
-	RoundWater();
+	if(d_usNumTangents)
+		UpdateFluidTangents(ps, psTangent, 1.0f);
 
 	d_PerSolids = ps;
 }
 
 
+//-----------------------------------------------------------------------
+// CalculateFluids - Private C_FlowData
+// Description 
+//	Calculates the fluid rate from the solids and percent solids.
+// 
+// Arguments:	ps - percent solids. as a percent.
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline void C_FlowData::CalculateFluids(const float& ps)
+{
+	d_FluidRate = ((d_SolidRate / ps) - d_SolidRate);
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateFluidTangents - Private C_FlowData
+// Description 
+//	d(fluid) = dS / ps - S * dps / ps^2 - dS.
+// 
+// Arguments:	ps - percent solids
+//				psTangent - sensitivities of ps, or null if it has none
+//				sign - multiplies psTangent
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline void C_FlowData::UpdateFluidTangents(const float& ps, const float* psTangent, const float& sign)
+{
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+	{
+		float dps = psTangent ? sign * psTangent[k] : 0.0f;
+		FlowValue dS = SolidTangent(k);
+		FluidTangent(k) = dS / ps - d_SolidRate * dps / (ps * ps) - dS;
+		PerSolidsTangent(k) = dps;
+	}
+}
+
+
 //-----------------------------------------------------------------------
 // UpdatePerSolids - Private C_FlowData
 // Description 
@@ -206,10 +401,19 @@ inline void C_FlowData::CalculateFluidsBasedOnPerSolids(const float& ps)
 //-----------------------------------------------------------------------
 inline void C_FlowData::UpdatePerSolids()
 {
-	if(d_fspFSParams->d_bMetric)
-		d_PerSolids = d_SolidRate / (d_SolidRate + d_FluidRate);
-	else
-		d_PerSolids = d_SolidRate / (d_SolidRate + (d_FluidRate / 4));
+	d_PerSolids = d_SolidRate / (d_SolidRate + d_FluidRate);
+
+	// ps = S / (S + F) so d(ps) = (dS * F - S * dF) / (S + F)^2
+	if(d_usNumTangents)
+	{
+		FlowValue total = d_SolidRate + d_FluidRate;
+		FlowValue denom = total * total;
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			PerSolidsTangent(k) = (denom != 0.0f) ? 
+				(SolidTangent(k) * d_FluidRate - d_SolidRate * FluidTangent(k)) / denom : 0.0f;
+		}
+	}
 }
 
 
@@ -0,0 +1,135 @@
+//======================================================================
+// C_FlowKernels.cpp
+// Author: James McCormick
+// Description:
+//	The general loops and the table of fixed size sets.
+//======================================================================
+
+#include "C_FlowKernels.h"
+
+
+template<typename Acc>
+static FlowValue SumGeneral(const FlowValue* a, const unsigned short& n)
+{
+	Acc total = 0.0f;
+	for(unsigned short i = 0; i < n; i++)
+		total += a[i];
+	return (FlowValue)total;
+}
+
+template<typename Acc>
+static FlowValue AddGeneral(FlowValue* dst, const FlowValue* src, const unsigned short& n)
+{
+	for(unsigned short i = 0; i < n; i++)
+		dst[i] += src[i];
+	return SumGeneral<Acc>(dst, n);
+}
+
+template<typename Acc>
+static FlowValue ScaleGeneral(FlowValue* dst, const FlowValue* src, const float& factor, const unsigned short& n)
+{
+	const FlowValue f = factor;
+	for(unsigned short i = 0; i < n; i++)
+		dst[i] = src[i] * f;
+	return SumGeneral<Acc>(dst, n);
+}
+
+template<typename Acc>
+static FlowValue ScaleEachGeneral(FlowValue* dst, const FlowValue* src, const float* factors, const unsigned short& n)
+{
+	for(unsigned short i = 0; i < n; i++)
+		dst[i] = src[i] * factors[i];
+	return SumGeneral<Acc>(dst, n);
+}
+
+template<typename Acc>
+static FlowValue SubtractGeneral(FlowValue* dst, const FlowValue* a, const FlowValue* b, const unsigned short& n)
+{
+	for(unsigned short i = 0; i < n; i++)
+		dst[i] = a[i] - b[i];
+	return SumGeneral<Acc>(dst, n);
+}
+
+static FlowValue MaxAbsDiffGeneral(const FlowValue* a, const FlowValue* b, const unsigned short& n)
+{
+	FlowValue maxDiff = 0.0f;
+	for(unsigned short i = 0; i < n; i++)
+	{
+		FlowValue diff = a[i] - b[i];
+		diff = (diff < 0.0f) ? -diff : diff;
+		maxDiff = (diff > maxDiff) ? diff : maxDiff;
+	}
+	return maxDiff;
+}
+
+static FlowValue MaxExcessGeneral(const FlowValue* a, const FlowValue* b, const float& rel, const unsigned short& n)
+{
+	const FlowValue r = rel;
+	FlowValue maxExcess = 0.0f;
+	for(unsigned short i = 0; i < n; i++)
+	{
+		FlowValue diff = a[i] - b[i];
+		FlowValue absA = (a[i] < 0.0f) ? -a[i] : a[i];
+		FlowValue absB = (b[i] < 0.0f) ? -b[i] : b[i];
+		diff = (diff < 0.0f) ? -diff : diff;
+		FlowValue excess = diff - r * ((absA > absB) ? absA : absB);
+		maxExcess = (excess > maxExcess) ? excess : maxExcess;
+	}
+	return maxExcess;
+}
+
+
+//-----------------------------------------------------------------------
+// General - Public S_FlowKernels
+// Description 
+//	The loops for any number of fractions.
+// 
+// Arguments:	wideSums - sum in double rather than the stored type
+// Returns:		The kernels to use.
+//-----------------------------------------------------------------------
+const S_FlowKernels* S_FlowKernels::General(const bool& wideSums)
+{
+	static const S_FlowKernels kernels = { 0, sizeof(FlowValue) == sizeof(double), 
+		SumGeneral<FlowValue>, AddGeneral<FlowValue>, ScaleGeneral<FlowValue>, ScaleEachGeneral<FlowValue>, 
+		SubtractGeneral<FlowValue>, MaxAbsDiffGeneral, MaxExcessGeneral };
+	static const S_FlowKernels wide = { 0, true, 
+		SumGeneral<double>, AddGeneral<double>, ScaleGeneral<double>, ScaleEachGeneral<double>, 
+		SubtractGeneral<double>, MaxAbsDiffGeneral, MaxExcessGeneral };
+	return wideSums ? &wide : &kernels;
+}
+
+
+//-----------------------------------------------------------------------
+// Select - Public S_FlowKernels
+// Description 
+//	Picks the set compiled for the number of fractions.  The sizes are
+//	the sieve series in common use; add a case to compile another.
+// 
+// Arguments:	n - the number of size fractions
+//				wideSums - sum in double rather than the stored type
+// Returns:		The kernels to use.
+//-----------------------------------------------------------------------
+const S_FlowKernels* S_FlowKernels::Select(const unsigned short& n, const bool& wideSums)
+{
+	if(wideSums)
+	{
+		switch(n)
+		{
+			case 16:	return &C_FixedFlowKernels<16, double>::Kernels();
+			case 25:	return &C_FixedFlowKernels<25, double>::Kernels();
+			case 32:	return &C_FixedFlowKernels<32, double>::Kernels();
+			case 64:	return &C_FixedFlowKernels<64, double>::Kernels();
+		}
+	}
+	else
+	{
+		switch(n)
+		{
+			case 16:	return &C_FixedFlowKernels<16, FlowValue>::Kernels();
+			case 25:	return &C_FixedFlowKernels<25, FlowValue>::Kernels();
+			case 32:	return &C_FixedFlowKernels<32, FlowValue>::Kernels();
+			case 64:	return &C_FixedFlowKernels<64, FlowValue>::Kernels();
+		}
+	}
+	return General(wideSums);
+}
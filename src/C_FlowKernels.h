@@ -0,0 +1,134 @@
+//======================================================================
+// C_FlowKernels.h
+// Author: James McCormick
+// Description:
+//	The loops over the size fractions that the solve spends its time
+//	in.  Each set is compiled for a fixed number of fractions, so the
+//	loops have a known trip count and are unrolled and vectorized, with
+//	a general set for any other count.  C_FlowData picks the set that
+//	matches its number of fractions when it is allocated.
+//
+//	The element by element work is done first and the rate summed after
+//	in fraction order, so every set gives the same answer to the bit.
+//	Each size comes in two sets, one summing in the type the flows are
+//	stored in and one summing in double.
+//======================================================================
+
+#ifndef _FLOWKERNELS_
+#define _FLOWKERNELS_
+
+#include "Typedefs.h"
+
+struct S_FlowKernels
+{
+	// The number of fractions the set is compiled for, 0 for the general set
+	unsigned short usNumFractions;
+
+	// Are the sums done in double
+	bool bWideSums;
+
+	// The sum of a
+	FlowValue (*Sum)(const FlowValue* a, const unsigned short& n);
+
+	// dst += src.  Returns the sum of dst.
+	FlowValue (*Add)(FlowValue* dst, const FlowValue* src, const unsigned short& n);
+
+	// dst = src * factor.  Returns the sum of dst.
+	FlowValue (*Scale)(FlowValue* dst, const FlowValue* src, const float& factor, const unsigned short& n);
+
+	// dst = src * factors, fraction by fraction.  Returns the sum of dst.
+	FlowValue (*ScaleEach)(FlowValue* dst, const FlowValue* src, const float* factors, const unsigned short& n);
+
+	// dst = a - b.  Returns the sum of dst.
+	FlowValue (*Subtract)(FlowValue* dst, const FlowValue* a, const FlowValue* b, const unsigned short& n);
+
+	// The largest |a - b|.  A NaN difference is ignored.
+	FlowValue (*MaxAbsDiff)(const FlowValue* a, const FlowValue* b, const unsigned short& n);
+
+	// The largest |a - b| - rel * max(|a|, |b|), what a change is over a
+	// relative tolerance.  A NaN difference is ignored.
+	FlowValue (*MaxExcess)(const FlowValue* a, const FlowValue* b, const float& rel, const unsigned short& n);
+
+	// The set compiled for n fractions, or the general one
+	static const S_FlowKernels* Select(const unsigned short& n, const bool& wideSums = false);
+	static const S_FlowKernels* General(const bool& wideSums = false);
+};
+
+
+// The loops with the trip count fixed at N, summing in Acc.  n is ignored.
+template<unsigned short N, typename Acc>
+struct C_FixedFlowKernels
+{
+	static FlowValue Sum(const FlowValue* a, const unsigned short& = N)
+	{
+		Acc total = 0.0f;
+		for(unsigned short i = 0; i < N; i++)
+			total += a[i];
+		return (FlowValue)total;
+	}
+
+	static FlowValue Add(FlowValue* dst, const FlowValue* src, const unsigned short&)
+	{
+		for(unsigned short i = 0; i < N; i++)
+			dst[i] += src[i];
+		return Sum(dst);
+	}
+
+	static FlowValue Scale(FlowValue* dst, const FlowValue* src, const float& factor, const unsigned short&)
+	{
+		const FlowValue f = factor;
+		for(unsigned short i = 0; i < N; i++)
+			dst[i] = src[i] * f;
+		return Sum(dst);
+	}
+
+	static FlowValue ScaleEach(FlowValue* dst, const FlowValue* src, const float* factors, const unsigned short&)
+	{
+		for(unsigned short i = 0; i < N; i++)
+			dst[i] = src[i] * factors[i];
+		return Sum(dst);
+	}
+
+	static FlowValue Subtract(FlowValue* dst, const FlowValue* a, const FlowValue* b, const unsigned short&)
+	{
+		for(unsigned short i = 0; i < N; i++)
+			dst[i] = a[i] - b[i];
+		return Sum(dst);
+	}
+
+	static FlowValue MaxAbsDiff(const FlowValue* a, const FlowValue* b, const unsigned short&)
+	{
+		FlowValue maxDiff = 0.0f;
+		for(unsigned short i = 0; i < N; i++)
+		{
+			FlowValue diff = a[i] - b[i];
+			diff = (diff < 0.0f) ? -diff : diff;
+			maxDiff = (diff > maxDiff) ? diff : maxDiff;
+		}
+		return maxDiff;
+	}
+
+	static FlowValue MaxExcess(const FlowValue* a, const FlowValue* b, const float& rel, const unsigned short&)
+	{
+		const FlowValue r = rel;
+		FlowValue maxExcess = 0.0f;
+		for(unsigned short i = 0; i < N; i++)
+		{
+			FlowValue diff = a[i] - b[i];
+			FlowValue absA = (a[i] < 0.0f) ? -a[i] : a[i];
+			FlowValue absB = (b[i] < 0.0f) ? -b[i] : b[i];
+			diff = (diff < 0.0f) ? -diff : diff;
+			FlowValue excess = diff - r * ((absA > absB) ? absA : absB);
+			maxExcess = (excess > maxExcess) ? excess : maxExcess;
+		}
+		return maxExcess;
+	}
+
+	static const S_FlowKernels& Kernels()
+	{
+		static const S_FlowKernels kernels = { N, sizeof(Acc) == sizeof(double), Sum, Add, Scale, ScaleEach, Subtract, MaxAbsDiff, MaxExcess };
+		return kernels;
+	}
+};
+
+#endif // _FLOWKERNELS_
@@ -10,6 +10,8 @@
 #define _FLOWSHEETPARAMS_
 
 #include "C_SizeDistribution.h"
+#include "C_Washability.h"
+#include "C_PartitionNumbers.h"
 #include "C_SmartPointer.h"
 
 class S_FlowSheetParams : public C_SmartPointerObject
@@ -19,7 +21,13 @@ public:
 	bool d_bUpdateWater;					// Tell the blocks to update the water
 	bool d_bUpdateSolids;					// Tell the blocks to update the solids
 	bool d_bMetric;							// States if metric units are to be used
+	float d_fWaterUnit;						// Reported water per unit of water held: 1 for m3/h, 4 for US gpm
 	C_SizeDistribution d_sdSizeDistribution;	// The flowsheet size distribution
+	C_Washability d_wbWashability;			// Density classes of the feed, if any
+	PartitionNumbersPtr d_PartitionNumbers;	// Partition tables shared between flowsheets, if any
+	unsigned d_uiGridVersion;				// Changes whenever the size distribution does
+	bool d_bMemoize;						// Blocks skip updates when nothing has changed
+	bool d_bWideSums;						// Sum the size fractions into the rates in double
 };
 
 typedef C_SmartPointer<S_FlowSheetParams> FSParamsPtr;
@@ -100,137 +100,1279 @@ void C_Flowsheet::DeleteSourceLink(const BlockID& from, const BlockID& to, const
 // Description 
 //	Sums the sources data for a block.
 // 
-// Arguments:	feedList - The source list for a block
+// Arguments:	sources - The resolved sources for a block
 //				dest - A pointer to the FlowData to store the sum
 // Returns:		none
 //-----------------------------------------------------------------------
-void C_Flowsheet::SumSources(FeedSourceList& feedList, C_FlowData* const fd)
+void C_Flowsheet::SumSources(const SourceArray& sources, C_FlowData* const fd)
 {
-	FeedSourceListIterator feedItr = feedList.begin();
-	FeedSourceListIterator feedItrEnd = feedList.end();
+	if(d_fspFSParams->d_bUpdateSolids)
+		fd->ZeroSolids();
+	if(d_fspFSParams->d_bUpdateWater)
+		fd->ZeroWater();
+
+	for(size_t i = 0; i < sources.size(); i++)
+		(*fd) += (*sources[i]);
+}
+
+
+//-----------------------------------------------------------------------
+// CompileSchedule - Private C_Flowsheet
+// Description 
+//	Resolves the source lists into flowdata pointers and groups the
+//	blocks into dependency levels.  A depth first search in BlockID order
+//	finds the links that close a recycle; those are read from the
+//	previous sweep when running in parallel and are ignored when the
+//	levels are assigned.  Every other link points to a lower level.
+//
+//	Only the blocks fed from a feed block, and the ones sending anything
+//	to them, are solved.  Of those, the ones with no recycle downstream
+//	are left out of the sweeps and updated once after convergence, as
+//	nothing in the loop reads them.  The rest are zeroed.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::CompileSchedule()
+{
+	// The sources below point at the ports where they will stay
+	PackPorts();
+
+	d_Schedule.clear();
+	d_Levels.clear();
+	d_AfterLevels.clear();
+	d_LevelOrder.clear();
+	d_LoopOrder.clear();
+	d_Analysis = S_GraphAnalysis();
+
+	// The non-feed blocks are scheduled in BlockID order
+	std::map<BlockID, unsigned> index;
+	BlockMapIterator blockItr = d_BlockMap.begin();
+	BlockMapIterator blockItrEnd = d_BlockMap.end();
+	while(blockItr != blockItrEnd)
+	{
+		if(blockItr->second != NULL && !blockItr->second->IsFeedBlock())
+		{
+			index[blockItr->first] = (unsigned)d_Schedule.size();
+			d_Schedule.push_back(S_ScheduledBlock());
+			S_ScheduledBlock& sb = d_Schedule.back();
+			sb.blkPointer = blockItr->second;
+			sb.ucRole = ROLE_UNREACHABLE;
+			sb.bConverged = false;
+			FS_PROFILE( sb.fResidual = 0.0f; )
+		}
+		blockItr++;
+	}
+
+	const unsigned numBlocks = (unsigned)d_Schedule.size();
+
+	// The scheduled sources of each block, -1 for a feed block
+	std::vector< std::vector<int> > sourceIndex(numBlocks);
+	std::vector< std::vector<unsigned> > successors(numBlocks);
+	for(unsigned i = 0; i < numBlocks; i++)
+	{
+		FeedSourceList& feedList = d_SourceMap[d_Schedule[i].blkPointer->GetBlockID()];
+		FeedSourceListIterator feedItr = feedList.begin();
+		FeedSourceListIterator feedItrEnd = feedList.end();
+		while(feedItr != feedItrEnd)
+		{
+			if(feedItr->blkPointer != NULL)
+			{
+				std::map<BlockID, unsigned>::iterator found = index.find(feedItr->blkPointer->GetBlockID());
+				if(found == index.end())
+					sourceIndex[i].push_back(-1);
+				else
+				{
+					sourceIndex[i].push_back((int)found->second);
+					successors[found->second].push_back(i);
+				}
+			}
+			feedItr++;
+		}
+	}
+
+	// Find the recycle links with an iterative depth first search
+	enum { WHITE = 0, GREY, BLACK };
+	std::vector<char> colour(numBlocks, WHITE);
+	std::vector< std::vector<bool> > isBack(numBlocks);
+	for(unsigned i = 0; i < numBlocks; i++)
+		isBack[i].assign(successors[i].size(), false);
+
+	std::vector< std::pair<unsigned, unsigned> > stack;
+	for(unsigned root = 0; root < numBlocks; root++)
+	{
+		if(colour[root] != WHITE)
+			continue;
+
+		colour[root] = GREY;
+		stack.push_back(std::make_pair(root, 0u));
+		while(!stack.empty())
+		{
+			unsigned node = stack.back().first;
+			unsigned& edge = stack.back().second;
+			if(edge == successors[node].size())
+			{
+				colour[node] = BLACK;
+				stack.pop_back();
+				continue;
+			}
+
+			unsigned next = successors[node][edge];
+			if(colour[next] == GREY)
+				isBack[node][edge] = true;
+			edge++;
+
+			if(colour[next] == WHITE)
+			{
+				colour[next] = GREY;
+				stack.push_back(std::make_pair(next, 0u));
+			}
+		}
+	}
+
+	// A source is lagged if any link from it to this block closes a recycle
+	std::vector< std::vector<unsigned> > laggedFrom(numBlocks);
+	for(unsigned i = 0; i < numBlocks; i++)
+		for(size_t e = 0; e < successors[i].size(); e++)
+			if(isBack[i][e])
+				laggedFrom[successors[i][e]].push_back(i);
+
+	// Longest path levels over the forward links (Kahn's algorithm)
+	std::vector<unsigned> level(numBlocks, 0);
+	std::vector<unsigned> inDegree(numBlocks, 0);
+	for(unsigned i = 0; i < numBlocks; i++)
+		for(size_t e = 0; e < successors[i].size(); e++)
+			if(!isBack[i][e])
+				inDegree[successors[i][e]]++;
+
+	std::vector<unsigned> ready;
+	for(unsigned i = 0; i < numBlocks; i++)
+		if(inDegree[i] == 0)
+			ready.push_back(i);
+
+	unsigned numLevels = 0;
+	for(size_t r = 0; r < ready.size(); r++)
+	{
+		unsigned node = ready[r];
+		if(level[node] + 1 > numLevels)
+			numLevels = level[node] + 1;
+
+		for(size_t e = 0; e < successors[node].size(); e++)
+		{
+			if(isBack[node][e])
+				continue;
+			unsigned next = successors[node][e];
+			if(level[node] + 1 > level[next])
+				level[next] = level[node] + 1;
+			if(--inDegree[next] == 0)
+				ready.push_back(next);
+		}
+	}
+
+	// Live blocks are downstream of a feed block, or upstream of one that is
+	std::vector<unsigned> work;
+	for(unsigned i = 0; i < numBlocks; i++)
+	{
+		for(size_t s = 0; s < sourceIndex[i].size(); s++)
+		{
+			if(sourceIndex[i][s] < 0)
+			{
+				d_Schedule[i].ucRole = ROLE_LOOP;
+				work.push_back(i);
+				break;
+			}
+		}
+	}
+	for(size_t w = 0; w < work.size(); w++)
+	{
+		for(size_t e = 0; e < successors[work[w]].size(); e++)
+		{
+			unsigned next = successors[work[w]][e];
+			if(d_Schedule[next].ucRole == ROLE_UNREACHABLE)
+			{
+				d_Schedule[next].ucRole = ROLE_LOOP;
+				work.push_back(next);
+			}
+		}
+	}
+	for(size_t w = 0; w < work.size(); w++)
+	{
+		for(size_t s = 0; s < sourceIndex[work[w]].size(); s++)
+		{
+			int src = sourceIndex[work[w]][s];
+			if(src >= 0 && d_Schedule[src].ucRole == ROLE_UNREACHABLE)
+			{
+				d_Schedule[src].ucRole = ROLE_LOOP;
+				work.push_back((unsigned)src);
+			}
+		}
+	}
+
+	// A live block is updated after convergence when all of its live
+	// destinations are, starting from the ones that feed nothing.  Blocks
+	// in a recycle never get there.
+	std::vector<unsigned> remaining(numBlocks, 0);
+	work.clear();
+	for(unsigned i = 0; i < numBlocks; i++)
+	{
+		if(d_Schedule[i].ucRole == ROLE_UNREACHABLE)
+			continue;
+		for(size_t e = 0; e < successors[i].size(); e++)
+			if(d_Schedule[successors[i][e]].ucRole != ROLE_UNREACHABLE)
+				remaining[i]++;
+		if(remaining[i] == 0)
+			work.push_back(i);
+	}
+	for(size_t w = 0; w < work.size(); w++)
+	{
+		d_Schedule[work[w]].ucRole = ROLE_AFTER;
+		for(size_t s = 0; s < sourceIndex[work[w]].size(); s++)
+		{
+			int src = sourceIndex[work[w]][s];
+			if(src >= 0 && --remaining[src] == 0)
+				work.push_back((unsigned)src);
+		}
+	}
+
+	for(unsigned i = 0; i < numBlocks; i++)
+	{
+		S_ScheduledBlock& sb = d_Schedule[i];
+		if(sb.ucRole == ROLE_LOOP)
+		{
+			sb.previous = new C_BlockPorts(sb.blkPointer->GetPorts());
+			d_LoopOrder.push_back(i);
+		}
+		else if(sb.ucRole == ROLE_AFTER)
+			d_Analysis.afterConvergence.push_back(sb.blkPointer->GetBlockID());
+		else
+		{
+			// Left over from before it was cut off
+			sb.blkPointer->GetPorts().Zero();
+			sb.blkPointer->InvalidateMemo();
+			d_Analysis.unreachable.push_back(sb.blkPointer->GetBlockID());
+		}
+	}
+
+	// Resolve the sources now that the recycle links are known
+	for(unsigned i = 0; i < numBlocks; i++)
+	{
+		S_ScheduledBlock& sb = d_Schedule[i];
+		if(sb.ucRole == ROLE_UNREACHABLE)
+			continue;
+		FeedSourceList& feedList = d_SourceMap[sb.blkPointer->GetBlockID()];
+		FeedSourceListIterator feedItr = feedList.begin();
+		FeedSourceListIterator feedItrEnd = feedList.end();
+		unsigned s = 0;
+		while(feedItr != feedItrEnd)
+		{
+			if(feedItr->blkPointer != NULL)
+			{
+				C_FlowData* live = feedItr->blkPointer->GetFlowData(feedItr->usPort);
+				C_FlowData* lagged = live;
+
+				int src = sourceIndex[i][s++];
+				if(src >= 0)
+				{
+					for(size_t l = 0; l < laggedFrom[i].size(); l++)
+						if(laggedFrom[i][l] == (unsigned)src)
+							lagged = d_Schedule[src].previous->GetFlowData(feedItr->usPort);
+				}
+
+				sb.liveSources.push_back(live);
+				sb.laggedSources.push_back(lagged);
+			}
+			feedItr++;
+		}
+	}
+
+	GroupLevels(level, numLevels, ROLE_LOOP, d_Levels);
+	GroupLevels(level, numLevels, ROLE_AFTER, d_AfterLevels);
+
+	FindUnconnectedPorts();
+
+	d_bScheduleValid = true;
+}
+
+
+//-----------------------------------------------------------------------
+// GroupLevels - Private C_Flowsheet
+// Description 
+//	Groups the blocks with a role by level, parallel blocks first,
+//	keeping BlockID order within each group.
+// 
+// Arguments:	level - the level of each scheduled block
+//				numLevels - one more than the highest level
+//				role - the blocks to group
+//				levels - the list to add the non-empty levels to
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::GroupLevels(const std::vector<unsigned>& level, unsigned numLevels, unsigned char role, LevelList& levels)
+{
+	const unsigned numBlocks = (unsigned)d_Schedule.size();
+	for(unsigned l = 0; l < numLevels; l++)
+	{
+		S_Level group;
+		group.uiFirst = (unsigned)d_LevelOrder.size();
+		group.uiNumParallel = 0;
+		group.uiNumSerial = 0;
+
+		for(unsigned i = 0; i < numBlocks; i++)
+		{
+			if(level[i] == l && d_Schedule[i].ucRole == role && !d_Schedule[i].blkPointer->IsReportBlock())
+			{
+				d_LevelOrder.push_back(i);
+				group.uiNumParallel++;
+			}
+		}
+		for(unsigned i = 0; i < numBlocks; i++)
+		{
+			if(level[i] == l && d_Schedule[i].ucRole == role && d_Schedule[i].blkPointer->IsReportBlock())
+			{
+				d_LevelOrder.push_back(i);
+				group.uiNumSerial++;
+			}
+		}
+
+		if(group.uiNumParallel + group.uiNumSerial)
+			levels.push_back(group);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// FindUnconnectedPorts - Private C_Flowsheet
+// Description 
+//	Lists the ports that are not linked.  The output ports are every port
+//	after the first, or the only one on a single port block.  Report
+//	blocks are meant to be the end of the line and are left out.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::FindUnconnectedPorts()
+{
+	std::map<BlockID, std::vector<bool> > linked;
+	for(SourceMap::iterator srcItr = d_SourceMap.begin(); srcItr != d_SourceMap.end(); srcItr++)
+	{
+		for(FeedSourceListIterator feedItr = srcItr->second.begin(); feedItr != srcItr->second.end(); feedItr++)
+		{
+			if(feedItr->blkPointer == NULL)
+				continue;
+			std::vector<bool>& ports = linked[feedItr->blkPointer->GetBlockID()];
+			if(ports.size() <= feedItr->usPort)
+				ports.resize(feedItr->usPort + 1, false);
+			ports[feedItr->usPort] = true;
+		}
+	}
+
+	for(BlockMapIterator blockItr = d_BlockMap.begin(); blockItr != d_BlockMap.end(); blockItr++)
+	{
+		BlockPtr block = blockItr->second;
+		if(block == NULL || block->IsReportBlock())
+			continue;
+
+		S_StreamKey key;
+		key.blockID = blockItr->first;
+
+		const PortNo numPorts = block->GetPorts().GetNumPorts();
+		SourceMap::iterator sources = d_SourceMap.find(blockItr->first);
+		const bool noFeed = !block->IsFeedBlock() && (sources == d_SourceMap.end() || sources->second.empty());
+		if(noFeed)
+		{
+			key.port = 0;
+			d_Analysis.unconnected.push_back(key);
+		}
+
+		const std::vector<bool>& ports = linked[blockItr->first];
+		for(PortNo p = (numPorts > 1 || noFeed) ? 1 : 0; p < numPorts; p++)
+		{
+			if(p >= ports.size() || !ports[p])
+			{
+				key.port = p;
+				d_Analysis.unconnected.push_back(key);
+			}
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// AnalyseGraph - Public C_Flowsheet
+// Description 
+//	Compiles the schedule if the links have changed and returns what it
+//	found.
+// 
+// Arguments:	None.
+// Returns:		The analysis.
+//-----------------------------------------------------------------------
+const S_GraphAnalysis& C_Flowsheet::AnalyseGraph()
+{
+	if(!d_bScheduleValid)
+	{
+		ApplySensitivities();
+		CompileSchedule();
+	}
+	return d_Analysis;
+}
+
+
+//-----------------------------------------------------------------------
+// PackPorts - Private C_Flowsheet
+// Description 
+//	Moves the ports of every block, in BlockID order, into a new port
+//	store.  A block's ports leave it if it allocates them again, e.g.
+//	for a new size distribution, which also invalidates the schedule.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::PackPorts()
+{
+	unsigned numPorts = 0;
+	BlockMapIterator blockItr;
+	for(blockItr = d_BlockMap.begin(); blockItr != d_BlockMap.end(); blockItr++)
+	{
+		if(blockItr->second != NULL)
+			numPorts += blockItr->second->GetPorts().GetNumPorts();
+	}
+
+	d_PortStore = new C_PortStore(d_fspFSParams, numPorts);
+	for(blockItr = d_BlockMap.begin(); blockItr != d_BlockMap.end(); blockItr++)
+	{
+		if(blockItr->second != NULL)
+			blockItr->second->GetPorts().MoveTo(d_PortStore, blockItr->first);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// GetPortStore - Public C_Flowsheet
+// Description 
+//	Compiles the schedule, which packs the ports, if the links have
+//	changed or a block's ports have left the store.
+// 
+// Arguments:	None.
+// Returns:		The port store.
+//-----------------------------------------------------------------------
+C_SmartPointer<C_PortStore> C_Flowsheet::GetPortStore()
+{
+	if(d_bScheduleValid)
+	{
+		unsigned numPorts = 0;
+		for(BlockMapIterator blockItr = d_BlockMap.begin(); blockItr != d_BlockMap.end() && d_bScheduleValid; blockItr++)
+		{
+			if(blockItr->second == NULL)
+				continue;
+			C_BlockPorts& ports = blockItr->second->GetPorts();
+			for(PortNo p = 0; p < ports.GetNumPorts(); p++)
+			{
+				if(!d_PortStore->Holds(ports.GetFlowData(p)))
+					d_bScheduleValid = false;
+			}
+			numPorts += ports.GetNumPorts();
+		}
+		if(numPorts != d_PortStore->GetNumPorts())
+			d_bScheduleValid = false;
+	}
+
+	if(!d_bScheduleValid)
+	{
+		ApplySensitivities();
+		CompileSchedule();
+	}
+	return d_PortStore;
+}
+
+
+//-----------------------------------------------------------------------
+// LoadSizeDistribution - Public C_Flowsheet
+// Description 
+//	Loads a size distribution from a text file
+// 
+// Arguments:	name of the file to load
+// Returns:		true if successful, false otherwise
+//-----------------------------------------------------------------------
+bool C_Flowsheet::LoadSizeDistribution(const char* fileName)
+{	
+	if(d_fspFSParams->d_sdSizeDistribution.LoadSizeDist(fileName))
+	{
+		OnNewSizeDistribution();
+		return true;
+	}
+	else
+		return false;
+}
+
+
+//-----------------------------------------------------------------------
+// LoadSizeDistribution - Public C_Flowsheet
+// Description 
+//	Loads a size distribution from a stream in the text file format
+// 
+// Arguments:	stream - the stream to read
+// Returns:		true if successful, false otherwise
+//-----------------------------------------------------------------------
+bool C_Flowsheet::LoadSizeDistribution(std::istream& stream)
+{	
+	if(d_fspFSParams->d_sdSizeDistribution.LoadSizeDist(stream))
+	{
+		OnNewSizeDistribution();
+		return true;
+	}
+	else
+		return false;
+}
+
+
+//-----------------------------------------------------------------------
+// LoadWashability - Public C_Flowsheet
+// Description 
+//	Loads a washability table from a text file
+// 
+// Arguments:	name of the file to load
+// Returns:		true if successful, false otherwise
+//-----------------------------------------------------------------------
+bool C_Flowsheet::LoadWashability(const char* fileName)
+{	
+	if(d_fspFSParams->d_wbWashability.LoadWashability(fileName))
+	{
+		OnNewSizeDistribution();
+		return true;
+	}
+	else
+		return false;
+}
+
+
+bool C_Flowsheet::LoadWashability(std::istream& stream)
+{	
+	if(d_fspFSParams->d_wbWashability.LoadWashability(stream))
+	{
+		OnNewSizeDistribution();
+		return true;
+	}
+	else
+		return false;
+}
+
+
+//-----------------------------------------------------------------------
+// LoadPartitionNumbers - Public C_Flowsheet
+// Description 
+//	Loads, or shares, the partition number tables in a file
+// 
+// Arguments:	name of the file to load
+// Returns:		true if successful, false otherwise
+//-----------------------------------------------------------------------
+bool C_Flowsheet::LoadPartitionNumbers(const char* fileName)
+{	
+	PartitionNumbersPtr tables = C_PartitionNumbers::Load(fileName);
+	if(!tables)
+		return false;
+
+	d_fspFSParams->d_PartitionNumbers = tables;
+	OnNewSizeDistribution();
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// OnNewSizeDistribution - Private C_Flowsheet
+// Description 
+//	Maps the washability onto the size distribution and tells the blocks
+//	that a size distribution has been loaded
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::OnNewSizeDistribution()
+{
+	// The ports are reallocated so the schedule has to be rebuilt
+	d_bScheduleValid = false;
+	d_fspFSParams->d_uiGridVersion++;
+
+	if(d_fspFSParams->d_wbWashability.GetNumDensities())
+		d_fspFSParams->d_wbWashability.MapToGrid(d_fspFSParams->d_sdSizeDistribution);
+
+	BlockMapIterator blockItrEnd = d_BlockMap.end();
+	BlockMapIterator blockItr = d_BlockMap.begin();
+	while(blockItr != blockItrEnd)
+	{
+		blockItr->second->OnNewSizeDistribution();
+		blockItr->second->InvalidateMemo();
+		blockItr++;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetWideSums - Public C_Flowsheet
+// Description 
+//	Picks whether the size fractions are summed into the rates in double.
+//	The ports pick their kernels when they are allocated, so they are
+//	reallocated, and zeroed, when it changes.
+// 
+// Arguments:	b - sum in double
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::SetWideSums(bool b)
+{
+	if(d_fspFSParams->d_bWideSums == b)
+		return;
+
+	d_fspFSParams->d_bWideSums = b;
+	OnNewSizeDistribution();
+}
+
+
+//-----------------------------------------------------------------------
+// GetBlockIDs - Public C_Flowsheet
+// Description 
+//	Lists the blocks in the flowsheet in BlockID order.
+// 
+// Arguments:	ids - the list to fill
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::GetBlockIDs(std::vector<BlockID>& ids) const
+{
+	ids.clear();
+	std::map< BlockID, C_SmartPointer<I_FSBlock> >::const_iterator blockItr = d_BlockMap.begin();
+	while(blockItr != d_BlockMap.end())
+	{
+		if(blockItr->second != NULL)
+			ids.push_back(blockItr->first);
+		blockItr++;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetParameter - Public C_Flowsheet
+// Description 
+//	Sets a single named parameter on a block.
+// 
+// Arguments:	id - the block, name - the parameter, value - the new value
+// Returns:		true if the block has the parameter
+//-----------------------------------------------------------------------
+bool C_Flowsheet::SetParameter(const BlockID& id, const std::string& name, const float& value)
+{
+	BlockPtr block = GetBlock(id);
+	if(block == NULL)
+		return false;
 
-	if(d_fspFSParams->d_bUpdateSolids)
-		fd->ZeroSolids();
-	if(d_fspFSParams->d_bUpdateWater)
-		fd->ZeroWater();
+	block->InvalidateMemo();
+	return block->SetParameter(name, value);
+}
+
+
+bool C_Flowsheet::GetParameter(const BlockID& id, const std::string& name, float& value)
+{
+	BlockPtr block = GetBlock(id);
+	if(block == NULL)
+		return false;
+
+	return block->GetParameter(name, value);
+}
+
+
+//-----------------------------------------------------------------------
+// Clone - Public C_Flowsheet
+// Description 
+//	Rebuilds dest as a copy of this flowsheet.  The blocks are created
+//	with the same ids and process types, their named parameters copied
+//	across and the links made in the same order so the sources are
+//	summed in the same order.  The ports are not copied, so dest starts
+//	cold.  dest gets its own flowsheet parameters so the two can be
+//	solved on different threads.
+// 
+// Arguments:	dest - the flowsheet to rebuild
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::Clone(C_Flowsheet& dest)
+{
+	if(&dest == this)
+		return;
 
-	while(feedItr != feedItrEnd)
+	dest.Reset();
+
+	// Nothing to copy if dest shares the parameters, e.g. two sub-flowsheets of one parent
+	if(dest.d_fspFSParams != d_fspFSParams)
 	{
-		(*fd) += (*feedItr->blkPointer->GetFlowData(feedItr->usPort));
-		feedItr++;
+		dest.d_fspFSParams->d_iWaterRoundTo = d_fspFSParams->d_iWaterRoundTo;
+		dest.d_fspFSParams->d_bUpdateWater = d_fspFSParams->d_bUpdateWater;
+		dest.d_fspFSParams->d_bUpdateSolids = d_fspFSParams->d_bUpdateSolids;
+		dest.d_fspFSParams->d_bMetric = d_fspFSParams->d_bMetric;
+		dest.d_fspFSParams->d_fWaterUnit = d_fspFSParams->d_fWaterUnit;
+		dest.d_fspFSParams->d_bMemoize = d_fspFSParams->d_bMemoize;
+		dest.d_fspFSParams->d_bWideSums = d_fspFSParams->d_bWideSums;
+		dest.d_fspFSParams->d_sdSizeDistribution = d_fspFSParams->d_sdSizeDistribution;
+		dest.d_fspFSParams->d_wbWashability = d_fspFSParams->d_wbWashability;
+		dest.d_fspFSParams->d_PartitionNumbers = d_fspFSParams->d_PartitionNumbers;
+		dest.d_fspFSParams->d_uiGridVersion++;
+	}
+
+	dest.d_fDelta = d_fDelta;
+	dest.d_fRelDelta = d_fRelDelta;
+	dest.d_uiMaxNumberIter = d_uiMaxNumberIter;
+	dest.d_bParallel = d_bParallel;
+	dest.d_uiNumThreads = d_uiNumThreads;
+	dest.d_bTracing = d_bTracing;
+
+	BlockMapIterator blockItrEnd = d_BlockMap.end();
+	BlockMapIterator blockItr = d_BlockMap.begin();
+	while(blockItr != blockItrEnd)
+	{
+		if(blockItr->second != NULL)
+		{
+			BlockPtr block = dest.d_BlockFactory->CreateBlock(blockItr->second->GetProcessID(), blockItr->first);
+			dest.d_BlockMap[blockItr->first] = block;
+			blockItr->second->CloneInto(block);
+		}
+		blockItr++;
+	}
+
+	SourceMap::iterator sourceItr = d_SourceMap.begin();
+	while(sourceItr != d_SourceMap.end())
+	{
+		FeedSourceListIterator feedItr = sourceItr->second.begin();
+		while(feedItr != sourceItr->second.end())
+		{
+			if(feedItr->blkPointer != NULL)
+				dest.MakeLink(feedItr->blkPointer->GetBlockID(), feedItr->usPort, sourceItr->first);
+			feedItr++;
+		}
+		sourceItr++;
 	}
+
+	dest.d_BlockFactory->SetNextID(d_BlockFactory->GetNextID());
+	dest.d_bScheduleValid = false;
 }
 
 
 //-----------------------------------------------------------------------
-// LoadSizeDistribution - Public C_Flowsheet
+// SetSensitivities - Public C_Flowsheet
 // Description 
-//	Loads a size distribution from a text file
+//	Sets the parameters to differentiate against.  The blocks get their
+//	tangents on the next solve.
 // 
-// Arguments:	name of the file to load
-// Returns:		true if successful, false otherwise
+// Arguments:	params - the parameters, one tangent each
+// Returns:		true if every parameter exists
 //-----------------------------------------------------------------------
-bool C_Flowsheet::LoadSizeDistribution(const char* fileName)
-{	
-	if(d_fspFSParams->d_sdSizeDistribution.LoadSizeDist(fileName))
+bool C_Flowsheet::SetSensitivities(const std::vector<S_ParameterRef>& params)
+{
+	d_Sensitivities.clear();
+	d_bScheduleValid = false;
+
+	float value;
+	for(size_t i = 0; i < params.size(); i++)
+	{
+		if(!GetParameter(params[i].blockID, params[i].name, value))
+			return false;
+	}
+
+	d_Sensitivities = params;
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// ApplySensitivities - Private C_Flowsheet
+// Description 
+//	Gives every block tangents for the sensitivity parameters and the
+//	seeds for its own parameters among them.  Does nothing if they are
+//	off and were never on.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::ApplySensitivities()
+{
+	if(d_Sensitivities.empty() && d_usNumTangents == 0)
+		return;
+
+	d_usNumTangents = (unsigned short)d_Sensitivities.size();
+
+	std::vector<std::pair<std::string, unsigned short> > seeds;
+	BlockMapIterator blockItrEnd = d_BlockMap.end();
+	BlockMapIterator blockItr = d_BlockMap.begin();
+	while(blockItr != blockItrEnd)
 	{
-		BlockMapIterator blockItrEnd = d_BlockMap.end();
-		BlockMapIterator blockItr = d_BlockMap.begin();
-		while(blockItr != blockItrEnd)
+		seeds.clear();
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
 		{
-			blockItr->second->OnNewSizeDistribution();
-			blockItr++;
+			if(d_Sensitivities[k].blockID == blockItr->first)
+				seeds.push_back(std::make_pair(d_Sensitivities[k].name, k));
 		}
-		return true;
+
+		if(blockItr->second != NULL)
+			blockItr->second->SetSensitivity(d_usNumTangents, seeds);
+		blockItr++;
 	}
-	else
-		return false;
 }
 
+
+//-----------------------------------------------------------------------
+// GetSensitivity - Public C_Flowsheet
+// Description 
+//	Reads a derivative off a stream.
+// 
+// Arguments:	stream - the port, quantity - SENS_SOLIDS, SENS_WATER or
+//				SENS_PERSOLIDS, k - the parameter
+// Returns:		The derivative, 0 if there is no such stream or parameter
+//-----------------------------------------------------------------------
+float C_Flowsheet::GetSensitivity(const S_StreamKey& stream, unsigned char quantity, unsigned short k)
+{
+	BlockPtr block = GetBlock(stream.blockID);
+	if(block == NULL || stream.port >= block->GetPorts().GetNumPorts())
+		return 0.0f;
+
+	C_FlowData* fd = block->GetFlowData(stream.port);
+	if(k >= fd->GetNumTangents())
+		return 0.0f;
+
+	switch(quantity)
+	{
+		case SENS_SOLIDS:		return fd->SolidTangent(k);
+		case SENS_WATER:		return fd->FluidTangent(k) * d_fspFSParams->d_fWaterUnit;
+		case SENS_PERSOLIDS:	return fd->PerSolidsTangent(k);
+	}
+	return 0.0f;
+}
+
+
+void C_Flowsheet::GetJacobian(const std::vector<S_StreamKey>& streams, unsigned char quantity, std::vector<float>& jacobian)
+{
+	const unsigned short numParams = GetNumSensitivities();
+	jacobian.assign(streams.size() * numParams, 0.0f);
+	for(size_t s = 0; s < streams.size(); s++)
+		for(unsigned short k = 0; k < numParams; k++)
+			jacobian[s * numParams + k] = GetSensitivity(streams[s], quantity, k);
+}
+
+
 //-----------------------------------------------------------------------
-// Check - private C_Flowsheet
+// ZeroFlows - Public C_Flowsheet
 // Description 
-//	Checks to see if any value in deltaPorts is over the delta.  If just one
-//	value is over, d_bDone is set to false and Check returns.
+//	Zeros the ports of every block so the next solve starts cold.
 // 
 // Arguments:	None.
 // Returns:		None.
 //-----------------------------------------------------------------------
-void C_Flowsheet::Check(C_SmartPointer<C_BlockPorts> deltaPorts)
+void C_Flowsheet::ZeroFlows()
 {
-	C_FlowData* fd;
-	for(unsigned short i = 0; i < deltaPorts->GetNumPorts(); i++)
+	BlockMapIterator blockItrEnd = d_BlockMap.end();
+	BlockMapIterator blockItr = d_BlockMap.begin();
+	while(blockItr != blockItrEnd)
 	{
-		fd = deltaPorts->GetFlowData(i);
-		for(unsigned short j = 0; j < d_fspFSParams->d_sdSizeDistribution.GetNumSizeFractions(); j++)
+		if(!blockItr->second->IsFeedBlock())
 		{
-			if(((*fd)[j] < -d_fDelta) || ((*fd)[j] > d_fDelta))
-			{
-				d_bDone = false;
-				return;
-			}
+			blockItr->second->GetPorts().Zero();
+			blockItr->second->InvalidateMemo();
 		}
-		if((fd->d_FluidRate < -d_fDelta) || (fd->d_FluidRate > d_fDelta))
+		blockItr++;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateScheduledBlock - Private C_Flowsheet
+// Description 
+//	Sums the sources for the block, updates it and compares its ports
+//	against the values from the previous sweep.
+// 
+// Arguments:	sb - the scheduled block
+//				lagged - read recycle sources from the previous sweep
+//				check - compare the ports against the previous sweep
+//				worker - the thread running the update
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::UpdateScheduledBlock(S_ScheduledBlock& sb, bool lagged, bool check, unsigned worker)
+{
+	FS_PROFILE( double tStart = C_SolverStats::Now(); )
+
+	SumSources(lagged ? sb.laggedSources : sb.liveSources, sb.blkPointer->GetFlowData(0));
+
+	FS_PROFILE( double tSummed = C_SolverStats::Now(); )
+
+	sb.blkPointer->OnUpdate();
+
+	FS_PROFILE( double tUpdated = C_SolverStats::Now(); )
+
+#ifdef FS_PROFILING
+	// The residual needs every loop block, so always measure it.  It is
+	// only reported; convergence is decided the same way as without
+	// profiling.
+	if(sb.previous != NULL)
+		sb.fResidual = sb.blkPointer->GetPorts().MaxDelta(*sb.previous);
+#endif
+	if(check)
+		sb.bConverged = sb.blkPointer->IsConverged() && sb.blkPointer->GetPorts().WithinDelta(*sb.previous, d_fDelta, d_fRelDelta);
+
+	FS_PROFILE( double tChecked = C_SolverStats::Now(); )
+	FS_PROFILE( sb.stats.uiCalls++; )
+	FS_PROFILE( sb.stats.dSumSourcesTime += tSummed - tStart; )
+	FS_PROFILE( sb.stats.dUpdateTime += tUpdated - tSummed; )
+	FS_PROFILE( sb.stats.dCheckTime += tChecked - tUpdated; )
+	FS_PROFILE( AddTraceEvent(S_TraceEvent::TRACE_BLOCK, worker, sb.blkPointer->GetBlockID(), sb.blkPointer->GetProcessID(), tSummed, tUpdated); )
+}
+
+
+//-----------------------------------------------------------------------
+// AddTraceEvent - Private C_Flowsheet
+// Description 
+//	Adds an event to the worker's trace buffer.  Block events are only
+//	kept when tracing has been turned on.
+// 
+// Arguments:	type - the S_TraceEvent type, worker - the thread
+//				id, procID - the block or iteration number
+//				start, end - the clock times of the event
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::AddTraceEvent(unsigned char type, unsigned worker, BlockID id, ProcessID procID, double start, double end)
+{
+	if(type == S_TraceEvent::TRACE_BLOCK && !d_bTracing)
+		return;
+
+	S_TraceEvent e;
+	e.ucType = type;
+	e.uiThread = worker;
+	e.blockID = id;
+	e.procID = procID;
+	e.dStart = start - d_dSolveStart;
+	e.dDuration = end - start;
+	d_Stats.trace[worker].push_back(e);
+}
+
+
+//-----------------------------------------------------------------------
+// RunTask - Public C_Flowsheet::C_SnapshotTask
+// Description 
+//	Stores a loop block's ports as they were at the end of the last sweep.
+//-----------------------------------------------------------------------
+void C_Flowsheet::C_SnapshotTask::RunTask(const unsigned& index, const unsigned& worker)
+{
+	S_ScheduledBlock& sb = d_pFlowsheet->d_Schedule[d_pFlowsheet->d_LoopOrder[index]];
+	*sb.previous = sb.blkPointer->GetPorts();
+}
+
+
+//-----------------------------------------------------------------------
+// RunTask - Public C_Flowsheet::C_LevelTask
+// Description 
+//	Updates one of the parallel blocks in a level.
+//-----------------------------------------------------------------------
+void C_Flowsheet::C_LevelTask::RunTask(const unsigned& index, const unsigned& worker)
+{
+	S_ScheduledBlock& sb = d_pFlowsheet->d_Schedule[d_pFlowsheet->d_LevelOrder[d_uiFirst + index]];
+	d_pFlowsheet->UpdateScheduledBlock(sb, d_bSweep, d_bSweep, worker);
+}
+
+
+//-----------------------------------------------------------------------
+// SequentialSweep - Private C_Flowsheet
+// Description 
+//	Updates the loop blocks one after another in BlockID order.  Each
+//	block sees the newest values of its sources.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::SequentialSweep()
+{
+	for(size_t i = 0; i < d_LoopOrder.size(); i++)
+	{
+		S_ScheduledBlock& sb = d_Schedule[d_LoopOrder[i]];
+
+		// Store the previous values for this block
+		*sb.previous = sb.blkPointer->GetPorts();
+
+		// If it has not been proven that the flowsheet isnt done, then run a check
+		// If just one block isn't finished, then set it to false.
+		UpdateScheduledBlock(sb, false, d_bDone, 0);
+		if(d_bDone)
+			d_bDone = sb.bConverged;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ParallelSweep - Private C_Flowsheet
+// Description 
+//	Updates the blocks level by level.  The blocks in a level only read
+//	lower levels, which are finished, or the previous sweep's buffer, so
+//	the result is the same for any number of threads.  Report blocks are
+//	run on this thread after the rest of their level.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::ParallelSweep()
+{
+	C_SnapshotTask snapshot(this);
+	d_ThreadPool->ParallelFor(snapshot, (unsigned)d_LoopOrder.size());
+
+	for(size_t l = 0; l < d_Levels.size(); l++)
+	{
+		const S_Level& level = d_Levels[l];
+
+		C_LevelTask task(this, level.uiFirst);
+		d_ThreadPool->ParallelFor(task, level.uiNumParallel);
+
+		for(unsigned i = 0; i < level.uiNumSerial; i++)
+			UpdateScheduledBlock(d_Schedule[d_LevelOrder[level.uiFirst + level.uiNumParallel + i]], true, true, 0);
+	}
+
+	for(size_t i = 0; i < d_LoopOrder.size(); i++)
+	{
+		if(!d_Schedule[d_LoopOrder[i]].bConverged)
 		{
 			d_bDone = false;
-			return;
+			break;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateAfterConvergence - Private C_Flowsheet
+// Description 
+//	Updates the blocks that nothing in the loop reads, level by level
+//	so each sees its sources' final values.  The report blocks are left
+//	for UpdateReportBlocks.  A block that did not converge inside, such
+//	as a sub-flowsheet, leaves the flowsheet not converged.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::UpdateAfterConvergence()
+{
+	for(size_t l = 0; l < d_AfterLevels.size(); l++)
+	{
+		const S_Level& level = d_AfterLevels[l];
+		if(d_bParallel)
+		{
+			C_LevelTask task(this, level.uiFirst, false);
+			d_ThreadPool->ParallelFor(task, level.uiNumParallel);
+		}
+		else
+		{
+			for(unsigned i = 0; i < level.uiNumParallel; i++)
+				UpdateScheduledBlock(d_Schedule[d_LevelOrder[level.uiFirst + i]], false, false, 0);
+		}
+
+		for(unsigned i = 0; i < level.uiNumParallel; i++)
+		{
+			if(!d_Schedule[d_LevelOrder[level.uiFirst + i]].blkPointer->IsConverged())
+				d_bDone = false;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// RoundReportedWater - Private C_Flowsheet
+// Description 
+//	The solve works on unrounded water so the rounding can not stop it
+//	converging.  Once it has, the feeds are rounded and the blocks are
+//	passed over in level order: each sums its rounded feeds again and
+//	rounds its outputs, with its balance port taking the difference.
+//	A recycle brings a changed stream back round, so the pass is
+//	repeated until nothing moves.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Flowsheet::RoundReportedWater()
+{
+	if(!d_fspFSParams->d_bUpdateWater || d_fspFSParams->d_iWaterRoundTo <= 0)
+		return;
+
+	BlockMapIterator blockItr;
+	for(blockItr = d_BlockMap.begin(); blockItr != d_BlockMap.end(); blockItr++)
+	{
+		if(blockItr->second->IsFeedBlock())
+			blockItr->second->RoundWater();
+	}
+
+	std::vector<FluidRate> water;
+	bool changed = true;
+	for(unsigned pass = 0; changed && pass < d_uiMaxNumberIter; pass++)
+	{
+		changed = false;
+		for(size_t i = 0; i < d_LevelOrder.size(); i++)
+		{
+			S_ScheduledBlock& sb = d_Schedule[d_LevelOrder[i]];
+			if(sb.blkPointer->IsReportBlock())
+				continue;
+
+			C_BlockPorts& ports = sb.blkPointer->GetPorts();
+			water.resize(ports.GetNumPorts());
+			for(unsigned short p = 0; p < ports.GetNumPorts(); p++)
+				water[p] = ports.GetFlowData(p)->d_FluidRate;
+
+			C_FlowData* feed = ports.GetFlowData(0);
+			feed->ZeroWater();
+			for(size_t s = 0; s < sb.liveSources.size(); s++)
+				feed->AddFluid(*sb.liveSources[s]);
+
+			sb.blkPointer->RoundWater();
+
+			for(unsigned short p = 0; p < ports.GetNumPorts(); p++)
+				changed = changed || (water[p] != ports.GetFlowData(p)->d_FluidRate);
 		}
 	}
-	return;
+
+	// The ports no longer hold what the last update worked out
+	for(blockItr = d_BlockMap.begin(); blockItr != d_BlockMap.end(); blockItr++)
+		blockItr->second->InvalidateMemo();
 }
 
 
 //-----------------------------------------------------------------------
-// SolveFlowSheet - Public C_Flowsheet
+// UpdateReportBlocks - Private C_Flowsheet
 // Description 
-//	Updates all of the blocks until each block converges.
+//	Updates the report blocks, on this thread and in level order, once
+//	the flows they report are final.  The report blocks inside blocks,
+//	such as sub-flowsheets, go first, in the same order.
 // 
 // Arguments:	None.
 // Returns:		None.
 //-----------------------------------------------------------------------
-bool C_Flowsheet::SolveFlowSheet()
+void C_Flowsheet::UpdateReportBlocks()
+{
+	for(size_t i = 0; i < d_LevelOrder.size(); i++)
+	{
+		S_ScheduledBlock& sb = d_Schedule[d_LevelOrder[i]];
+		if(!sb.blkPointer->IsReportBlock())
+			sb.blkPointer->UpdateReports();
+	}
+
+	for(size_t l = 0; l < d_AfterLevels.size(); l++)
+	{
+		const S_Level& level = d_AfterLevels[l];
+		for(unsigned i = 0; i < level.uiNumSerial; i++)
+			UpdateScheduledBlock(d_Schedule[d_LevelOrder[level.uiFirst + level.uiNumParallel + i]], false, false, 0);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// Solve - Private C_Flowsheet
+// Description 
+//	Updates the loop blocks until each block converges, then the blocks
+//	downstream of every recycle once.  The water is rounded for reporting
+//	before the report blocks run; a sub-flowsheet leaves that to the
+//	flowsheet it is in, and a transient run skips both at every step.
+//	A converged report solve is then published, if there is a publisher.
+// 
+// Arguments:	report - round the water and update the report blocks
+// Returns:		true if it converged.
+//-----------------------------------------------------------------------
+bool C_Flowsheet::Solve(bool report)
 {
+	FS_PROFILE( d_dSolveStart = C_SolverStats::Now(); )
+	FS_PROFILE( unsigned long allocStart = C_SolverStats::GetAllocationCount(); )
+
+	// The ports may have been reallocated since the tangents were set up
+	if(!d_bScheduleValid)
+		ApplySensitivities();
+
 	BlockMapIterator blockItrEnd = d_BlockMap.end();
 	BlockMapIterator blockItr = d_BlockMap.begin();
 
+	d_ulNumBlockUpdates = 0;
+
 	// Update the feed blocks first
 	while(blockItr != blockItrEnd)
 	{
-		if(blockItr->second->GetProcessID() == PROCID_FEED)
+		blockItr->second->ResetMemoCounts();
+		if(blockItr->second->IsFeedBlock())
+		{
 			blockItr->second->OnUpdate();
+			d_ulNumBlockUpdates++;
+		}
 		blockItr++;
 	}
 
+	if(!d_bScheduleValid)
+		CompileSchedule();
+
+	if(d_bParallel && (d_ThreadPool == NULL || d_ThreadPool->GetNumThreads() != d_uiNumThreads))
+		d_ThreadPool = new C_ThreadPool(d_uiNumThreads);
+
 	// Set the number of iterations back to zero
 	d_uiNumIterations = 0;
 
+	d_Stats.Reset(d_bParallel ? d_uiNumThreads : 1);
+	FS_PROFILE( for(size_t i = 0; i < d_Schedule.size(); i++) d_Schedule[i].stats = S_BlockStats(); )
+
 	do
 	{
+		FS_PROFILE( double tIteration = C_SolverStats::Now(); )
+
 		// Assume that it is done.
 		d_bDone = true;
-		blockItr = d_BlockMap.begin();
 
-		while(blockItr != blockItrEnd)
-		{
-			if(blockItr->second->GetProcessID() != PROCID_FEED)
-			{
-				// Store the previous values for this block
-				C_BlockPorts before(blockItr->second->GetPorts());
-
-				// Sum the sources then update
-				SumSources(d_SourceMap[blockItr->first], blockItr->second->GetFlowData(0));
-				blockItr->second->OnUpdate();
-	
-				// If it has not been proven that the flowsheet isnt done, then run a check
-				// If just one block isn't finished, then set it to false.
-				if(d_bDone)
-					Check( (blockItr->second->GetPorts()).Difference(before) );
-			}
-			blockItr++;
-		}
+		if(d_bParallel)
+			ParallelSweep();
+		else
+			SequentialSweep();
+
+		FS_PROFILE( float residual = 0.0f; )
+		FS_PROFILE( for(size_t i = 0; i < d_Schedule.size(); i++) if(d_Schedule[i].fResidual > residual) residual = d_Schedule[i].fResidual; )
+		FS_PROFILE( d_Stats.residuals.push_back(residual); )
+		FS_PROFILE( AddTraceEvent(S_TraceEvent::TRACE_ITERATION, 0, d_uiNumIterations, 0, tIteration, C_SolverStats::Now()); )
 
 		d_uiNumIterations++;
 	}while((!d_bDone) && (d_uiNumIterations <= d_uiMaxNumberIter));
 
+	UpdateAfterConvergence();
+	if(report)
+	{
+		if(d_bOwnsParams)
+			RoundReportedWater();
+		UpdateReportBlocks();
+
+		if(d_bDone && d_Publisher != NULL)
+			d_Publisher->Publish(*GetPortStore(), GetWaterUnit(), d_uiNumIterations);
+	}
+
+	d_Stats.uiIterations = d_uiNumIterations;
+	d_ulNumBlockUpdates += (unsigned long)d_uiNumIterations * d_LoopOrder.size() + d_Analysis.afterConvergence.size();
+
+	// The report blocks only ran if it reported
+	for(size_t l = 0; !report && l < d_AfterLevels.size(); l++)
+		d_ulNumBlockUpdates -= d_AfterLevels[l].uiNumSerial;
+
+	for(blockItr = d_BlockMap.begin(); blockItr != blockItrEnd; blockItr++)
+	{
+		d_Stats.ulMemoHits += blockItr->second->GetMemoHits();
+		d_Stats.ulMemoMisses += blockItr->second->GetMemoMisses();
+	}
+
+	// A memo hit skipped the update
+	d_ulNumBlockUpdates -= d_Stats.ulMemoHits;
+
+#ifdef FS_PROFILING
+	d_Stats.dSolveTime = C_SolverStats::Now() - d_dSolveStart;
+	AddTraceEvent(S_TraceEvent::TRACE_SOLVE, 0, 0, 0, d_dSolveStart, d_dSolveStart + d_Stats.dSolveTime);
+
+	for(size_t i = 0; i < d_Schedule.size(); i++)
+	{
+		if(d_Schedule[i].ucRole == ROLE_UNREACHABLE)
+			continue;
+
+		S_BlockStats stats = d_Schedule[i].stats;
+		stats.blockID = d_Schedule[i].blkPointer->GetBlockID();
+		stats.procID = d_Schedule[i].blkPointer->GetProcessID();
+		stats.uiMemoHits = d_Schedule[i].blkPointer->GetMemoHits();
+		d_Stats.dSumSourcesTime += stats.dSumSourcesTime;
+		d_Stats.dCheckTime += stats.dCheckTime;
+		d_Stats.blocks.push_back(stats);
+	}
+
+	d_Stats.ulAllocations = C_SolverStats::GetAllocationCount() - allocStart;
+#endif
+
 	return d_bDone;
 }
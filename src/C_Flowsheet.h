@@ -10,11 +10,52 @@
 #define _FLOWSHEET_
 
 #include "C_BlockFactory.h"
+#include "C_ThreadPool.h"
+#include "C_SolverStats.h"
+#include "C_ResultPublisher.h"
 #include <map>
 #include <list>
+#include <vector>
+#include <string>
+
+// A port on a block
+struct S_StreamKey
+{
+	BlockID blockID;
+	PortNo port;
+};
+
+// A named parameter on a block
+struct S_ParameterRef
+{
+	BlockID blockID;
+	std::string name;
+};
+
+// What the pre-solve pass found out about the links
+struct S_GraphAnalysis
+{
+	std::vector<BlockID> unreachable;		// Carry no feed and send nothing to a block that does
+	std::vector<BlockID> afterConvergence;	// Nothing downstream feeds back, so updated once at the end
+	std::vector<S_StreamKey> unconnected;	// Output ports going nowhere, or port 0 of a block with no feed
+};
 
 class C_Flowsheet
 {
+	// Sub-flowsheets pass the size distribution and sensitivities down
+	friend class C_SubFlowsheet;
+
+	// Transient runs solve every step without rounding or reporting
+	friend class C_Transient;
+
+	// Monte Carlo samples are solved on pool threads without reporting
+	friend class C_MonteCarlo;
+
+	// Design specs and reconciliation solve each step without reporting,
+	// then report once
+	friend class C_DesignSpec;
+	friend class C_Reconciliation;
+
 private:
 
 	// Stores the information on the block that feeds another block.
@@ -47,6 +88,57 @@ private:
 	// Maps a BlockID to a list of BlockID's.  This tells the block with BlockID what it feeds.
 	typedef std::map< BlockID, BlockIDList > DestMap;
 	typedef std::map< BlockID, BlockIDList >::iterator DestMapIterator;
+
+	// The resolved feed sources of a block in the compiled schedule
+	typedef std::vector<const C_FlowData*> SourceArray;
+
+	// A non-feed block in the compiled schedule.  Only the blocks in the
+	// loop are swept; the rest are updated once after it has converged or
+	// not at all.
+	enum { ROLE_LOOP = 0, ROLE_AFTER, ROLE_UNREACHABLE };
+	struct S_ScheduledBlock
+	{
+		BlockPtr blkPointer;
+		unsigned char ucRole;
+		C_SmartPointer<C_BlockPorts> previous;	// The block's ports at the end of the last sweep, loop blocks only
+		SourceArray liveSources;				// The sources as they are right now
+		SourceArray laggedSources;				// Recycle sources are read from the last sweep
+		bool bConverged;						// Did the block stop changing this sweep
+		FS_PROFILE( S_BlockStats stats; )
+		FS_PROFILE( float fResidual; )
+	};
+	typedef std::vector<S_ScheduledBlock> Schedule;
+
+	// A group of blocks that only depend on earlier levels.  The parallel
+	// blocks come first in d_LevelOrder followed by the report blocks.
+	struct S_Level
+	{
+		unsigned uiFirst;
+		unsigned uiNumParallel;
+		unsigned uiNumSerial;
+	};
+	typedef std::vector<S_Level> LevelList;
+
+	// Copies every scheduled block's ports into its previous buffer
+	class C_SnapshotTask : public I_ParallelTask
+	{
+	public:
+		C_Flowsheet* d_pFlowsheet;
+		C_SnapshotTask(C_Flowsheet* fs) : d_pFlowsheet(fs) {}
+		void RunTask(const unsigned& index, const unsigned& worker);
+	};
+
+	// Updates the parallel blocks of one level, as part of a sweep or once
+	// after convergence
+	class C_LevelTask : public I_ParallelTask
+	{
+	public:
+		C_Flowsheet* d_pFlowsheet;
+		unsigned d_uiFirst;
+		bool d_bSweep;
+		C_LevelTask(C_Flowsheet* fs, unsigned first, bool sweep = true) : d_pFlowsheet(fs), d_uiFirst(first), d_bSweep(sweep) {}
+		void RunTask(const unsigned& index, const unsigned& worker);
+	};
 	
 	// PRIVATE DATA MEMBERS====================================================
 
@@ -56,8 +148,12 @@ private:
 	// The maximum delta considered for convergence
 	float d_fDelta;	
 
+	// A value may also move by this times its size, 0 for none
+	float d_fRelDelta;
+
 	// The number of iterations the SolveFlowsheet() function took
 	unsigned d_uiNumIterations;
+	unsigned long d_ulNumBlockUpdates;
 
 	// The maximum number of iterations
 	unsigned d_uiMaxNumberIter;
@@ -76,14 +172,83 @@ private:
 
 	// The flowsheet Parameters
 	FSParamsPtr d_fspFSParams;
+	bool d_bOwnsParams;					// False for a sub-flowsheet using its parent's
+
+	// The compiled schedule - rebuilt when the structure or size distribution changes
+	bool d_bScheduleValid;
+	Schedule d_Schedule;
+	LevelList d_Levels;
+	LevelList d_AfterLevels;			// The blocks updated once after convergence
+	std::vector<unsigned> d_LevelOrder;	// Indices into d_Schedule, grouped by level
+	std::vector<unsigned> d_LoopOrder;	// The loop blocks in BlockID order
+	S_GraphAnalysis d_Analysis;
+
+	// Every block's ports, moved in when the schedule is compiled
+	C_SmartPointer<C_PortStore> d_PortStore;
+
+	// Given a snapshot after every converged solve, if set - not owned
+	C_ResultPublisher* d_Publisher;
+
+	// Parallel execution
+	bool d_bParallel;
+	unsigned d_uiNumThreads;
+	ThreadPoolPtr d_ThreadPool;
+
+	// Instrumentation from the last solve - only filled in FS_PROFILING builds
+	C_SolverStats d_Stats;
+	bool d_bTracing;
+	double d_dSolveStart;
+
+	// The parameters the sensitivities are found for, and how many the
+	// blocks' ports have tangents for right now
+	std::vector<S_ParameterRef> d_Sensitivities;
+	unsigned short d_usNumTangents;
 
 	// PRIVATE METHODS=========================================================
 
 	// For suming the sources before calling the blocks update function
-	void SumSources(FeedSourceList& feedList, C_FlowData* const fd);
+	void SumSources(const SourceArray& sources, C_FlowData* const fd);
+
+	// Tells the blocks that a size distribution has been loaded
+	void OnNewSizeDistribution();
+
+	// Builds the schedule and dependency levels from the source map
+	void CompileSchedule();
+
+	// Moves every block's ports into a new port store
+	void PackPorts();
+
+	// Adds the blocks with the role to the levels, skipping empty levels
+	void GroupLevels(const std::vector<unsigned>& level, unsigned numLevels, unsigned char role, LevelList& levels);
+
+	// Lists the output ports nothing reads from and the blocks nothing feeds
+	void FindUnconnectedPorts();
+
+	// Gives every block its tangents and seeds
+	void ApplySensitivities();
+
+	// Sums the sources, updates the block and checks if it has stopped changing
+	void UpdateScheduledBlock(S_ScheduledBlock& sb, bool lagged, bool check, unsigned worker);
+
+	// Records a trace event if tracing is on
+	void AddTraceEvent(unsigned char type, unsigned worker, BlockID id, ProcessID procID, double start, double end);
+
+	// One pass over the loop blocks - sequential or by level on the thread pool
+	void SequentialSweep();
+	void ParallelSweep();
+
+	// Updates the blocks downstream of every recycle once
+	void UpdateAfterConvergence();
+
+	// Rounds the converged water for reporting, keeping every block balanced
+	void RoundReportedWater();
 
-	// Checks to see if the block has stopped changing
-	void Check(C_SmartPointer<C_BlockPorts> deltPorts);
+	// Updates the report blocks once the flows are final
+	void UpdateReportBlocks();
+
+	// Solves the flowsheet, rounding the water and updating the report
+	// blocks afterwards if report is set
+	bool Solve(bool report);
 
 	// For removing a block from the flowsheet
 	void RemoveFromSources(BlockIDList& DestList, const BlockID& removedID);
@@ -101,26 +266,94 @@ public:
 
 	// Constructor/Destructor
 	C_Flowsheet();
+	// A flowsheet that shares a parent flowsheet's parameters and size distribution
+	explicit C_Flowsheet(FSParamsPtr parentParams);
 	~C_Flowsheet();
 
 	// Wipes any FSBlocks in memory and sets everything to zero
 	void Reset();
 
 	// Solves the flowsheet - returns true if it converged, false if it hit the max number of iterations
-	bool SolveFlowSheet();
+	bool SolveFlowSheet() { return Solve(true); }
+
+	// Sets the metric bit.  The water is held in the same mass units as the
+	// solids and only converted to m3/h or US gpm on the way in and out, so
+	// set this before passing any parameters.
+	void SetMetric(bool b) 
+	{ 
+		d_fspFSParams->d_bMetric = b; 
+		d_fspFSParams->d_fWaterUnit = b ? 1.0f : 4.0f;
+	}
 
-	// Sets the metric bit
-	void SetMetric(bool b) { d_fspFSParams->d_bMetric = b; }
+	// Reported water per unit of water held in the ports
+	float GetWaterUnit() const { return d_fspFSParams->d_fWaterUnit; }
 
+	// Both on, and no water rounding, by default
 	void SetUpdateSolids(bool b) { d_fspFSParams->d_bUpdateSolids = b; }
 	void SetUpdateWater(bool b) { d_fspFSParams->d_bUpdateWater = b; }
 	void SetRoundToWater(int r) { d_fspFSParams->d_iWaterRoundTo = r; }
 
-	// Sets the delta for balancing the flowsheet
+	// Lets the blocks skip updates when their feed and parameters have not
+	// changed since the last one.  On by default.
+	void SetMemoize(bool b) { d_fspFSParams->d_bMemoize = b; }
+
+	// Sets the delta for balancing the flowsheet.  0.01 by default.
 	void SetDelta(float d) { d_fDelta = d; }
 
+	// Lets every value move by r times its size as well as the delta, so a
+	// big plant can be held to a tight delta on its small streams without
+	// asking for less than the round-off of its big ones.  0 by default.
+	void SetRelativeDelta(float r) { d_fRelDelta = (r > 0.0f) ? r : 0.0f; }
+
+	// Sums the size fractions into the solid rates in double, with the
+	// flows still stored in float.  Off by default.  Changing it
+	// reallocates the ports like loading a size distribution.  Build with
+	// FS_DOUBLE_PRECISION to store the flows in double as well.
+	void SetWideSums(bool b);
+
+	// The sweeps a solve may take, and the passes rounding the water may
+	// take after it.  100 by default.
 	void SetMaxIterations(unsigned i) { d_uiMaxNumberIter = i; }
 
+	// Updates the blocks level by level on a thread pool.  Blocks in a recycle
+	// read the value from the previous sweep so the result does not depend
+	// on the number of threads.
+	void SetParallel(bool b) { d_bParallel = b; }
+	void SetNumThreads(unsigned n) { d_uiNumThreads = (n == 0) ? 1 : n; }
+
+	// The number of sweeps the last SolveFlowSheet took
+	unsigned GetNumIterations() const { return d_uiNumIterations; }
+
+	// The number of block updates the last SolveFlowSheet did, feeds included.
+	// Updates skipped on a memo hit are not counted.
+	unsigned long GetNumBlockUpdates() const { return d_ulNumBlockUpdates; }
+
+	// Finds the blocks that take no part in the solve, the ones that are
+	// only updated once it has converged, and the loose ports.  Done
+	// before every solve after the links change.
+	const S_GraphAnalysis& AnalyseGraph();
+
+	// Every block's ports in BlockID order, in one store that solves write
+	// into.  Compiles the schedule first if the links have changed.  The
+	// store is replaced when the blocks, links or size distribution change.
+	C_SmartPointer<C_PortStore> GetPortStore();
+
+	// Publishes a snapshot of every port after each SolveFlowSheet that
+	// converges, for other threads to read while the next one runs.  The
+	// publisher is not owned and must outlive the flowsheet or be unset
+	// with NULL.
+	void SetPublisher(C_ResultPublisher* publisher) { d_Publisher = publisher; }
+
+	// Timing, allocation and residual stats for the last solve.  Only the
+	// iteration count is filled in unless built with FS_PROFILING.
+	const C_SolverStats& GetSolverStats() const { return d_Stats; }
+
+	// Records a trace event for every block update (FS_PROFILING builds only)
+	void SetTracing(bool b) { d_bTracing = b; }
+
+	// Writes the last solve as Chrome trace-event JSON
+	bool WriteChromeTrace(const char* fileName) const { return d_Stats.WriteChromeTrace(fileName); }
+
 	// Creates a new block
 	BlockID CreateBlock(const unsigned short& procID);
 
@@ -136,12 +369,68 @@ public:
 	// Loads the size distribution from a text file and tells the 
 	// blocks that a size distribution has been updated
 	bool LoadSizeDistribution(const char* fileName);
+	bool LoadSizeDistribution(std::istream& stream);
+
+	// Loads a washability table.  From then on the feeds split their solids
+	// by density class and the streams carry them through the flowsheet.
+	bool LoadWashability(const char* fileName);
+	bool LoadWashability(std::istream& stream);
+
+	// Loads partition number tables for the fine circuit units.  A file
+	// is only read once; every flowsheet that loads it shares the tables.
+	bool LoadPartitionNumbers(const char* fileName);
+
+	// Zeros every block's ports (except the feeds) so the next solve starts cold
+	void ZeroFlows();
 
 	// Prints the Size distribution to the console
 	void PrintSizeDistribution() { d_fspFSParams->d_sdSizeDistribution.PrintSizeDist(); }
 
+	// false until a size distribution has loaded, or after one fails to
+	bool HasSizeDistribution() const { return d_fspFSParams->d_sdSizeDistribution.GetNumSizeFractions() > 0; }
+
+	// Gets a block, null if the id is not in the flowsheet
+	BlockPtr GetBlock(const BlockID& id) 
+	{ 
+		BlockMapIterator itr = d_BlockMap.find(id);
+		return (itr == d_BlockMap.end()) ? BlockPtr() : itr->second;
+	}
+
+	// Lists the blocks in BlockID order
+	void GetBlockIDs(std::vector<BlockID>& ids) const;
+
+	// Sets or gets a single named parameter on a block, e.g. "FeedRate" or "CutPoint0"
+	bool SetParameter(const BlockID& id, const std::string& name, const float& value);
+	bool GetParameter(const BlockID& id, const std::string& name, float& value);
+
+	// Rebuilds dest as a copy of this flowsheet - same blocks, ids, links, settings and
+	// parameters - with its own copy of the flowsheet parameters and size distribution
+	void Clone(C_Flowsheet& dest);
+
+	// Finds the derivatives of every stream with respect to these parameters
+	// while solving.  Each parameter is one tangent, in the order given.
+	// Derivatives are carried through the water rounding as if it were not
+	// there, and cut points, which snap to the size grid, have none.
+	// Returns false, and turns them off, if a parameter does not exist.
+	enum { SENS_SOLIDS = 0, SENS_WATER, SENS_PERSOLIDS };
+	bool SetSensitivities(const std::vector<S_ParameterRef>& params);
+	void ClearSensitivities() { SetSensitivities(std::vector<S_ParameterRef>()); }
+	unsigned short GetNumSensitivities() const { return (unsigned short)d_Sensitivities.size(); }
+	const std::vector<S_ParameterRef>& GetSensitivities() const { return d_Sensitivities; }
+
+	// d(quantity of the stream) / d(parameter k) from the last solve
+	float GetSensitivity(const S_StreamKey& stream, unsigned char quantity, unsigned short k);
+
+	// The streams x parameters matrix of sensitivities, row major
+	void GetJacobian(const std::vector<S_StreamKey>& streams, unsigned char quantity, std::vector<float>& jacobian);
+
 	// Pushes parameters to a block
-	void PushParameters(BlockParamsPtr fsbParams) { d_BlockMap[fsbParams->d_BlockID]->OnParameters(fsbParams); }
+	void PushParameters(BlockParamsPtr fsbParams) 
+	{ 
+		BlockPtr block = d_BlockMap[fsbParams->d_BlockID];
+		block->OnParameters(fsbParams);
+		block->InvalidateMemo();
+	}
 };
 
 
@@ -157,8 +446,56 @@ inline C_Flowsheet::C_Flowsheet()
 {
 	d_bDone = false;
 	d_fspFSParams = new S_FlowSheetParams;
+	d_fspFSParams->d_uiGridVersion = 0;
+	d_fspFSParams->d_bMemoize = true;
+	d_fspFSParams->d_bWideSums = false;
+	d_fspFSParams->d_iWaterRoundTo = 0;
+	d_fspFSParams->d_bUpdateSolids = true;
+	d_fspFSParams->d_bUpdateWater = true;
+	SetMetric(true);
+	d_bOwnsParams = true;
+	d_fDelta = 0.01f;
+	d_fRelDelta = 0.0f;
+	d_uiMaxNumberIter = 100;
 	d_uiNumIterations = 0;
+	d_ulNumBlockUpdates = 0;
 	d_BlockFactory = new C_BlockFactory(d_fspFSParams, 100);
+	d_bScheduleValid = false;
+	d_bParallel = false;
+	d_uiNumThreads = 1;
+	d_bTracing = false;
+	d_dSolveStart = 0.0;
+	d_usNumTangents = 0;
+	d_Publisher = NULL;
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_Flowsheet
+// Description 
+//	Performs Initialization with a parent flowsheet's parameters.
+// 
+// Arguments:	parentParams - the parent's flowsheet parameters
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline C_Flowsheet::C_Flowsheet(FSParamsPtr parentParams)
+{
+	d_bDone = false;
+	d_fspFSParams = parentParams;
+	d_bOwnsParams = false;
+	d_fDelta = 0.01f;
+	d_fRelDelta = 0.0f;
+	d_uiMaxNumberIter = 100;
+	d_uiNumIterations = 0;
+	d_ulNumBlockUpdates = 0;
+	d_BlockFactory = new C_BlockFactory(d_fspFSParams, 100);
+	d_bScheduleValid = false;
+	d_bParallel = false;
+	d_uiNumThreads = 1;
+	d_bTracing = false;
+	d_dSolveStart = 0.0;
+	d_usNumTangents = 0;
+	d_Publisher = NULL;
 }
 
 
@@ -173,7 +510,11 @@ inline C_Flowsheet::C_Flowsheet()
 inline C_Flowsheet::~C_Flowsheet()
 {
 	Reset();
-	d_fspFSParams->d_sdSizeDistribution.UnloadSizeDist();
+	if(d_bOwnsParams)
+	{
+		d_fspFSParams->d_sdSizeDistribution.UnloadSizeDist();
+		d_fspFSParams->d_wbWashability.UnloadWashability();
+	}
 }
 
 
@@ -195,6 +536,7 @@ inline BlockID C_Flowsheet::CreateBlock(const unsigned short &procID)
 		return 0;
 
 	d_BlockMap[temp->GetBlockID()] = temp;
+	d_bScheduleValid = false;
 	
 	return temp->GetBlockID();
 }
@@ -214,6 +556,9 @@ inline void C_Flowsheet::Reset()
 	d_SourceMap.clear();
 	d_DestMap.clear();
 	d_BlockFactory->Reset();
+	d_Schedule.clear();
+	d_LoopOrder.clear();
+	d_bScheduleValid = false;
 }
 
 //-----------------------------------------------------------------------
@@ -230,6 +575,7 @@ inline void C_Flowsheet::BreakLink(BlockID from, BlockID to, PortNo port)
 {
 	d_DestMap[from].remove(to);
 	DeleteSourceLink(from, to, port);
+	d_bScheduleValid = false;
 }
 
 //-----------------------------------------------------------------------
@@ -245,6 +591,7 @@ inline void C_Flowsheet::MakeLink(BlockID from, PortNo fromPort, BlockID to)
 {
 	d_DestMap[from].push_back(to);
 	d_SourceMap[to].push_back(S_FeedSource(d_BlockMap[from], fromPort));
+	d_bScheduleValid = false;
 }
 
 
@@ -263,6 +610,7 @@ inline void C_Flowsheet::RemoveBlock(const BlockID &id)
 	d_DestMap.erase(id);
 	d_SourceMap.erase(id);
 	d_BlockMap.erase(id);
+	d_bScheduleValid = false;
 }
 
 #endif // _FLOWSHEET_
\ No newline at end of file
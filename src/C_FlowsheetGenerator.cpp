@@ -0,0 +1,286 @@
+//======================================================================
+// C_FlowsheetGenerator.cpp
+// Author: James McCormick
+// Description:
+//	Builds random flowsheets for benchmarking the solver.
+//======================================================================
+
+#include "C_FlowsheetGenerator.h"
+#include "C_FeedBlock.h"
+#include "C_DeslimeScreenSD.h"
+#include "C_DeslimeScreenDD.h"
+#include "C_SumpPump.h"
+#include "C_Splitter.h"
+
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_FlowsheetGenerator
+//-----------------------------------------------------------------------
+C_FlowsheetGenerator::C_FlowsheetGenerator(const S_GeneratorParams& params) : d_gpParams(params),
+	d_ullRandom(params.uiSeed), d_uiBlocksCreated(0), d_uiLoopsCreated(0)
+{
+	if(d_gpParams.usNumFractions < 3)
+		d_gpParams.usNumFractions = 3;
+	if(d_gpParams.uiFanIn == 0)
+		d_gpParams.uiFanIn = 1;
+	if(d_gpParams.uiNumFeeds == 0)
+		d_gpParams.uiNumFeeds = 1;
+}
+
+
+//-----------------------------------------------------------------------
+// Random - Private C_FlowsheetGenerator
+// Description
+//	A splitmix64 generator, so the flowsheets are the same on every
+//	compiler and platform.
+//-----------------------------------------------------------------------
+float C_FlowsheetGenerator::Random()
+{
+	unsigned long long z = (d_ullRandom += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z = z ^ (z >> 31);
+	return (float)((z >> 40) * (1.0 / 16777216.0));
+}
+
+unsigned C_FlowsheetGenerator::Random(unsigned n)
+{
+	unsigned r = (unsigned)(Random() * n);
+	return (r < n) ? r : n - 1;
+}
+
+
+//-----------------------------------------------------------------------
+// WriteSizeDistribution - Private C_FlowsheetGenerator
+// Description
+//	A geometric sieve series from 254mm down to 38 microns with a
+//	Gaudin-Schuhmann distribution (modulus 0.5) across it.  The sizes
+//	are written with enough digits to read back bit for bit, so the cut
+//	points picked from d_Passing match the loaded fractions exactly.
+//
+// Arguments:	stream - where to write the distribution
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_FlowsheetGenerator::WriteSizeDistribution(ostream& stream)
+{
+	const unsigned short n = d_gpParams.usNumFractions;
+	const double top = 254.0;
+	const double ratio = pow(0.038 / top, 1.0 / (n - 1));
+
+	d_Passing.resize(n + 1);
+	for(unsigned short i = 0; i < n; i++)
+		d_Passing[i] = (float)(top * pow(ratio, (double)i));
+	d_Passing[n] = 0.0f;
+
+	stream << n << "\n" << setprecision(9);
+
+	double cumRetained = 0.0;
+	for(unsigned short i = 0; i < n; i++)
+	{
+		double fractional = 100.0 * (sqrt(d_Passing[i] / top) - sqrt(d_Passing[i + 1] / top));
+		cumRetained += fractional;
+		stream << d_Passing[i] << "\t" << d_Passing[i + 1] << "\t" << (float)fractional << "\t" << (float)cumRetained << "\n";
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// RandomCutPoint - Private C_FlowsheetGenerator
+// Description
+//	Picks a size boundary between the given indices.  Index 0 is the top
+//	size and d_Passing.size() - 1 is zero, so neither is a valid cut.
+//-----------------------------------------------------------------------
+float C_FlowsheetGenerator::RandomCutPoint(unsigned minIndex, unsigned maxIndex)
+{
+	if(minIndex < 1)
+		minIndex = 1;
+	if(maxIndex > d_Passing.size() - 2)
+		maxIndex = (unsigned)d_Passing.size() - 2;
+	if(maxIndex < minIndex)
+		maxIndex = minIndex;
+
+	return d_Passing[minIndex + Random(maxIndex - minIndex + 1)];
+}
+
+
+//-----------------------------------------------------------------------
+// AddUnit - Private C_FlowsheetGenerator
+// Description
+//	Creates a screen or sump fed from input plus up to uiFanIn - 1 other
+//	open ports.  One output carries on down the segment and the others
+//	are left open for later blocks to pick up.
+//
+// Arguments:	fs - the flowsheet, input - the main feed for the unit
+// Returns:		The output port that carries on.
+//-----------------------------------------------------------------------
+C_FlowsheetGenerator::S_OpenPort C_FlowsheetGenerator::AddUnit(C_Flowsheet& fs, const S_OpenPort& input)
+{
+	float total = d_gpParams.fSingleDeckWeight + d_gpParams.fDoubleDeckWeight + d_gpParams.fSumpWeight;
+	float pick = Random() * ((total > 0.0f) ? total : 1.0f);
+
+	ProcessID procID;
+	if(pick < d_gpParams.fSingleDeckWeight)
+		procID = PROCID_DESLIME_SINGLEDECK;
+	else if(pick < d_gpParams.fSingleDeckWeight + d_gpParams.fDoubleDeckWeight)
+		procID = PROCID_DESLIME_DOUBLEDECK;
+	else
+		procID = PROCID_SUMPPUMP;
+
+	BlockID id = fs.CreateBlock(procID);
+	d_uiBlocksCreated++;
+	fs.MakeLink(input.blockID, input.port, id);
+
+	// Extra fan-in from the open ports
+	unsigned extra = Random(d_gpParams.uiFanIn);
+	for(unsigned i = 0; i < extra && !d_OpenPorts.empty(); i++)
+	{
+		unsigned index = Random((unsigned)d_OpenPorts.size());
+		fs.MakeLink(d_OpenPorts[index].blockID, d_OpenPorts[index].port, id);
+		d_OpenPorts[index] = d_OpenPorts.back();
+		d_OpenPorts.pop_back();
+	}
+
+	const unsigned numSizes = (unsigned)d_Passing.size() - 1;
+	PortNo numOutputs = 1;
+	PortNo firstOutput = 0;
+
+	switch(procID)
+	{
+		case PROCID_DESLIME_SINGLEDECK:
+		{
+			fs.PushParameters( new C_DeslimeScreenSDParams(id, procID, 0.05f + 0.15f * Random(),
+				RandomCutPoint(numSizes / 4, 3 * numSizes / 4), 100.0f * Random()) );
+			firstOutput = 1;
+			numOutputs = 2;
+			break;
+		}
+		case PROCID_DESLIME_DOUBLEDECK:
+		{
+			float top = RandomCutPoint(1, numSizes / 2);
+			float bottom = RandomCutPoint(numSizes / 2 + 1, numSizes - 1);
+			fs.PushParameters( new C_DeslimeScreenDDParams(id, procID, 0.05f + 0.1f * Random(), 0.1f + 0.1f * Random(),
+				top, bottom, 100.0f * Random()) );
+			firstOutput = 1;
+			numOutputs = 3;
+			break;
+		}
+		default:
+		{
+			fs.PushParameters( new C_SumpPumpParams(id, procID, 200.0f * Random()) );
+			break;
+		}
+	}
+
+	PortNo carry = firstOutput + (PortNo)Random(numOutputs);
+	for(PortNo p = firstOutput; p < firstOutput + numOutputs; p++)
+	{
+		if(p != carry)
+			d_OpenPorts.push_back(S_OpenPort(id, p));
+	}
+
+	return S_OpenPort(id, carry);
+}
+
+
+//-----------------------------------------------------------------------
+// BuildSegment - Private C_FlowsheetGenerator
+// Description
+//	Adds units one after another from input until the budget is used.
+//	A unit may instead start a recycle loop: a sump mixes the incoming
+//	stream with the return, a nested segment forms the body and a
+//	splitter sends fRecycleSplit of the body's product back to the sump.
+//
+// Arguments:	fs - the flowsheet, input - the stream to start from
+//				budget - blocks left to create (decremented)
+//				depth - the current loop nesting
+// Returns:		The stream leaving the segment.
+//-----------------------------------------------------------------------
+C_FlowsheetGenerator::S_OpenPort C_FlowsheetGenerator::BuildSegment(C_Flowsheet& fs, S_OpenPort input, unsigned& budget, unsigned depth)
+{
+	S_OpenPort current = input;
+
+	while(budget > 0)
+	{
+		if(depth < d_gpParams.uiLoopDepth && budget >= 3 && Random() < d_gpParams.fRecycleRatio)
+		{
+			BlockID head = fs.CreateBlock(PROCID_SUMPPUMP);
+			fs.PushParameters( new C_SumpPumpParams(head, PROCID_SUMPPUMP, 0.0f) );
+			fs.MakeLink(current.blockID, current.port, head);
+
+			BlockID split = fs.CreateBlock(PROCID_SPLITTER);
+			fs.PushParameters( new C_SplitterParams(split, PROCID_SPLITTER, d_gpParams.fRecycleSplit) );
+			d_uiBlocksCreated += 2;
+			d_uiLoopsCreated++;
+			budget -= 2;
+
+			// The body gets a share of what is left
+			unsigned body = 1 + Random(budget / 2 + 1);
+			if(body > budget)
+				body = budget;
+			budget -= body;
+
+			S_OpenPort bodyOut = BuildSegment(fs, S_OpenPort(head, 0), body, depth + 1);
+			budget += body;
+
+			fs.MakeLink(bodyOut.blockID, bodyOut.port, split);
+			fs.MakeLink(split, 1, head);
+			current = S_OpenPort(split, 2);
+		}
+		else
+		{
+			current = AddUnit(fs, current);
+			budget--;
+		}
+
+		// Nested segments stop early some of the time so loops vary in length
+		if(depth > 0 && Random() < 0.25f)
+			break;
+	}
+
+	return current;
+}
+
+
+//-----------------------------------------------------------------------
+// Generate - Public C_FlowsheetGenerator
+// Description
+//	Resets the flowsheet, loads the generated size distribution and
+//	builds uiNumBlocks blocks shared out between the feeds.  Streams that
+//	are never picked up for fan-in are left open.
+//
+// Arguments:	fs - the flowsheet to build into
+// Returns:		true if the size distribution loaded
+//-----------------------------------------------------------------------
+bool C_FlowsheetGenerator::Generate(C_Flowsheet& fs)
+{
+	d_ullRandom = d_gpParams.uiSeed;
+	d_OpenPorts.clear();
+	d_uiBlocksCreated = 0;
+	d_uiLoopsCreated = 0;
+
+	fs.Reset();
+
+	stringstream sizeDist;
+	WriteSizeDistribution(sizeDist);
+	if(!fs.LoadSizeDistribution(sizeDist))
+		return false;
+
+	unsigned remaining = d_gpParams.uiNumBlocks;
+	for(unsigned f = 0; f < d_gpParams.uiNumFeeds; f++)
+	{
+		BlockID feed = fs.CreateBlock(PROCID_FEED);
+		fs.PushParameters( new C_FeedBlockParams(feed, PROCID_FEED, 200.0f + 800.0f * Random(), 0.05f + 0.25f * Random()) );
+
+		unsigned budget = remaining / (d_gpParams.uiNumFeeds - f);
+		remaining -= budget;
+		BuildSegment(fs, S_OpenPort(feed, 0), budget, 0);
+	}
+
+	return true;
+}
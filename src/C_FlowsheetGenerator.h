@@ -0,0 +1,104 @@
+//======================================================================
+// C_FlowsheetGenerator.h
+// Author: James McCormick
+// Description:
+//	Builds random flowsheets for benchmarking the solver.  The size of
+//	the flowsheet, the mix of blocks, the recycle loops, the fan-in and
+//	the number of size fractions are all set by S_GeneratorParams.  The
+//	same parameters and seed always give the same flowsheet.
+//======================================================================
+
+#ifndef _FLOWSHEETGENERATOR_
+#define _FLOWSHEETGENERATOR_
+
+#include "C_Flowsheet.h"
+#include <vector>
+#include <ostream>
+
+struct S_GeneratorParams
+{
+	unsigned uiNumBlocks;			// Blocks to create, not counting the feeds
+	unsigned uiNumFeeds;			// Number of feed blocks
+
+	// The relative weights of the process types
+	float fSingleDeckWeight;
+	float fDoubleDeckWeight;
+	float fSumpWeight;
+
+	float fRecycleRatio;			// Chance that a new unit starts a recycle loop
+	float fRecycleSplit;			// Fraction of the loop product sent back to the start
+	unsigned uiLoopDepth;			// The deepest nesting of recycle loops
+	unsigned uiFanIn;				// The most sources linked into one block
+
+	unsigned short usNumFractions;	// Size fractions in the generated size distribution
+	unsigned uiSeed;
+
+	S_GeneratorParams() : uiNumBlocks(100), uiNumFeeds(1), fSingleDeckWeight(1.0f), fDoubleDeckWeight(1.0f),
+		fSumpWeight(1.0f), fRecycleRatio(0.0f), fRecycleSplit(0.3f), uiLoopDepth(1), uiFanIn(1),
+		usNumFractions(25), uiSeed(1)
+	{}
+};
+
+
+class C_FlowsheetGenerator
+{
+private:
+
+	// An output port that has not been linked to anything yet
+	struct S_OpenPort
+	{
+		BlockID blockID;
+		PortNo port;
+		S_OpenPort(BlockID id = 0, PortNo p = 0) : blockID(id), port(p) {}
+	};
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	S_GeneratorParams d_gpParams;
+
+	// The state of the random number generator
+	unsigned long long d_ullRandom;
+
+	// The size fraction boundaries, [0] is the top size
+	std::vector<float> d_Passing;
+
+	// Ports that are free to be used for fan-in
+	std::vector<S_OpenPort> d_OpenPorts;
+
+	// Counts from the last Generate
+	unsigned d_uiBlocksCreated;
+	unsigned d_uiLoopsCreated;
+
+	// PRIVATE METHODS=========================================================
+
+	// A random number in [0, 1) and in [0, n)
+	float Random();
+	unsigned Random(unsigned n);
+
+	// Builds the size fraction boundaries and writes them in the size distribution file format
+	void WriteSizeDistribution(std::ostream& stream);
+
+	// Picks one of the interior size boundaries for a cut point
+	float RandomCutPoint(unsigned minIndex, unsigned maxIndex);
+
+	// Creates one unit fed from the input and returns the output that carries on
+	S_OpenPort AddUnit(C_Flowsheet& fs, const S_OpenPort& input);
+
+	// Builds a chain of units, with nested recycle loops, using up the budget of blocks
+	S_OpenPort BuildSegment(C_Flowsheet& fs, S_OpenPort input, unsigned& budget, unsigned depth);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_FlowsheetGenerator(const S_GeneratorParams& params);
+
+	// Resets fs, loads a generated size distribution and builds the flowsheet
+	bool Generate(C_Flowsheet& fs);
+
+	// Counts from the last Generate
+	unsigned GetNumBlocks() const { return d_uiBlocksCreated; }
+	unsigned GetNumLoops() const { return d_uiLoopsCreated; }
+};
+
+#endif // _FLOWSHEETGENERATOR_
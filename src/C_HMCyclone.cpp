@@ -0,0 +1,104 @@
+//======================================================================
+// C_HMCyclone.cpp 
+// Author: James McCormick
+// Description:
+//	A block that represents a heavy medium cyclone
+//
+//======================================================================
+
+#include "C_HMCyclone.h"
+
+// The size distribution has been updated
+void C_HMCyclone::OnNewSizeDistribution()
+{
+	d_bPartitionValid = false;
+	d_Ports.Reset();
+}
+
+// Is called to pass the parameters to the block
+void C_HMCyclone::OnParameters(BlockParamsPtr p)
+{
+	// If the process id of the parameters does not match the id for this
+	// block, then exit
+	if(p->d_ProcessID != d_ProccessID)
+		return;
+
+	C_HMCycloneParams* castParams = static_cast<C_HMCycloneParams*>((I_FSBlockParameters*)p);
+
+	d_fCutDensity = castParams->d_fCutDensity;
+	d_fEp = castParams->d_fEp;
+	d_AddWater = WaterFromReport(castParams->d_fAddWater);
+	d_fWaterSplit = castParams->d_fWaterSplit;
+	d_bPartitionValid = false;
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateWater - Protected C_HMCyclone
+// Description 
+//	The feed water and the add water are split between the clean and
+//	refuse by d_fWaterSplit.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_HMCyclone::UpdateWater()
+{
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	C_FlowData* clean = d_Ports.GetFlowData(1);
+	C_FlowData* refuse = d_Ports.GetFlowData(2);
+
+	FluidRate total = feed->d_FluidRate + d_AddWater;
+	clean->d_FluidRate = total * d_fWaterSplit;
+	refuse->d_FluidRate = total - clean->d_FluidRate;
+
+	if(d_usNumTangents)
+	{
+		const float* addSeed = GetSeed("AddWater");
+		const float* splitSeed = GetSeed("WaterSplit");
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			FlowValue dTotal = feed->FluidTangent(k) + (addSeed ? addSeed[k] : 0.0f);
+			clean->FluidTangent(k) = dTotal * d_fWaterSplit + total * (splitSeed ? splitSeed[k] : 0.0f);
+			refuse->FluidTangent(k) = dTotal - clean->FluidTangent(k);
+		}
+	}
+}
+
+
+void C_HMCyclone::UpdateSolids()
+{
+	GravitySeperation(1, 2);
+}
+
+
+bool C_HMCyclone::SetParameter(const std::string& name, const float& value)
+{
+	if(name == "AddWater")
+		d_AddWater = WaterFromReport(value);
+	else if(name == "WaterSplit")
+		d_fWaterSplit = value;
+	else
+		return I_GravitySep::SetParameter(name, value);
+
+	return true;
+}
+
+bool C_HMCyclone::GetParameter(const std::string& name, float& value) const
+{
+	if(name == "AddWater")
+		value = WaterToReport(d_AddWater);
+	else if(name == "WaterSplit")
+		value = d_fWaterSplit;
+	else
+		return I_GravitySep::GetParameter(name, value);
+
+	return true;
+}
+
+void C_HMCyclone::GetParameterNames(std::vector<std::string>& names) const
+{
+	names.push_back("AddWater");
+	names.push_back("WaterSplit");
+	I_GravitySep::GetParameterNames(names);
+}
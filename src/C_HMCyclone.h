@@ -0,0 +1,75 @@
+//======================================================================
+// C_HMCyclone.h 
+// Author: James McCormick
+// Description:
+//	A block that represents a heavy medium cyclone
+//	The first port is the feed.
+//	The second port is the clean coal (overflow).
+//	The third port is the refuse (underflow).
+//======================================================================
+
+#ifndef _HMCYCLONE_
+#define _HMCYCLONE_
+
+#include "I_GravitySep.h"
+
+
+class C_HMCycloneParams : public I_FSBlockParameters
+{
+private:
+	C_HMCycloneParams();
+	C_HMCycloneParams(C_HMCycloneParams&);
+
+public:
+	C_HMCycloneParams(BlockID id, ProcessID p, float cutDensity, float ep, float addWater, float waterSplit) : 
+		I_FSBlockParameters(id, p), d_fCutDensity(cutDensity), d_fEp(ep), d_fAddWater(addWater), d_fWaterSplit(waterSplit)
+	{}
+
+	float d_fCutDensity;
+	float d_fEp;
+	float d_fAddWater;
+	float d_fWaterSplit;		// The fraction of the water that goes to the clean port
+};
+
+
+class C_HMCyclone : public I_GravitySep
+{
+protected:
+
+	// PROTECTED DATA MEMBERS==================================================
+	float d_fWaterSplit;
+
+	// PROTECTED METHODS=======================================================
+
+	virtual void UpdateWater();
+	virtual void UpdateSolids();
+
+	// The refuse takes the rounding
+	virtual int WaterBalancePort() const { return 2; }
+
+public:
+
+	// PUBLIC DATA MEMBERS=====================================================
+
+	// PUBLIC METHODS==========================================================
+
+	// Constructor
+	C_HMCyclone(FSParamsPtr fsp, const BlockID& ID) : I_GravitySep(fsp, ID), d_fWaterSplit(0.5f)
+	{
+		d_ProccessID = PROCID_HMC;
+		d_Ports.Init(fsp, 3); 
+	}
+
+	// The size distribution has been updated
+	virtual void OnNewSizeDistribution();
+
+	// Is called to pass the parameters to the block
+	virtual void OnParameters(BlockParamsPtr);
+
+	// Named parameters - "AddWater", "WaterSplit" and the gravity separation's
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
+};
+
+#endif // _HMCYCLONE_
@@ -0,0 +1,46 @@
+//======================================================================
+// C_InletBlock.h 
+// Author: James McCormick
+// Description:
+//	The inlet of a sub-flowsheet.  Its one port is the stream coming in
+//	to the sub-flowsheet, which the sub-flowsheet block fills in before
+//	each solve.  Like a feed it is not updated during the sweeps.
+//======================================================================
+
+#ifndef _INLETBLOCK_
+#define _INLETBLOCK_
+
+#include "I_FSBlock.h"
+
+class C_InletBlock : public I_FSBlock
+{
+protected:
+	
+	// PROTECTED METHODS=======================================================
+	C_InletBlock();
+	C_InletBlock(const C_InletBlock&);
+
+	void UpdateSolids() {}
+	void UpdateWater() {}
+
+public:
+
+	C_InletBlock(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID)
+	{
+		d_ProccessID = PROCID_INLET;
+		d_Ports.Init(fsp, 1); 
+	}
+
+	// The size distribution has been updated
+	void OnNewSizeDistribution() { d_Ports.Reset(); }
+
+	bool IsFeedBlock() const { return true; }
+
+	// The stream is set from outside
+	void OnUpdate() {}
+
+	// Is called to pass the parameters to the block
+	void OnParameters(BlockParamsPtr p) {}
+};
+
+#endif // _INLETBLOCK_
@@ -0,0 +1,277 @@
+//======================================================================
+// C_MonteCarlo.cpp
+// Author: James McCormick
+// Description:
+//	Propagates parameter uncertainty through a flowsheet.
+//======================================================================
+
+#include "C_MonteCarlo.h"
+#include <cmath>
+
+using namespace std;
+
+//-----------------------------------------------------------------------
+// SplitMix
+// Description
+//	Steps a splitmix64 generator and returns a value in (0, 1).
+//-----------------------------------------------------------------------
+static double SplitMix(unsigned long long& state)
+{
+	unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z = z ^ (z >> 31);
+	return ((z >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_MonteCarlo
+//-----------------------------------------------------------------------
+C_MonteCarlo::C_MonteCarlo() : d_ullSeed(1), d_uiNumThreads(1), d_uiBatchSize(256), d_pObserver(0),
+	d_uiNumSamples(0), d_uiNumConverged(0)
+{
+	d_Percentiles.push_back(0.05);
+	d_Percentiles.push_back(0.5);
+	d_Percentiles.push_back(0.95);
+}
+
+
+void C_MonteCarlo::AddNormal(const BlockID& id, const std::string& name, float mean, float stdDev)
+{
+	S_Uncertainty u = { id, name, S_Uncertainty::DIST_NORMAL, mean, stdDev, 0.0f };
+	d_Uncertainties.push_back(u);
+}
+
+void C_MonteCarlo::AddUniform(const BlockID& id, const std::string& name, float min, float max)
+{
+	S_Uncertainty u = { id, name, S_Uncertainty::DIST_UNIFORM, min, max, 0.0f };
+	d_Uncertainties.push_back(u);
+}
+
+void C_MonteCarlo::AddTriangular(const BlockID& id, const std::string& name, float min, float mode, float max)
+{
+	S_Uncertainty u = { id, name, S_Uncertainty::DIST_TRIANGULAR, min, mode, max };
+	d_Uncertainties.push_back(u);
+}
+
+
+void C_MonteCarlo::ClearClones()
+{
+	for(size_t i = 0; i < d_Clones.size(); i++)
+		delete d_Clones[i];
+	d_Clones.clear();
+}
+
+
+//-----------------------------------------------------------------------
+// Sample - Private C_MonteCarlo
+// Description
+//	Draws a value from the parameter's distribution.
+//
+// Arguments:	u - the uncertain parameter, state - the sample's generator
+// Returns:		The value.
+//-----------------------------------------------------------------------
+float C_MonteCarlo::Sample(const S_Uncertainty& u, unsigned long long& state)
+{
+	double r = SplitMix(state);
+
+	switch(u.ucDistribution)
+	{
+		case S_Uncertainty::DIST_UNIFORM:
+		{
+			return (float)(u.fA + (u.fB - u.fA) * r);
+		}
+		case S_Uncertainty::DIST_TRIANGULAR:
+		{
+			double range = u.fC - u.fA;
+			if(range <= 0.0)
+				return u.fA;
+			double split = (u.fB - u.fA) / range;
+			if(r < split)
+				return (float)(u.fA + sqrt(r * range * (u.fB - u.fA)));
+			return (float)(u.fC - sqrt((1.0 - r) * range * (u.fC - u.fB)));
+		}
+		default:
+		{
+			// Box-Muller
+			double r2 = SplitMix(state);
+			return (float)(u.fA + u.fB * sqrt(-2.0 * log(r)) * cos(6.283185307179586 * r2));
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// RunSample - Private C_MonteCarlo
+// Description
+//	Sets the sampled parameters on a clone, solves it from cold and
+//	copies every stream into the batch buffer.  The generator is seeded
+//	from the sample number so the values do not depend on the thread.
+//	The clone is solved on a pool thread, so its report blocks are not
+//	run; the water is still rounded so the streams are as reported.
+//
+// Arguments:	sample - the sample number, slot - the place in the batch
+//				fs - the worker's clone
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_MonteCarlo::RunSample(unsigned sample, unsigned slot, C_Flowsheet& fs)
+{
+	unsigned long long state = d_ullSeed ^ (0xD1B54A32D192ED03ULL * (sample + 1));
+
+	for(size_t i = 0; i < d_Uncertainties.size(); i++)
+		fs.SetParameter(d_Uncertainties[i].blockID, d_Uncertainties[i].name, Sample(d_Uncertainties[i], state));
+
+	fs.ZeroFlows();
+	d_BatchConverged[slot] = fs.Solve(false) ? 1 : 0;
+	fs.RoundReportedWater();
+
+	float* values = &d_BatchValues[(size_t)slot * d_Streams.size() * NUM_METRICS];
+	BlockID lastID = 0;
+	BlockPtr block;
+	for(size_t s = 0; s < d_Streams.size(); s++)
+	{
+		if(block == NULL || d_Streams[s].blockID != lastID)
+		{
+			lastID = d_Streams[s].blockID;
+			block = fs.GetBlock(lastID);
+		}
+
+		C_FlowData* fd = block->GetFlowData(d_Streams[s].port);
+		values[s * NUM_METRICS + METRIC_SOLIDS] = fd->d_SolidRate;
+		values[s * NUM_METRICS + METRIC_WATER] = fd->GetFluidRate();
+		values[s * NUM_METRICS + METRIC_PERSOLIDS] = fd->d_PerSolids;
+	}
+}
+
+
+void C_MonteCarlo::C_SampleTask::RunTask(const unsigned& index, const unsigned& worker)
+{
+	d_pMonteCarlo->RunSample(d_uiFirstSample + index, index, *d_pMonteCarlo->d_Clones[worker]);
+}
+
+
+//-----------------------------------------------------------------------
+// Run - Public C_MonteCarlo
+// Description
+//	Clones the flowsheet once per thread and runs the samples in
+//	batches.  Each batch is solved in parallel and then merged into the
+//	statistics in sample order.  Samples that do not converge are
+//	counted but left out of the statistics.
+//
+// Arguments:	fs - the flowsheet to sample, numSamples - how many to run
+// Returns:		false, running nothing, if a parameter is not on the
+//				flowsheet.
+//-----------------------------------------------------------------------
+bool C_MonteCarlo::Run(C_Flowsheet& fs, unsigned numSamples)
+{
+	d_uiNumSamples = 0;
+	d_uiNumConverged = 0;
+
+	// The parameters are set without checks on the workers
+	for(size_t i = 0; i < d_Uncertainties.size(); i++)
+	{
+		float value = 0.0f;
+		if(!fs.GetParameter(d_Uncertainties[i].blockID, d_Uncertainties[i].name, value))
+			return false;
+	}
+
+	// The clones are built on this thread, then each is only touched by its worker
+	ClearClones();
+	for(unsigned i = 0; i < d_uiNumThreads; i++)
+	{
+		d_Clones.push_back(new C_Flowsheet);
+		fs.Clone(*d_Clones.back());
+		d_Clones.back()->SetParallel(false);
+	}
+
+	// Every port of every block is a stream.  The report blocks are not
+	// run on the clones, and only repeat their feed anyway.
+	d_Streams.clear();
+	std::vector<BlockID> ids;
+	fs.GetBlockIDs(ids);
+	for(size_t i = 0; i < ids.size(); i++)
+	{
+		if(fs.GetBlock(ids[i])->IsReportBlock())
+			continue;
+
+		PortNo numPorts = fs.GetBlock(ids[i])->GetPorts().GetNumPorts();
+		for(PortNo p = 0; p < numPorts; p++)
+		{
+			S_StreamKey key = { ids[i], p };
+			d_Streams.push_back(key);
+		}
+	}
+
+	d_Stats.assign(d_Streams.size() * NUM_METRICS, C_StreamStatistic());
+	for(size_t i = 0; i < d_Stats.size(); i++)
+		d_Stats[i].Init(d_Percentiles);
+
+	d_BatchValues.assign((size_t)d_uiBatchSize * d_Streams.size() * NUM_METRICS, 0.0f);
+	d_BatchConverged.assign(d_uiBatchSize, 0);
+
+	C_ThreadPool pool(d_uiNumThreads);
+
+	for(unsigned first = 0; first < numSamples; first += d_uiBatchSize)
+	{
+		unsigned count = numSamples - first;
+		if(count > d_uiBatchSize)
+			count = d_uiBatchSize;
+
+		C_SampleTask task(this, first);
+		pool.ParallelFor(task, count);
+
+		// Merge in sample order so the percentile estimates are reproducible
+		const size_t stride = d_Streams.size() * NUM_METRICS;
+		for(unsigned slot = 0; slot < count; slot++)
+		{
+			d_uiNumSamples++;
+			if(!d_BatchConverged[slot])
+				continue;
+
+			d_uiNumConverged++;
+			const float* values = &d_BatchValues[slot * stride];
+			for(size_t v = 0; v < stride; v++)
+				d_Stats[v].Add(values[v]);
+		}
+
+		if(d_pObserver)
+			d_pObserver->OnBatch(*this, d_uiNumSamples);
+	}
+
+	ClearClones();
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// WriteSummary - Public C_MonteCarlo
+// Description
+//	Writes the statistics as comma separated values with a header line.
+//
+// Arguments:	out - where to write
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_MonteCarlo::WriteSummary(ostream& out) const
+{
+	static const char* metricNames[NUM_METRICS] = { "solids", "water", "persolids" };
+
+	out << "block,port,metric,count,mean,stddev,min,max";
+	for(size_t p = 0; p < d_Percentiles.size(); p++)
+		out << ",p" << d_Percentiles[p] * 100.0;
+	out << "\n";
+
+	for(unsigned s = 0; s < GetNumStreams(); s++)
+	{
+		for(unsigned m = 0; m < NUM_METRICS; m++)
+		{
+			const C_StreamStatistic& stat = GetStatistic(s, m);
+			out << d_Streams[s].blockID << "," << d_Streams[s].port << "," << metricNames[m] << ","
+				<< stat.GetCount() << "," << stat.GetMean() << "," << sqrt(stat.GetVariance()) << ","
+				<< stat.GetMin() << "," << stat.GetMax();
+			for(unsigned q = 0; q < stat.GetNumQuantiles(); q++)
+				out << "," << stat.GetQuantile(q).Get();
+			out << "\n";
+		}
+	}
+}
@@ -0,0 +1,140 @@
+//======================================================================
+// C_MonteCarlo.h
+// Author: James McCormick
+// Description:
+//	Propagates parameter uncertainty through a flowsheet.  Each sample
+//	draws new values for the uncertain parameters, solves a copy of the
+//	flowsheet and adds every stream's solids, water and percent solids
+//	to streaming statistics.
+//
+//	Every worker thread solves its own clone of the flowsheet.  Samples
+//	are run in fixed size batches and merged in sample order, and each
+//	sample's random numbers depend only on the seed and the sample
+//	number, so the results are the same for any number of threads.
+//	Memory depends on the batch size, never on the number of samples.
+//======================================================================
+
+#ifndef _MONTECARLO_
+#define _MONTECARLO_
+
+#include "C_Flowsheet.h"
+#include "C_StreamingStats.h"
+#include <string>
+#include <vector>
+#include <ostream>
+
+// A parameter with measurement uncertainty
+struct S_Uncertainty
+{
+	enum { DIST_NORMAL = 0, DIST_UNIFORM, DIST_TRIANGULAR };
+
+	BlockID blockID;
+	std::string name;				// The named parameter, e.g. "FeedRate"
+	unsigned char ucDistribution;
+
+	// Normal: mean, std dev.  Uniform: min, max.  Triangular: min, mode, max.
+	float fA, fB, fC;
+};
+
+class C_MonteCarlo;
+
+// Told after each batch is merged so results can be streamed out while the run continues
+class I_MonteCarloObserver
+{
+public:
+	virtual ~I_MonteCarloObserver() {}
+	virtual void OnBatch(const C_MonteCarlo& mc, const unsigned& samplesDone) = 0;
+};
+
+
+class C_MonteCarlo
+{
+public:
+	enum { METRIC_SOLIDS = 0, METRIC_WATER, METRIC_PERSOLIDS, NUM_METRICS };
+
+private:
+
+	// Solves one batch of samples, one clone per worker
+	class C_SampleTask : public I_ParallelTask
+	{
+	public:
+		C_MonteCarlo* d_pMonteCarlo;
+		unsigned d_uiFirstSample;
+		C_SampleTask(C_MonteCarlo* mc, unsigned first) : d_pMonteCarlo(mc), d_uiFirstSample(first) {}
+		void RunTask(const unsigned& index, const unsigned& worker);
+	};
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	std::vector<S_Uncertainty> d_Uncertainties;
+	std::vector<double> d_Percentiles;
+
+	unsigned long long d_ullSeed;
+	unsigned d_uiNumThreads;
+	unsigned d_uiBatchSize;
+	I_MonteCarloObserver* d_pObserver;
+
+	// One clone of the flowsheet per worker
+	std::vector<C_Flowsheet*> d_Clones;
+
+	// The streams and a statistic for each stream and metric
+	std::vector<S_StreamKey> d_Streams;
+	std::vector<C_StreamStatistic> d_Stats;
+
+	// Per batch results - batch size x streams x metrics, plus a converged flag per sample
+	std::vector<float> d_BatchValues;
+	std::vector<char> d_BatchConverged;
+
+	unsigned d_uiNumSamples;
+	unsigned d_uiNumConverged;
+
+	// PRIVATE METHODS=========================================================
+
+	// Draws a value for an uncertain parameter
+	static float Sample(const S_Uncertainty& u, unsigned long long& state);
+
+	// Solves a sample on a clone and stores its stream values in the batch buffer
+	void RunSample(unsigned sample, unsigned slot, C_Flowsheet& fs);
+
+	void ClearClones();
+
+	C_MonteCarlo(const C_MonteCarlo&);
+	C_MonteCarlo& operator=(const C_MonteCarlo&);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_MonteCarlo();
+	~C_MonteCarlo() { ClearClones(); }
+
+	// Adds an uncertain parameter
+	void AddUncertainty(const S_Uncertainty& u) { d_Uncertainties.push_back(u); }
+	void AddNormal(const BlockID& id, const std::string& name, float mean, float stdDev);
+	void AddUniform(const BlockID& id, const std::string& name, float min, float max);
+	void AddTriangular(const BlockID& id, const std::string& name, float min, float mode, float max);
+
+	// The percentiles to estimate, 0 to 1.  Defaults to 0.05, 0.5 and 0.95.
+	void SetPercentiles(const std::vector<double>& p) { d_Percentiles = p; }
+
+	void SetSeed(unsigned long long seed) { d_ullSeed = seed; }
+	void SetNumThreads(unsigned n) { d_uiNumThreads = (n == 0) ? 1 : n; }
+	void SetBatchSize(unsigned n) { d_uiBatchSize = (n == 0) ? 1 : n; }
+	void SetObserver(I_MonteCarloObserver* o) { d_pObserver = o; }
+
+	// Runs numSamples samples of the flowsheet.  fs is only read.  Returns
+	// false if one of the uncertain parameters is not on the flowsheet.
+	bool Run(C_Flowsheet& fs, unsigned numSamples);
+
+	// Results
+	unsigned GetNumSamples() const { return d_uiNumSamples; }
+	unsigned GetNumConverged() const { return d_uiNumConverged; }
+	unsigned GetNumStreams() const { return (unsigned)d_Streams.size(); }
+	const S_StreamKey& GetStream(unsigned i) const { return d_Streams[i]; }
+	const C_StreamStatistic& GetStatistic(unsigned stream, unsigned metric) const { return d_Stats[stream * NUM_METRICS + metric]; }
+
+	// Writes a line per stream and metric as comma separated values
+	void WriteSummary(std::ostream& out) const;
+};
+
+#endif // _MONTECARLO_
@@ -0,0 +1,181 @@
+//======================================================================
+// C_PartitionNumbers.cpp
+// Author: James McCormick
+// Description:
+//	A class that loads in and manages partition numbers for the fine
+//	circuit calculations.
+//======================================================================
+
+#include "C_PartitionNumbers.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+C_PartitionNumbers::C_PartitionNumbers()
+{
+}
+
+
+C_PartitionNumbers::~C_PartitionNumbers()
+{
+}
+
+
+//-----------------------------------------------------------------------
+// LoadPartitionNumbers - Public C_PartitionNumbers
+// Description 
+//	Reads the tables from a stream in the file format.  A unit type that
+//	appears twice keeps the last table.
+// 
+// Arguments:	stream - The stream to read from.
+// Returns:		bool - true if successfull, false otherwise.
+//-----------------------------------------------------------------------
+bool C_PartitionNumbers::LoadPartitionNumbers(istream& stream)
+{
+	d_Tables.clear();
+	{
+		lock_guard<mutex> lock(d_CacheMutex);
+		d_Cache.clear();
+	}
+
+	unsigned numTables = 0;
+	if(!(stream >> numTables) || numTables == 0)
+		return false;
+
+	for(unsigned t = 0; t < numTables; t++)
+	{
+		unsigned procID = 0, numPoints = 0;
+		if(!(stream >> procID >> numPoints) || numPoints == 0)
+		{
+			d_Tables.clear();
+			return false;
+		}
+
+		vector<pair<float, float> > points(numPoints);
+		for(unsigned p = 0; p < numPoints; p++)
+		{
+			if(!(stream >> points[p].first >> points[p].second))
+			{
+				d_Tables.clear();
+				return false;
+			}
+		}
+		sort(points.begin(), points.end());
+
+		S_PartitionTable& table = d_Tables[(ProcessID)procID];
+		table.sizes.resize(numPoints);
+		table.numbers.resize(numPoints);
+		for(unsigned p = 0; p < numPoints; p++)
+		{
+			table.sizes[p] = points[p].first;
+			table.numbers[p] = points[p].second;
+		}
+	}
+
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// Load - Public C_PartitionNumbers
+// Description 
+//	Loads a file, or hands back the instance already loaded from it.
+//	Only a weak reference is kept, so the tables are freed when the last
+//	flowsheet using them lets go.
+// 
+// Arguments:	fileName - the file to load
+// Returns:		The shared tables, null if the file could not be read.
+//-----------------------------------------------------------------------
+PartitionNumbersPtr C_PartitionNumbers::Load(const char* fileName)
+{
+	static mutex loadMutex;
+	static map<string, weak_ptr<const C_PartitionNumbers> > loaded;
+
+	lock_guard<mutex> lock(loadMutex);
+
+	PartitionNumbersPtr shared = loaded[fileName].lock();
+	if(shared)
+		return shared;
+
+	ifstream file(fileName);
+	if(!file)
+		return PartitionNumbersPtr();
+
+	shared_ptr<C_PartitionNumbers> tables(new C_PartitionNumbers);
+	if(!tables->LoadPartitionNumbers(file))
+		return PartitionNumbersPtr();
+
+	loaded[fileName] = tables;
+	return tables;
+}
+
+
+//-----------------------------------------------------------------------
+// Interpolate - Protected C_PartitionNumbers
+// Description 
+//	Linear in log size between the points either side of size, and the
+//	end value past either end.
+//-----------------------------------------------------------------------
+float C_PartitionNumbers::Interpolate(const S_PartitionTable& table, const float& size)
+{
+	const vector<float>& x = table.sizes;
+	const vector<float>& y = table.numbers;
+
+	if(size <= x.front())
+		return y.front();
+	if(size >= x.back())
+		return y.back();
+
+	size_t hi = upper_bound(x.begin(), x.end(), size) - x.begin();
+	size_t lo = hi - 1;
+
+	if(x[lo] <= 0.0f)
+		return y[lo] + (y[hi] - y[lo]) * (size - x[lo]) / (x[hi] - x[lo]);
+
+	double t = log(size / x[lo]) / log(x[hi] / x[lo]);
+	return (float)(y[lo] + (y[hi] - y[lo]) * t);
+}
+
+
+//-----------------------------------------------------------------------
+// GetPartition - Public C_PartitionNumbers
+// Description 
+//	Looks up the grid, interpolating every table onto it the first time
+//	it is seen.
+// 
+// Arguments:	procID - the unit type
+//				sd - the size distribution
+// Returns:		A partition number per size fraction, null if there is
+//				no table for the unit type.
+//-----------------------------------------------------------------------
+const float* C_PartitionNumbers::GetPartition(const ProcessID& procID, const C_SizeDistribution& sd) const
+{
+	map<ProcessID, S_PartitionTable>::const_iterator table = d_Tables.find(procID);
+	if(table == d_Tables.end() || sd.GetNumSizeFractions() == 0)
+		return 0;
+
+	vector<float> grid(sd.GetNumSizeFractions());
+	for(unsigned short i = 0; i < grid.size(); i++)
+		grid[i] = sd.GetFractionSize(i);
+
+	lock_guard<mutex> lock(d_CacheMutex);
+
+	map<vector<float>, GridTables>::iterator cached = d_Cache.find(grid);
+	if(cached == d_Cache.end())
+	{
+		cached = d_Cache.insert(make_pair(grid, GridTables())).first;
+		for(map<ProcessID, S_PartitionTable>::const_iterator t = d_Tables.begin(); t != d_Tables.end(); t++)
+		{
+			vector<float>& numbers = cached->second[t->first];
+			numbers.resize(grid.size());
+			for(size_t i = 0; i < grid.size(); i++)
+				numbers[i] = Interpolate(t->second, grid[i]);
+		}
+	}
+
+	return &cached->second[procID][0];
+}
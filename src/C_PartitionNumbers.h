@@ -4,20 +4,65 @@
 // Description:
 //	A class that loads in and manages partition numbers for the fine
 //	circuit calculations.
+//
+//	A partition number is the fraction of a size reporting to a unit's
+//	product.  Each unit type has one table of sizes and partition
+//	numbers, which is interpolated onto a size distribution's fractions
+//	(linearly in log size, held flat past either end).  The interpolated
+//	numbers are kept for every grid asked for, so a block only looks them
+//	up when the size distribution changes and an update is one multiply
+//	per size fraction.
+//
+//	The tables never change once loaded, so one instance is shared by
+//	every flowsheet that loads the same file - see Load.  The grid cache
+//	is locked, so flowsheets on different threads can share it.
+//
+//	File format:
+//		<number of tables>
+//		<process id> <number of points>			(one per table)
+//		<size mm> <partition number, decimal>	(one line per point)
 //======================================================================
 
 #ifndef _PARTITIONNUMBERS_
 #define _PARTITIONNUMBERS_
 
+#include "C_SizeDistribution.h"
+#include "Typedefs.h"
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class C_PartitionNumbers;
+typedef std::shared_ptr<const C_PartitionNumbers> PartitionNumbersPtr;
+
 class C_PartitionNumbers
 {
 protected:
 	
 	// PROTECTED DATA MEMBERS==================================================
 
+	// A unit's table, sorted by increasing size
+	struct S_PartitionTable
+	{
+		std::vector<float> sizes;
+		std::vector<float> numbers;
+	};
+	std::map<ProcessID, S_PartitionTable> d_Tables;
+
+	// The tables interpolated onto each grid asked for, keyed by the mid
+	// size of every fraction.  Entries are never changed once made, so
+	// the pointers handed out stay good for the life of the instance.
+	typedef std::map<ProcessID, std::vector<float> > GridTables;
+	mutable std::map<std::vector<float>, GridTables> d_Cache;
+	mutable std::mutex d_CacheMutex;
 
 	// PROTECTED METHODS=======================================================
 
+	// Interpolates a table at a size
+	static float Interpolate(const S_PartitionTable& table, const float& size);
+
 public:
 
 	// PUBLIC DATA MEMBERS=====================================================
@@ -29,6 +74,20 @@ public:
 	C_PartitionNumbers();
 	~C_PartitionNumbers();
 
+	// Reads the tables from a stream in the file format
+	bool LoadPartitionNumbers(std::istream& stream);
+
+	// Loads a file once - later calls with the same name, from any
+	// flowsheet, get the same instance while it is still in use.  Null if
+	// the file could not be read.
+	static PartitionNumbersPtr Load(const char* fileName);
+
+	// Does the unit type have a table
+	bool HasTable(const ProcessID& procID) const { return d_Tables.find(procID) != d_Tables.end(); }
+
+	// The partition number of every size fraction of sd for the unit type,
+	// [0] is the top fraction.  Null if the unit type has no table.
+	const float* GetPartition(const ProcessID& procID, const C_SizeDistribution& sd) const;
 };
 
-#endif // _PARTITIONNUMBERS_
\ No newline at end of file
+#endif // _PARTITIONNUMBERS_
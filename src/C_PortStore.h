@@ -0,0 +1,120 @@
+//======================================================================
+// C_PortStore.h
+// Author: James McCormick
+// Description:
+//	Holds the ports of every block in a flowsheet in two arrays: the
+//	flow data one after another, and their size fractions one row per
+//	port.  The blocks' ports are moved in when the flowsheet compiles
+//	its schedule, so a solve writes the results straight into these
+//	arrays and they can be read as a whole by stride, without walking
+//	the blocks.
+//======================================================================
+
+#ifndef _PORTSTORE_
+#define _PORTSTORE_
+
+#include "C_FlowData.h"
+#include <vector>
+
+class C_PortStore : public C_SmartPointerObject
+{
+private:
+	// PRIVATE DATA MEMBERS====================================================
+
+	// The ports, and the size fractions of port i at i * d_usNumFractions
+	C_FlowData* d_Flows;
+	FlowValue* d_fpFractions;
+	unsigned d_uiNumPorts;
+	unsigned short d_usNumFractions;
+
+	// The block and port number of each port handed out
+	std::vector<BlockID> d_BlockIDs;
+	std::vector<PortNo> d_PortNos;
+
+	C_PortStore(const C_PortStore&);
+	C_PortStore& operator=(const C_PortStore&);
+
+public:
+	// PUBLIC METHODS==========================================================
+
+	// Allocates numPorts zeroed ports on the loaded size distribution
+	C_PortStore(FSParamsPtr params, const unsigned& numPorts);
+	~C_PortStore()
+	{
+		// The ports leave the fractions for this to free
+		delete [] d_Flows;
+		delete [] d_fpFractions;
+	}
+
+	// Hands out the next count ports to block id, null if there are not
+	// that many left
+	C_FlowData* Take(const BlockID& id, const unsigned short& count);
+
+	// The number of ports handed out, and their block ids and port numbers
+	unsigned GetNumPorts() const { return (unsigned)d_BlockIDs.size(); }
+	const BlockID* GetBlockIDs() const { return d_BlockIDs.empty() ? 0 : &d_BlockIDs[0]; }
+	const PortNo* GetPortNos() const { return d_PortNos.empty() ? 0 : &d_PortNos[0]; }
+
+	// Port i is GetFlows()[i] and its size fractions start at
+	// GetFractions() + i * GetNumFractions()
+	const C_FlowData* GetFlows() const { return d_Flows; }
+	const FlowValue* GetFractions() const { return d_fpFractions; }
+	unsigned short GetNumFractions() const { return d_usNumFractions; }
+
+	// Is fd one of the ports here, still on its own row of fractions
+	bool Holds(const C_FlowData* fd) const
+	{
+		if(fd < d_Flows || fd >= d_Flows + d_uiNumPorts)
+			return false;
+		return fd->d_bBorrowed && fd->d_fpSizeFractions == d_fpFractions + (fd - d_Flows) * d_usNumFractions;
+	}
+};
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_PortStore
+// Description
+//	Allocates the ports and one row of size fractions for each.
+//
+// Arguments:	params - the flowsheet parameters
+//				numPorts - the number of ports
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline C_PortStore::C_PortStore(FSParamsPtr params, const unsigned& numPorts)
+{
+	d_uiNumPorts = numPorts;
+	d_usNumFractions = params->d_sdSizeDistribution.GetNumSizeFractions();
+	d_Flows = new C_FlowData[numPorts];
+	d_fpFractions = new FlowValue[numPorts * d_usNumFractions];
+	for(unsigned i = 0; i < numPorts; i++)
+		d_Flows[i].InitBorrowed(params, d_fpFractions + i * d_usNumFractions);
+
+	d_BlockIDs.reserve(numPorts);
+	d_PortNos.reserve(numPorts);
+}
+
+
+//-----------------------------------------------------------------------
+// Take - Public C_PortStore
+// Description
+//	Hands out the next ports in order.
+//
+// Arguments:	id - the block the ports belong to
+//				count - the number of ports
+// Returns:		The first of the ports, null if there are too few left.
+//-----------------------------------------------------------------------
+inline C_FlowData* C_PortStore::Take(const BlockID& id, const unsigned short& count)
+{
+	const unsigned first = (unsigned)d_BlockIDs.size();
+	if(count == 0 || first + count > d_uiNumPorts)
+		return 0;
+
+	for(unsigned short p = 0; p < count; p++)
+	{
+		d_BlockIDs.push_back(id);
+		d_PortNos.push_back(p);
+	}
+	return d_Flows + first;
+}
+
+#endif // _PORTSTORE_
@@ -34,6 +34,9 @@ public:
 	// The size distribution has been updated
 	void OnNewSizeDistribution();
 
+	// Prints to the console
+	bool IsReportBlock() const { return true; }
+
 	// Called by the flowsheet to have the block update itself.
 	// The flowsheet will update the flowdata for the block before calling update.
 	void OnUpdate() 
@@ -0,0 +1,504 @@
+//======================================================================
+// C_Reconciliation.cpp
+// Author: James McCormick
+// Description:
+//	Fits a flowsheet to measured plant data by weighted least squares.
+//======================================================================
+
+#include "C_Reconciliation.h"
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cctype>
+#include <map>
+
+using namespace std;
+
+static double SumOfSquares(const vector<double>& r)
+{
+	double sum = 0.0;
+	for(size_t i = 0; i < r.size(); i++)
+		sum += r[i] * r[i];
+	return sum;
+}
+
+
+static double Dot(const vector<double>& a, const vector<double>& b)
+{
+	double sum = 0.0;
+	for(size_t i = 0; i < a.size(); i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_Reconciliation
+//-----------------------------------------------------------------------
+C_Reconciliation::C_Reconciliation() : d_uiMaxIterations(50), d_fTolerance(1e-4f), d_usNumTangents(0),
+	d_uiNumIterations(0), d_uiNumSolves(0), d_uiNumCGIterations(0), d_ulNumBlockUpdates(0), d_dCost(0.0)
+{
+}
+
+
+void C_Reconciliation::AddMeasurement(const BlockID& id, const PortNo& port, unsigned char quantity, float value, float stdDev)
+{
+	AddSizeMeasurement(id, port, quantity, 0, value, stdDev);
+}
+
+
+void C_Reconciliation::AddSizeMeasurement(const BlockID& id, const PortNo& port, unsigned char quantity,
+	unsigned short fraction, float value, float stdDev)
+{
+	S_Measurement m;
+	m.stream.blockID = id;
+	m.stream.port = port;
+	m.ucQuantity = quantity;
+	m.usFraction = fraction;
+	m.fValue = value;
+	m.fStdDev = stdDev;
+	d_Measurements.push_back(m);
+}
+
+
+void C_Reconciliation::AddVariable(const BlockID& id, const std::string& name, float min, float max)
+{
+	S_DesignVariable v;
+	v.param.blockID = id;
+	v.param.name = name;
+	v.fMin = min;
+	v.fMax = max;
+	d_Variables.push_back(v);
+}
+
+
+//-----------------------------------------------------------------------
+// AddFeedVariables - Public C_Reconciliation
+// Description
+//	Adds "FractionRate0" onwards on the feed, one variable for each size
+//	fraction of the loaded distribution, kept non-negative.
+//
+// Arguments:	fs - the flowsheet, feed - the feed block
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Reconciliation::AddFeedVariables(C_Flowsheet& fs, const BlockID& feed)
+{
+	float value;
+	for(int i = 0; fs.GetParameter(feed, I_FSBlock::IndexedName("FractionRate", i), value); i++)
+		AddVariable(feed, I_FSBlock::IndexedName("FractionRate", i), 0.0f, FLT_MAX);
+}
+
+
+double C_Reconciliation::GetValue(const C_FlowData* fd, const S_Measurement& m) const
+{
+	switch(m.ucQuantity)
+	{
+		case C_Flowsheet::SENS_SOLIDS:		return fd->d_SolidRate;
+		case C_Flowsheet::SENS_WATER:		return fd->GetFluidRate();
+		case C_Flowsheet::SENS_PERSOLIDS:	return fd->d_PerSolids;
+		case SIZE_RATE:						return (*fd)[m.usFraction];
+		default:							return (fd->d_SolidRate != 0.0f) ? 100.0 * (*fd)[m.usFraction] / fd->d_SolidRate : 0.0;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetTangents - Private C_Reconciliation
+// Description
+//	Gives each variable a tangent.  A feed's fraction rates share the
+//	feed's "FractionRates" tangent unless a water or percent solids is
+//	measured, as those need each fraction's rate on its own.
+//
+// Arguments:	fs - the flowsheet
+// Returns:		false if a variable is not on fs.
+//-----------------------------------------------------------------------
+bool C_Reconciliation::SetTangents(C_Flowsheet& fs)
+{
+	const unsigned numVars = (unsigned)d_Variables.size();
+
+	bool share = true;
+	for(size_t i = 0; i < d_Measurements.size(); i++)
+	{
+		if(d_Measurements[i].ucQuantity == C_Flowsheet::SENS_WATER || d_Measurements[i].ucQuantity == C_Flowsheet::SENS_PERSOLIDS)
+			share = false;
+	}
+
+	d_VarTangent.assign(numVars, 0);
+	d_VarFraction.assign(numVars, -1);
+	d_OwnTangent.clear();
+	d_ByFraction.clear();
+
+	vector<S_ParameterRef> params;
+	map<BlockID, unsigned short> feedTangents;
+	const string prefix("FractionRate");
+	for(unsigned j = 0; j < numVars; j++)
+	{
+		const S_ParameterRef& param = d_Variables[j].param;
+		BlockPtr block = fs.GetBlock(param.blockID);
+		if(share && block != NULL && block->IsFeedBlock() && param.name.size() > prefix.size() && 
+			param.name.compare(0, prefix.size(), prefix) == 0 && isdigit((unsigned char)param.name[prefix.size()]))
+		{
+			map<BlockID, unsigned short>::iterator it = feedTangents.find(param.blockID);
+			if(it == feedTangents.end())
+			{
+				it = feedTangents.insert(make_pair(param.blockID, (unsigned short)params.size())).first;
+				S_ParameterRef shared = { param.blockID, "FractionRates" };
+				params.push_back(shared);
+			}
+
+			int fraction = atoi(param.name.c_str() + prefix.size());
+			d_VarTangent[j] = it->second;
+			d_VarFraction[j] = fraction;
+			if(d_ByFraction.size() <= (size_t)fraction)
+				d_ByFraction.resize(fraction + 1);
+			d_ByFraction[fraction].push_back(j);
+		}
+		else
+		{
+			d_VarTangent[j] = (unsigned short)params.size();
+			params.push_back(param);
+			d_OwnTangent.push_back(j);
+		}
+	}
+
+	d_usNumTangents = (unsigned short)params.size();
+	return fs.SetSensitivities(params);
+}
+
+
+//-----------------------------------------------------------------------
+// GetDerivative - Private C_Reconciliation
+// Description
+//	The sensitivity of a measured value to variable j.  The size
+//	quantities are read off the fraction's own tangent.  A shared
+//	tangent only holds fraction i's sensitivity to fraction i of the
+//	feed, which is also the stream's solids' sensitivity to it.
+//
+// Arguments:	fs - the flowsheet, fd - the measured stream
+//				m - the measurement, j - the variable
+// Returns:		The derivative.
+//-----------------------------------------------------------------------
+double C_Reconciliation::GetDerivative(C_Flowsheet& fs, C_FlowData* fd, const S_Measurement& m, unsigned j) const
+{
+	const unsigned short k = d_VarTangent[j];
+	if(k >= fd->GetNumTangents())
+		return 0.0;
+
+	const FlowValue* t = fd->GetTangent(k);
+	const int fraction = d_VarFraction[j];
+
+	// The sensitivities of the measured fraction and of the solids
+	double dFraction, dSolids;
+	if(fraction < 0)
+	{
+		if(m.ucQuantity == C_Flowsheet::SENS_WATER || m.ucQuantity == C_Flowsheet::SENS_PERSOLIDS)
+			return fs.GetSensitivity(m.stream, m.ucQuantity, k);
+		dFraction = t[m.usFraction];
+		dSolids = fd->SolidTangent(k);
+	}
+	else
+	{
+		dFraction = (m.usFraction == fraction) ? t[fraction] : 0.0;
+		dSolids = t[fraction];
+	}
+
+	switch(m.ucQuantity)
+	{
+		case C_Flowsheet::SENS_SOLIDS:	return dSolids;
+		case SIZE_RATE:					return dFraction;
+	}
+
+	// 100 f / S
+	double solids = fd->d_SolidRate;
+	if(solids == 0.0)
+		return 0.0;
+	return 100.0 * (dFraction * solids - (*fd)[m.usFraction] * dSolids) / (solids * solids);
+}
+
+
+//-----------------------------------------------------------------------
+// Evaluate - Private C_Reconciliation
+// Description
+//	Sets the variables and solves the flowsheet from wherever its flows
+//	are now, without rounding or reporting; Solve reports once at the
+//	end.  The residuals and the Jacobian rows are divided by each
+//	measurement's standard deviation, so the cost is the weighted sum of
+//	squares.  Only the non-zero derivatives are kept.
+//
+// Arguments:	fs - the flowsheet, x - the variables
+//				r - the scaled residuals
+//				rowStart, columns, entries - the scaled Jacobian by rows
+// Returns:		false if the flowsheet did not converge.
+//-----------------------------------------------------------------------
+bool C_Reconciliation::Evaluate(C_Flowsheet& fs, const vector<double>& x, vector<double>& r,
+	vector<unsigned>& rowStart, vector<unsigned>& columns, vector<double>& entries)
+{
+	const unsigned numVars = (unsigned)d_Variables.size();
+	const unsigned numMeasurements = (unsigned)d_Measurements.size();
+
+	for(unsigned j = 0; j < numVars; j++)
+		fs.SetParameter(d_Variables[j].param.blockID, d_Variables[j].param.name, (float)x[j]);
+
+	bool converged = fs.Solve(false);
+	d_uiNumSolves++;
+	d_ulNumBlockUpdates += fs.GetNumBlockUpdates();
+	if(!converged)
+		return false;
+
+	r.resize(numMeasurements);
+	rowStart.resize(numMeasurements + 1);
+	columns.clear();
+	entries.clear();
+	for(unsigned i = 0; i < numMeasurements; i++)
+	{
+		const S_Measurement& m = d_Measurements[i];
+		C_FlowData* fd = fs.GetBlock(m.stream.blockID)->GetFlowData(m.stream.port);
+		double scale = StdDev(m);
+
+		r[i] = (GetValue(fd, m) - m.fValue) / scale;
+		rowStart[i] = (unsigned)entries.size();
+		if(m.ucQuantity == SIZE_RATE)
+		{
+			// Only the variables with their own tangents and the fraction
+			// rates for the same fraction can move it
+			const vector<unsigned>* candidates[2] = { &d_OwnTangent, 
+				(m.usFraction < d_ByFraction.size()) ? &d_ByFraction[m.usFraction] : 0 };
+			for(int c = 0; c < 2 && candidates[c]; c++)
+			{
+				for(size_t v = 0; v < candidates[c]->size(); v++)
+				{
+					unsigned j = (*candidates[c])[v];
+					double d = GetDerivative(fs, fd, m, j);
+					if(d != 0.0)
+					{
+						columns.push_back(j);
+						entries.push_back(d / scale);
+					}
+				}
+			}
+		}
+		else
+		{
+			for(unsigned j = 0; j < numVars; j++)
+			{
+				double d = GetDerivative(fs, fd, m, j);
+				if(d != 0.0)
+				{
+					columns.push_back(j);
+					entries.push_back(d / scale);
+				}
+			}
+		}
+	}
+	rowStart[numMeasurements] = (unsigned)entries.size();
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// SolveStep - Private C_Reconciliation
+// Description
+//	Solves (J'J + lambda D) step = -J'r, D the diagonal of J'J, by
+//	conjugate gradients preconditioned with the diagonal of the whole
+//	matrix.  Each iteration multiplies by J and J' once, so it costs two
+//	passes over the non-zeros.  Variables no measurement sees have an
+//	empty column and are left where they are.
+//
+// Arguments:	r - the scaled residuals, lambda - the damping
+//				step - the step, one per variable
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Reconciliation::SolveStep(const vector<double>& r, const double& lambda, vector<double>& step)
+{
+	const unsigned numVars = (unsigned)d_Variables.size();
+	const unsigned numMeasurements = (unsigned)d_Measurements.size();
+
+	vector<double> diag(numVars, 0.0), b(numVars, 0.0);
+	for(unsigned i = 0; i < numMeasurements; i++)
+	{
+		for(unsigned e = d_RowStart[i]; e < d_RowStart[i + 1]; e++)
+		{
+			diag[d_Columns[e]] += d_Entries[e] * d_Entries[e];
+			b[d_Columns[e]] -= d_Entries[e] * r[i];
+		}
+	}
+
+	step.assign(numVars, 0.0);
+	vector<double> res(b), z(numVars), p(numVars), q(numVars), Jp(numMeasurements);
+	for(unsigned j = 0; j < numVars; j++)
+		z[j] = (diag[j] > 0.0) ? res[j] / ((1.0 + lambda) * diag[j]) : 0.0;
+	p = z;
+
+	double rz = Dot(res, z);
+	const double stop = 1e-20 * Dot(b, b);
+	for(unsigned it = 0; it < 2 * numVars && Dot(res, res) > stop; it++)
+	{
+		d_uiNumCGIterations++;
+
+		// q = (J'J + lambda D) p
+		for(unsigned i = 0; i < numMeasurements; i++)
+		{
+			double sum = 0.0;
+			for(unsigned e = d_RowStart[i]; e < d_RowStart[i + 1]; e++)
+				sum += d_Entries[e] * p[d_Columns[e]];
+			Jp[i] = sum;
+		}
+		for(unsigned j = 0; j < numVars; j++)
+			q[j] = lambda * diag[j] * p[j];
+		for(unsigned i = 0; i < numMeasurements; i++)
+		{
+			for(unsigned e = d_RowStart[i]; e < d_RowStart[i + 1]; e++)
+				q[d_Columns[e]] += d_Entries[e] * Jp[i];
+		}
+
+		double pq = Dot(p, q);
+		if(pq <= 0.0)
+			break;
+
+		double alpha = rz / pq;
+		for(unsigned j = 0; j < numVars; j++)
+		{
+			step[j] += alpha * p[j];
+			res[j] -= alpha * q[j];
+			z[j] = (diag[j] > 0.0) ? res[j] / ((1.0 + lambda) * diag[j]) : 0.0;
+		}
+
+		double rzNew = Dot(res, z);
+		double beta = rzNew / rz;
+		rz = rzNew;
+		for(unsigned j = 0; j < numVars; j++)
+			p[j] = z[j] + beta * p[j];
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// Solve - Public C_Reconciliation
+// Description
+//	Levenberg-Marquardt on the weighted residuals.  A step that raises
+//	the cost is thrown away and the damping raised.  Steps are clipped
+//	to the variable bounds.  The fit has converged when a step lowers
+//	the cost by less than the tolerance, or when no step can lower it
+//	at all.  The flowsheet's own sensitivity settings are put back
+//	afterwards, and it is solved once more at the fitted point to round
+//	the water and update the report blocks.
+//
+// Arguments:	fs - the flowsheet to fit
+// Returns:		true if the fit converged.
+//-----------------------------------------------------------------------
+bool C_Reconciliation::Solve(C_Flowsheet& fs)
+{
+	const unsigned numVars = (unsigned)d_Variables.size();
+	const unsigned numMeasurements = (unsigned)d_Measurements.size();
+
+	d_uiNumIterations = 0;
+	d_uiNumSolves = 0;
+	d_uiNumCGIterations = 0;
+	d_ulNumBlockUpdates = 0;
+	d_dCost = 0.0;
+	d_Values.assign(numVars, 0.0f);
+	d_Reconciled.assign(numMeasurements, 0.0f);
+
+	for(unsigned i = 0; i < numMeasurements; i++)
+	{
+		BlockPtr block = fs.GetBlock(d_Measurements[i].stream.blockID);
+		if(block == NULL || d_Measurements[i].stream.port >= block->GetPorts().GetNumPorts())
+			return false;
+	}
+
+	vector<S_ParameterRef> saved = fs.GetSensitivities();
+	vector<double> x(numVars);
+	for(unsigned j = 0; j < numVars; j++)
+	{
+		float value = 0.0f;
+		if(!fs.GetParameter(d_Variables[j].param.blockID, d_Variables[j].param.name, value))
+			return false;
+		if(value < d_Variables[j].fMin) value = d_Variables[j].fMin;
+		if(value > d_Variables[j].fMax) value = d_Variables[j].fMax;
+		x[j] = value;
+		d_Values[j] = value;
+	}
+
+	if(!SetTangents(fs))
+	{
+		fs.SetSensitivities(saved);
+		return false;
+	}
+
+	vector<double> r, step, rTrial, xTrial(numVars);
+	vector<unsigned> rowStart, columns;
+	vector<double> entries;
+	bool converged = false;
+	if(Evaluate(fs, x, r, d_RowStart, d_Columns, d_Entries))
+	{
+		double cost = SumOfSquares(r);
+		double lambda = 1e-3;
+
+		converged = (numVars == 0 || numMeasurements == 0);
+		while(!converged && d_uiNumIterations < d_uiMaxIterations)
+		{
+			d_uiNumIterations++;
+
+			SolveStep(r, lambda, step);
+
+			bool moved = false;
+			for(unsigned j = 0; j < numVars; j++)
+			{
+				xTrial[j] = x[j] + step[j];
+				if(xTrial[j] < d_Variables[j].fMin) xTrial[j] = d_Variables[j].fMin;
+				if(xTrial[j] > d_Variables[j].fMax) xTrial[j] = d_Variables[j].fMax;
+				if((float)xTrial[j] != (float)x[j])
+					moved = true;
+			}
+
+			// Nowhere left to go, in float or against the bounds
+			if(!moved)
+			{
+				converged = true;
+				break;
+			}
+
+			double trialCost = 0.0;
+			if(Evaluate(fs, xTrial, rTrial, rowStart, columns, entries) && (trialCost = SumOfSquares(rTrial)) < cost)
+			{
+				converged = (cost - trialCost <= d_fTolerance * cost);
+				x.swap(xTrial);
+				r.swap(rTrial);
+				d_RowStart.swap(rowStart);
+				d_Columns.swap(columns);
+				d_Entries.swap(entries);
+				cost = trialCost;
+				lambda = (lambda > 1e-7) ? lambda * 0.1 : lambda;
+			}
+			else
+			{
+				lambda *= 10.0;
+
+				// No step lowers the cost, so this is the minimum to the
+				// precision of the solve
+				if(lambda > 1e10)
+				{
+					converged = true;
+					break;
+				}
+			}
+		}
+
+		d_dCost = cost;
+		for(unsigned j = 0; j < numVars; j++)
+			d_Values[j] = (float)x[j];
+		for(unsigned i = 0; i < numMeasurements; i++)
+			d_Reconciled[i] = (float)(d_Measurements[i].fValue + r[i] * StdDev(d_Measurements[i]));
+	}
+
+	// Leave the flowsheet solved and reported at the fitted point, with
+	// its own sensitivities
+	fs.SetSensitivities(saved);
+	for(unsigned j = 0; j < numVars; j++)
+		fs.SetParameter(d_Variables[j].param.blockID, d_Variables[j].param.name, (float)x[j]);
+
+	bool reported = fs.SolveFlowSheet();
+	d_uiNumSolves++;
+	d_ulNumBlockUpdates += fs.GetNumBlockUpdates();
+	return converged && reported;
+}
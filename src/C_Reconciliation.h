@@ -0,0 +1,160 @@
+//======================================================================
+// C_Reconciliation.h
+// Author: James McCormick
+// Description:
+//	Fits a flowsheet to measured plant data.  Each measurement is a
+//	stream value with a standard deviation, and the fit adjusts the
+//	variables - the solids in each size fraction of the feeds, and any
+//	other named block parameters such as cut points or splits - to
+//	minimise the weighted sum of squares of the adjustments.  Every
+//	stream, measured or not, is then read off the solved flowsheet, so
+//	the unmeasured flows are estimated with the same balances that make
+//	the measured ones close.
+//
+//	The steps are Levenberg-Marquardt, with the Jacobian read off the
+//	flowsheet's sensitivities as in C_DesignSpec.  A feed's fraction
+//	rate only reaches the same size fraction downstream, which the fit
+//	uses twice.  All of a feed's fraction rates share one tangent, so a
+//	solve costs the same for one variable per feed as for one per size
+//	fraction.  The water does not split by size fraction, so they only
+//	share when no water or percent solids is measured.  And most of the
+//	Jacobian is zero: it is held by rows with only the non-zeros, and
+//	each step is solved by conjugate gradients on the normal equations
+//	preconditioned by their diagonal, which the per-fraction structure
+//	makes nearly block diagonal.  The normal matrix is never formed.
+//======================================================================
+
+#ifndef _RECONCILIATION_
+#define _RECONCILIATION_
+
+#include "C_DesignSpec.h"
+#include <string>
+#include <vector>
+
+// A measured stream value
+struct S_Measurement
+{
+	S_StreamKey stream;
+	unsigned char ucQuantity;		// C_Flowsheet::SENS_SOLIDS, SENS_WATER, SENS_PERSOLIDS,
+									// or C_Reconciliation::SIZE_RATE or SIZE_PERCENT
+	unsigned short usFraction;		// The size fraction for SIZE_RATE and SIZE_PERCENT
+	float fValue;
+	float fStdDev;					// Weighted by 1 / fStdDev^2
+};
+
+
+class C_Reconciliation
+{
+public:
+	// The solids in one size fraction, and the same as a percent of the stream's solids
+	enum { SIZE_RATE = C_Flowsheet::SENS_PERSOLIDS + 1, SIZE_PERCENT };
+
+private:
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	std::vector<S_Measurement> d_Measurements;
+	std::vector<S_DesignVariable> d_Variables;
+
+	unsigned d_uiMaxIterations;
+
+	// Converged when a step lowers the cost by less than this fraction of it
+	float d_fTolerance;
+
+	// The tangent each variable's sensitivities are on, and the size
+	// fraction of a feed's fraction rate sharing its feed's tangent, -1
+	// for a variable with its own
+	std::vector<unsigned short> d_VarTangent;
+	std::vector<int> d_VarFraction;
+	unsigned short d_usNumTangents;
+
+	// The variables with their own tangents, and those sharing by fraction.
+	// A size fraction measurement can only see these two sets.
+	std::vector<unsigned> d_OwnTangent;
+	std::vector<std::vector<unsigned> > d_ByFraction;
+
+	// The scaled Jacobian by rows, non-zeros only
+	std::vector<unsigned> d_RowStart;
+	std::vector<unsigned> d_Columns;
+	std::vector<double> d_Entries;
+
+	// Results of the last Solve
+	unsigned d_uiNumIterations;
+	unsigned d_uiNumSolves;
+	unsigned d_uiNumCGIterations;
+	unsigned long d_ulNumBlockUpdates;
+	double d_dCost;
+	std::vector<float> d_Values;
+	std::vector<float> d_Reconciled;
+
+	// PRIVATE METHODS=========================================================
+
+	// Picks the tangents for the variables and gives them to fs
+	bool SetTangents(C_Flowsheet& fs);
+
+	// Sets the variables, solves and fills the scaled residuals and Jacobian
+	bool Evaluate(C_Flowsheet& fs, const std::vector<double>& x, std::vector<double>& r,
+		std::vector<unsigned>& rowStart, std::vector<unsigned>& columns, std::vector<double>& entries);
+
+	// A measurement's standard deviation, kept away from zero
+	static float StdDev(const S_Measurement& m) { return (m.fStdDev > 0.0f) ? m.fStdDev : 1e-6f; }
+
+	double GetValue(const C_FlowData* fd, const S_Measurement& m) const;
+	double GetDerivative(C_Flowsheet& fs, C_FlowData* fd, const S_Measurement& m, unsigned j) const;
+
+	// Solves (J'J + lambda diag(J'J)) step = -J'r
+	void SolveStep(const std::vector<double>& r, const double& lambda, std::vector<double>& step);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_Reconciliation();
+
+	void AddMeasurement(const S_Measurement& m) { d_Measurements.push_back(m); }
+	void AddMeasurement(const BlockID& id, const PortNo& port, unsigned char quantity, float value, float stdDev);
+	void AddSizeMeasurement(const BlockID& id, const PortNo& port, unsigned char quantity,
+		unsigned short fraction, float value, float stdDev);
+
+	void AddVariable(const S_DesignVariable& v) { d_Variables.push_back(v); }
+	void AddVariable(const BlockID& id, const std::string& name, float min, float max);
+
+	// Adds the solids in every size fraction of a feed as variables
+	void AddFeedVariables(C_Flowsheet& fs, const BlockID& feed);
+
+	void Clear() { d_Measurements.clear(); d_Variables.clear(); }
+
+	void SetMaxIterations(unsigned n) { d_uiMaxIterations = n; }
+	void SetTolerance(float tolerance) { d_fTolerance = tolerance; }
+
+	unsigned GetNumMeasurements() const { return (unsigned)d_Measurements.size(); }
+	unsigned GetNumVariables() const { return (unsigned)d_Variables.size(); }
+
+
+	// Fits the variables on fs, starting from their current values.  fs is
+	// left solved at the best fit.  Returns true if the fit converged.
+	bool Solve(C_Flowsheet& fs);
+
+	// Results of the last Solve
+	unsigned GetNumIterations() const { return d_uiNumIterations; }
+	unsigned GetNumSolves() const { return d_uiNumSolves; }
+	unsigned GetNumCGIterations() const { return d_uiNumCGIterations; }
+	unsigned short GetNumTangents() const { return d_usNumTangents; }
+	unsigned long GetNumBlockUpdates() const { return d_ulNumBlockUpdates; }
+	unsigned long GetNumNonZeros() const { return (unsigned long)d_Entries.size(); }
+	float GetVariable(unsigned i) const { return d_Values[i]; }
+
+	// The weighted sum of squares of the adjustments, chi-square with
+	// GetDegreesOfFreedom() degrees of freedom if the model is right
+	double GetCost() const { return d_dCost; }
+	int GetDegreesOfFreedom() const { return (int)d_Measurements.size() - (int)d_Variables.size(); }
+
+	// The fitted value of measurement i, how far it was moved, and that in
+	// standard deviations.  A large standardized adjustment points to a
+	// gross error in the measurement.
+	float GetReconciled(unsigned i) const { return d_Reconciled[i]; }
+	float GetAdjustment(unsigned i) const { return d_Reconciled[i] - d_Measurements[i].fValue; }
+	float GetStandardizedAdjustment(unsigned i) const { return GetAdjustment(i) / StdDev(d_Measurements[i]); }
+};
+
+#endif // _RECONCILIATION_
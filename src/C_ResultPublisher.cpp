@@ -0,0 +1,155 @@
+//======================================================================
+// C_ResultPublisher.cpp
+// Author: James McCormick
+// Description:
+//	Publishes immutable snapshots of the results.  See C_ResultPublisher.h.
+//======================================================================
+
+#include "C_ResultPublisher.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+//-----------------------------------------------------------------------
+// CopyFrom - Private C_ResultSnapshot
+// Description
+//	Copies the ports out of the store.  The vectors keep their memory
+//	from the last copy, so once a slot has held a plant this size a
+//	publish does not allocate.
+//
+// Arguments:	store - the flowsheet's port store
+//				waterUnit - reported water per unit of water in the ports
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ResultSnapshot::CopyFrom(const C_PortStore& store, const float& waterUnit)
+{
+	const unsigned numPorts = store.GetNumPorts();
+	d_usNumFractions = store.GetNumFractions();
+
+	d_BlockIDs.assign(store.GetBlockIDs(), store.GetBlockIDs() + numPorts);
+	d_PortNos.assign(store.GetPortNos(), store.GetPortNos() + numPorts);
+
+	d_Values.resize(numPorts * 3);
+	const C_FlowData* flows = store.GetFlows();
+	for(unsigned i = 0; i < numPorts; i++)
+	{
+		d_Values[i * 3] = flows[i].d_SolidRate;
+		d_Values[i * 3 + 1] = flows[i].d_FluidRate * waterUnit;
+		d_Values[i * 3 + 2] = flows[i].d_PerSolids;
+	}
+
+	// The fractions are one block in the store
+	d_Fractions.resize(numPorts * d_usNumFractions);
+	if(!d_Fractions.empty())
+		memcpy(&d_Fractions[0], store.GetFractions(), d_Fractions.size() * sizeof(FlowValue));
+}
+
+
+//-----------------------------------------------------------------------
+// Find - Public C_ResultSnapshot
+// Description
+//	Looks a port up by binary search; the ports are in BlockID then
+//	port order.
+//
+// Arguments:	id - the block
+//				port - the port
+// Returns:		The stream, or -1.
+//-----------------------------------------------------------------------
+int C_ResultSnapshot::Find(const BlockID& id, const PortNo& port) const
+{
+	vector<BlockID>::const_iterator first = lower_bound(d_BlockIDs.begin(), d_BlockIDs.end(), id);
+	if(first == d_BlockIDs.end() || *first != id)
+		return -1;
+
+	const unsigned i = (unsigned)(first - d_BlockIDs.begin()) + port;
+	if(i >= d_BlockIDs.size() || d_BlockIDs[i] != id || d_PortNos[i] != port)
+		return -1;
+	return (int)i;
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_ResultPublisher
+// Description
+//	Sets up the slots with nothing published.
+//
+// Arguments:	numSlots - the number of snapshots that can be held at
+//				once, from 2 up
+// Returns:		None.
+//-----------------------------------------------------------------------
+C_ResultPublisher::C_ResultPublisher(unsigned numSlots) : d_Slots((numSlots < 2) ? 2 : (numSlots < NO_SLOT) ? numSlots : NO_SLOT - 1)
+{
+	d_Current.store(NO_SLOT);
+	d_ulNumPublished = 0;
+	d_ulNumSkipped = 0;
+}
+
+
+//-----------------------------------------------------------------------
+// FindFreeSlot - Private C_ResultPublisher
+// Description
+//	Finds a slot to fill.  A swapped out slot is free again once as many
+//	readers have given it back as took it while it was current; its
+//	count is then started again for its next turn.
+//
+// Arguments:	None.
+// Returns:		The slot, or NO_SLOT if they are all held.
+//-----------------------------------------------------------------------
+unsigned C_ResultPublisher::FindFreeSlot()
+{
+	const unsigned current = (unsigned)(d_Current.load(memory_order_relaxed) & SLOT_MASK);
+	for(unsigned i = 0; i < d_Slots.size(); i++)
+	{
+		S_Slot& slot = d_Slots[i];
+		if(i == current)
+			continue;
+
+		// Acquire, so the readers are done with it before it is written
+		if(slot.bInUse && slot.ulReleased.load(memory_order_acquire) != slot.ulTaken)
+			continue;
+
+		slot.bInUse = false;
+		slot.ulReleased.store(0, memory_order_relaxed);
+		slot.ulTaken = 0;
+		return i;
+	}
+	return NO_SLOT;
+}
+
+
+//-----------------------------------------------------------------------
+// Publish - Public C_ResultPublisher
+// Description
+//	Copies the results into a free slot and swaps it in as the current
+//	snapshot.  The word swapped out says how many readers took the old
+//	snapshot; the slot is free once they have all given it back.
+//	Readers that take the word after the swap see the new snapshot
+//	whole.  Never waits for a reader.
+//
+// Arguments:	store - the flowsheet's port store
+//				waterUnit - reported water per unit of water in the ports
+//				iterations - the iterations the solve took
+// Returns:		true if it was published.
+//-----------------------------------------------------------------------
+bool C_ResultPublisher::Publish(const C_PortStore& store, const float& waterUnit, const unsigned& iterations)
+{
+	const unsigned slot = FindFreeSlot();
+	if(slot == NO_SLOT)
+	{
+		d_ulNumSkipped++;
+		return false;
+	}
+
+	C_ResultSnapshot& snapshot = d_Slots[slot].snapshot;
+	snapshot.CopyFrom(store, waterUnit);
+	snapshot.d_ulSerial = ++d_ulNumPublished;
+	snapshot.d_uiIterations = iterations;
+	d_Slots[slot].bInUse = true;
+
+	const unsigned long long old = d_Current.exchange(slot, memory_order_acq_rel);
+	const unsigned oldSlot = (unsigned)(old & SLOT_MASK);
+	if(oldSlot != NO_SLOT)
+		d_Slots[oldSlot].ulTaken = old >> SLOT_BITS;
+	return true;
+}
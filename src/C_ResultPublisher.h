@@ -0,0 +1,160 @@
+//======================================================================
+// C_ResultPublisher.h
+// Author: James McCormick
+// Description:
+//	Publishes the results of each converged solve as an immutable
+//	snapshot of every port, so other threads can read a whole, settled
+//	set of results while the next solve mutates the ports.
+//
+//	The snapshots live in a fixed set of slots.  The current one is a
+//	single atomic word holding its slot and the number of readers that
+//	have taken it, so a reader takes the current snapshot with one
+//	atomic add and gives it back with another - readers never wait.
+//	Publishing fills a free slot and swaps it in; the count in the word
+//	it swaps out says how many readers the old slot has to wait for
+//	before it is free again.  The solver never waits on them: if every
+//	slot is still held it skips that publish, and readers keep the last
+//	one.
+//
+//	One thread publishes; any number read.
+//======================================================================
+
+#ifndef _RESULTPUBLISHER_
+#define _RESULTPUBLISHER_
+
+#include "C_PortStore.h"
+#include <vector>
+#include <atomic>
+
+// The results of one solve, by port in BlockID order
+class C_ResultSnapshot
+{
+private:
+	// PRIVATE DATA MEMBERS====================================================
+
+	unsigned long d_ulSerial;			// The number of the publish, from 1
+	unsigned d_uiIterations;
+
+	std::vector<BlockID> d_BlockIDs;
+	std::vector<PortNo> d_PortNos;
+
+	// Solids, water in m3/h or US gpm, and percent solids for each port
+	std::vector<FlowValue> d_Values;
+
+	// The size fractions of port i at i * d_usNumFractions
+	std::vector<FlowValue> d_Fractions;
+	unsigned short d_usNumFractions;
+
+	// PRIVATE METHODS=========================================================
+
+	// Copies the ports, reusing the memory from the last copy
+	void CopyFrom(const C_PortStore& store, const float& waterUnit);
+
+	friend class C_ResultPublisher;
+
+public:
+	// PUBLIC METHODS==========================================================
+
+	C_ResultSnapshot() : d_ulSerial(0), d_uiIterations(0), d_usNumFractions(0) {}
+
+	unsigned long GetSerial() const { return d_ulSerial; }
+	unsigned GetNumIterations() const { return d_uiIterations; }
+
+	unsigned GetNumStreams() const { return (unsigned)d_BlockIDs.size(); }
+	unsigned short GetNumFractions() const { return d_usNumFractions; }
+
+	// Stream i
+	BlockID GetBlockID(const unsigned& i) const { return d_BlockIDs[i]; }
+	PortNo GetPort(const unsigned& i) const { return d_PortNos[i]; }
+	FlowValue GetSolids(const unsigned& i) const { return d_Values[i * 3]; }
+	FlowValue GetWater(const unsigned& i) const { return d_Values[i * 3 + 1]; }
+	FlowValue GetPerSolids(const unsigned& i) const { return d_Values[i * 3 + 2]; }
+	const FlowValue* GetFractions(const unsigned& i) const { return d_Fractions.empty() ? 0 : &d_Fractions[i * d_usNumFractions]; }
+
+	// The stream of a port, -1 if it is not in the snapshot
+	int Find(const BlockID& id, const PortNo& port) const;
+};
+
+
+class C_ResultPublisher
+{
+private:
+	// The current word is the slot in its low bits and the number of
+	// readers that have taken it above them
+	enum { SLOT_BITS = 16 };
+	static const unsigned long long SLOT_MASK = (1ull << SLOT_BITS) - 1;
+	static const unsigned long long ONE_READER = 1ull << SLOT_BITS;
+	static const unsigned NO_SLOT = (unsigned)SLOT_MASK;
+
+	struct S_Slot
+	{
+		C_ResultSnapshot snapshot;
+		std::atomic<unsigned long long> ulReleased;	// Readers that have given it back
+		unsigned long long ulTaken;					// Readers that took it, once it is swapped out
+		bool bInUse;								// Current, or swapped out with readers left
+
+		S_Slot() : ulReleased(0), ulTaken(0), bInUse(false) {}
+	};
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	std::vector<S_Slot> d_Slots;
+	std::atomic<unsigned long long> d_Current;
+
+	unsigned long d_ulNumPublished;
+	unsigned long d_ulNumSkipped;
+
+	// PRIVATE METHODS=========================================================
+
+	// Finds a slot that is not current and that no reader holds
+	unsigned FindFreeSlot();
+
+	C_ResultPublisher(const C_ResultPublisher&);
+	C_ResultPublisher& operator=(const C_ResultPublisher&);
+
+	friend class C_SnapshotReader;
+
+public:
+	// PUBLIC METHODS==========================================================
+
+	// At least 2 slots: the current snapshot and the next one
+	C_ResultPublisher(unsigned numSlots = 4);
+
+	// Copies the ports into a free slot and makes it the current snapshot.
+	// Returns false, publishing nothing, if readers hold every other slot.
+	bool Publish(const C_PortStore& store, const float& waterUnit, const unsigned& iterations);
+
+	// For the publishing thread
+	unsigned long GetNumPublished() const { return d_ulNumPublished; }
+	unsigned long GetNumSkipped() const { return d_ulNumSkipped; }
+};
+
+
+// Holds the snapshot that was current when it was made, for as long as
+// it lives.  Taking and giving it back never waits.
+class C_SnapshotReader
+{
+private:
+	C_ResultPublisher& d_Publisher;
+	unsigned d_uiSlot;
+
+	C_SnapshotReader(const C_SnapshotReader&);
+	C_SnapshotReader& operator=(const C_SnapshotReader&);
+
+public:
+	C_SnapshotReader(C_ResultPublisher& publisher) : d_Publisher(publisher)
+	{
+		d_uiSlot = (unsigned)(d_Publisher.d_Current.fetch_add(C_ResultPublisher::ONE_READER, std::memory_order_acquire) & C_ResultPublisher::SLOT_MASK);
+	}
+	~C_SnapshotReader()
+	{
+		if(d_uiSlot != C_ResultPublisher::NO_SLOT)
+			d_Publisher.d_Slots[d_uiSlot].ulReleased.fetch_add(1, std::memory_order_release);
+	}
+
+	// Null until something has been published
+	const C_ResultSnapshot* Get() const { return (d_uiSlot == C_ResultPublisher::NO_SLOT) ? 0 : &d_Publisher.d_Slots[d_uiSlot].snapshot; }
+	const C_ResultSnapshot* operator->() const { return Get(); }
+};
+
+#endif // _RESULTPUBLISHER_
@@ -32,11 +32,35 @@ bool C_SizeDistribution::LoadSizeDist(const char* fileName)
 	if(!file)
 		return false;
 
+	bool loaded = LoadSizeDist(file);
+
+	// Close the file
+	file.close();
+
+	return loaded;
+}
+
+
+//-----------------------------------------------------------------------
+// LoadSizeDist - Public C_SizeDistribution
+// Description 
+//	Loads in a size distribution from a stream.  The first line is the
+//	number of fractions, then one line per fraction of passing, retained,
+//	fractional wt and cumulative wt.
+// 
+// Arguments:	stream - The stream to read from.
+// Returns:		bool - true if successfull, false otherwise.
+//-----------------------------------------------------------------------
+bool C_SizeDistribution::LoadSizeDist(istream& stream)
+{
+	this->UnloadSizeDist();
+
 	// Create a buffer to store a line from the file
 	string buffer;
 
 	// Get the number of lines to read in
-	getline(file, buffer);
+	if(!getline(stream, buffer))
+		return false;
 	istringstream line1(buffer);
 
 	line1 >> d_sNumFractions;
@@ -45,7 +69,7 @@ bool C_SizeDistribution::LoadSizeDist(const char* fileName)
 	d_sfFractions = new S_SizeFraction[d_sNumFractions];
 
 	int i = 0;
-	while(getline(file, buffer))
+	while(i < d_sNumFractions && getline(stream, buffer))
 	{
 		// Create a string stream from the line read in
 		istringstream line(buffer);
@@ -61,9 +85,6 @@ bool C_SizeDistribution::LoadSizeDist(const char* fileName)
 		i++;
 	}
 
-	// Close the file
-	file.close();
-
 	return true;
 }
 
@@ -72,7 +93,9 @@ bool C_SizeDistribution::LoadSizeDist(const char* fileName)
 // GetRange - Private C_SizeDistribution
 // Description 
 //	Finds the start and end indices into the array for a certain 
-//	size fraction.
+//	size fraction.  Sizes that are not on a size fraction boundary are
+//	moved onto the nearest one, so the indices are always set; if the
+//	range holds no fractions end is left before start.
 //
 // Arguments:	pass - the starting point to find.
 //				retained - the end point to find.
@@ -81,19 +104,17 @@ bool C_SizeDistribution::LoadSizeDist(const char* fileName)
 //-----------------------------------------------------------------------
 void C_SizeDistribution::GetRange(const float& pass, const float& retained, short& start, short& end) const
 {
-	// Test to see if pass is the top size
-	if(d_sfFractions[0].fPassing < pass)
-		start = 0;
+	const float top = GetNearestBoundary(pass);
+	const float bottom = GetNearestBoundary(retained);
 
+	start = (short)d_sNumFractions;
+	end = -1;
 	for(int i = 0; i < d_sNumFractions; i++)
 	{
-		if(d_sfFractions[i].fPassing == pass)
-			start = i;
-		if(d_sfFractions[i].fRetained == retained)
-		{
-			end = i;
-			continue;
-		}
+		if(start == d_sNumFractions && d_sfFractions[i].fPassing <= top)
+			start = (short)i;
+		if(d_sfFractions[i].fRetained >= bottom)
+			end = (short)i;
 	}
 }
 
@@ -138,6 +159,38 @@ float C_SizeDistribution::GetFractionalWt(const float& pass, const float& retain
 	return fractWt;
 }
 
+//-----------------------------------------------------------------------
+// GetNearestBoundary - Public C_SizeDistribution
+// Description 
+//	Finds the size fraction boundary closest to size.  The top size
+//	and zero are included.
+//
+// Arguments:	size - the size in mm
+// Returns:		float - the closest boundary, or size if nothing is loaded
+//-----------------------------------------------------------------------
+float C_SizeDistribution::GetNearestBoundary(const float& size) const
+{
+	if(d_sNumFractions == 0)
+		return size;
+
+	float nearest = d_sfFractions[0].fPassing;
+	float bestDiff = (size > nearest) ? size - nearest : nearest - size;
+
+	for(int i = 0; i < d_sNumFractions; i++)
+	{
+		float boundary = d_sfFractions[i].fRetained;
+		float diff = (size > boundary) ? size - boundary : boundary - size;
+		if(diff < bestDiff)
+		{
+			bestDiff = diff;
+			nearest = boundary;
+		}
+	}
+
+	return nearest;
+}
+
+
 //-----------------------------------------------------------------------
 // GetAVGSize - Public C_SizeDistribution
 // Description 
@@ -10,6 +10,7 @@
 #ifndef _SIZEDISTRIBUTION_
 #define _SIZEDISTRIBUTION_
 
+#include <istream>
 
 class C_SizeDistribution
 {
@@ -48,13 +49,20 @@ public:
 
 	// Constructor/Destructor
 	C_SizeDistribution();
+	C_SizeDistribution(const C_SizeDistribution& sd);
 	~C_SizeDistribution();
 
+	// Copies the fractions from sd
+	C_SizeDistribution& operator=(const C_SizeDistribution& sd);
+
 	float TopSize() const { return d_sfFractions[0].fPassing; }
 
 	// Load a size distribution from a txt file
 	bool LoadSizeDist(const char* fileName);
 
+	// Load a size distribution from a stream in the same format as the txt file
+	bool LoadSizeDist(std::istream& stream);
+
 	// Unload the size distribution from memory
 	void UnloadSizeDist();
 
@@ -73,9 +81,18 @@ public:
 	// Gets the fractional weight between two size fractions
 	float GetFractionalWt(const float& pass, const float& retained) const;
 
+	// Gets the size fraction boundary closest to size
+	float GetNearestBoundary(const float& size) const;
+
 	// Gets the average grain size for a size fraction in mm
 	float GetAVGSize(const float& pass, const float& retained) const;
 
+	// The mid size of fraction i in mm, [0] is the top fraction
+	float GetFractionSize(const unsigned short& i) const { return d_sfFractions[i].fAvgSize; }
+
+	// The weight in fraction i as it is used to split a feed, [0] is the top fraction
+	float GetFractionWt(const unsigned short& i) const { return d_sfFractions[i].fFractionalWt; }
+
 	// Prints the SizeDistribution to the screen
 	void PrintSizeDist() const;
 };
@@ -96,6 +113,48 @@ inline C_SizeDistribution::C_SizeDistribution()
 }
 
 
+//-----------------------------------------------------------------------
+// Copy Constructor - Public C_SizeDistribution
+// Description 
+//	Copies the fractions from sd.
+//
+// Arguments:	sd - the size distribution to copy.
+// Returns:		None.
+//-----------------------------------------------------------------------
+inline C_SizeDistribution::C_SizeDistribution(const C_SizeDistribution& sd)
+{
+	d_sfFractions = 0;
+	d_sNumFractions = 0;
+	*this = sd;
+}
+
+
+//-----------------------------------------------------------------------
+// operator= - Public C_SizeDistribution
+// Description 
+//	Replaces the current fractions with a copy of sd's.
+//
+// Arguments:	sd - the size distribution to copy.
+// Returns:		A reference to this size distribution.
+//-----------------------------------------------------------------------
+inline C_SizeDistribution& C_SizeDistribution::operator=(const C_SizeDistribution& sd)
+{
+	if(this == &sd)
+		return *this;
+
+	UnloadSizeDist();
+	if(sd.d_sNumFractions == 0)
+		return *this;
+
+	d_sNumFractions = sd.d_sNumFractions;
+	d_sfFractions = new S_SizeFraction[d_sNumFractions];
+	for(unsigned short i = 0; i < d_sNumFractions; i++)
+		d_sfFractions[i] = sd.d_sfFractions[i];
+
+	return *this;
+}
+
+
 //-----------------------------------------------------------------------
 // UnloadSizeDist - Public C_SizeDistribution
 // Description 
@@ -7,6 +7,8 @@
 #ifndef _SMARTPOINTER_
 #define _SMARTPOINTER_
 
+#include <atomic>
+
 /*=========================================================================
 / C_Object - Class
 / An object class that will be used with the smart pointer class
@@ -17,13 +19,21 @@ class C_SmartPointerObject
 {
 public:
 	// Constructor
-	C_SmartPointerObject() : d_sNumRef(0) {}
+	C_SmartPointerObject() : d_uiNumRef(0) {}
 	virtual ~C_SmartPointerObject() {}
 
+	// A copy is a new object with no references of its own yet, and
+	// assigning keeps the references to this one
+	C_SmartPointerObject(const C_SmartPointerObject&) : d_uiNumRef(0) {}
+	C_SmartPointerObject& operator=(const C_SmartPointerObject&) { return *this; }
+
 private:
-	unsigned short d_sNumRef;		
+	// Atomic because the blocks updated on the thread pool take references
+	// to the shared flowsheet parameters, and wide because every port,
+	// memo and previous sweep buffer in a big plant holds one
+	std::atomic<unsigned> d_uiNumRef;
 	void DecrementRef();
-	void IncrementRef() { d_sNumRef++; }
+	void IncrementRef() { d_uiNumRef.fetch_add(1, std::memory_order_relaxed); }
 
 	template <class T> friend class C_SmartPointer;
 };
@@ -34,7 +44,7 @@ private:
 //------------------------------------------------------------------------------
 inline void C_SmartPointerObject::DecrementRef()
 {
-	if( --d_sNumRef == 0 ) 
+	if( d_uiNumRef.fetch_sub(1, std::memory_order_acq_rel) == 1 ) 
 		delete this;
 }
 
@@ -0,0 +1,255 @@
+//======================================================================
+// C_SolverClient.cpp
+// Author: James McCormick
+// Description:
+//	Talks to a C_SolverServer over its Unix domain socket.
+//======================================================================
+
+#include "C_SolverClient.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+
+using namespace std;
+
+bool C_SolverClient::Connect(const char* path)
+{
+	Close();
+
+	sockaddr_un address;
+	if(strlen(path) >= sizeof(address.sun_path))
+		return false;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	d_iSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(d_iSocket < 0)
+		return false;
+
+	if(connect(d_iSocket, (sockaddr*)&address, sizeof(address)) != 0)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+
+void C_SolverClient::Close()
+{
+	if(d_iSocket >= 0)
+		close(d_iSocket);
+	d_iSocket = -1;
+}
+
+
+void C_SolverClient::Begin(unsigned char op, const std::string& name)
+{
+	d_Request.Clear();
+	d_Request.Put(op);
+	d_Request.PutString(name);
+}
+
+
+//-----------------------------------------------------------------------
+// Send - Private C_SolverClient
+// Description
+//	Writes the request in one go and reads the whole reply.
+//
+// Arguments:	None.
+// Returns:		false if the connection has gone.
+//-----------------------------------------------------------------------
+bool C_SolverClient::Send()
+{
+	if(d_iSocket < 0)
+		return false;
+
+	const vector<char>& request = d_Request.Finish();
+	for(size_t sent = 0; sent < request.size(); )
+	{
+		ssize_t n = send(d_iSocket, &request[sent], request.size() - sent, MSG_NOSIGNAL);
+		if(n <= 0 && errno != EINTR)
+			return false;
+		if(n > 0)
+			sent += (size_t)n;
+	}
+
+	unsigned length = 0;
+	size_t got = 0;
+	while(got < sizeof(length))
+	{
+		ssize_t n = recv(d_iSocket, (char*)&length + got, sizeof(length) - got, 0);
+		if(n <= 0 && (n == 0 || errno != EINTR))
+			return false;
+		if(n > 0)
+			got += (size_t)n;
+	}
+	if(length > MAX_MESSAGE)
+		return false;
+
+	d_Reply.resize(length);
+	for(got = 0; got < length; )
+	{
+		ssize_t n = recv(d_iSocket, &d_Reply[got], length - got, 0);
+		if(n <= 0 && (n == 0 || errno != EINTR))
+			return false;
+		if(n > 0)
+			got += (size_t)n;
+	}
+	return true;
+}
+
+
+unsigned char C_SolverClient::Call()
+{
+	if(!Send())
+	{
+		Close();
+		return STATUS_FAILED;
+	}
+	C_MessageReader reply = Reply();
+	return reply.Get<unsigned char>();
+}
+
+
+void C_SolverClient::PutParameters(const std::vector<S_ParameterValue>& params)
+{
+	d_Request.Put((unsigned short)params.size());
+	for(size_t i = 0; i < params.size(); i++)
+	{
+		d_Request.Put((unsigned)params[i].blockID);
+		d_Request.PutString(params[i].name);
+		d_Request.Put(params[i].fValue);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ReadResults - Private C_SolverClient
+// Description
+//	Sends the request and reads the streams in the reply.
+//
+// Arguments:	flags - the RESULT_* flags the request was sent with
+//				results - filled with the streams sent
+// Returns:		the reply's status.
+//-----------------------------------------------------------------------
+unsigned char C_SolverClient::ReadResults(unsigned char flags, std::vector<S_StreamResult>& results)
+{
+	results.clear();
+	if(!Send())
+	{
+		Close();
+		return STATUS_FAILED;
+	}
+
+	C_MessageReader reply = Reply();
+	const unsigned char status = reply.Get<unsigned char>();
+	if(status != STATUS_OK)
+		return status;
+
+	d_bConverged = reply.Get<unsigned char>() != 0;
+	d_uiIterations = reply.Get<unsigned>();
+	const unsigned count = reply.Get<unsigned>();
+	results.reserve(count);
+	for(unsigned s = 0; s < count && !reply.Failed(); s++)
+	{
+		results.push_back(S_StreamResult());
+		S_StreamResult& r = results.back();
+		r.blockID = reply.Get<unsigned>();
+		r.port = reply.Get<unsigned short>();
+		r.fSolids = reply.Get<float>();
+		r.fWater = reply.Get<float>();
+		r.fPerSolids = reply.Get<float>();
+		if(flags & RESULT_FRACTIONS)
+		{
+			r.fractions.resize(reply.Get<unsigned short>());
+			for(size_t i = 0; i < r.fractions.size(); i++)
+				r.fractions[i] = reply.Get<float>();
+		}
+	}
+	return reply.Failed() ? STATUS_BAD_REQUEST : STATUS_OK;
+}
+
+
+unsigned char C_SolverClient::Create(const std::string& name, bool metric, float delta, unsigned maxIterations, int roundTo)
+{
+	Begin(OP_CREATE, name);
+	d_Request.Put((unsigned char)(metric ? 1 : 0));
+	d_Request.Put(delta);
+	d_Request.Put(maxIterations);
+	d_Request.Put((signed char)roundTo);
+	return Call();
+}
+
+
+unsigned char C_SolverClient::Drop(const std::string& name)
+{
+	Begin(OP_DROP, name);
+	return Call();
+}
+
+
+unsigned char C_SolverClient::Load(const std::string& name, unsigned char kind, const std::string& path)
+{
+	Begin(OP_LOAD, name);
+	d_Request.Put(kind);
+	d_Request.PutString(path, true);
+	return Call();
+}
+
+
+unsigned char C_SolverClient::AddBlock(const std::string& name, const ProcessID& procID, BlockID& id)
+{
+	Begin(OP_ADD_BLOCK, name);
+	d_Request.Put((unsigned short)procID);
+	id = 0;
+	if(!Send())
+	{
+		Close();
+		return STATUS_FAILED;
+	}
+
+	C_MessageReader reply = Reply();
+	const unsigned char status = reply.Get<unsigned char>();
+	id = reply.Get<unsigned>();
+	return status;
+}
+
+
+unsigned char C_SolverClient::Link(const std::string& name, const BlockID& from, const PortNo& port, const BlockID& to)
+{
+	Begin(OP_LINK, name);
+	d_Request.Put((unsigned)from);
+	d_Request.Put((unsigned short)port);
+	d_Request.Put((unsigned)to);
+	return Call();
+}
+
+
+unsigned char C_SolverClient::Set(const std::string& name, const std::vector<S_ParameterValue>& params)
+{
+	Begin(OP_SET, name);
+	PutParameters(params);
+	return Call();
+}
+
+
+unsigned char C_SolverClient::Solve(const std::string& name, const std::vector<S_ParameterValue>& params,
+	unsigned char flags, std::vector<S_StreamResult>& results)
+{
+	Begin(OP_SOLVE, name);
+	d_Request.Put(flags);
+	PutParameters(params);
+	return ReadResults(flags, results);
+}
+
+
+unsigned char C_SolverClient::Get(const std::string& name, unsigned char flags, std::vector<S_StreamResult>& results)
+{
+	Begin(OP_GET, name);
+	d_Request.Put(flags);
+	return ReadResults(flags, results);
+}
@@ -0,0 +1,101 @@
+//======================================================================
+// C_SolverClient.h
+// Author: James McCormick
+// Description:
+//	Talks to a C_SolverServer over its Unix domain socket.  Each call
+//	sends one request and waits for the reply.  A client keeps one
+//	connection and is used from one thread at a time.
+//======================================================================
+
+#ifndef _SOLVERCLIENT_
+#define _SOLVERCLIENT_
+
+#include "Typedefs.h"
+#include "C_SolverProtocol.h"
+#include <string>
+#include <vector>
+
+// A stream from a solve's results
+struct S_StreamResult
+{
+	BlockID blockID;
+	PortNo port;
+	float fSolids;
+	float fWater;					// m3/h or US gpm
+	float fPerSolids;
+	std::vector<float> fractions;	// Only with RESULT_FRACTIONS
+};
+
+// A parameter to set
+struct S_ParameterValue
+{
+	BlockID blockID;
+	std::string name;
+	float fValue;
+};
+
+
+class C_SolverClient
+{
+private:
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	int d_iSocket;
+	C_MessageWriter d_Request;
+	std::vector<char> d_Reply;
+
+	// From the last SOLVE or GET
+	bool d_bConverged;
+	unsigned d_uiIterations;
+
+	// PRIVATE METHODS=========================================================
+
+	// Starts a request on the named flowsheet
+	void Begin(unsigned char op, const std::string& name);
+
+	// Sends the request and reads the reply into d_Reply.  Returns false
+	// if the connection has gone.
+	bool Send();
+	C_MessageReader Reply() const { return C_MessageReader(d_Reply.empty() ? 0 : &d_Reply[0], d_Reply.size()); }
+
+	// Sends the request and returns the reply's status
+	unsigned char Call();
+
+	void PutParameters(const std::vector<S_ParameterValue>& params);
+	unsigned char ReadResults(unsigned char flags, std::vector<S_StreamResult>& results);
+
+	C_SolverClient(const C_SolverClient&);
+	C_SolverClient& operator=(const C_SolverClient&);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_SolverClient() : d_iSocket(-1), d_bConverged(false), d_uiIterations(0) {}
+	~C_SolverClient() { Close(); }
+
+	bool Connect(const char* path);
+	void Close();
+
+	// Each returns the reply's STATUS_*
+	unsigned char Create(const std::string& name, bool metric, float delta, unsigned maxIterations, int roundTo);
+	unsigned char Drop(const std::string& name);
+	unsigned char Load(const std::string& name, unsigned char kind, const std::string& path);
+	unsigned char AddBlock(const std::string& name, const ProcessID& procID, BlockID& id);
+	unsigned char Link(const std::string& name, const BlockID& from, const PortNo& port, const BlockID& to);
+	unsigned char Set(const std::string& name, const std::vector<S_ParameterValue>& params);
+
+	// Sets the parameters, solves and gets the streams that have changed
+	// since this client last saw them, or all of them with RESULT_ALL
+	unsigned char Solve(const std::string& name, const std::vector<S_ParameterValue>& params,
+		unsigned char flags, std::vector<S_StreamResult>& results);
+
+	// The results of the last solve without solving
+	unsigned char Get(const std::string& name, unsigned char flags, std::vector<S_StreamResult>& results);
+
+	bool GetConverged() const { return d_bConverged; }
+	unsigned GetNumIterations() const { return d_uiIterations; }
+};
+
+#endif // _SOLVERCLIENT_
@@ -0,0 +1,152 @@
+//======================================================================
+// C_SolverProtocol.h
+// Author: James McCormick
+// Description:
+//	The messages the solver server and its clients pass over a Unix
+//	domain socket.  Every message is a 4 byte length followed by that
+//	many bytes of body.  A request body is the operation, the length of
+//	the flowsheet's name and the name, then the operation's arguments.
+//	A reply body is a status followed by the results.  Numbers are in
+//	the host's byte order, as both ends are on the same machine; floats
+//	are 4 bytes, and names and paths are a length then the characters.
+//
+//	OP_CREATE		u8 metric, f32 delta, u32 max iterations, i8 water rounding
+//	OP_DROP
+//	OP_LOAD			u8 LOAD_*, u16 length, path
+//	OP_ADD_BLOCK	u16 process id								-> u32 block id
+//	OP_LINK			u32 from, u16 port, u32 to
+//	OP_SET			parameters									-> u16 number set
+//	OP_SOLVE		u8 RESULT_* flags, parameters				-> results
+//	OP_GET			u8 RESULT_* flags							-> results
+//
+//	The parameters are a u16 count, then for each a u32 block id, u8
+//	length, name and f32 value.  The results are a u8 converged, u32
+//	iterations, u32 count of streams, then for each a u32 block id, u16
+//	port, and f32 solids, water and percent solids, followed by u16
+//	count and f32 solids in each size fraction with RESULT_FRACTIONS.
+//	Only the streams that have changed since the client last saw them
+//	are sent unless RESULT_ALL is set.
+//======================================================================
+
+#ifndef _SOLVERPROTOCOL_
+#define _SOLVERPROTOCOL_
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+enum
+{
+	OP_CREATE = 1,
+	OP_DROP,
+	OP_LOAD,
+	OP_ADD_BLOCK,
+	OP_LINK,
+	OP_SET,
+	OP_SOLVE,
+	OP_GET
+};
+
+enum
+{
+	STATUS_OK = 0,
+	STATUS_BAD_REQUEST,			// The message could not be read
+	STATUS_NO_FLOWSHEET,		// No flowsheet has the name
+	STATUS_EXISTS,				// A flowsheet already has the name
+	STATUS_FAILED				// The operation failed, e.g. a file would not load
+};
+
+enum { LOAD_SIZES = 0, LOAD_WASHABILITY, LOAD_PARTITIONS };
+enum { RESULT_FRACTIONS = 1, RESULT_ALL = 2 };
+
+// The largest message either end will accept
+const unsigned MAX_MESSAGE = 64u << 20;
+
+
+// Builds a message body
+class C_MessageWriter
+{
+private:
+	std::vector<char> d_Buffer;
+
+public:
+	// Starts a new message, leaving room for the length
+	void Clear() { d_Buffer.assign(4, 0); }
+
+	C_MessageWriter() { Clear(); }
+
+	template <class T> void Put(const T& value)
+	{
+		const size_t at = d_Buffer.size();
+		d_Buffer.resize(at + sizeof(T));
+		memcpy(&d_Buffer[at], &value, sizeof(T));
+	}
+
+	void PutString(const std::string& s, bool wide = false)
+	{
+		if(wide)
+			Put((unsigned short)s.size());
+		else
+			Put((unsigned char)s.size());
+		d_Buffer.insert(d_Buffer.end(), s.begin(), s.end());
+	}
+
+	// Where the next value goes, and writes over a value already put there,
+	// e.g. a count only known once the items after it are written
+	size_t Tell() const { return d_Buffer.size(); }
+	template <class T> void PutAt(size_t at, const T& value) { memcpy(&d_Buffer[at], &value, sizeof(T)); }
+
+	// Fills in the length and returns the whole message
+	const std::vector<char>& Finish()
+	{
+		const unsigned length = (unsigned)d_Buffer.size() - 4;
+		memcpy(&d_Buffer[0], &length, 4);
+		return d_Buffer;
+	}
+};
+
+
+// Reads a message body.  Reading past the end sets the failed flag and
+// gives zeros, so a short message is checked once at the end.
+class C_MessageReader
+{
+private:
+	const char* d_pData;
+	size_t d_Size;
+	size_t d_Pos;
+	bool d_bFailed;
+
+public:
+	C_MessageReader(const char* data, size_t size) : d_pData(data), d_Size(size), d_Pos(0), d_bFailed(false) {}
+
+	template <class T> T Get()
+	{
+		T value = T();
+		if(d_Pos + sizeof(T) > d_Size)
+			d_bFailed = true;
+		else
+		{
+			memcpy(&value, d_pData + d_Pos, sizeof(T));
+			d_Pos += sizeof(T);
+		}
+		return value;
+	}
+
+	std::string GetString(bool wide = false)
+	{
+		const size_t length = wide ? Get<unsigned short>() : Get<unsigned char>();
+		if(d_Pos + length > d_Size)
+		{
+			d_bFailed = true;
+			return std::string();
+		}
+		std::string s(d_pData + d_Pos, length);
+		d_Pos += length;
+		return s;
+	}
+
+	bool Failed() const { return d_bFailed; }
+	bool AtEnd() const { return d_Pos == d_Size; }
+};
+
+#endif // _SOLVERPROTOCOL_
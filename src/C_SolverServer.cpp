@@ -0,0 +1,519 @@
+//======================================================================
+// C_SolverServer.cpp
+// Author: James McCormick
+// Description:
+//	Serves named flowsheets over a Unix domain socket.
+//======================================================================
+
+#include "C_SolverServer.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+
+using namespace std;
+
+// Reads or writes exactly size bytes, false if the other end has gone
+static bool ReadFully(int fd, void* data, size_t size)
+{
+	char* p = (char*)data;
+	while(size > 0)
+	{
+		ssize_t n = recv(fd, p, size, 0);
+		if(n <= 0)
+		{
+			if(n < 0 && errno == EINTR)
+				continue;
+			return false;
+		}
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+static bool WriteFully(int fd, const void* data, size_t size)
+{
+	const char* p = (const char*)data;
+	while(size > 0)
+	{
+		ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+		if(n <= 0)
+		{
+			if(n < 0 && errno == EINTR)
+				continue;
+			return false;
+		}
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+// Equal, or both NaN - an empty stream's percent solids is 0/0 and has
+// not moved because it is still empty
+static bool SameValue(const float& a, const float& b)
+{
+	return a == b || (a != a && b != b);
+}
+
+// FNV-1a over the size fractions, to tell if any has moved
+static unsigned HashFractions(const C_FlowData* fd)
+{
+	unsigned hash = 2166136261u;
+	for(unsigned short i = 0; i < fd->GetNumFractions(); i++)
+	{
+		const float value = (float)(*fd)[i];
+		unsigned bits;
+		memcpy(&bits, &value, sizeof(bits));
+		for(int b = 0; b < 4; b++)
+		{
+			hash ^= (bits >> (8 * b)) & 0xff;
+			hash *= 16777619u;
+		}
+	}
+	return hash;
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_SolverServer
+//-----------------------------------------------------------------------
+C_SolverServer::C_SolverServer() : d_iListen(-1), d_uiNumThreads(4), d_bStopping(false),
+	d_uiLastVersion(0), d_ulNumRequests(0)
+{
+}
+
+
+C_SolverServer::~C_SolverServer()
+{
+	Stop();
+	if(d_iListen >= 0)
+	{
+		close(d_iListen);
+		unlink(d_Path.c_str());
+	}
+}
+
+
+bool C_SolverServer::AddFlowsheet(const std::string& name, C_Flowsheet* fs)
+{
+	HostedPtr hosted(new S_Hosted(fs));
+	lock_guard<mutex> lock(d_Mutex);
+	if(d_Flowsheets.count(name))
+		return false;
+
+	hosted->uiVersion = ++d_uiLastVersion;
+	d_Flowsheets[name] = hosted;
+	return true;
+}
+
+
+bool C_SolverServer::Listen(const char* path)
+{
+	sockaddr_un address;
+	if(strlen(path) >= sizeof(address.sun_path))
+		return false;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+		return false;
+
+	unlink(path);
+	if(bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	d_iListen = fd;
+	d_Path = path;
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// Run - Public C_SolverServer
+// Description
+//	Puts every worker of the pool, the caller included, to accepting and
+//	serving clients.  Returns once Stop has been called and every worker
+//	has hung up on its client.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SolverServer::Run()
+{
+	if(d_iListen < 0)
+		return;
+
+	if(d_ThreadPool == NULL || d_ThreadPool->GetNumThreads() != d_uiNumThreads)
+		d_ThreadPool = new C_ThreadPool(d_uiNumThreads);
+
+	C_ServeTask task(this);
+	d_ThreadPool->ParallelFor(task, d_uiNumThreads);
+}
+
+
+void C_SolverServer::C_ServeTask::RunTask(const unsigned& index, const unsigned& worker)
+{
+	while(!d_pServer->d_bStopping)
+	{
+		int client = accept(d_pServer->d_iListen, 0, 0);
+		if(client < 0)
+		{
+			if(errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+
+		{
+			lock_guard<mutex> lock(d_pServer->d_Mutex);
+			d_pServer->d_Clients.insert(client);
+		}
+
+		if(!d_pServer->d_bStopping)
+			d_pServer->ServeClient(client);
+
+		{
+			lock_guard<mutex> lock(d_pServer->d_Mutex);
+			d_pServer->d_Clients.erase(client);
+		}
+		close(client);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// Stop - Public C_SolverServer
+// Description
+//	Shuts the listening socket, which wakes the workers waiting to accept,
+//	and every client's, which wakes the ones waiting for a request.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SolverServer::Stop()
+{
+	d_bStopping = true;
+
+	lock_guard<mutex> lock(d_Mutex);
+	if(d_iListen >= 0)
+		shutdown(d_iListen, SHUT_RDWR);
+	for(set<int>::iterator it = d_Clients.begin(); it != d_Clients.end(); it++)
+		shutdown(*it, SHUT_RDWR);
+}
+
+
+void C_SolverServer::ServeClient(int client)
+{
+	S_Session session;
+	vector<char> body;
+	C_MessageWriter out;
+
+	while(!d_bStopping)
+	{
+		unsigned length;
+		if(!ReadFully(client, &length, sizeof(length)) || length > MAX_MESSAGE)
+			return;
+
+		body.resize(length);
+		if(length && !ReadFully(client, &body[0], length))
+			return;
+
+		C_MessageReader in(body.empty() ? 0 : &body[0], length);
+		out.Clear();
+		Handle(session, in, out);
+
+		const vector<char>& reply = out.Finish();
+		if(!WriteFully(client, &reply[0], reply.size()))
+			return;
+
+		d_ulNumRequests++;
+	}
+}
+
+
+C_SolverServer::HostedPtr C_SolverServer::Find(const std::string& name)
+{
+	lock_guard<mutex> lock(d_Mutex);
+	map<string, HostedPtr>::iterator it = d_Flowsheets.find(name);
+	return (it == d_Flowsheets.end()) ? HostedPtr() : it->second;
+}
+
+
+unsigned C_SolverServer::NextVersion()
+{
+	lock_guard<mutex> lock(d_Mutex);
+	return ++d_uiLastVersion;
+}
+
+
+bool C_SolverServer::ReadParameters(C_MessageReader& in, std::vector<S_ParameterRef>& refs, std::vector<float>& values)
+{
+	const unsigned short count = in.Get<unsigned short>();
+	refs.resize(count);
+	values.resize(count);
+	for(unsigned short i = 0; i < count && !in.Failed(); i++)
+	{
+		refs[i].blockID = in.Get<unsigned>();
+		refs[i].name = in.GetString();
+		values[i] = in.Get<float>();
+	}
+	return !in.Failed();
+}
+
+
+//-----------------------------------------------------------------------
+// Handle - Private C_SolverServer
+// Description
+//	Reads a request and writes the reply.  A request that cannot be read
+//	in full changes nothing.
+//
+// Arguments:	session - the client's session
+//				in - the request
+//				out - the reply
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SolverServer::Handle(S_Session& session, C_MessageReader& in, C_MessageWriter& out)
+{
+	const unsigned char op = in.Get<unsigned char>();
+	const string name = in.GetString();
+	if(in.Failed())
+	{
+		out.Put((unsigned char)STATUS_BAD_REQUEST);
+		return;
+	}
+
+	if(op == OP_CREATE)
+	{
+		const unsigned char metric = in.Get<unsigned char>();
+		const float delta = in.Get<float>();
+		const unsigned maxIterations = in.Get<unsigned>();
+		const signed char roundTo = in.Get<signed char>();
+		if(in.Failed())
+		{
+			out.Put((unsigned char)STATUS_BAD_REQUEST);
+			return;
+		}
+
+		C_Flowsheet* fs = new C_Flowsheet;
+		fs->SetMetric(metric != 0);
+		fs->SetDelta(delta);
+		fs->SetMaxIterations(maxIterations);
+		fs->SetRoundToWater(roundTo);
+		fs->SetUpdateSolids(true);
+		fs->SetUpdateWater(true);
+		out.Put((unsigned char)(AddFlowsheet(name, fs) ? STATUS_OK : STATUS_EXISTS));
+		return;
+	}
+
+	if(op == OP_DROP)
+	{
+		lock_guard<mutex> lock(d_Mutex);
+		session.seen.erase(name);
+		out.Put((unsigned char)(d_Flowsheets.erase(name) ? STATUS_OK : STATUS_NO_FLOWSHEET));
+		return;
+	}
+
+	HostedPtr hosted = Find(name);
+	if(!hosted)
+	{
+		out.Put((unsigned char)STATUS_NO_FLOWSHEET);
+		return;
+	}
+
+	lock_guard<mutex> lock(hosted->mutex);
+	C_Flowsheet& fs = *hosted->pFlowsheet;
+
+	switch(op)
+	{
+	case OP_LOAD:
+	{
+		const unsigned char kind = in.Get<unsigned char>();
+		const string path = in.GetString(true);
+		if(in.Failed())
+			break;
+
+		bool loaded = false;
+		if(kind == LOAD_SIZES)
+			loaded = fs.LoadSizeDistribution(path.c_str());
+		else if(kind == LOAD_WASHABILITY)
+			loaded = fs.LoadWashability(path.c_str());
+		else if(kind == LOAD_PARTITIONS)
+			loaded = fs.LoadPartitionNumbers(path.c_str());
+		hosted->uiVersion = NextVersion();
+		out.Put((unsigned char)(loaded ? STATUS_OK : STATUS_FAILED));
+		return;
+	}
+
+	case OP_ADD_BLOCK:
+	{
+		const unsigned short procID = in.Get<unsigned short>();
+		if(in.Failed())
+			break;
+
+		const BlockID id = fs.CreateBlock(procID);
+		hosted->uiVersion = NextVersion();
+		out.Put((unsigned char)(id ? STATUS_OK : STATUS_FAILED));
+		out.Put((unsigned)id);
+		return;
+	}
+
+	case OP_LINK:
+	{
+		const BlockID from = in.Get<unsigned>();
+		const PortNo port = in.Get<unsigned short>();
+		const BlockID to = in.Get<unsigned>();
+		if(in.Failed())
+			break;
+
+		BlockPtr source = fs.GetBlock(from);
+		if(source == NULL || fs.GetBlock(to) == NULL || port >= source->GetPorts().GetNumPorts())
+		{
+			out.Put((unsigned char)STATUS_FAILED);
+			return;
+		}
+		fs.MakeLink(from, port, to);
+		hosted->uiVersion = NextVersion();
+		out.Put((unsigned char)STATUS_OK);
+		return;
+	}
+
+	case OP_SET:
+	case OP_SOLVE:
+	{
+		const unsigned char flags = (op == OP_SOLVE) ? in.Get<unsigned char>() : 0;
+		vector<S_ParameterRef> refs;
+		vector<float> values;
+		if(!ReadParameters(in, refs, values))
+			break;
+
+		unsigned short numSet = 0;
+		for(size_t i = 0; i < refs.size(); i++)
+		{
+			if(fs.SetParameter(refs[i].blockID, refs[i].name, values[i]))
+				numSet++;
+		}
+
+		if(op == OP_SET)
+		{
+			out.Put((unsigned char)STATUS_OK);
+			out.Put(numSet);
+			return;
+		}
+
+		// A flowsheet cannot be solved without a size distribution
+		if(!fs.HasSizeDistribution())
+		{
+			out.Put((unsigned char)STATUS_FAILED);
+			return;
+		}
+
+		hosted->bConverged = fs.SolveFlowSheet();
+		hosted->uiIterations = fs.GetNumIterations();
+		WriteResults(session, name, *hosted, flags, out);
+		return;
+	}
+
+	case OP_GET:
+	{
+		const unsigned char flags = in.Get<unsigned char>();
+		if(in.Failed())
+			break;
+
+		WriteResults(session, name, *hosted, flags, out);
+		return;
+	}
+	}
+
+	out.Put((unsigned char)STATUS_BAD_REQUEST);
+}
+
+
+//-----------------------------------------------------------------------
+// WriteResults - Private C_SolverServer
+// Description
+//	Writes the streams whose solids, water, percent solids or size
+//	fractions have moved since the session last saw them, or all of them
+//	if asked or the flowsheet has changed shape since.
+//
+// Arguments:	session - the client's session
+//				name - the flowsheet's name
+//				hosted - the flowsheet, locked
+//				flags - RESULT_* flags
+//				out - the reply
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SolverServer::WriteResults(S_Session& session, const std::string& name, S_Hosted& hosted,
+	unsigned char flags, C_MessageWriter& out)
+{
+	if(hosted.uiStreamsVersion != hosted.uiVersion)
+	{
+		vector<BlockID> ids;
+		hosted.pFlowsheet->GetBlockIDs(ids);
+		hosted.streams.clear();
+		hosted.streamBlocks.clear();
+		for(size_t i = 0; i < ids.size(); i++)
+		{
+			BlockPtr block = hosted.pFlowsheet->GetBlock(ids[i]);
+			for(PortNo p = 0; p < block->GetPorts().GetNumPorts(); p++)
+			{
+				S_StreamKey key = { ids[i], p };
+				hosted.streams.push_back(key);
+				hosted.streamBlocks.push_back(block);
+			}
+		}
+		hosted.uiStreamsVersion = hosted.uiVersion;
+	}
+
+	S_Seen& seen = session.seen[name];
+	bool all = (flags & RESULT_ALL) != 0;
+	if(seen.uiVersion != hosted.uiVersion || seen.streams.size() != hosted.streams.size())
+	{
+		seen.uiVersion = hosted.uiVersion;
+		seen.streams.resize(hosted.streams.size());
+		all = true;
+	}
+
+	out.Put((unsigned char)STATUS_OK);
+	out.Put((unsigned char)(hosted.bConverged ? 1 : 0));
+	out.Put(hosted.uiIterations);
+	const size_t countAt = out.Tell();
+	out.Put((unsigned)0);
+
+	unsigned count = 0;
+	for(size_t s = 0; s < hosted.streams.size(); s++)
+	{
+		const C_FlowData* fd = hosted.streamBlocks[s]->GetFlowData(hosted.streams[s].port);
+		S_SeenStream now;
+		now.fSolids = (float)fd->d_SolidRate;
+		now.fWater = (float)fd->GetFluidRate();
+		now.fPerSolids = (float)fd->d_PerSolids;
+		now.uiFractions = HashFractions(fd);
+
+		S_SeenStream& last = seen.streams[s];
+		if(!all && SameValue(now.fSolids, last.fSolids) && SameValue(now.fWater, last.fWater) &&
+			SameValue(now.fPerSolids, last.fPerSolids) && now.uiFractions == last.uiFractions)
+			continue;
+
+		last = now;
+		out.Put((unsigned)hosted.streams[s].blockID);
+		out.Put((unsigned short)hosted.streams[s].port);
+		out.Put(now.fSolids);
+		out.Put(now.fWater);
+		out.Put(now.fPerSolids);
+		if(flags & RESULT_FRACTIONS)
+		{
+			out.Put(fd->GetNumFractions());
+			for(unsigned short i = 0; i < fd->GetNumFractions(); i++)
+				out.Put((float)(*fd)[i]);
+		}
+		count++;
+	}
+	out.PutAt(countAt, count);
+}
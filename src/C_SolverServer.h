@@ -0,0 +1,155 @@
+//======================================================================
+// C_SolverServer.h
+// Author: James McCormick
+// Description:
+//	Keeps named flowsheets loaded and compiled, and serves requests to
+//	build, change and solve them over a Unix domain socket (see
+//	C_SolverProtocol.h).  A flowsheet is only compiled again when its
+//	blocks, links or size distribution change, so a request that moves
+//	a few parameters and solves only re-updates the blocks downstream of
+//	them.  The reply only carries the streams that changed since the
+//	client last saw them.
+//
+//	Each worker of a thread pool accepts a client and serves it until it
+//	hangs up, so as many clients as there are threads are served at
+//	once and the rest wait to be accepted.  Requests on one flowsheet
+//	take turns; different flowsheets are solved at the same time.
+//======================================================================
+
+#ifndef _SOLVERSERVER_
+#define _SOLVERSERVER_
+
+#include "C_Flowsheet.h"
+#include "C_SolverProtocol.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+class C_SolverServer
+{
+private:
+
+	// A flowsheet the server holds.  Its mutex is held for every request on it.
+	struct S_Hosted
+	{
+		std::mutex mutex;
+		C_Flowsheet* pFlowsheet;
+
+		// Moves on, to a number no flowsheet has had, whenever the blocks,
+		// links or size distribution change
+		unsigned uiVersion;
+
+		// Every port of every block in BlockID order, as of uiStreamsVersion
+		std::vector<S_StreamKey> streams;
+		std::vector<BlockPtr> streamBlocks;
+		unsigned uiStreamsVersion;
+
+		bool bConverged;
+		unsigned uiIterations;
+
+		S_Hosted(C_Flowsheet* fs) : pFlowsheet(fs), uiVersion(0), uiStreamsVersion(0), bConverged(false), uiIterations(0) {}
+		~S_Hosted() { delete pFlowsheet; }
+	};
+	typedef std::shared_ptr<S_Hosted> HostedPtr;
+
+	// A stream's values as a client last saw them
+	struct S_SeenStream
+	{
+		float fSolids;
+		float fWater;
+		float fPerSolids;
+		unsigned uiFractions;		// A hash of the size fractions
+	};
+
+	// What a client has been sent from one flowsheet
+	struct S_Seen
+	{
+		unsigned uiVersion;
+		std::vector<S_SeenStream> streams;
+	};
+
+	// A connected client
+	struct S_Session
+	{
+		std::map<std::string, S_Seen> seen;
+	};
+
+	// Accepts and serves clients on one worker until the server stops
+	class C_ServeTask : public I_ParallelTask
+	{
+	public:
+		C_SolverServer* d_pServer;
+		C_ServeTask(C_SolverServer* server) : d_pServer(server) {}
+		void RunTask(const unsigned& index, const unsigned& worker);
+	};
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	std::string d_Path;
+	int d_iListen;
+	unsigned d_uiNumThreads;
+	ThreadPoolPtr d_ThreadPool;
+	std::atomic<bool> d_bStopping;
+
+	// Guards the flowsheets and the clients
+	std::mutex d_Mutex;
+	std::map<std::string, HostedPtr> d_Flowsheets;
+	std::set<int> d_Clients;
+	unsigned d_uiLastVersion;
+
+	std::atomic<unsigned long> d_ulNumRequests;
+
+	// PRIVATE METHODS=========================================================
+
+	// Serves one client until it hangs up or the server stops
+	void ServeClient(int client);
+
+	// Carries out one request
+	void Handle(S_Session& session, C_MessageReader& in, C_MessageWriter& out);
+
+	HostedPtr Find(const std::string& name);
+
+	// A version no flowsheet has had
+	unsigned NextVersion();
+
+	// Reads a list of parameters, all of it or none
+	static bool ReadParameters(C_MessageReader& in, std::vector<S_ParameterRef>& refs, std::vector<float>& values);
+
+	// Writes the results of the last solve that the session has not seen
+	void WriteResults(S_Session& session, const std::string& name, S_Hosted& hosted, unsigned char flags, C_MessageWriter& out);
+
+	C_SolverServer(const C_SolverServer&);
+	C_SolverServer& operator=(const C_SolverServer&);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_SolverServer();
+	~C_SolverServer();
+
+	// The number of clients served at once.  Set before Run.
+	void SetNumThreads(unsigned n) { d_uiNumThreads = (n == 0) ? 1 : n; }
+
+	// Hosts a flowsheet built in this process.  The server owns fs from
+	// then on.  Returns false, and deletes fs, if the name is taken.
+	bool AddFlowsheet(const std::string& name, C_Flowsheet* fs);
+
+	// Binds the socket, replacing any old socket file at path
+	bool Listen(const char* path);
+
+	// Serves clients until Stop is called.  The calling thread is one of
+	// the workers.
+	void Run();
+
+	// Stops Run and hangs up on every client.  Can be called from any thread.
+	void Stop();
+
+	unsigned long GetNumRequests() const { return d_ulNumRequests; }
+};
+
+#endif // _SOLVERSERVER_
@@ -0,0 +1,154 @@
+//======================================================================
+// C_SolverStats.cpp
+// Author: James McCormick
+// Description:
+//	Timing and counters collected by the flowsheet while it solves.
+//======================================================================
+
+#include "C_SolverStats.h"
+#include <fstream>
+#include <chrono>
+
+#ifdef FS_PROFILING
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Profiling builds count every heap allocation made by the process,
+// host included, except the aligned ones.  See C_SolverStats.h.
+static std::atomic<unsigned long> g_ulAllocations(0);
+
+void* operator new(size_t size)
+{
+	g_ulAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------
+// Reset - Public C_SolverStats
+// Description
+//	Clears the stats before a solve.
+//
+// Arguments:	numThreads - the number of trace buffers to keep
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SolverStats::Reset(unsigned numThreads)
+{
+	uiIterations = 0;
+	dSolveTime = 0.0;
+	dSumSourcesTime = 0.0;
+	dCheckTime = 0.0;
+	ulAllocations = 0;
+	ulMemoHits = 0;
+	ulMemoMisses = 0;
+	residuals.clear();
+	blocks.clear();
+	trace.resize(numThreads);
+	for(size_t i = 0; i < trace.size(); i++)
+		trace[i].clear();
+}
+
+
+bool C_SolverStats::IsEnabled()
+{
+#ifdef FS_PROFILING
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+double C_SolverStats::Now()
+{
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+unsigned long C_SolverStats::GetAllocationCount()
+{
+#ifdef FS_PROFILING
+	return g_ulAllocations.load(memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+
+//-----------------------------------------------------------------------
+// WriteChromeTrace - Public C_SolverStats
+// Description
+//	Writes the trace as a JSON array of complete ("X") events, one row
+//	per thread, and the residual of each sweep as a counter ("C") track.
+//	Times are written in microseconds.
+//
+// Arguments:	fileName - the file to write
+// Returns:		true if the file was written
+//-----------------------------------------------------------------------
+bool C_SolverStats::WriteChromeTrace(const char* fileName) const
+{
+	ofstream file(fileName);
+	if(!file)
+		return false;
+
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Flowsheet\"}}";
+
+	for(size_t t = 0; t < trace.size(); t++)
+	{
+		for(size_t i = 0; i < trace[t].size(); i++)
+		{
+			const S_TraceEvent& e = trace[t][i];
+			file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << e.uiThread
+				<< ",\"ts\":" << e.dStart * 1.0e6 << ",\"dur\":" << e.dDuration * 1.0e6;
+
+			switch(e.ucType)
+			{
+				case S_TraceEvent::TRACE_SOLVE:
+					file << ",\"name\":\"SolveFlowSheet\",\"cat\":\"solve\",\"args\":{\"iterations\":" << uiIterations << "}}";
+					break;
+				case S_TraceEvent::TRACE_ITERATION:
+					file << ",\"name\":\"Iteration " << e.blockID << "\",\"cat\":\"iteration\",\"args\":{\"residual\":"
+						<< ((e.blockID < residuals.size()) ? residuals[e.blockID] : 0.0f) << "}}";
+					break;
+				default:
+					file << ",\"name\":\"Block " << e.blockID << "\",\"cat\":\"block\",\"args\":{\"procID\":" << e.procID << "}}";
+					break;
+			}
+		}
+	}
+
+	// The residual as a counter, stamped at the end of each iteration
+	if(!trace.empty())
+	{
+		for(size_t i = 0; i < trace[0].size(); i++)
+		{
+			const S_TraceEvent& e = trace[0][i];
+			if(e.ucType == S_TraceEvent::TRACE_ITERATION && e.blockID < residuals.size())
+			{
+				file << ",\n{\"name\":\"residual\",\"ph\":\"C\",\"pid\":1,\"ts\":" << (e.dStart + e.dDuration) * 1.0e6
+					<< ",\"args\":{\"residual\":" << residuals[e.blockID] << "}}";
+			}
+		}
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return file.good();
+}
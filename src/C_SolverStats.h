@@ -0,0 +1,110 @@
+//======================================================================
+// C_SolverStats.h
+// Author: James McCormick
+// Description:
+//	Timing and counters collected by the flowsheet while it solves.
+//	The instrumentation is only compiled in when FS_PROFILING is
+//	defined; without it the FS_PROFILE() statements vanish and the
+//	stats only hold the iteration count.
+//======================================================================
+
+#ifndef _SOLVERSTATS_
+#define _SOLVERSTATS_
+
+#include "Typedefs.h"
+#include <vector>
+
+// FS_PROFILING also replaces the global operator new and delete, in
+// C_SolverStats.cpp, to count allocations.  That applies to the whole
+// process, so a program linking the library, such as a C API host, is
+// counted as well and can not replace them itself.  The aligned overloads
+// are not replaced, so over-aligned allocations are not counted.
+#ifdef FS_PROFILING
+	#define FS_PROFILE(x) x
+#else
+	#define FS_PROFILE(x)
+#endif
+
+// The time and call count for one block during the last solve
+struct S_BlockStats
+{
+	BlockID blockID;
+	ProcessID procID;
+	unsigned uiCalls;			// Number of OnUpdate calls
+	double dUpdateTime;			// Seconds spent in OnUpdate
+	double dSumSourcesTime;		// Seconds spent summing the block's sources
+	double dCheckTime;			// Seconds spent comparing against the last sweep
+	unsigned uiMemoHits;		// Number of OnUpdate calls skipped as nothing had changed
+
+	S_BlockStats() : blockID(0), procID(0), uiCalls(0), dUpdateTime(0.0), dSumSourcesTime(0.0), dCheckTime(0.0), uiMemoHits(0) {}
+};
+
+// One complete event for the trace
+struct S_TraceEvent
+{
+	enum { TRACE_SOLVE = 0, TRACE_ITERATION, TRACE_BLOCK };
+
+	unsigned char ucType;
+	unsigned uiThread;
+	BlockID blockID;			// The block, or the iteration number
+	ProcessID procID;
+	double dStart;				// Seconds from the start of the solve
+	double dDuration;
+};
+
+
+class C_SolverStats
+{
+public:
+
+	// PUBLIC DATA MEMBERS=====================================================
+
+	// Number of sweeps the last solve took
+	unsigned uiIterations;
+
+	// Wall time of the whole solve, and the totals over every block
+	double dSolveTime;
+	double dSumSourcesTime;
+	double dCheckTime;
+
+	// Heap allocations made by the process during the solve, on any thread
+	unsigned long ulAllocations;
+
+	// Block updates skipped as their feed and parameters had not changed,
+	// and the ones that were done
+	unsigned long ulMemoHits;
+	unsigned long ulMemoMisses;
+
+	// The largest change of any block in each sweep
+	std::vector<float> residuals;
+
+	// Per block stats in schedule order
+	std::vector<S_BlockStats> blocks;
+
+	// Trace events, one list per worker thread
+	std::vector< std::vector<S_TraceEvent> > trace;
+
+	// PUBLIC METHODS==========================================================
+
+	C_SolverStats() { Reset(0); }
+
+	// Clears everything and sets up a trace buffer for each thread
+	void Reset(unsigned numThreads);
+
+	// The fraction of block updates that were skipped
+	double GetMemoHitRate() const { return (ulMemoHits + ulMemoMisses) ? (double)ulMemoHits / (ulMemoHits + ulMemoMisses) : 0.0; }
+
+	// Is the instrumentation compiled in
+	static bool IsEnabled();
+
+	// Seconds on a monotonic clock
+	static double Now();
+
+	// Total heap allocations made by the process so far - 0 without FS_PROFILING
+	static unsigned long GetAllocationCount();
+
+	// Writes the trace and residuals in the Chrome trace event format (chrome://tracing)
+	bool WriteChromeTrace(const char* fileName) const;
+};
+
+#endif // _SOLVERSTATS_
@@ -0,0 +1,146 @@
+//======================================================================
+// C_Splitter.h 
+// Author: James McCormick
+// Description:
+//	A block that splits a stream in two without changing it.  Used for
+//	bleeds and for closing recycle loops.
+//	The first port is the feed.
+//	The second port gets d_fSplit of the feed.
+//	The third port gets the rest.
+//======================================================================
+
+#ifndef _SPLITTER_
+#define _SPLITTER_
+
+#include "I_FSBlock.h"
+
+
+class C_SplitterParams : public I_FSBlockParameters
+{
+private:
+	C_SplitterParams();
+	C_SplitterParams(C_SplitterParams&);
+
+public:
+	C_SplitterParams(BlockID id, ProcessID p, float split) : I_FSBlockParameters(id, p), 
+		d_fSplit(split)
+	{}
+
+	float d_fSplit;
+};
+
+
+class C_Splitter : public I_FSBlock
+{
+protected:
+
+	// PROTECTED DATA MEMBERS==================================================
+
+	// The fraction of the feed sent to the second port
+	float d_fSplit;
+
+	// PROTECTED METHODS=======================================================
+
+	virtual void UpdateWater()
+	{
+		C_FlowData* feed = d_Ports.GetFlowData(0);
+		d_Ports.GetFlowData(1)->d_FluidRate = feed->d_FluidRate * d_fSplit;
+		d_Ports.GetFlowData(2)->d_FluidRate = feed->d_FluidRate - d_Ports.GetFlowData(1)->d_FluidRate;
+
+		const float* seed = GetSeed("Split");
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			float dSplit = seed ? seed[k] : 0.0f;
+			d_Ports.GetFlowData(1)->FluidTangent(k) = feed->FluidTangent(k) * d_fSplit + feed->d_FluidRate * dSplit;
+			d_Ports.GetFlowData(2)->FluidTangent(k) = feed->FluidTangent(k) - d_Ports.GetFlowData(1)->FluidTangent(k);
+		}
+	}
+
+	// The rest takes the rounding
+	virtual int WaterBalancePort() const { return 2; }
+
+	virtual void UpdateSolids()
+	{
+		C_FlowData* feed = d_Ports.GetFlowData(0);
+		C_FlowData* split = d_Ports.GetFlowData(1);
+		C_FlowData* rest = d_Ports.GetFlowData(2);
+
+		split->ScaleFrom(*feed, d_fSplit);
+		rest->SetToDifference(*feed, *split);
+
+		const float* seed = GetSeed("Split");
+		const unsigned short n = feed->GetNumFractions();
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			float dSplit = seed ? seed[k] : 0.0f;
+			const FlowValue* f = feed->GetTangent(k);
+			FlowValue* s = split->GetTangent(k);
+			FlowValue* r = rest->GetTangent(k);
+			s[n] = 0.0f;
+			r[n] = 0.0f;
+			for(unsigned short i = 0; i < n; i++)
+			{
+				s[i] = f[i] * d_fSplit + (*feed)[i] * dSplit;
+				r[i] = f[i] - s[i];
+				s[n] += s[i];
+				r[n] += r[i];
+			}
+		}
+	}
+
+public:
+
+	// PUBLIC DATA MEMBERS=====================================================
+
+	// PUBLIC METHODS==========================================================
+
+	// Constructor
+	C_Splitter(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID), d_fSplit(0.5f)
+	{
+		d_ProccessID = PROCID_SPLITTER;
+		d_Ports.Init(fsp, 3); 
+	}
+
+	// The size distribution has been updated
+	virtual void OnNewSizeDistribution()
+	{
+		d_Ports.Reset();
+	}
+
+	// Is called to pass the parameters to the block
+	virtual void OnParameters(BlockParamsPtr p)
+	{
+		// If the process id of the parameters does not match the id for this
+		// block, then exit
+		if(p->d_ProcessID != d_ProccessID)
+			return;
+
+		C_SplitterParams* castParams = static_cast<C_SplitterParams*>((I_FSBlockParameters*)p);
+
+		d_fSplit = castParams->d_fSplit;
+	}
+
+	// Named parameters - "Split"
+	virtual bool SetParameter(const std::string& name, const float& value)
+	{
+		if(name != "Split")
+			return false;
+		d_fSplit = value;
+		return true;
+	}
+
+	virtual bool GetParameter(const std::string& name, float& value) const
+	{
+		if(name != "Split")
+			return false;
+		value = d_fSplit;
+		return true;
+	}
+
+	virtual void GetParameterNames(std::vector<std::string>& names) const
+	{
+		names.push_back("Split");
+	}
+};
+
+#endif // _SPLITTER_
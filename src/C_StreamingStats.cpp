@@ -0,0 +1,184 @@
+//======================================================================
+// C_StreamingStats.cpp
+// Author: James McCormick
+// Description:
+//	Statistics that are updated one value at a time.
+//======================================================================
+
+#include "C_StreamingStats.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_P2Quantile
+//-----------------------------------------------------------------------
+C_P2Quantile::C_P2Quantile(double p) : d_dP(p), d_uiCount(0)
+{
+	for(int i = 0; i < 5; i++)
+	{
+		d_dQ[i] = 0.0;
+		d_dN[i] = i;
+	}
+
+	d_dNP[0] = 0.0;
+	d_dNP[1] = 2.0 * p;
+	d_dNP[2] = 4.0 * p;
+	d_dNP[3] = 2.0 + 2.0 * p;
+	d_dNP[4] = 4.0;
+
+	d_dDN[0] = 0.0;
+	d_dDN[1] = p / 2.0;
+	d_dDN[2] = p;
+	d_dDN[3] = (1.0 + p) / 2.0;
+	d_dDN[4] = 1.0;
+}
+
+
+double C_P2Quantile::Parabolic(int i, double d) const
+{
+	return d_dQ[i] + d / (d_dN[i + 1] - d_dN[i - 1]) *
+		((d_dN[i] - d_dN[i - 1] + d) * (d_dQ[i + 1] - d_dQ[i]) / (d_dN[i + 1] - d_dN[i]) +
+		 (d_dN[i + 1] - d_dN[i] - d) * (d_dQ[i] - d_dQ[i - 1]) / (d_dN[i] - d_dN[i - 1]));
+}
+
+
+double C_P2Quantile::Linear(int i, double d) const
+{
+	int j = i + (int)d;
+	return d_dQ[i] + d * (d_dQ[j] - d_dQ[i]) / (d_dN[j] - d_dN[i]);
+}
+
+
+//-----------------------------------------------------------------------
+// Add - Public C_P2Quantile
+// Description
+//	Adds a value and moves the markers toward their desired positions.
+//
+// Arguments:	x - the value
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_P2Quantile::Add(double x)
+{
+	// The first five values are kept sorted in the markers
+	if(d_uiCount < 5)
+	{
+		d_dQ[d_uiCount++] = x;
+		if(d_uiCount == 5)
+			std::sort(d_dQ, d_dQ + 5);
+		return;
+	}
+
+	int k;
+	if(x < d_dQ[0])
+	{
+		d_dQ[0] = x;
+		k = 0;
+	}
+	else if(x >= d_dQ[4])
+	{
+		d_dQ[4] = x;
+		k = 3;
+	}
+	else
+	{
+		k = 0;
+		while(k < 3 && x >= d_dQ[k + 1])
+			k++;
+	}
+
+	for(int i = k + 1; i < 5; i++)
+		d_dN[i] += 1.0;
+	for(int i = 0; i < 5; i++)
+		d_dNP[i] += d_dDN[i];
+
+	for(int i = 1; i < 4; i++)
+	{
+		double d = d_dNP[i] - d_dN[i];
+		if((d >= 1.0 && d_dN[i + 1] - d_dN[i] > 1.0) || (d <= -1.0 && d_dN[i - 1] - d_dN[i] < -1.0))
+		{
+			d = (d > 0.0) ? 1.0 : -1.0;
+			double q = Parabolic(i, d);
+			if(d_dQ[i - 1] < q && q < d_dQ[i + 1])
+				d_dQ[i] = q;
+			else
+				d_dQ[i] = Linear(i, d);
+			d_dN[i] += d;
+		}
+	}
+
+	d_uiCount++;
+}
+
+
+//-----------------------------------------------------------------------
+// Get - Public C_P2Quantile
+// Description
+//	The current estimate.  Until there are five values the quantile is
+//	taken straight from the sorted values.
+//-----------------------------------------------------------------------
+double C_P2Quantile::Get() const
+{
+	if(d_uiCount == 0)
+		return 0.0;
+
+	if(d_uiCount < 5)
+	{
+		double sorted[5];
+		std::copy(d_dQ, d_dQ + d_uiCount, sorted);
+		std::sort(sorted, sorted + d_uiCount);
+		unsigned index = (unsigned)(d_dP * (d_uiCount - 1) + 0.5);
+		return sorted[index];
+	}
+
+	return d_dQ[2];
+}
+
+
+//-----------------------------------------------------------------------
+// Init - Public C_StreamStatistic
+//-----------------------------------------------------------------------
+void C_StreamStatistic::Init(const std::vector<double>& quantiles)
+{
+	d_uiCount = 0;
+	d_dMean = 0.0;
+	d_dM2 = 0.0;
+	d_dMin = 0.0;
+	d_dMax = 0.0;
+
+	d_Quantiles.clear();
+	for(size_t i = 0; i < quantiles.size(); i++)
+		d_Quantiles.push_back(C_P2Quantile(quantiles[i]));
+}
+
+
+//-----------------------------------------------------------------------
+// Add - Public C_StreamStatistic
+// Description
+//	Adds a value to the running statistics.
+//
+// Arguments:	x - the value
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_StreamStatistic::Add(double x)
+{
+	if(x != x)
+		return;
+
+	d_uiCount++;
+	if(d_uiCount == 1)
+	{
+		d_dMin = x;
+		d_dMax = x;
+	}
+	else
+	{
+		if(x < d_dMin) d_dMin = x;
+		if(x > d_dMax) d_dMax = x;
+	}
+
+	double delta = x - d_dMean;
+	d_dMean += delta / d_uiCount;
+	d_dM2 += delta * (x - d_dMean);
+
+	for(size_t i = 0; i < d_Quantiles.size(); i++)
+		d_Quantiles[i].Add(x);
+}
@@ -0,0 +1,79 @@
+//======================================================================
+// C_StreamingStats.h
+// Author: James McCormick
+// Description:
+//	Statistics that are updated one value at a time and never store the
+//	values themselves, so the memory used does not grow with the number
+//	of samples.  The mean and variance use Welford's method and the
+//	percentiles use the P-square estimator of Jain and Chlamtac (1985).
+//======================================================================
+
+#ifndef _STREAMINGSTATS_
+#define _STREAMINGSTATS_
+
+#include <vector>
+
+//======================================================================
+// C_P2Quantile
+// Estimates a single quantile with five markers.
+//======================================================================
+class C_P2Quantile
+{
+private:
+	double d_dP;			// The quantile, 0 to 1
+	double d_dQ[5];			// Marker heights
+	double d_dN[5];			// Marker positions
+	double d_dNP[5];		// Desired marker positions
+	double d_dDN[5];		// Desired position increments
+	unsigned d_uiCount;
+
+	// Piecewise parabolic prediction of marker i moved by d
+	double Parabolic(int i, double d) const;
+	double Linear(int i, double d) const;
+
+public:
+	C_P2Quantile(double p = 0.5);
+
+	void Add(double x);
+
+	// The current estimate - exact while there are five or fewer values
+	double Get() const;
+
+	double GetQuantile() const { return d_dP; }
+};
+
+
+//======================================================================
+// C_StreamStatistic
+// Count, mean, variance, min, max and a set of percentiles for one value.
+//======================================================================
+class C_StreamStatistic
+{
+private:
+	unsigned d_uiCount;
+	double d_dMean;
+	double d_dM2;
+	double d_dMin;
+	double d_dMax;
+	std::vector<C_P2Quantile> d_Quantiles;
+
+public:
+	C_StreamStatistic() : d_uiCount(0), d_dMean(0.0), d_dM2(0.0), d_dMin(0.0), d_dMax(0.0) {}
+
+	// Sets the percentiles to track (0 to 1) and clears the statistic
+	void Init(const std::vector<double>& quantiles);
+
+	// Adds a value.  NaN values are skipped.
+	void Add(double x);
+
+	unsigned GetCount() const { return d_uiCount; }
+	double GetMean() const { return d_dMean; }
+	double GetVariance() const { return (d_uiCount > 1) ? d_dM2 / (d_uiCount - 1) : 0.0; }
+	double GetMin() const { return d_dMin; }
+	double GetMax() const { return d_dMax; }
+
+	unsigned GetNumQuantiles() const { return (unsigned)d_Quantiles.size(); }
+	const C_P2Quantile& GetQuantile(unsigned i) const { return d_Quantiles[i]; }
+};
+
+#endif // _STREAMINGSTATS_
@@ -0,0 +1,278 @@
+//======================================================================
+// C_SubFlowsheet.cpp 
+// Author: James McCormick
+// Description:
+//	A block that wraps a whole flowsheet.
+//
+//======================================================================
+
+#include "C_SubFlowsheet.h"
+#include <cstdio>
+#include <cstdlib>
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_SubFlowsheet
+// Description 
+//	Creates the inner flowsheet with its inlet block.  The inner solve
+//	is tighter than the outer one's default, so the outlets have settled
+//	well within it; set "Delta" and "MaxIterations" to change it.
+// 
+// Arguments:	fsp - the outer flowsheet's parameters
+//				ID - the id for this block
+// Returns:		None.
+//-----------------------------------------------------------------------
+C_SubFlowsheet::C_SubFlowsheet(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID), d_bConverged(false), d_uiMultiplicity(1)
+{
+	d_ProccessID = PROCID_SUBFLOWSHEET;
+	d_Ports.Init(fsp, 1);
+
+	d_pFlowsheet = new C_Flowsheet(fsp);
+	d_pFlowsheet->SetDelta(0.0001f);
+	d_pFlowsheet->SetMaxIterations(100);
+	d_InletID = d_pFlowsheet->CreateBlock(PROCID_INLET);
+}
+
+
+C_SubFlowsheet::~C_SubFlowsheet()
+{
+	delete d_pFlowsheet;
+}
+
+
+PortNo C_SubFlowsheet::AddOutlet(const BlockID& id, const PortNo& port)
+{
+	S_StreamKey outlet;
+	outlet.blockID = id;
+	outlet.port = port;
+	d_Outlets.push_back(outlet);
+
+	d_Ports.Init(d_fspFSParams, (unsigned short)(d_Outlets.size() + 1));
+	return (PortNo)d_Outlets.size();
+}
+
+
+// The size distribution has been updated
+void C_SubFlowsheet::OnNewSizeDistribution()
+{
+	d_Ports.Reset();
+	d_pFlowsheet->OnNewSizeDistribution();
+}
+
+
+//-----------------------------------------------------------------------
+// OnUpdate - Public C_SubFlowsheet
+// Description 
+//	Hands the feed to the inlet, solves the inner flowsheet and copies
+//	the outlets onto this block's ports.  With several identical
+//	circuits the inlet gets one circuit's share and the outlets are
+//	scaled back up.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SubFlowsheet::OnUpdate()
+{
+	BlockPtr inlet = d_pFlowsheet->GetBlock(d_InletID);
+	*inlet->GetFlowData(0) = *d_Ports.GetFlowData(0);
+	if(d_uiMultiplicity > 1)
+		inlet->GetFlowData(0)->ScaleFlow(1.0f / d_uiMultiplicity);
+
+	// The report blocks wait for UpdateReports
+	d_bConverged = d_pFlowsheet->Solve(false);
+
+	for(size_t i = 0; i < d_Outlets.size(); i++)
+	{
+		BlockPtr block = d_pFlowsheet->GetBlock(d_Outlets[i].blockID);
+		if(block == NULL)
+			continue;
+
+		C_FlowData* outlet = d_Ports.GetFlowData((PortNo)(i + 1));
+		*outlet = *block->GetFlowData(d_Outlets[i].port);
+		if(d_uiMultiplicity > 1)
+			outlet->ScaleFlow((float)d_uiMultiplicity);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// RoundWater - Public C_SubFlowsheet
+// Description 
+//	Hands the feed's water, as it now stands, to the inlet and rounds
+//	the inner flowsheet's water.  The outlets' water is copied back out
+//	the way OnUpdate copies the outlets.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SubFlowsheet::RoundWater()
+{
+	BlockPtr inlet = d_pFlowsheet->GetBlock(d_InletID);
+	inlet->GetFlowData(0)->d_FluidRate = d_Ports.GetFlowData(0)->d_FluidRate;
+	if(d_uiMultiplicity > 1)
+		inlet->GetFlowData(0)->d_FluidRate *= 1.0f / d_uiMultiplicity;
+	inlet->GetPorts().UpdatePercentSolids();
+
+	d_pFlowsheet->RoundReportedWater();
+
+	for(size_t i = 0; i < d_Outlets.size(); i++)
+	{
+		BlockPtr block = d_pFlowsheet->GetBlock(d_Outlets[i].blockID);
+		if(block == NULL)
+			continue;
+
+		C_FlowData* outlet = d_Ports.GetFlowData((PortNo)(i + 1));
+		outlet->d_FluidRate = block->GetFlowData(d_Outlets[i].port)->d_FluidRate;
+		if(d_uiMultiplicity > 1)
+			outlet->d_FluidRate *= (float)d_uiMultiplicity;
+	}
+	d_Ports.UpdatePercentSolids();
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateReports - Public C_SubFlowsheet
+// Description 
+//	Updates the inner report blocks.  The outer flowsheet calls this
+//	from its own report phase, on one thread, after the water has been
+//	rounded, so they run once per solve on the final flows.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SubFlowsheet::UpdateReports()
+{
+	d_pFlowsheet->UpdateReportBlocks();
+}
+
+
+bool C_SubFlowsheet::ParseName(const std::string& name, BlockID& id, std::string& param)
+{
+	std::string::size_type slash = name.find('/');
+	if(slash == std::string::npos || slash == 0)
+		return false;
+
+	char* end = 0;
+	id = (BlockID)strtoul(name.c_str(), &end, 10);
+	if(end != name.c_str() + slash)
+		return false;
+
+	param = name.substr(slash + 1);
+	return true;
+}
+
+
+bool C_SubFlowsheet::SetParameter(const std::string& name, const float& value)
+{
+	if(name == "Multiplicity")
+	{
+		SetMultiplicity((value > 0.0f) ? (unsigned)(value + 0.5f) : 1);
+		return true;
+	}
+	if(name == "Delta")
+	{
+		d_pFlowsheet->SetDelta(value);
+		return true;
+	}
+	if(name == "MaxIterations")
+	{
+		d_pFlowsheet->SetMaxIterations((value > 0.0f) ? (unsigned)(value + 0.5f) : 0);
+		return true;
+	}
+
+	BlockID id;
+	std::string param;
+	return ParseName(name, id, param) && d_pFlowsheet->SetParameter(id, param, value);
+}
+
+bool C_SubFlowsheet::GetParameter(const std::string& name, float& value) const
+{
+	if(name == "Multiplicity")
+	{
+		value = (float)d_uiMultiplicity;
+		return true;
+	}
+	if(name == "Delta")
+	{
+		value = d_pFlowsheet->d_fDelta;
+		return true;
+	}
+	if(name == "MaxIterations")
+	{
+		value = (float)d_pFlowsheet->d_uiMaxNumberIter;
+		return true;
+	}
+
+	BlockID id;
+	std::string param;
+	return ParseName(name, id, param) && d_pFlowsheet->GetParameter(id, param, value);
+}
+
+void C_SubFlowsheet::GetParameterNames(std::vector<std::string>& names) const
+{
+	names.push_back("Multiplicity");
+	names.push_back("Delta");
+	names.push_back("MaxIterations");
+
+	std::vector<BlockID> ids;
+	std::vector<std::string> blockNames;
+	d_pFlowsheet->GetBlockIDs(ids);
+	for(size_t b = 0; b < ids.size(); b++)
+	{
+		char prefix[16];
+		sprintf(prefix, "%u/", ids[b]);
+
+		blockNames.clear();
+		d_pFlowsheet->GetBlock(ids[b])->GetParameterNames(blockNames);
+		for(size_t i = 0; i < blockNames.size(); i++)
+			names.push_back(prefix + blockNames[i]);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// CloneInto - Public C_SubFlowsheet
+// Description 
+//	Clones the inner flowsheet, which copies its blocks' parameters, and
+//	sets up the same inlet, outlets and multiplicity.
+// 
+// Arguments:	dest - a sub-flowsheet block
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SubFlowsheet::CloneInto(I_FSBlock* dest) const
+{
+	C_SubFlowsheet* sub = static_cast<C_SubFlowsheet*>(dest);
+
+	d_pFlowsheet->Clone(*sub->d_pFlowsheet);
+	sub->d_InletID = d_InletID;
+	sub->d_Outlets = d_Outlets;
+	sub->d_uiMultiplicity = d_uiMultiplicity;
+	sub->d_Ports.Init(sub->d_fspFSParams, (unsigned short)(d_Outlets.size() + 1));
+}
+
+
+//-----------------------------------------------------------------------
+// SetSensitivity - Public C_SubFlowsheet
+// Description 
+//	Gives the inner flowsheet the same number of tangents, seeding the
+//	inner parameters among them.  The other tangents come in through
+//	the feed.
+// 
+// Arguments:	numTangents - the number of parameters
+//				seeds - this block's parameters and their tangent numbers
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SubFlowsheet::SetSensitivity(const unsigned short& numTangents, 
+	const std::vector<std::pair<std::string, unsigned short> >& seeds)
+{
+	I_FSBlock::SetSensitivity(numTangents, seeds);
+
+	// Block 0 is never used, so those tangents seed nothing inside
+	S_ParameterRef none;
+	none.blockID = 0;
+	std::vector<S_ParameterRef> inner(numTangents, none);
+	for(size_t i = 0; i < seeds.size(); i++)
+		ParseName(seeds[i].first, inner[seeds[i].second].blockID, inner[seeds[i].second].name);
+
+	d_pFlowsheet->d_Sensitivities = inner;
+	d_pFlowsheet->d_bScheduleValid = false;
+}
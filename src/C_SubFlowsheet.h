@@ -0,0 +1,108 @@
+//======================================================================
+// C_SubFlowsheet.h 
+// Author: James McCormick
+// Description:
+//	A block that wraps a whole flowsheet, e.g. one circuit of a plant.
+//	The first port is the feed, which goes to the inner flowsheet's
+//	inlet block.
+//	The second port on are the outlets, each a port of an inner block.
+//
+//	Every update solves the inner flowsheet to convergence, starting
+//	from its last solution, so the outer flowsheet only iterates on the
+//	streams between circuits.  The outer flowsheet is not converged
+//	while the inner one is not.  With the outer flowsheet solving in
+//	parallel, sub-flowsheets in the same level are solved on separate
+//	threads.  The inner report blocks are updated with the outer ones,
+//	once the outer flowsheet has been solved.
+//
+//	The inner flowsheet shares the outer one's size distribution and
+//	settings.  Build it through GetFlowsheet, linking from GetInletID,
+//	and add the outlets before linking the block in the outer flowsheet.
+//	Its blocks' parameters are named "<block id>/<parameter>", e.g.
+//	"102/Split".
+//
+//	A plant running several identical circuits side by side, e.g. four
+//	deslime screens off a splitter, is one block with a "Multiplicity".
+//	The inner flowsheet is one of the circuits: it gets its share of the
+//	feed and its outlets are scaled back up, so the circuit is stored
+//	and solved once.
+//======================================================================
+
+#ifndef _SUBFLOWSHEET_
+#define _SUBFLOWSHEET_
+
+#include "C_Flowsheet.h"
+
+class C_SubFlowsheet : public I_FSBlock
+{
+protected:
+
+	// PROTECTED DATA MEMBERS==================================================
+	C_Flowsheet* d_pFlowsheet;
+	BlockID d_InletID;
+	std::vector<S_StreamKey> d_Outlets;
+	bool d_bConverged;			// Did the last inner solve converge
+	unsigned d_uiMultiplicity;	// The number of identical circuits
+
+	// PROTECTED METHODS=======================================================
+	C_SubFlowsheet();
+	C_SubFlowsheet(const C_SubFlowsheet&);
+
+	void UpdateSolids() {}
+	void UpdateWater() {}
+
+	// Splits "<block id>/<parameter>"
+	static bool ParseName(const std::string& name, BlockID& id, std::string& param);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	// Constructor/Destructor
+	C_SubFlowsheet(FSParamsPtr fsp, const BlockID& ID);
+	~C_SubFlowsheet();
+
+	// The inner flowsheet and the block to link its feed from
+	C_Flowsheet& GetFlowsheet() { return *d_pFlowsheet; }
+	BlockID GetInletID() const { return d_InletID; }
+
+	// Makes a port of an inner block an outlet.  Returns the outlet's port.
+	PortNo AddOutlet(const BlockID& id, const PortNo& port);
+	unsigned short GetNumOutlets() const { return (unsigned short)d_Outlets.size(); }
+
+	virtual bool IsConverged() const { return d_bConverged; }
+
+	// The number of identical circuits the block stands for
+	void SetMultiplicity(const unsigned& n) { d_uiMultiplicity = (n == 0) ? 1 : n; }
+	unsigned GetMultiplicity() const { return d_uiMultiplicity; }
+
+	// The size distribution has been updated
+	virtual void OnNewSizeDistribution();
+
+	// Solves the inner flowsheet with the feed and copies out the outlets
+	virtual void OnUpdate();
+
+	// Rounds the inner flowsheet's water and copies the outlets' out
+	virtual void RoundWater();
+
+	// Updates the inner flowsheet's report blocks
+	virtual void UpdateReports();
+
+	// Is called to pass the parameters to the block
+	virtual void OnParameters(BlockParamsPtr) {}
+
+	// Named parameters - "Multiplicity", the inner solve's "Delta" and
+	// "MaxIterations", and the inner blocks' as "<block id>/<parameter>"
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
+
+	// Copies the inner flowsheet, inlet and outlets
+	virtual void CloneInto(I_FSBlock* dest) const;
+
+	// Passes the tangents, and seeds for the inner blocks' parameters, down
+	virtual void SetSensitivity(const unsigned short& numTangents, 
+		const std::vector<std::pair<std::string, unsigned short> >& seeds);
+};
+
+#endif // _SUBFLOWSHEET_
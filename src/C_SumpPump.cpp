@@ -0,0 +1,326 @@
+//======================================================================
+// C_SumpPump.cpp
+// Author: James McCormick
+// Description:
+//	A block that represents the sump and pump.  The sump's contents are
+//	only held during a transient run; otherwise the pump passes its feed
+//	straight on.
+//
+//======================================================================
+
+#include "C_SumpPump.h"
+#include <algorithm>
+#include <cmath>
+
+// A US gallon of water is 1/240 of a short ton
+static const float GALLONS_PER_TON = 240.0f;
+
+
+//-----------------------------------------------------------------------
+// SetParameter - Public C_SumpPump
+// Description
+//	Sets a named parameter.  Setting the level during a run tops up or
+//	draws down the contents to it without changing what they are made of.
+//
+// Arguments:	name - the parameter
+//				value - its value in the report units
+// Returns:		false if the sump does not have the parameter.
+//-----------------------------------------------------------------------
+bool C_SumpPump::SetParameter(const std::string& name, const float& value)
+{
+	if(name == "AddWater")
+		d_AddWater = WaterFromReport(value);
+	else if(name == "Volume")
+		d_fCapacity = d_fspFSParams->d_bMetric ? value : value / GALLONS_PER_TON;
+	else if(name == "PumpRate")
+		d_fPumpRate = WaterFromReport(value);
+	else if(name == "SolidsSG")
+		d_fSolidsSG = (value > 0.0f) ? value : 1.0f;
+	else if(name == "Level")
+	{
+		d_fLevel = value;
+		if(d_pState)
+		{
+			const FlowValue volume = ContentsVolume();
+			const FlowValue wanted = d_fCapacity * value / 100.0f;
+			if(volume > 0.0f)
+			{
+				const FlowValue scale = wanted / volume;
+				for(unsigned i = 0; i < GetNumStates(); i++)
+					d_pState[i] *= scale;
+			}
+			else
+				d_pState[d_Ports.GetFlowData(0)->GetNumFractions()] = wanted;
+		}
+	}
+	else
+		return false;
+
+	return true;
+}
+
+
+bool C_SumpPump::GetParameter(const std::string& name, float& value) const
+{
+	const float toVolume = d_fspFSParams->d_bMetric ? 1.0f : GALLONS_PER_TON;
+
+	if(name == "AddWater")
+		value = WaterToReport(d_AddWater);
+	else if(name == "Volume")
+		value = d_fCapacity * toVolume;
+	else if(name == "PumpRate")
+		value = WaterToReport(d_fPumpRate);
+	else if(name == "SolidsSG")
+		value = d_fSolidsSG;
+	else if(name == "Level")
+		value = (d_pState && d_fCapacity > 0.0f) ? (float)(100.0f * ContentsVolume() / d_fCapacity) : d_fLevel;
+	else if(name == "Spill")
+		value = (float)(d_dSpill * toVolume);
+	else
+		return false;
+
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// ContentsVolume - Protected C_SumpPump
+// Description
+//	The volume of the contents while bound, in the same units as the
+//	capacity.
+//
+// Arguments:	None.
+// Returns:		the volume.
+//-----------------------------------------------------------------------
+FlowValue C_SumpPump::ContentsVolume() const
+{
+	const unsigned short n = d_Ports.GetFlowData(0)->GetNumFractions();
+	FlowValue solids = 0.0f;
+	for(unsigned short i = 0; i < n; i++)
+		solids += d_pState[i];
+
+	return d_pState[n] + solids / d_fSolidsSG;
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateHoldup - Protected C_SumpPump
+// Description
+//	Keeps the feed, with the add water, as the inflow and sets port 0 to
+//	what the pump draws off.  A level controlled pump sends on what
+//	comes in.  An empty sump can only pass on its feed, up to the pump
+//	rate.  Otherwise the pump takes the mixed contents at the pump rate.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SumpPump::UpdateHoldup()
+{
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	d_Inflow = *feed;
+	d_Inflow.d_FluidRate += d_AddWater;
+	feed->d_FluidRate = d_Inflow.d_FluidRate;
+
+	if(d_fPumpRate <= 0.0f)
+		return;
+
+	const FlowValue volume = ContentsVolume();
+	if(volume <= 1e-6f * d_fCapacity)
+	{
+		const FlowValue in = d_Inflow.d_FluidRate + d_Inflow.d_SolidRate / d_fSolidsSG;
+		if(in > d_fPumpRate)
+		{
+			const float share = (float)(d_fPumpRate / in);
+			feed->ScaleFrom(d_Inflow, share);
+			feed->d_FluidRate = d_Inflow.d_FluidRate * share;
+		}
+		return;
+	}
+
+	const FlowValue drawn = d_fPumpRate / volume;
+	const unsigned short n = feed->GetNumFractions();
+	feed->ZeroSolids();
+	for(unsigned short i = 0; i < n; i++)
+	{
+		if(d_pState[i] > 0.0f)
+			(*feed)[i] = d_pState[i] * drawn;
+	}
+	feed->UpdateSolidRate();
+	feed->d_FluidRate = d_pState[n] * drawn;
+
+	if(d_bDensity && feed->HasDensity())
+	{
+		const unsigned short stride = feed->GetDensityStride();
+		const FlowValue* cells = d_pState + n + 1;
+		for(unsigned short i = 0; i < n; i++)
+		{
+			FlowValue* row = feed->GetDensityRow(i);
+			for(unsigned short d = 0; d < stride; d++)
+				row[d] = cells[i * stride + d] * drawn;
+		}
+	}
+}
+
+
+unsigned C_SumpPump::GetNumStates() const
+{
+	if(d_pState)
+		return d_uiNumStates;
+	if(d_fCapacity <= 0.0f)
+		return 0;
+
+	const C_FlowData* feed = d_Ports.GetFlowData(0);
+	const unsigned n = feed->GetNumFractions();
+	return n + 1 + (feed->HasDensity() ? n * feed->GetDensityStride() : 0);
+}
+
+
+//-----------------------------------------------------------------------
+// BindState - Public C_SumpPump
+// Description
+//	Starts or ends a run.  The sump starts at its level, filled with
+//	slurry made up like its feed, or with water if it has none.
+//
+// Arguments:	state - GetNumStates() values for the contents, or null
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SumpPump::BindState(FlowValue* state)
+{
+	d_pState = 0;
+	d_dSpill = 0.0;
+	InvalidateMemo();
+	if(!state)
+		return;
+
+	const C_FlowData* feed = d_Ports.GetFlowData(0);
+	const unsigned short n = feed->GetNumFractions();
+	d_Inflow = *feed;
+	d_uiNumStates = GetNumStates();
+	d_bDensity = feed->HasDensity();
+	d_pState = state;
+
+	const FlowValue wanted = d_fCapacity * d_fLevel / 100.0f;
+	const FlowValue volume = feed->d_FluidRate + feed->d_SolidRate / d_fSolidsSG;
+	const FlowValue scale = (volume > 0.0f) ? wanted / volume : 0.0f;
+
+	for(unsigned short i = 0; i < n; i++)
+		state[i] = (*feed)[i] * scale;
+	state[n] = (volume > 0.0f) ? feed->d_FluidRate * scale : wanted;
+
+	if(d_bDensity)
+	{
+		const unsigned short stride = feed->GetDensityStride();
+		for(unsigned short i = 0; i < n; i++)
+		{
+			const FlowValue* row = feed->GetDensityRow(i);
+			for(unsigned short d = 0; d < stride; d++)
+				state[n + 1 + i * stride + d] = row[d] * scale;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// GetStateRates - Public C_SumpPump
+// Description
+//	What came in on the last update less what the pump drew off.
+//
+// Arguments:	rates - GetNumStates() values to fill, per hour
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SumpPump::GetStateRates(FlowValue* rates) const
+{
+	const C_FlowData* out = d_Ports.GetFlowData(0);
+	const unsigned short n = out->GetNumFractions();
+	const C_FlowData& in = d_Inflow;
+
+	for(unsigned short i = 0; i < n; i++)
+		rates[i] = in[i] - (*out)[i];
+	rates[n] = in.d_FluidRate - out->d_FluidRate;
+
+	if(d_bDensity)
+	{
+		const unsigned short stride = out->GetDensityStride();
+		const bool hasIn = in.HasDensity(), hasOut = out->HasDensity();
+		for(unsigned short i = 0; i < n; i++)
+		{
+			for(unsigned short d = 0; d < stride; d++)
+			{
+				rates[n + 1 + i * stride + d] = (hasIn ? in.GetDensityRow(i)[d] : 0.0f) -
+					(hasOut ? out->GetDensityRow(i)[d] : 0.0f);
+			}
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// GetMaxStep - Public C_SumpPump
+// Description
+//	Limits the step so the level moves by no more than change of the
+//	volume, the solids and the water held by no more than change of
+//	themselves, and the sump does not drain past empty.  The step is
+//	also kept under the time the pump takes to draw off the contents,
+//	past which a step would pump out more than is there.
+//
+// Arguments:	rates - the rates from GetStateRates
+//				change - the fraction the states may move
+// Returns:		the step in hours.
+//-----------------------------------------------------------------------
+double C_SumpPump::GetMaxStep(const FlowValue* rates, const float& change) const
+{
+	const unsigned short n = d_Ports.GetFlowData(0)->GetNumFractions();
+	double solids = 0.0, dSolids = 0.0, moved = 0.0;
+	for(unsigned short i = 0; i < n; i++)
+	{
+		solids += d_pState[i];
+		dSolids += rates[i];
+		moved += fabs(rates[i]);
+	}
+
+	const double dVolume = rates[n] + dSolids / d_fSolidsSG;
+	const double volume = ContentsVolume();
+	double step = 1e30;
+
+	if(dVolume != 0.0)
+		step = change * d_fCapacity / fabs(dVolume);
+	if(dVolume < 0.0 && volume > 0.0)
+		step = std::min(step, volume / -dVolume);
+	if(moved > 0.0 && solids > 0.0)
+		step = std::min(step, change * solids / moved);
+	if(rates[n] != 0.0f && d_pState[n] > 0.0f)
+		step = std::min(step, change * d_pState[n] / fabs(rates[n]));
+	if(d_fPumpRate > 0.0f && volume > 1e-6 * d_fCapacity)
+		step = std::min(step, volume / d_fPumpRate);
+
+	return step;
+}
+
+
+//-----------------------------------------------------------------------
+// ClampState - Public C_SumpPump
+// Description
+//	Takes out anything a step drew below zero, and spills the contents
+//	over the volume evenly.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_SumpPump::ClampState()
+{
+	const unsigned states = GetNumStates();
+	for(unsigned i = 0; i < states; i++)
+	{
+		if(d_pState[i] < 0.0f)
+			d_pState[i] = 0.0f;
+	}
+
+	const FlowValue volume = ContentsVolume();
+	if(volume <= d_fCapacity)
+		return;
+
+	const FlowValue scale = d_fCapacity / volume;
+	for(unsigned i = 0; i < states; i++)
+		d_pState[i] *= scale;
+	d_dSpill += volume - d_fCapacity;
+}
@@ -5,6 +5,13 @@
 //	A block that represents the sump and pump
 //	The Sump pump block will have only one port, the feed.  The block
 //	that gets fed from the pump will refer to the feed.
+//
+//	In a steady solve the pump passes its feed straight on.  Given a
+//	volume and a pump rate, a transient run (see C_Transient) holds the
+//	sump's contents as states: the pump draws PumpRate of slurry off the
+//	mixed contents, the feed tops them up, and anything over the volume
+//	spills.  A pump rate of 0 is level controlled and pumps out what
+//	comes in.
 //======================================================================
 
 #ifndef _SUMPPUMP_
@@ -35,15 +42,60 @@ protected:
 
 	// PROTECTED DATA MEMBERS==================================================
 
+	// The volume of the sump and the pump rate, held as water in the
+	// flows' mass units, 0 for none.  The solids take up 1 / d_fSolidsSG
+	// of their mass.
+	float d_fCapacity;
+	float d_fPumpRate;
+	float d_fSolidsSG;
+
+	// The level, as a percent of the volume, to start a run at
+	float d_fLevel;
+
+	// What has spilled over the top since the state was bound
+	double d_dSpill;
+
+	// The contents while bound for a run - the solids in each size
+	// fraction, the water, then the density rows if the feed carries the
+	// washability - and what came in on the last update
+	FlowValue* d_pState;
+	unsigned d_uiNumStates;
+	bool d_bDensity;
+	C_FlowData d_Inflow;
+
 
 	// PROTECTED METHODS=======================================================
 
+	// The volume of the contents, as water
+	FlowValue ContentsVolume() const;
+
+	// Sets the pump's output from the contents while bound for a run
+	void UpdateHoldup();
+
 	virtual void UpdateWater()
 	{
-		d_Ports.GetFlowData(0)->d_FluidRate += d_AddWater;
+		if(d_pState)
+			return;
+
+		C_FlowData* feed = d_Ports.GetFlowData(0);
+		feed->d_FluidRate += d_AddWater;
+
+		const float* seed = GetSeed("AddWater");
+		if(seed)
+		{
+			for(unsigned short k = 0; k < d_usNumTangents; k++)
+				feed->FluidTangent(k) += seed[k];
+		}
 	}
 
-	virtual void UpdateSolids() {}
+	virtual void UpdateSolids()
+	{
+		if(d_pState)
+			UpdateHoldup();
+	}
+
+	// The pump only adds to its feed, so its one port already balances
+	virtual int WaterBalancePort() const { return 0; }
 
 public:
 
@@ -52,7 +104,8 @@ public:
 	// PUBLIC METHODS==========================================================
 
 	// Constructor
-	C_SumpPump(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID) 
+	C_SumpPump(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID), d_fCapacity(0.0f), d_fPumpRate(0.0f),
+		d_fSolidsSG(1.5f), d_fLevel(50.0f), d_dSpill(0.0), d_pState(0), d_uiNumStates(0), d_bDensity(false)
 	{
 		d_ProccessID = PROCID_SUMPPUMP;
 		d_Ports.Init(fsp, 1); 
@@ -62,6 +115,7 @@ public:
 	virtual void OnNewSizeDistribution()
 	{
 		d_Ports.Reset();
+		d_pState = 0;
 	}
 
 	// Called by the flowsheet to have the block update itself.
@@ -78,8 +132,33 @@ public:
 
 		C_SumpPumpParams* castParams = static_cast<C_SumpPumpParams*>((I_FSBlockParameters*)p);
 
-		d_AddWater = castParams->d_fAddWater;
+		d_AddWater = WaterFromReport(castParams->d_fAddWater);
+	}
+
+	// Named parameters - "AddWater", "Volume" (m3 or US gallons),
+	// "PumpRate" (m3/h or US gpm of slurry), "SolidsSG" and "Level" (% of
+	// the volume, the level now during a run).  "Spill", read only, is
+	// what has spilled during the run in the same units as the volume.
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+
+	virtual void GetParameterNames(std::vector<std::string>& names) const
+	{
+		names.push_back("AddWater");
+		names.push_back("Volume");
+		names.push_back("PumpRate");
+		names.push_back("SolidsSG");
+		names.push_back("Level");
 	}
+
+	// The contents while a transient run is going - the solids in each size
+	// fraction, the water, and the density rows if the feed carries them.
+	// None if the sump has no volume.
+	virtual unsigned GetNumStates() const;
+	virtual void BindState(FlowValue* state);
+	virtual void GetStateRates(FlowValue* rates) const;
+	virtual double GetMaxStep(const FlowValue* rates, const float& change) const;
+	virtual void ClampState();
 };
 
-#endif // _SUMPPUMP_
\ No newline at end of file
+#endif // _SUMPPUMP_
@@ -0,0 +1,148 @@
+//======================================================================
+// C_ThreadPool.cpp
+// Author: James McCormick
+// Description:
+//	A small pool of worker threads used by the flowsheet to update
+//	independent blocks at the same time.
+//======================================================================
+
+#include "C_ThreadPool.h"
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_ThreadPool
+// Description
+//	Starts numThreads - 1 workers, numbered from 1.  The thread calling
+//	ParallelFor is worker 0.
+//
+// Arguments:	numThreads - the total number of threads to use.
+// Returns:		None.
+//-----------------------------------------------------------------------
+C_ThreadPool::C_ThreadPool(unsigned numThreads) : d_pTask(0), d_uiCount(0), d_uiGeneration(0),
+	d_uiNextIndex(0), d_uiBusyWorkers(0), d_bStop(false)
+{
+	for(unsigned i = 1; i < numThreads; i++)
+		d_Workers.push_back(std::thread(&C_ThreadPool::WorkerLoop, this, i));
+}
+
+
+//-----------------------------------------------------------------------
+// Destructor - Public C_ThreadPool
+// Description
+//	Stops and joins the workers.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+C_ThreadPool::~C_ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(d_Mutex);
+		d_bStop = true;
+	}
+	d_cvStart.notify_all();
+
+	for(size_t i = 0; i < d_Workers.size(); i++)
+		d_Workers[i].join();
+}
+
+
+//-----------------------------------------------------------------------
+// Drain - Private C_ThreadPool
+// Description
+//	Claims the next index and runs it until every index has been taken.
+//
+// Arguments:	task - the job, count - the number of indices,
+//				worker - the worker number of the calling thread
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ThreadPool::Drain(I_ParallelTask* task, unsigned count, unsigned worker)
+{
+	unsigned index = d_uiNextIndex.fetch_add(1);
+	while(index < count)
+	{
+		task->RunTask(index, worker);
+		index = d_uiNextIndex.fetch_add(1);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// WorkerLoop - Private C_ThreadPool
+// Description
+//	Waits for a job, helps drain it, and signals when it is finished.
+//
+// Arguments:	worker - the worker number for this thread
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ThreadPool::WorkerLoop(unsigned worker)
+{
+	unsigned seenGeneration = 0;
+
+	for(;;)
+	{
+		I_ParallelTask* task;
+		unsigned count;
+		{
+			std::unique_lock<std::mutex> lock(d_Mutex);
+			while(!d_bStop && d_uiGeneration == seenGeneration)
+				d_cvStart.wait(lock);
+
+			if(d_bStop)
+				return;
+
+			seenGeneration = d_uiGeneration;
+			task = d_pTask;
+			count = d_uiCount;
+		}
+
+		Drain(task, count, worker);
+
+		{
+			std::lock_guard<std::mutex> lock(d_Mutex);
+			if(--d_uiBusyWorkers == 0)
+				d_cvDone.notify_one();
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// ParallelFor - Public C_ThreadPool
+// Description
+//	Runs the task for every index in [0, count).  The calling thread
+//	takes part and the call returns once every index has completed.
+//
+// Arguments:	task - the job to run, count - the number of indices
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_ThreadPool::ParallelFor(I_ParallelTask& task, const unsigned& count)
+{
+	if(count == 0)
+		return;
+
+	// Not worth waking anybody up
+	if(d_Workers.empty() || count == 1)
+	{
+		for(unsigned i = 0; i < count; i++)
+			task.RunTask(i, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(d_Mutex);
+		d_pTask = &task;
+		d_uiCount = count;
+		d_uiNextIndex.store(0);
+		d_uiBusyWorkers = (unsigned)d_Workers.size();
+		d_uiGeneration++;
+	}
+	d_cvStart.notify_all();
+
+	Drain(&task, count, 0);
+
+	// Wait for the workers to finish what they claimed
+	std::unique_lock<std::mutex> lock(d_Mutex);
+	while(d_uiBusyWorkers != 0)
+		d_cvDone.wait(lock);
+}
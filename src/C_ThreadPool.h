@@ -0,0 +1,92 @@
+//======================================================================
+// C_ThreadPool.h
+// Author: James McCormick
+// Description:
+//	A small pool of worker threads used by the flowsheet to update
+//	independent blocks at the same time.  Work is handed out as a
+//	parallel for loop; idle workers keep pulling the next unclaimed
+//	item until the loop is drained, so uneven blocks balance out.
+//======================================================================
+
+#ifndef _THREADPOOL_
+#define _THREADPOOL_
+
+#include "C_SmartPointer.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+//======================================================================
+// I_ParallelTask - Interface
+// The work that is handed to the thread pool.  RunTask is called once
+// for every index in the loop, from any of the worker threads.
+//======================================================================
+class I_ParallelTask
+{
+public:
+	virtual ~I_ParallelTask() {}
+
+	// index - the loop index to run, worker - the thread running it (0 is the caller)
+	virtual void RunTask(const unsigned& index, const unsigned& worker) = 0;
+};
+
+
+class C_ThreadPool : public C_SmartPointerObject
+{
+private:
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	// The worker threads - the calling thread acts as worker 0
+	std::vector<std::thread> d_Workers;
+
+	// Guards the job hand off between the caller and the workers
+	std::mutex d_Mutex;
+	std::condition_variable d_cvStart;
+	std::condition_variable d_cvDone;
+
+	// The current job
+	I_ParallelTask* d_pTask;
+	unsigned d_uiCount;
+
+	// Bumped every time a new job is posted so the workers can tell them apart
+	unsigned d_uiGeneration;
+
+	// The next unclaimed index and the number of workers still busy
+	std::atomic<unsigned> d_uiNextIndex;
+	unsigned d_uiBusyWorkers;
+
+	// Tells the workers to exit
+	bool d_bStop;
+
+	// PRIVATE METHODS=========================================================
+
+	// The loop each worker thread sits in
+	void WorkerLoop(unsigned worker);
+
+	// Claims and runs indices until the job is drained
+	void Drain(I_ParallelTask* task, unsigned count, unsigned worker);
+
+	C_ThreadPool(const C_ThreadPool&);
+	C_ThreadPool& operator=(const C_ThreadPool&);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	// Constructor/Destructor
+	C_ThreadPool(unsigned numThreads);
+	~C_ThreadPool();
+
+	// The number of threads that work on a job, including the caller
+	unsigned GetNumThreads() const { return (unsigned)d_Workers.size() + 1; }
+
+	// Runs task.RunTask(i) for every i in [0, count) and returns when all are done
+	void ParallelFor(I_ParallelTask& task, const unsigned& count);
+};
+
+typedef C_SmartPointer<C_ThreadPool> ThreadPoolPtr;
+
+#endif // _THREADPOOL_
@@ -0,0 +1,390 @@
+//======================================================================
+// C_Transient.cpp
+// Author: James McCormick
+// Description:
+//	Runs a flowsheet through time with the sumps holding inventories.
+//======================================================================
+
+#include "C_Transient.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using namespace std;
+
+// Times closer than this, in seconds, are the same time
+static const double TIME_EPS = 1e-9;
+
+// Orders the events by time only, so ones at the same time keep their order
+static bool EventBefore(const double& time, const S_TransientEvent& e)
+{
+	return time < e.dTime;
+}
+
+
+//-----------------------------------------------------------------------
+// Constructor - Public C_Transient
+//-----------------------------------------------------------------------
+C_Transient::C_Transient() : d_pFlowsheet(0), d_dTime(0.0), d_bSolved(false), d_bAdaptive(true),
+	d_dStep(10.0), d_dMinStep(1.0), d_dMaxStep(60.0), d_fChange(0.02f), d_NextEvent(0),
+	d_pOut(0), d_dInterval(0.0), d_dNextOutput(0.0), d_pObserver(0),
+	d_ulNumSteps(0), d_ulNumSolves(0), d_ulNumBlockUpdates(0), d_ulNumUnconverged(0)
+{
+}
+
+
+void C_Transient::SetTimeStep(double seconds)
+{
+	d_bAdaptive = false;
+	d_dStep = (seconds > 0.0) ? seconds : 1.0;
+}
+
+
+void C_Transient::SetAdaptive(double minSeconds, double maxSeconds, float change)
+{
+	d_bAdaptive = true;
+	d_dMinStep = (minSeconds > 0.0) ? minSeconds : 1e-3;
+	d_dMaxStep = (maxSeconds > d_dMinStep) ? maxSeconds : d_dMinStep;
+	d_fChange = (change > 0.0f) ? change : 0.02f;
+}
+
+
+void C_Transient::AddEvent(const S_TransientEvent& e)
+{
+	vector<S_TransientEvent>::iterator pos = upper_bound(d_Events.begin(), d_Events.end(), e.dTime, EventBefore);
+	if((size_t)(pos - d_Events.begin()) < d_NextEvent)
+		d_NextEvent++;
+	d_Events.insert(pos, e);
+}
+
+
+void C_Transient::AddEvent(double seconds, const BlockID& id, const std::string& name, float value)
+{
+	S_TransientEvent e;
+	e.dTime = seconds;
+	e.blockID = id;
+	e.name = name;
+	e.fValue = value;
+	AddEvent(e);
+}
+
+
+void C_Transient::AddOutput(const BlockID& id, const PortNo& port, unsigned char quantity)
+{
+	S_TransientOutput o;
+	o.stream.blockID = id;
+	o.stream.port = port;
+	o.ucQuantity = quantity;
+	d_Outputs.push_back(o);
+}
+
+
+void C_Transient::AddOutput(const BlockID& id, const std::string& name)
+{
+	S_TransientOutput o;
+	o.stream.blockID = id;
+	o.stream.port = 0;
+	o.ucQuantity = 0;
+	o.name = name;
+	d_Outputs.push_back(o);
+}
+
+
+void C_Transient::SetOutput(std::ostream* out, double interval)
+{
+	d_pOut = out;
+	d_dInterval = interval;
+	d_dNextOutput = d_dTime;
+}
+
+
+void C_Transient::Clear()
+{
+	d_Events.clear();
+	d_Outputs.clear();
+	d_NextEvent = 0;
+}
+
+
+//-----------------------------------------------------------------------
+// Start - Public C_Transient
+// Description
+//	Solves fs for its steady state and gives every block with states,
+//	that is part of the solve, its place in one state vector.
+//
+// Arguments:	fs - the flowsheet, used until Stop
+// Returns:		true if the run has started.
+//-----------------------------------------------------------------------
+bool C_Transient::Start(C_Flowsheet& fs)
+{
+	Stop();
+
+	if(!fs.d_fspFSParams->d_bUpdateSolids || !fs.d_fspFSParams->d_bUpdateWater)
+		return false;
+
+	d_pFlowsheet = &fs;
+	d_SavedSensitivities = fs.GetSensitivities();
+	if(!d_SavedSensitivities.empty())
+		fs.ClearSensitivities();
+
+	fs.Solve(false);
+
+	const S_GraphAnalysis& analysis = fs.AnalyseGraph();
+	set<BlockID> unreachable(analysis.unreachable.begin(), analysis.unreachable.end());
+
+	vector<BlockID> ids;
+	fs.GetBlockIDs(ids);
+	unsigned numStates = 0;
+	for(size_t i = 0; i < ids.size(); i++)
+	{
+		if(unreachable.count(ids[i]))
+			continue;
+
+		BlockPtr block = fs.GetBlock(ids[i]);
+		const unsigned n = block->GetNumStates();
+		if(n == 0)
+			continue;
+
+		d_Blocks.push_back(block);
+		d_Offsets.push_back(numStates);
+		numStates += n;
+	}
+
+	if(d_Blocks.empty())
+	{
+		Stop();
+		return false;
+	}
+
+	d_State.assign(numStates, 0.0f);
+	d_Rates.assign(numStates, 0.0f);
+	for(size_t b = 0; b < d_Blocks.size(); b++)
+		d_Blocks[b]->BindState(&d_State[d_Offsets[b]]);
+
+	d_dTime = 0.0;
+	d_bSolved = false;
+	d_dNextOutput = 0.0;
+	d_ulNumSteps = d_ulNumSolves = d_ulNumBlockUpdates = d_ulNumUnconverged = 0;
+
+	d_NextEvent = 0;
+	while(d_NextEvent < d_Events.size() && d_Events[d_NextEvent].dTime < -TIME_EPS)
+		d_NextEvent++;
+
+	WriteHeader();
+	return true;
+}
+
+
+//-----------------------------------------------------------------------
+// Advance - Public C_Transient
+// Description
+//	Steps on to seconds from now.  At each time the events due are
+//	applied, the flows solved and the output written if it is due;
+//	then the states move on by their rates over the next step, which
+//	stops short at the next event, output or the end.
+//
+// Arguments:	seconds - how long to run for
+// Returns:		true if every step converged.
+//-----------------------------------------------------------------------
+bool C_Transient::Advance(double seconds)
+{
+	if(!d_pFlowsheet)
+		return false;
+
+	const double end = d_dTime + seconds;
+	const unsigned long unconverged = d_ulNumUnconverged;
+
+	for(;;)
+	{
+		if(ApplyEvents() || !d_bSolved)
+			SolveStep();
+
+		if(d_dInterval > 0.0 && d_dTime >= d_dNextOutput - TIME_EPS)
+		{
+			WriteRow();
+			if(d_pObserver)
+				d_pObserver->OnOutput(*this, d_dTime);
+			d_dNextOutput = d_dInterval * (floor(d_dTime / d_dInterval + TIME_EPS) + 1.0);
+		}
+
+		if(d_dTime >= end - TIME_EPS)
+			break;
+
+		for(size_t b = 0; b < d_Blocks.size(); b++)
+			d_Blocks[b]->GetStateRates(&d_Rates[d_Offsets[b]]);
+
+		const double step = NextStep(end);
+		const FlowValue hours = (FlowValue)(step / 3600.0);
+		for(size_t i = 0; i < d_State.size(); i++)
+			d_State[i] += hours * d_Rates[i];
+
+		for(size_t b = 0; b < d_Blocks.size(); b++)
+			d_Blocks[b]->ClampState();
+
+		d_dTime += step;
+		d_bSolved = false;
+		d_ulNumSteps++;
+	}
+
+	return d_ulNumUnconverged == unconverged;
+}
+
+
+//-----------------------------------------------------------------------
+// Stop - Public C_Transient
+// Description
+//	Unbinds the blocks and turns the sensitivities back on.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Transient::Stop()
+{
+	if(!d_pFlowsheet)
+		return;
+
+	for(size_t b = 0; b < d_Blocks.size(); b++)
+		d_Blocks[b]->BindState(0);
+
+	if(!d_SavedSensitivities.empty())
+		d_pFlowsheet->SetSensitivities(d_SavedSensitivities);
+
+	d_Blocks.clear();
+	d_Offsets.clear();
+	d_State.clear();
+	d_Rates.clear();
+	d_SavedSensitivities.clear();
+	d_pFlowsheet = 0;
+}
+
+
+bool C_Transient::ApplyEvents()
+{
+	bool applied = false;
+	while(d_NextEvent < d_Events.size() && d_Events[d_NextEvent].dTime <= d_dTime + TIME_EPS)
+	{
+		const S_TransientEvent& e = d_Events[d_NextEvent++];
+		d_pFlowsheet->SetParameter(e.blockID, e.name, e.fValue);
+		applied = true;
+	}
+	return applied;
+}
+
+
+//-----------------------------------------------------------------------
+// SolveStep - Private C_Transient
+// Description
+//	Solves the flows for the states as they stand.  The blocks with
+//	states are told their last update is stale, as their feed has not
+//	changed but what they send on has; the rest skip the update unless
+//	their feed has moved.  The water is not rounded and the report
+//	blocks are not run.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Transient::SolveStep()
+{
+	for(size_t b = 0; b < d_Blocks.size(); b++)
+		d_Blocks[b]->InvalidateMemo();
+
+	if(!d_pFlowsheet->Solve(false))
+		d_ulNumUnconverged++;
+
+	d_ulNumSolves++;
+	d_ulNumBlockUpdates += d_pFlowsheet->GetNumBlockUpdates();
+	d_bSolved = true;
+}
+
+
+//-----------------------------------------------------------------------
+// NextStep - Private C_Transient
+// Description
+//	The fixed step, or the longest every block allows kept between the
+//	limits, cut short to land on the next event, output or the end.
+//
+// Arguments:	end - the time the run stops
+// Returns:		the step in seconds.
+//-----------------------------------------------------------------------
+double C_Transient::NextStep(const double& end)
+{
+	double step = d_dStep;
+	if(d_bAdaptive)
+	{
+		double hours = 1e30;
+		for(size_t b = 0; b < d_Blocks.size(); b++)
+			hours = min(hours, d_Blocks[b]->GetMaxStep(&d_Rates[d_Offsets[b]], d_fChange));
+		step = max(d_dMinStep, min(d_dMaxStep, hours * 3600.0));
+	}
+
+	double limits[3] = { end, 1e300, 1e300 };
+	if(d_NextEvent < d_Events.size())
+		limits[1] = d_Events[d_NextEvent].dTime;
+	if(d_dInterval > 0.0)
+		limits[2] = d_dNextOutput;
+
+	for(int i = 0; i < 3; i++)
+	{
+		const double limit = limits[i] - d_dTime;
+		if(limit > TIME_EPS && limit < step)
+			step = limit;
+	}
+	return step;
+}
+
+
+float C_Transient::GetOutputValue(unsigned i) const
+{
+	const S_TransientOutput& o = d_Outputs[i];
+	float value = 0.0f;
+	if(!o.name.empty())
+	{
+		d_pFlowsheet->GetParameter(o.stream.blockID, o.name, value);
+		return value;
+	}
+
+	BlockPtr block = d_pFlowsheet->GetBlock(o.stream.blockID);
+	if(block == NULL || o.stream.port >= block->GetPorts().GetNumPorts())
+		return 0.0f;
+
+	const C_FlowData* fd = block->GetFlowData(o.stream.port);
+	switch(o.ucQuantity)
+	{
+	case C_Flowsheet::SENS_SOLIDS:		return (float)fd->d_SolidRate;
+	case C_Flowsheet::SENS_WATER:		return (float)fd->GetFluidRate();
+	case C_Flowsheet::SENS_PERSOLIDS:	return (float)fd->d_PerSolids;
+	}
+	return 0.0f;
+}
+
+
+void C_Transient::WriteHeader()
+{
+	static const char* quantityNames[] = { "solids", "water", "persolids" };
+
+	if(!d_pOut || d_dInterval <= 0.0)
+		return;
+
+	*d_pOut << "seconds";
+	for(size_t i = 0; i < d_Outputs.size(); i++)
+	{
+		const S_TransientOutput& o = d_Outputs[i];
+		if(o.name.empty())
+			*d_pOut << "," << o.stream.blockID << "." << o.stream.port << "." << quantityNames[o.ucQuantity % 3];
+		else
+			*d_pOut << "," << o.stream.blockID << "." << o.name;
+	}
+	*d_pOut << "\n";
+}
+
+
+void C_Transient::WriteRow()
+{
+	if(!d_pOut)
+		return;
+
+	*d_pOut << d_dTime;
+	for(unsigned i = 0; i < d_Outputs.size(); i++)
+		*d_pOut << "," << GetOutputValue(i);
+	*d_pOut << "\n";
+}
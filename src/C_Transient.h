@@ -0,0 +1,182 @@
+//======================================================================
+// C_Transient.h
+// Author: James McCormick
+// Description:
+//	Runs a flowsheet through time.  The blocks that hold an inventory -
+//	the sumps with a volume and a pump rate - keep their contents in one
+//	state vector allocated when the run starts.  Each step solves the
+//	flowsheet for the flows the inventories give, on the schedule it
+//	has already compiled and starting from the last step's flows, then
+//	moves every state on by its rate over the step.  The steps are a
+//	fixed length, or as long as the inventories allow without any of
+//	them moving by more than a set fraction.
+//
+//	Parameter changes, such as a feed rate step or a pump tripping, are
+//	events at set times, and the steps land on them.  Chosen stream
+//	values and block parameters are written out at a set interval as
+//	the run goes, and nothing is kept of the steps in between, so a run
+//	of any length takes the same memory.
+//
+//	Sensitivities are turned off for the run and back on at the end.
+//	Sumps in a sub-flowsheet pass their feed straight on.
+//======================================================================
+
+#ifndef _TRANSIENT_
+#define _TRANSIENT_
+
+#include "C_Flowsheet.h"
+#include <string>
+#include <vector>
+#include <ostream>
+
+// A parameter change at a time in the run
+struct S_TransientEvent
+{
+	double dTime;			// Seconds from the start of the run
+	BlockID blockID;
+	std::string name;
+	float fValue;
+};
+
+// A column of the output - a stream value, or a block parameter if name is set
+struct S_TransientOutput
+{
+	S_StreamKey stream;
+	unsigned char ucQuantity;		// C_Flowsheet::SENS_SOLIDS, SENS_WATER or SENS_PERSOLIDS
+	std::string name;				// e.g. "Level", on stream.blockID
+};
+
+class C_Transient;
+
+// Told at every output time, after the row has been written
+class I_TransientObserver
+{
+public:
+	virtual ~I_TransientObserver() {}
+	virtual void OnOutput(const C_Transient& t, const double& time) = 0;
+};
+
+
+class C_Transient
+{
+private:
+
+	// PRIVATE DATA MEMBERS====================================================
+
+	C_Flowsheet* d_pFlowsheet;
+
+	// The blocks with states and where each one's start in the state vector
+	std::vector<BlockPtr> d_Blocks;
+	std::vector<unsigned> d_Offsets;
+	std::vector<FlowValue> d_State;
+	std::vector<FlowValue> d_Rates;
+
+	// The time in seconds, and whether the flows are solved for the state
+	double d_dTime;
+	bool d_bSolved;
+
+	// A fixed step, or the limits on an adaptive one and the fraction of
+	// its range a state may move in a step, all steps in seconds
+	bool d_bAdaptive;
+	double d_dStep;
+	double d_dMinStep;
+	double d_dMaxStep;
+	float d_fChange;
+
+	// The events in time order and the next to apply
+	std::vector<S_TransientEvent> d_Events;
+	size_t d_NextEvent;
+
+	// The output columns, where to write them and how often
+	std::vector<S_TransientOutput> d_Outputs;
+	std::ostream* d_pOut;
+	double d_dInterval;
+	double d_dNextOutput;
+	I_TransientObserver* d_pObserver;
+
+	// The sensitivities turned off for the run
+	std::vector<S_ParameterRef> d_SavedSensitivities;
+
+	// Run totals
+	unsigned long d_ulNumSteps;
+	unsigned long d_ulNumSolves;
+	unsigned long d_ulNumBlockUpdates;
+	unsigned long d_ulNumUnconverged;
+
+	// PRIVATE METHODS=========================================================
+
+	// Applies the events due by now, returns true if there were any
+	bool ApplyEvents();
+
+	// Solves the flowsheet for the states as they are
+	void SolveStep();
+
+	// The length of the next step in seconds, up to end
+	double NextStep(const double& end);
+
+	void WriteHeader();
+	void WriteRow();
+
+	C_Transient(const C_Transient&);
+	C_Transient& operator=(const C_Transient&);
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_Transient();
+	~C_Transient() { Stop(); }
+
+	// A step of fixed length in seconds
+	void SetTimeStep(double seconds);
+
+	// Steps as long as the inventories allow, between minimum and maximum
+	// seconds, with no state moving by more than change of its range.  The
+	// default is 1 to 60 seconds and 2%.
+	void SetAdaptive(double minSeconds, double maxSeconds, float change);
+
+	// Adds a parameter change at seconds from the start of the run.  Events
+	// at the same time are applied in the order they were added.
+	void AddEvent(const S_TransientEvent& e);
+	void AddEvent(double seconds, const BlockID& id, const std::string& name, float value);
+
+	// Adds a column of the output
+	void AddOutput(const S_TransientOutput& o) { d_Outputs.push_back(o); }
+	void AddOutput(const BlockID& id, const PortNo& port, unsigned char quantity);
+	void AddOutput(const BlockID& id, const std::string& name);
+
+	// Writes the output columns as comma separated values, with a header
+	// line, every interval seconds.  Null writes nothing.
+	void SetOutput(std::ostream* out, double interval);
+	void SetObserver(I_TransientObserver* o) { d_pObserver = o; }
+
+	void Clear();
+
+	// Solves fs for its steady state, which is where every block with
+	// states starts from, and binds them.  fs must be updating both the
+	// solids and the water.  Returns false if it is not, or there is no
+	// block with states.
+	bool Start(C_Flowsheet& fs);
+
+	// Runs for seconds more.  Returns true if every step converged.
+	bool Advance(double seconds);
+
+	// Ends the run.  The blocks pass their feeds straight on again and the
+	// flows are left as the last step had them, with the water unrounded.
+	void Stop();
+
+	// The value of output column i right now
+	float GetOutputValue(unsigned i) const;
+	unsigned GetNumOutputs() const { return (unsigned)d_Outputs.size(); }
+
+	// The run so far
+	double GetTime() const { return d_dTime; }
+	unsigned GetNumStates() const { return (unsigned)d_State.size(); }
+	unsigned GetNumStateBlocks() const { return (unsigned)d_Blocks.size(); }
+	unsigned long GetNumSteps() const { return d_ulNumSteps; }
+	unsigned long GetNumSolves() const { return d_ulNumSolves; }
+	unsigned long GetNumBlockUpdates() const { return d_ulNumBlockUpdates; }
+	unsigned long GetNumUnconverged() const { return d_ulNumUnconverged; }
+};
+
+#endif // _TRANSIENT_
@@ -0,0 +1,142 @@
+//======================================================================
+// C_Washability.cpp
+// Author: James McCormick
+// Description:
+//	A washability table - how the coal in each size fraction splits
+//	between density classes.
+//======================================================================
+
+#include "C_Washability.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+bool C_Washability::LoadWashability(const char* fileName)
+{
+	UnloadWashability();
+
+	ifstream file(fileName);
+	if(!file)
+		return false;
+
+	return LoadWashability(file);
+}
+
+
+//-----------------------------------------------------------------------
+// LoadWashability - Public C_Washability
+// Description 
+//	Reads the table from a stream in the file format.
+// 
+// Arguments:	stream - The stream to read from.
+// Returns:		bool - true if successfull, false otherwise.
+//-----------------------------------------------------------------------
+bool C_Washability::LoadWashability(istream& stream)
+{
+	UnloadWashability();
+
+	string buffer;
+	unsigned numDensities = 0, numRows = 0;
+	if(!getline(stream, buffer))
+		return false;
+	istringstream line1(buffer);
+	if(!(line1 >> numDensities >> numRows) || numDensities == 0)
+		return false;
+
+	if(!getline(stream, buffer))
+		return false;
+	istringstream line2(buffer);
+	d_Densities.resize(numDensities);
+	for(unsigned d = 0; d < numDensities; d++)
+	{
+		if(!(line2 >> d_Densities[d]))
+		{
+			UnloadWashability();
+			return false;
+		}
+	}
+
+	while(d_Rows.size() < numRows && getline(stream, buffer))
+	{
+		istringstream line(buffer);
+		S_WashRow row;
+		row.fractions.resize(numDensities);
+		if(!(line >> row.fPassing >> row.fRetained))
+			continue;
+
+		float total = 0.0f;
+		for(unsigned d = 0; d < numDensities; d++)
+		{
+			line >> row.fractions[d];
+			total += row.fractions[d];
+		}
+		for(unsigned d = 0; d < numDensities && total > 0.0f; d++)
+			row.fractions[d] /= total;
+
+		d_Rows.push_back(row);
+	}
+
+	if(d_Rows.empty())
+	{
+		UnloadWashability();
+		return false;
+	}
+
+	return true;
+}
+
+
+void C_Washability::UnloadWashability()
+{
+	d_Densities.clear();
+	d_Rows.clear();
+	d_Grid.clear();
+	d_usNumFractions = 0;
+}
+
+
+//-----------------------------------------------------------------------
+// MapToGrid - Public C_Washability
+// Description 
+//	Gives every size fraction the row that contains its mid size, or
+//	the row closest to it.
+// 
+// Arguments:	sd - the size distribution
+// Returns:		None.
+//-----------------------------------------------------------------------
+void C_Washability::MapToGrid(const C_SizeDistribution& sd)
+{
+	const unsigned numDensities = GetNumDensities();
+	d_usNumFractions = sd.GetNumSizeFractions();
+	d_Grid.assign(d_usNumFractions * numDensities, 0.0f);
+
+	if(d_Rows.empty())
+		return;
+
+	for(unsigned short i = 0; i < d_usNumFractions; i++)
+	{
+		float size = sd.GetFractionSize(i);
+
+		size_t best = 0;
+		float bestDistance = -1.0f;
+		for(size_t r = 0; r < d_Rows.size(); r++)
+		{
+			float distance = 0.0f;
+			if(size > d_Rows[r].fPassing)
+				distance = size - d_Rows[r].fPassing;
+			else if(size < d_Rows[r].fRetained)
+				distance = d_Rows[r].fRetained - size;
+
+			if(bestDistance < 0.0f || distance < bestDistance)
+			{
+				best = r;
+				bestDistance = distance;
+			}
+		}
+
+		for(unsigned d = 0; d < numDensities; d++)
+			d_Grid[i * numDensities + d] = d_Rows[best].fractions[d];
+	}
+}
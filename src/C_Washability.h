@@ -0,0 +1,71 @@
+//======================================================================
+// C_Washability.h 
+// Author: James McCormick
+// Description:
+//	A washability table - how the coal in each size fraction splits
+//	between density classes.  Loaded alongside the size distribution
+//	and mapped onto its fractions.
+//
+//	File format:
+//		<number of density classes> <number of size rows>
+//		<mean relative density of each class>
+//		<passing mm> <retained mm> <wt of each class>	(one line per size row)
+//	The weights can be in any units; each row is scaled to sum to 1.
+//	A size fraction takes the row that contains its mid size, or the
+//	nearest row if none does.
+//======================================================================
+
+#ifndef _WASHABILITY_
+#define _WASHABILITY_
+
+#include "C_SizeDistribution.h"
+#include <istream>
+#include <vector>
+
+class C_Washability
+{
+private:
+
+	// PRIVATE DATA MEMBERS===================================================
+
+	// The table as loaded
+	struct S_WashRow
+	{
+		float fPassing;
+		float fRetained;
+		std::vector<float> fractions;
+	};
+	std::vector<float> d_Densities;
+	std::vector<S_WashRow> d_Rows;
+
+	// The table mapped onto the size distribution - size fractions x classes
+	std::vector<float> d_Grid;
+	unsigned short d_usNumFractions;
+
+public:
+
+	// PUBLIC METHODS==========================================================
+
+	C_Washability() : d_usNumFractions(0) {}
+
+	// Loads the table.  MapToGrid must be called before it is used.
+	bool LoadWashability(const char* fileName);
+	bool LoadWashability(std::istream& stream);
+
+	void UnloadWashability();
+
+	// Maps the table onto the size distribution's fractions
+	void MapToGrid(const C_SizeDistribution& sd);
+
+	// The number of density classes, 0 if no table is loaded
+	unsigned short GetNumDensities() const { return (unsigned short)d_Densities.size(); }
+
+	float GetDensity(const unsigned short& d) const { return d_Densities[d]; }
+
+	// The fraction of size fraction i in each density class, summing to 1
+	const float* GetFractions(const unsigned short& i) const { return &d_Grid[i * d_Densities.size()]; }
+
+	bool IsMapped() const { return !d_Densities.empty() && d_usNumFractions > 0; }
+};
+
+#endif // _WASHABILITY_
@@ -0,0 +1,206 @@
+//======================================================================
+// FlowsheetAPI.cpp
+// Author: James McCormick
+// Description:
+//	The C interface to the solver.  See FlowsheetAPI.h.
+//======================================================================
+
+#include "FlowsheetAPI.h"
+#include "C_Flowsheet.h"
+#include <new>
+#include <cstring>
+
+using namespace std;
+
+struct fs_flowsheet
+{
+	C_Flowsheet flowsheet;
+
+	// The store the last view points into, held so it can still be read
+	// after the ports move
+	C_SmartPointer<C_PortStore> store;
+	unsigned long generation;
+
+	fs_flowsheet() : generation(0) {}
+};
+
+
+unsigned fs_api_version(void)
+{
+	return FS_API_VERSION;
+}
+
+
+fs_flowsheet* fs_create(int metric)
+{
+	fs_flowsheet* fs = new(nothrow) fs_flowsheet;
+	if(!fs)
+		return 0;
+
+	fs->flowsheet.SetMetric(metric != 0);
+	fs->flowsheet.SetUpdateSolids(true);
+	fs->flowsheet.SetUpdateWater(true);
+	return fs;
+}
+
+
+void fs_destroy(fs_flowsheet* fs)
+{
+	delete fs;
+}
+
+
+int fs_set_options(fs_flowsheet* fs, float delta, unsigned max_iterations, int water_round_to)
+{
+	if(!fs || delta <= 0.0f || max_iterations == 0)
+		return FS_BAD_ARGUMENT;
+
+	fs->flowsheet.SetDelta(delta);
+	fs->flowsheet.SetMaxIterations(max_iterations);
+	fs->flowsheet.SetRoundToWater(water_round_to);
+	return FS_OK;
+}
+
+
+int fs_load_sizes(fs_flowsheet* fs, const char* path)
+{
+	if(!fs || !path)
+		return FS_BAD_ARGUMENT;
+	return fs->flowsheet.LoadSizeDistribution(path) ? FS_OK : FS_FAILED;
+}
+
+
+int fs_load_washability(fs_flowsheet* fs, const char* path)
+{
+	if(!fs || !path)
+		return FS_BAD_ARGUMENT;
+	return fs->flowsheet.LoadWashability(path) ? FS_OK : FS_FAILED;
+}
+
+
+int fs_load_partitions(fs_flowsheet* fs, const char* path)
+{
+	if(!fs || !path)
+		return FS_BAD_ARGUMENT;
+	return fs->flowsheet.LoadPartitionNumbers(path) ? FS_OK : FS_FAILED;
+}
+
+
+int fs_add_block(fs_flowsheet* fs, unsigned short process, unsigned* block)
+{
+	if(!fs || !block)
+		return FS_BAD_ARGUMENT;
+
+	*block = fs->flowsheet.CreateBlock(process);
+	return *block ? FS_OK : FS_NOT_FOUND;
+}
+
+
+int fs_link(fs_flowsheet* fs, unsigned from, unsigned short port, unsigned to)
+{
+	if(!fs)
+		return FS_BAD_ARGUMENT;
+
+	// MakeLink takes the blocks on trust
+	BlockPtr source = fs->flowsheet.GetBlock(from);
+	if(source == NULL || fs->flowsheet.GetBlock(to) == NULL || port >= source->GetPorts().GetNumPorts())
+		return FS_BAD_ARGUMENT;
+
+	fs->flowsheet.MakeLink(from, port, to);
+	return FS_OK;
+}
+
+
+int fs_set_parameters(fs_flowsheet* fs, const fs_parameter* params, size_t count, size_t* num_set)
+{
+	if(!fs || (!params && count))
+		return FS_BAD_ARGUMENT;
+
+	size_t set = 0;
+	for(size_t i = 0; i < count; i++)
+	{
+		if(params[i].name && fs->flowsheet.SetParameter(params[i].block, params[i].name, params[i].value))
+			set++;
+	}
+
+	if(num_set)
+		*num_set = set;
+	return (set == count) ? FS_OK : FS_NOT_FOUND;
+}
+
+
+int fs_get_parameter(fs_flowsheet* fs, unsigned block, const char* name, float* value)
+{
+	if(!fs || !name || !value)
+		return FS_BAD_ARGUMENT;
+	return fs->flowsheet.GetParameter(block, name, *value) ? FS_OK : FS_NOT_FOUND;
+}
+
+
+int fs_solve(fs_flowsheet* fs)
+{
+	if(!fs)
+		return FS_BAD_ARGUMENT;
+
+	// A flowsheet cannot be solved without a size distribution
+	if(!fs->flowsheet.HasSizeDistribution())
+		return FS_FAILED;
+
+	return fs->flowsheet.SolveFlowSheet() ? FS_OK : FS_NOT_CONVERGED;
+}
+
+
+unsigned fs_get_iterations(const fs_flowsheet* fs)
+{
+	return fs ? fs->flowsheet.GetNumIterations() : 0;
+}
+
+
+//-----------------------------------------------------------------------
+// fs_get_results
+// Description
+//	Points the view at the flowsheet's port store, packing the ports
+//	first if they have moved.  Nothing is copied.  Only as much of the
+//	view as the caller's structure has room for is filled in.
+//
+// Arguments:	fs - the flowsheet
+//				results - the view, with its size set
+// Returns:		FS_OK, or FS_BAD_ARGUMENT.
+//-----------------------------------------------------------------------
+int fs_get_results(fs_flowsheet* fs, fs_results* results)
+{
+	if(!fs || !results || results->size < sizeof(results->size))
+		return FS_BAD_ARGUMENT;
+
+	C_SmartPointer<C_PortStore> store = fs->flowsheet.GetPortStore();
+	if(store != fs->store)
+	{
+		fs->store = store;
+		fs->generation++;
+	}
+
+	// The offsets are the same in every port
+	const C_FlowData probe;
+	const char* base = (const char*)&probe;
+
+	fs_results view;
+	memset(&view, 0, sizeof(view));
+	view.size = results->size;
+	view.generation = fs->generation;
+	view.num_streams = store->GetNumPorts();
+	view.block_ids = store->GetBlockIDs();
+	view.ports = store->GetPortNos();
+	view.value_bytes = sizeof(FlowValue);
+	view.flows = (const char*)store->GetFlows();
+	view.flow_stride = sizeof(C_FlowData);
+	view.solids_offset = (const char*)&probe.d_SolidRate - base;
+	view.water_offset = (const char*)&probe.d_FluidRate - base;
+	view.percent_solids_offset = (const char*)&probe.d_PerSolids - base;
+	view.water_scale = fs->flowsheet.GetWaterUnit();
+	view.fractions = (const char*)store->GetFractions();
+	view.fraction_stride = store->GetNumFractions() * sizeof(FlowValue);
+	view.num_fractions = store->GetNumFractions();
+
+	memcpy(results, &view, (results->size < sizeof(view)) ? results->size : sizeof(view));
+	return FS_OK;
+}
@@ -0,0 +1,131 @@
+//======================================================================
+// FlowsheetAPI.h
+// Author: James McCormick
+// Description:
+//	A C interface to the solver for embedding it in another process.
+//	Flowsheets are opaque handles.  Every function returns one of the
+//	FS_* codes unless it says otherwise, and no C++ type crosses it, so
+//	the host can be built with any compiler.
+//
+//	Results are not copied out.  fs_get_results fills in a view of the
+//	flowsheet's port storage: every stream's solids, water and percent
+//	solids at a fixed stride, and its size fractions as one row each.
+//	The view is read-only and borrowed, and its values change with each
+//	solve.  When the blocks, links or size distribution change the ports
+//	move: the old view can still be read, but only a new one from
+//	fs_get_results, with a new generation, follows the solves.
+//
+//	A handle is used from one thread at a time.  Structures are only
+//	ever added to at the end, so a host built against an older header
+//	keeps working.
+//======================================================================
+
+#ifndef _FLOWSHEETAPI_
+#define _FLOWSHEETAPI_
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+	#if defined(FS_BUILD_API)
+		#define FS_API __declspec(dllexport)
+	#else
+		#define FS_API __declspec(dllimport)
+	#endif
+#else
+	#define FS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Goes up when functions or fields are added
+#define FS_API_VERSION 1
+
+enum
+{
+	FS_OK = 0,
+	FS_BAD_ARGUMENT,		// A null handle or pointer, or a block or port that is not there
+	FS_NOT_FOUND,			// A process or parameter that does not exist
+	FS_NOT_CONVERGED,		// The solve ran out of iterations
+	FS_FAILED				// A file that would not load, or no size distribution to solve with
+};
+
+typedef struct fs_flowsheet fs_flowsheet;
+
+// A parameter to set, e.g. "FeedRate" or "CutPoint0"
+typedef struct fs_parameter
+{
+	unsigned block;
+	const char* name;
+	float value;
+} fs_parameter;
+
+// A view of every stream.  Stream i is block_ids[i], port ports[i], in
+// block id then port order.  Its values are value_bytes wide, a float or
+// a double in a double precision build:
+//	solids			flows + i * flow_stride + solids_offset
+//	water			flows + i * flow_stride + water_offset
+//	percent solids	flows + i * flow_stride + percent_solids_offset
+//	fraction j		fractions + i * fraction_stride + j * value_bytes
+// The water is in the solids' mass units; times water_scale it is in
+// m3/h or US gpm.  Percent solids is from 0 to 1.
+typedef struct fs_results
+{
+	size_t size;						// Set to sizeof(fs_results) by the caller
+	unsigned long generation;			// Moves on when the pointers change
+	size_t num_streams;
+	const unsigned* block_ids;
+	const unsigned short* ports;
+	unsigned value_bytes;
+	const char* flows;
+	ptrdiff_t flow_stride;
+	ptrdiff_t solids_offset;
+	ptrdiff_t water_offset;
+	ptrdiff_t percent_solids_offset;
+	double water_scale;
+	const char* fractions;
+	ptrdiff_t fraction_stride;
+	unsigned num_fractions;
+} fs_results;
+
+// The FS_API_VERSION the library was built with
+FS_API unsigned fs_api_version(void);
+
+// Creates an empty flowsheet updating solids and water, in metric or
+// US units.  Returns null if there is no memory.
+FS_API fs_flowsheet* fs_create(int metric);
+FS_API void fs_destroy(fs_flowsheet* fs);
+
+// The convergence delta, iteration limit and water rounding
+FS_API int fs_set_options(fs_flowsheet* fs, float delta, unsigned max_iterations, int water_round_to);
+
+FS_API int fs_load_sizes(fs_flowsheet* fs, const char* path);
+FS_API int fs_load_washability(fs_flowsheet* fs, const char* path);
+FS_API int fs_load_partitions(fs_flowsheet* fs, const char* path);
+
+// Adds a block of one of the PROCID_* processes and gives its id
+FS_API int fs_add_block(fs_flowsheet* fs, unsigned short process, unsigned* block);
+
+// Feeds port of from into to
+FS_API int fs_link(fs_flowsheet* fs, unsigned from, unsigned short port, unsigned to);
+
+// Sets count parameters.  All are tried; num_set, if not null, is given
+// how many were set, and FS_NOT_FOUND is returned if any were not.
+FS_API int fs_set_parameters(fs_flowsheet* fs, const fs_parameter* params, size_t count, size_t* num_set);
+FS_API int fs_get_parameter(fs_flowsheet* fs, unsigned block, const char* name, float* value);
+
+// Solves the flowsheet.  FS_NOT_CONVERGED still leaves the last iteration's results.
+FS_API int fs_solve(fs_flowsheet* fs);
+FS_API unsigned fs_get_iterations(const fs_flowsheet* fs);
+
+// Fills in the view of the streams.  Call it after any change to the
+// blocks, links or size distribution; otherwise the last view shows
+// every solve.  The last view is freed by the next call or fs_destroy.
+FS_API int fs_get_results(fs_flowsheet* fs, fs_results* results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _FLOWSHEETAPI_
@@ -10,8 +10,35 @@
 #include "I_FSBlock.h"
 
 
+//-----------------------------------------------------------------------
+// OnUpdate - Public I_FSBlock
+// Description 
+//	Updates the solids and water.  The update is skipped when port 0 is
+//	exactly what it was for the last one and nothing else has changed,
+//	so the other ports still hold its result.  A block that writes to
+//	port 0 has it put back the way the update left it.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
 void I_FSBlock::OnUpdate()
 {
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	const bool memoize = d_fspFSParams->d_bMemoize;
+
+	if(memoize && d_bMemoValid && d_uiMemoVersion == d_uiParamVersion && 
+		d_uiMemoGrid == d_fspFSParams->d_uiGridVersion && d_uiMemoSettings == MemoSettings() &&
+		feed->SameAs(d_MemoFeed))
+	{
+		if(d_bChangesFeed)
+			*feed = d_MemoResult;
+		d_uiMemoHits++;
+		return;
+	}
+
+	if(memoize)
+		d_MemoFeed = *feed;
+
 	if(d_fspFSParams->d_bUpdateSolids)
 		UpdateSolids();
 	
@@ -20,4 +47,232 @@ void I_FSBlock::OnUpdate()
 		UpdateWater();
 		d_Ports.UpdatePercentSolids();
 	}
+
+	if(memoize)
+	{
+		d_bChangesFeed = !feed->SameAs(d_MemoFeed);
+		if(d_bChangesFeed)
+			d_MemoResult = *feed;
+
+		d_bMemoValid = true;
+		d_uiMemoVersion = d_uiParamVersion;
+		d_uiMemoGrid = d_fspFSParams->d_uiGridVersion;
+		d_uiMemoSettings = MemoSettings();
+		d_uiMemoMisses++;
+	}
+}
+
+
+unsigned I_FSBlock::MemoSettings() const
+{
+	return (d_fspFSParams->d_bUpdateSolids ? 1u : 0u) | (d_fspFSParams->d_bUpdateWater ? 2u : 0u);
+}
+
+
+//-----------------------------------------------------------------------
+// RoundWater - Public I_FSBlock
+// Description 
+//	Rounds the water on the outputs to the flowsheet's water rounding.
+//	The block's water is updated again from port 0, which may have moved
+//	with the rounding upstream, and the balance port takes the feed and
+//	add water less the other outputs.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_FSBlock::RoundWater()
+{
+	const int balance = WaterBalancePort();
+	if(balance < 0)
+		return;
+
+	UpdateWater();
+
+	if(balance > 0)
+	{
+		FluidRate rest = d_Ports.GetFlowData(0)->d_FluidRate + d_AddWater;
+		for(int p = 1; p < d_Ports.GetNumPorts(); p++)
+		{
+			if(p == balance)
+				continue;
+			C_FlowData* fd = d_Ports.GetFlowData(p);
+			fd->RoundWater();
+			rest -= fd->d_FluidRate;
+		}
+		d_Ports.GetFlowData(balance)->d_FluidRate = rest;
+	}
+
+	d_Ports.UpdatePercentSolids();
+}
+
+
+//-----------------------------------------------------------------------
+// SetSensitivity - Public I_FSBlock
+// Description 
+//	Allocates the tangents on the ports and builds the seeds.
+// 
+// Arguments:	numTangents - the number of parameters
+//				seeds - this block's parameters and their tangent numbers
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_FSBlock::SetSensitivity(const unsigned short& numTangents, 
+	const std::vector<std::pair<std::string, unsigned short> >& seeds)
+{
+	d_usNumTangents = numTangents;
+	d_Ports.SetNumTangents(numTangents);
+	InvalidateMemo();
+
+	// The add water is held in the flows' units, so it moves by 1 / unit
+	// for each unit of the parameter
+	d_Seeds.clear();
+	for(size_t i = 0; i < seeds.size(); i++)
+	{
+		std::vector<float>& seed = d_Seeds[seeds[i].first];
+		seed.resize(numTangents, 0.0f);
+		seed[seeds[i].second] = (seeds[i].first == "AddWater") ? WaterFromReport(1.0f) : 1.0f;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// CloneInto - Public I_FSBlock
+// Description 
+//	Copies the named parameters onto dest.
+// 
+// Arguments:	dest - a block of the same type
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_FSBlock::CloneInto(I_FSBlock* dest) const
+{
+	std::vector<std::string> names;
+	float value;
+	GetParameterNames(names);
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		if(GetParameter(names[i], value))
+			dest->SetParameter(names[i], value);
+	}
+}
+
+
+const float* I_FSBlock::GetSeed(const std::string& name) const
+{
+	if(d_Seeds.empty())
+		return 0;
+
+	std::map<std::string, std::vector<float> >::const_iterator it = d_Seeds.find(name);
+	return (it == d_Seeds.end()) ? 0 : &it->second[0];
+}
+
+
+//-----------------------------------------------------------------------
+// ParseIndex - Protected I_FSBlock
+// Description 
+//	Reads the number off the end of a parameter name such as
+//	"CutPoint1".
+// 
+// Arguments:	name - the parameter name, prefix - the part before the number
+//				count - the number of indexed parameters
+// Returns:		The index, or -1 if the name does not match.
+//-----------------------------------------------------------------------
+int I_FSBlock::ParseIndex(const std::string& name, const char* prefix, int count)
+{
+	std::string p(prefix);
+	if(name.size() <= p.size() || name.compare(0, p.size(), p) != 0)
+		return -1;
+
+	int index = 0;
+	for(size_t i = p.size(); i < name.size(); i++)
+	{
+		if(name[i] < '0' || name[i] > '9')
+			return -1;
+		index = index * 10 + (name[i] - '0');
+		if(index >= count)
+			return -1;
+	}
+
+	return index;
+}
+
+
+//-----------------------------------------------------------------------
+// IndexedName - Public I_FSBlock
+// Description 
+//	Builds the name ParseIndex reads.
+// 
+// Arguments:	prefix - the part before the number, index - the number
+// Returns:		The parameter name.
+//-----------------------------------------------------------------------
+std::string I_FSBlock::IndexedName(const char* prefix, int index)
+{
+	char digits[12];
+	int n = 0;
+	do
+	{
+		digits[n++] = (char)('0' + index % 10);
+		index /= 10;
+	} while(index > 0 && n < 11);
+
+	std::string name(prefix);
+	while(n > 0)
+		name += digits[--n];
+	return name;
+}
+
+
+//-----------------------------------------------------------------------
+// GetPartitionNumbers - Protected I_FSBlock
+// Description 
+//	Looks the block's table up on the flowsheet's partition numbers when
+//	the size distribution or tables have changed since the last call.
+// 
+// Arguments:	None.
+// Returns:		One partition number per size fraction, or null.
+//-----------------------------------------------------------------------
+const float* I_FSBlock::GetPartitionNumbers()
+{
+	if(d_uiPartitionGrid != d_fspFSParams->d_uiGridVersion)
+	{
+		d_uiPartitionGrid = d_fspFSParams->d_uiGridVersion;
+		d_fpPartitionNumbers = d_fspFSParams->d_PartitionNumbers ? 
+			d_fspFSParams->d_PartitionNumbers->GetPartition(d_ProccessID, d_fspFSParams->d_sdSizeDistribution) : 0;
+	}
+	return d_fpPartitionNumbers;
+}
+
+
+//-----------------------------------------------------------------------
+// PartitionSolids - Protected I_FSBlock
+// Description 
+//	Splits the feed's solids by a partition number per size fraction.
+// 
+// Arguments:	partition - the fraction of each size going to product
+//				product, rest - the ports to split between
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_FSBlock::PartitionSolids(const float* partition, const PortNo& product, const PortNo& rest)
+{
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	C_FlowData* p = d_Ports.GetFlowData(product);
+	C_FlowData* r = d_Ports.GetFlowData(rest);
+	const unsigned short n = feed->GetNumFractions();
+
+	p->ScaleFrom(*feed, partition);
+	r->SetToDifference(*feed, *p);
+
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+	{
+		const FlowValue* ft = feed->GetTangent(k);
+		FlowValue* pt = p->GetTangent(k);
+		FlowValue* rt = r->GetTangent(k);
+		pt[n] = 0.0f;
+		rt[n] = 0.0f;
+		for(unsigned short i = 0; i < n; i++)
+		{
+			pt[i] = ft[i] * partition[i];
+			rt[i] = ft[i] - pt[i];
+			pt[n] += pt[i];
+			rt[n] += rt[i];
+		}
+	}
 }
@@ -13,6 +13,9 @@
 #include "C_SmartPointer.h"
 #include "C_BlockPorts.h"
 #include "I_FSBlockParameters.h"
+#include <string>
+#include <vector>
+#include <map>
 
 class I_FSBlock : public C_SmartPointerObject
 {
@@ -35,12 +38,65 @@ protected:
 	// The amount of washwater coming in for sprays, washwater, or add water
 	float d_AddWater;	
 
+	// The number of parameters the flowsheet is finding sensitivities for,
+	// and a seed for each of this block's parameters among them - 1 for its
+	// own tangent and 0 for the others
+	unsigned short d_usNumTangents;
+	std::map<std::string, std::vector<float> > d_Seeds;
+
+	// This block's partition numbers on the current grid, looked up again
+	// when the flowsheet's grid version moves on
+	const float* d_fpPartitionNumbers;
+	unsigned d_uiPartitionGrid;
+
+	// The last update, kept so the next can be skipped if port 0 and the
+	// parameters have not changed since.  d_MemoFeed is port 0 before the
+	// update, and d_MemoResult after it for blocks that change their feed.
+	unsigned d_uiParamVersion;
+	unsigned d_uiMemoVersion;
+	unsigned d_uiMemoGrid;
+	unsigned d_uiMemoSettings;
+	bool d_bMemoValid;
+	bool d_bChangesFeed;
+	C_FlowData d_MemoFeed;
+	C_FlowData d_MemoResult;
+	unsigned d_uiMemoHits;
+	unsigned d_uiMemoMisses;
+
 
 	// PROTECTED METHODS=======================================================
 
 	virtual void UpdateWater() = 0;
 	virtual void UpdateSolids() = 0;
 
+	// The seed for a parameter, or null if it is not being differentiated against
+	const float* GetSeed(const std::string& name) const;
+
+	// Water parameters are given in m3/h or US gpm and held in the same
+	// mass units as the flows
+	float WaterFromReport(const float& water) const { return water / d_fspFSParams->d_fWaterUnit; }
+	float WaterToReport(const float& water) const { return water * d_fspFSParams->d_fWaterUnit; }
+
+	// Reads the number off the end of a parameter name such as "CutPoint1".
+	// Returns -1 if name is not prefix followed by a number less than count.
+	static int ParseIndex(const std::string& name, const char* prefix, int count);
+
+	// The partition numbers loaded for this block's process type, one per
+	// size fraction, or null if none are loaded
+	const float* GetPartitionNumbers();
+
+	// Sends partition[i] of each size fraction of port 0 to product and the
+	// rest to rest.  The partition has no sensitivities.
+	void PartitionSolids(const float* partition, const PortNo& product, const PortNo& rest);
+
+	// The flowsheet settings the blocks' results depend on, packed together
+	unsigned MemoSettings() const;
+
+	// The output port that takes up what rounding the others' water moves,
+	// so the block still balances.  0 for a block that only adds to its
+	// feed, -1 for one with no water of its own to round.
+	virtual int WaterBalancePort() const { return -1; }
+
 	// Force the constructor that takes parameters
 	I_FSBlock() { }
 	I_FSBlock(const I_FSBlock &o) { }
@@ -52,12 +108,15 @@ public:
 	// PUBLIC METHODS==========================================================
 
 	// Constructor/Destructor
-	I_FSBlock(FSParamsPtr fsp, const BlockID& ID) : d_fspFSParams(fsp), d_BlockID(ID), d_AddWater(0)
+	I_FSBlock(FSParamsPtr fsp, const BlockID& ID) : d_fspFSParams(fsp), d_BlockID(ID), d_AddWater(0),
+		d_usNumTangents(0), d_fpPartitionNumbers(0), d_uiPartitionGrid(~0u), d_uiParamVersion(0),
+		d_uiMemoVersion(0), d_uiMemoGrid(0), d_uiMemoSettings(0), d_bMemoValid(false), d_bChangesFeed(false),
+		d_uiMemoHits(0), d_uiMemoMisses(0)
 	{}
 
 	virtual ~I_FSBlock() {}
 
-	float GetAddWater() const { return d_AddWater; }
+	float GetAddWater() const { return WaterToReport(d_AddWater); }
 
 	// Get the ID of the block
 	BlockID GetBlockID() const { return d_BlockID; }
@@ -71,15 +130,88 @@ public:
 	// Gets the Ports
 	C_BlockPorts& GetPorts() { return d_Ports; }
 
+	// Report blocks write to the console and must be updated from one thread in order
+	virtual bool IsReportBlock() const { return false; }
+
+	// Feed blocks make their own flow and are updated once before the sweeps
+	virtual bool IsFeedBlock() const { return false; }
+
+	// Blocks that iterate inside their update, such as a sub-flowsheet,
+	// say whether the last one converged.  The flowsheet is not converged
+	// until they are.
+	virtual bool IsConverged() const { return true; }
+
 	// The size distribution has been updated
 	virtual void OnNewSizeDistribution() = 0;
 
 	// Called by the flowsheet to have the block update itself.
 	// The flowsheet will update the flowdata for the block before calling update.
+	// Skips the update if port 0, the parameters and the flowsheet settings
+	// are the same as last time.
 	virtual void OnUpdate();
 
+	// Rounds the water leaving the block for reporting, once the flowsheet
+	// has been solved on unrounded water.  The water is worked out again
+	// from port 0 as it stands, then every output but the balance port is
+	// rounded and the balance port gets the rest.
+	virtual void RoundWater();
+
+	// Updates the report blocks the block holds, such as a sub-flowsheet's,
+	// once the flowsheet has been solved and its water rounded
+	virtual void UpdateReports() {}
+
+	// Forgets the last update.  The flowsheet calls this whenever it changes
+	// a block's parameters or ports, anything else that does must too.
+	void InvalidateMemo() { d_uiParamVersion++; }
+
+	// The number of updates skipped and done since the counts were reset
+	unsigned GetMemoHits() const { return d_uiMemoHits; }
+	unsigned GetMemoMisses() const { return d_uiMemoMisses; }
+	void ResetMemoCounts() { d_uiMemoHits = 0; d_uiMemoMisses = 0; }
+
 	// Is called to pass the parameters to the block
 	virtual void OnParameters(BlockParamsPtr) = 0;
+
+	// Named access to single parameters, e.g. "AddWater" or "CutPoint0".
+	// Both return false if the block does not have the parameter.
+	virtual bool SetParameter(const std::string& name, const float& value) { return false; }
+	virtual bool GetParameter(const std::string& name, float& value) const { return false; }
+
+	// Adds the names of the block's parameters to the list
+	virtual void GetParameterNames(std::vector<std::string>& names) const {}
+
+	// The name of an indexed parameter, e.g. IndexedName("CutPoint", 1)
+	static std::string IndexedName(const char* prefix, int index);
+
+	// Makes dest, a new block of the same type, a copy of this one.  Copies
+	// the named parameters in the order they are listed.
+	virtual void CloneInto(I_FSBlock* dest) const;
+
+	// Turns on sensitivities to numTangents parameters.  seeds holds the
+	// names of this block's parameters among them and the tangent of each.
+	// Zero tangents turns them off.
+	virtual void SetSensitivity(const unsigned short& numTangents,
+		const std::vector<std::pair<std::string, unsigned short> >& seeds);
+
+	// Blocks that hold an inventory, such as a sump, have states for a
+	// transient run to integrate.  The number of states a block has, 0
+	// for one that only passes its flows on.
+	virtual unsigned GetNumStates() const { return 0; }
+
+	// Gives the block its part of the run's state vector.  The block fills
+	// it in from its flows as they stand and works from it until it is
+	// bound to null again.
+	virtual void BindState(FlowValue* state) {}
+
+	// The rate of change of each state per hour, from the last update
+	virtual void GetStateRates(FlowValue* rates) const {}
+
+	// The longest step in hours for which the states move by no more than
+	// change of their range, given their rates
+	virtual double GetMaxStep(const FlowValue* rates, const float& change) const { return 1e30; }
+
+	// Brings the states back within their limits after a step
+	virtual void ClampState() {}
 };
 
 typedef C_SmartPointer<I_FSBlock> BlockPtr;
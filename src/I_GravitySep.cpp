@@ -6,8 +6,305 @@
 //======================================================================
 
 #include "I_GravitySep.h"
+#include <cmath>
+#include <cstdio>
 
-void I_GravitySep::GravitySeperation()
+//-----------------------------------------------------------------------
+// Partition
+// Description
+//	The partition curve - the chance of reporting to refuse - and its
+//	derivatives, at x = density - cut.
+//-----------------------------------------------------------------------
+static void Partition(double x, double ep, unsigned char curve, double& P, double& dPdCut, double& dPdEp)
 {
+	const double ln3 = 1.0986122886681098;
+	const double sqrt2 = 1.4142135623730951;
+	const double invSqrt2Pi = 0.3989422804014327;
 
-}
\ No newline at end of file
+	dPdCut = 0.0;
+	dPdEp = 0.0;
+	if(ep <= 0.0)
+		P = (x >= 0.0) ? 1.0 : 0.0;
+	else if(curve == I_GravitySep::CURVE_ERF)
+	{
+		// Normal with the quartiles at cut -/+ Ep
+		double sigma = ep / 0.6744897501960817;
+		double z = x / sigma;
+		double phi = invSqrt2Pi * exp(-0.5 * z * z);
+		P = 0.5 * (1.0 + erf(z / sqrt2));
+		dPdCut = -phi / sigma;
+		dPdEp = -phi * z / ep;
+	}
+	else
+	{
+		// Logistic with P(cut + Ep) = 0.75
+		double k = ln3 / ep;
+		P = 1.0 / (1.0 + exp(-k * x));
+		dPdCut = -k * P * (1.0 - P);
+		dPdEp = -P * (1.0 - P) * x * ln3 / (ep * ep);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// UpdatePartition - Protected I_GravitySep
+// Description
+//	Works out the clean yield of every size fraction from the partition
+//	curve and the density classes, along with its derivatives for the
+//	sensitivities, and the same for every washability cell if a table is
+//	loaded.  A zero Ep is a perfect separation at the cut density.
+//
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_GravitySep::UpdatePartition()
+{
+	const C_SizeDistribution& sd = d_fspFSParams->d_sdSizeDistribution;
+	const C_Washability& wb = d_fspFSParams->d_wbWashability;
+	const unsigned short numFractions = sd.GetNumSizeFractions();
+
+	d_CleanYield.assign(numFractions, 1.0f);
+	d_YieldByCut.assign(numFractions, 0.0f);
+	d_YieldByEp.assign(numFractions, 0.0f);
+
+	for(unsigned short i = 0; i < numFractions && !d_Densities.empty(); i++)
+	{
+		double size = sd.GetFractionSize(i);
+		double cut = d_fCutDensity + ((size > 0.0) ? d_fCutShift / size : 0.0);
+		double ep = d_fEp + ((size > 0.0) ? d_fEpShift / size : 0.0);
+
+		double yield = 0.0, byCut = 0.0, byEp = 0.0;
+		for(size_t d = 0; d < d_Densities.size(); d++)
+		{
+			// P is the chance of reporting to refuse
+			double P, dPdCut, dPdEp;
+			Partition(d_Densities[d] - cut, ep, d_ucCurve, P, dPdCut, dPdEp);
+
+			yield += d_DensityFractions[d] * (1.0 - P);
+			byCut -= d_DensityFractions[d] * dPdCut;
+			byEp -= d_DensityFractions[d] * dPdEp;
+		}
+
+		d_CleanYield[i] = (float)yield;
+		d_YieldByCut[i] = (float)byCut;
+		d_YieldByEp[i] = (float)byEp;
+	}
+
+	d_CellYield.clear();
+	d_CellByCut.clear();
+	d_CellByEp.clear();
+	if(wb.IsMapped())
+	{
+		const unsigned short numDensities = wb.GetNumDensities();
+		const unsigned short stride = C_FlowData::DensityStride(numDensities);
+		d_CellYield.assign(numFractions * stride, 0.0f);
+		d_CellByCut.assign(numFractions * stride, 0.0f);
+		d_CellByEp.assign(numFractions * stride, 0.0f);
+
+		for(unsigned short i = 0; i < numFractions; i++)
+		{
+			double size = sd.GetFractionSize(i);
+			double cut = d_fCutDensity + ((size > 0.0) ? d_fCutShift / size : 0.0);
+			double ep = d_fEp + ((size > 0.0) ? d_fEpShift / size : 0.0);
+
+			for(unsigned short d = 0; d < numDensities; d++)
+			{
+				double P, dPdCut, dPdEp;
+				Partition(wb.GetDensity(d) - cut, ep, d_ucCurve, P, dPdCut, dPdEp);
+				d_CellYield[i * stride + d] = (float)(1.0 - P);
+				d_CellByCut[i * stride + d] = (float)-dPdCut;
+				d_CellByEp[i * stride + d] = (float)-dPdEp;
+			}
+		}
+	}
+
+	d_bPartitionValid = true;
+}
+
+
+//-----------------------------------------------------------------------
+// GravitySeperation - Protected I_GravitySep
+// Description
+//	Splits each size fraction of the feed by its clean yield, or each
+//	density cell if the feed carries them.  With density cells the
+//	sensitivities assume the split of each size fraction between the
+//	classes does not change.
+//
+// Arguments:	clean, refuse - the ports for the floats and sinks
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_GravitySep::GravitySeperation(const PortNo& clean, const PortNo& refuse)
+{
+	if(!d_bPartitionValid)
+		UpdatePartition();
+
+	const C_FlowData* feed = d_Ports.GetFlowData(0);
+	C_FlowData* c = d_Ports.GetFlowData(clean);
+	C_FlowData* r = d_Ports.GetFlowData(refuse);
+	const unsigned short n = feed->GetNumFractions();
+	const bool cells = feed->HasDensity() && !d_CellYield.empty();
+	const float* yield = &d_CleanYield[0];
+
+	if(cells)
+	{
+		c->ScaleCellsFrom(*feed, &d_CellYield[0]);
+		r->SetToDifference(*feed, *c);
+	}
+	else
+	{
+		if(c->HasDensity()) c->DisableDensity();
+		if(r->HasDensity()) r->DisableDensity();
+
+		for(unsigned short i = 0; i < n; i++)
+		{
+			FlowValue f = (*feed)[i];
+			FlowValue toClean = f * yield[i];
+			(*c)[i] = toClean;
+			(*r)[i] = f - toClean;
+		}
+		c->UpdateSolidRate();
+		r->UpdateSolidRate();
+	}
+
+	d_fYield = (feed->d_SolidRate > 0.0f) ? c->d_SolidRate / feed->d_SolidRate : 0.0f;
+
+	if(d_usNumTangents)
+	{
+		const float* cutSeed = GetSeed("CutDensity");
+		const float* epSeed = GetSeed("Ep");
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
+		{
+			const FlowValue* ft = feed->GetTangent(k);
+			FlowValue* ct = c->GetTangent(k);
+			FlowValue* rt = r->GetTangent(k);
+			float dCut = cutSeed ? cutSeed[k] : 0.0f;
+			float dEp = epSeed ? epSeed[k] : 0.0f;
+
+			ct[n] = 0.0f;
+			rt[n] = 0.0f;
+			for(unsigned short i = 0; i < n; i++)
+			{
+				FlowValue y = yield[i];
+				FlowValue dYield = d_YieldByCut[i] * dCut + d_YieldByEp[i] * dEp;
+				if(cells)
+				{
+					// The mass weighted yield of the row's cells
+					const FlowValue* row = feed->GetDensityRow(i);
+					const unsigned short stride = feed->GetDensityStride();
+					FlowValue dClean = 0.0f;
+					for(unsigned short d = 0; d < stride; d++)
+						dClean += row[d] * (d_CellByCut[i * stride + d] * dCut + d_CellByEp[i * stride + d] * dEp);
+					y = ((*feed)[i] > 0.0f) ? (*c)[i] / (*feed)[i] : 0.0f;
+					dYield = ((*feed)[i] > 0.0f) ? dClean / (*feed)[i] : 0.0f;
+				}
+				ct[i] = ft[i] * y + (*feed)[i] * dYield;
+				rt[i] = ft[i] - ct[i];
+				ct[n] += ct[i];
+				rt[n] += rt[i];
+			}
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetDensityClasses - Public I_GravitySep
+// Description
+//	Sets the feed's density classes.
+//
+// Arguments:	num - the number of classes
+//				densities - the mean relative density of each class
+//				fractions - the mass fraction of each class
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_GravitySep::SetDensityClasses(const unsigned short& num, const float* densities, const float* fractions)
+{
+	d_Densities.assign(densities, densities + num);
+	d_DensityFractions.assign(fractions, fractions + num);
+	d_bPartitionValid = false;
+}
+
+
+//-----------------------------------------------------------------------
+// SetParameter - Public I_GravitySep
+// Description
+//	Sets a named parameter.  Setting "NumDensities" keeps the existing
+//	classes that still fit and zeros any new ones.
+//
+// Arguments:	name - the parameter, value - the new value
+// Returns:		true if the parameter was found.
+//-----------------------------------------------------------------------
+bool I_GravitySep::SetParameter(const std::string& name, const float& value)
+{
+	const int numDensities = (int)d_Densities.size();
+	int index;
+	if(name == "CutDensity")
+		d_fCutDensity = value;
+	else if(name == "Ep")
+		d_fEp = value;
+	else if(name == "CutShift")
+		d_fCutShift = value;
+	else if(name == "EpShift")
+		d_fEpShift = value;
+	else if(name == "Curve")
+		d_ucCurve = (value >= 0.5f) ? CURVE_ERF : CURVE_LOGISTIC;
+	else if(name == "NumDensities")
+	{
+		unsigned num = (value > 0.0f) ? (unsigned)(value + 0.5f) : 0;
+		d_Densities.resize(num, 0.0f);
+		d_DensityFractions.resize(num, 0.0f);
+	}
+	else if((index = ParseIndex(name, "Density", numDensities)) >= 0)
+		d_Densities[index] = value;
+	else if((index = ParseIndex(name, "DensityFraction", numDensities)) >= 0)
+		d_DensityFractions[index] = value;
+	else
+		return false;
+
+	d_bPartitionValid = false;
+	return true;
+}
+
+bool I_GravitySep::GetParameter(const std::string& name, float& value) const
+{
+	const int numDensities = (int)d_Densities.size();
+	int index;
+	if(name == "CutDensity")
+		value = d_fCutDensity;
+	else if(name == "Ep")
+		value = d_fEp;
+	else if(name == "CutShift")
+		value = d_fCutShift;
+	else if(name == "EpShift")
+		value = d_fEpShift;
+	else if(name == "Curve")
+		value = d_ucCurve;
+	else if(name == "NumDensities")
+		value = (float)numDensities;
+	else if((index = ParseIndex(name, "Density", numDensities)) >= 0)
+		value = d_Densities[index];
+	else if((index = ParseIndex(name, "DensityFraction", numDensities)) >= 0)
+		value = d_DensityFractions[index];
+	else
+		return false;
+
+	return true;
+}
+
+// NumDensities comes before the classes so copying the parameters in order works
+void I_GravitySep::GetParameterNames(std::vector<std::string>& names) const
+{
+	names.push_back("CutDensity");
+	names.push_back("Ep");
+	names.push_back("CutShift");
+	names.push_back("EpShift");
+	names.push_back("Curve");
+	names.push_back("NumDensities");
+	for(size_t i = 0; i < d_Densities.size(); i++)
+	{
+		char number[12];
+		sprintf(number, "%u", (unsigned)i);
+		names.push_back(std::string("Density") + number);
+		names.push_back(std::string("DensityFraction") + number);
+	}
+}
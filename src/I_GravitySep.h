@@ -1,8 +1,23 @@
 //======================================================================
-// I_GravitySep.h 
+// I_GravitySep.h
 // Author: James McCormick
 // Description:
 //	Interface for a block that performs a gravity seperation
+//
+//	Each size fraction is split by a partition (Tromp) curve, the
+//	chance of a particle of a given density reporting to refuse.  The
+//	curve is set by the cut density and the Ep, (d75 - d25) / 2, and
+//	either can be shifted for fine sizes by CutShift / size and
+//	EpShift / size.  The feed's density classes are block parameters;
+//	a block without any sends everything to clean.
+//
+//	When a washability table is loaded the feed carries its own density
+//	classes and those are used instead.  The clean yield of every size
+//	and density cell is then worked out and the feed split cell by cell.
+//
+//	The clean yield of every size fraction is worked out once when the
+//	parameters or size distribution change, so an update is one
+//	multiply per fraction, or per cell.
 //======================================================================
 
 #ifndef _GRAVITYSEP_
@@ -12,14 +27,44 @@
 
 class I_GravitySep : public I_FSBlock
 {
+public:
+	// The shape of the partition curve
+	enum { CURVE_LOGISTIC = 0, CURVE_ERF };
+
 protected:
 
 	// PROTECTED DATA MEMBERS==================================================
-	float d_fYield;
+	float d_fYield;				// The clean yield of the last update
 	float d_fEp;
+	float d_fCutDensity;
+	float d_fCutShift;
+	float d_fEpShift;
+	unsigned char d_ucCurve;
+
+	// The feed's density classes - mean relative density and mass fraction
+	std::vector<float> d_Densities;
+	std::vector<float> d_DensityFractions;
+
+	// The clean yield of each size fraction and its derivatives with
+	// respect to the cut density and Ep.  Rebuilt when d_bPartitionValid is false.
+	bool d_bPartitionValid;
+	std::vector<float> d_CleanYield;
+	std::vector<float> d_YieldByCut;
+	std::vector<float> d_YieldByEp;
+
+	// The same for every cell of the washability, laid out like a stream's
+	// density matrix.  Empty without a washability table.
+	std::vector<float> d_CellYield;
+	std::vector<float> d_CellByCut;
+	std::vector<float> d_CellByEp;
 
 	// PROTECTED METHODS=======================================================
-	void GravitySeperation();
+
+	// Rebuilds the clean yields
+	void UpdatePartition();
+
+	// Splits the feed's solids between the clean and refuse ports
+	void GravitySeperation(const PortNo& clean, const PortNo& refuse);
 
 public:
 
@@ -28,12 +73,18 @@ public:
 	// PUBLIC METHODS==========================================================
 
 	// Constructor
-	I_GravitySep(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID), d_fEp(0.0f), d_fYield(0.0f) 
+	I_GravitySep(FSParamsPtr fsp, const BlockID& ID) : I_FSBlock(fsp, ID), d_fYield(0.0f), d_fEp(0.0f),
+		d_fCutDensity(0.0f), d_fCutShift(0.0f), d_fEpShift(0.0f), d_ucCurve(CURVE_LOGISTIC), d_bPartitionValid(false)
 	{}
 
 	~I_GravitySep()
 	{}
 
+	float GetYield() const { return d_fYield; }
+
+	// Sets the feed's density classes
+	void SetDensityClasses(const unsigned short& num, const float* densities, const float* fractions);
+
 	// The size distribution has been updated
 	virtual void OnNewSizeDistribution() = 0;
 
@@ -43,6 +94,12 @@ public:
 
 	// Is called to pass the parameters to the block
 	virtual void OnParameters(BlockParamsPtr) = 0;
+
+	// Named parameters - "CutDensity", "Ep", "CutShift", "EpShift", "Curve",
+	// "NumDensities", "Density<n>" and "DensityFraction<n>"
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
 };
 
 
@@ -20,35 +20,216 @@
 //======================================================================
 
 #include "I_Screen.h"
+#include <cmath>
 
 void I_Screen::ScreenTheFeed(int start)
 {
-	// Get the feed
-	C_FlowData* feed = d_Ports.GetFlowData(0);
-	
-	float pass, retained;
-	short first, last;
-	for(int i = 0; i <= d_NumDecks; i++)
+	UpdateDeckPartition();
+	SplitFeed(&d_DeckPartition[0], start, d_NumDecks + 1);
+}
+
+
+//-----------------------------------------------------------------------
+// UpdateDeckPartition - Protected I_Screen
+// Description 
+//	Works out where each size fraction ends up.  Sharp decks split on
+//	whole size fractions.  Otherwise the feed is passed down from the top
+//	deck, each deck keeping its share of what reaches it.
+// 
+// Arguments:	None.
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_Screen::UpdateDeckPartition()
+{
+	if(d_bPartitionValid && d_uiPartitionGridVersion == d_fspFSParams->d_uiGridVersion)
+		return;
+
+	const C_SizeDistribution& sd = d_fspFSParams->d_sdSizeDistribution;
+	const unsigned short n = sd.GetNumSizeFractions();
+	d_DeckPartition.assign((d_NumDecks + 1) * n, 0.0f);
+
+	bool sharp = true;
+	for(short i = 0; i < d_NumDecks; i++)
+		if(d_DeckSharpness[i] > 0.0f)
+			sharp = false;
+
+	if(sharp)
 	{
-		if(i == 0)
-			retained = 0.0f;
-		else
+		float pass, retained = 0.0f;
+		short first, last;
+		for(int i = 0; i <= d_NumDecks; i++)
+		{
+			pass = (i == d_NumDecks) ? sd.GetTopSize() : d_DeckCutPoints[i];
+			sd.GetRange(pass, retained, first, last);
+			for(int j = first; j <= last; j++)
+				d_DeckPartition[i * n + j] = 1.0f;
 			retained = pass;
+		}
+	}
+	else
+	{
+		for(unsigned short j = 0; j < n; j++)
+		{
+			double x = sd.GetFractionSize(j);
+			double reaching = 1.0;
+			for(int i = d_NumDecks - 1; i >= 0; i--)
+			{
+				double kept;
+				double d = d_DeckCutPoints[i];
+				double a = d_DeckSharpness[i];
+				if(a <= 0.0 || d <= 0.0)
+					kept = (x >= d) ? 1.0 : 0.0;
+				else
+				{
+					// Written with exp(-u) so coarse sizes go to 1 without overflowing
+					double e = exp(-a * x / d);
+					kept = (1.0 - e) / (1.0 + (exp(a) - 2.0) * e);
+				}
+				d_DeckPartition[(i + 1) * n + j] = (float)(reaching * kept);
+				reaching -= reaching * kept;
+			}
+			d_DeckPartition[j] = (float)reaching;
+		}
+	}
+
+	d_uiPartitionGridVersion = d_fspFSParams->d_uiGridVersion;
+	d_bPartitionValid = true;
+}
 
-		if(i == d_NumDecks)
-			pass = d_fspFSParams->d_sdSizeDistribution.GetTopSize();
-		else
-			pass = d_DeckCutPoints[i];
 
-		d_fspFSParams->d_sdSizeDistribution.GetRange(pass, retained, first, last);
+//-----------------------------------------------------------------------
+// SplitFeed - Protected I_Screen
+// Description 
+//	Scales the feed onto each port by its row of factors, tangents and
+//	density classes included.
+// 
+// Arguments:	factors - numPorts rows of one factor per size fraction
+//				firstPort - the port row 0 goes to
+//				numPorts - the number of rows
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_Screen::SplitFeed(const float* factors, int firstPort, int numPorts)
+{
+	C_FlowData* feed = d_Ports.GetFlowData(0);
+	const unsigned short n = feed->GetNumFractions();
 
-		C_FlowData* port = d_Ports.GetFlowData(start + i);			
-		port->Zero();
+	for(int o = 0; o < numPorts; o++)
+	{
+		const float* f = factors + o * n;
+		C_FlowData* port = d_Ports.GetFlowData(firstPort + o);
+		port->ScaleFrom(*feed, f);
 
-		for(int j = first; j <= last; j++)
+		for(unsigned short k = 0; k < d_usNumTangents; k++)
 		{
-			(*port)[j] = (*feed)[j];
-			(*port).d_SolidRate += (*feed)[j];
+			const FlowValue* ft = feed->GetTangent(k);
+			FlowValue* pt = port->GetTangent(k);
+			pt[n] = 0.0f;
+			for(unsigned short j = 0; j < n; j++)
+			{
+				pt[j] = ft[j] * f[j];
+				pt[n] += pt[j];
+			}
 		}
 	}
 }
+
+
+//-----------------------------------------------------------------------
+// UpdateDrainTangents - Protected I_Screen
+// Description 
+//	The drain gets the add water and feed water less what leaves on the
+//	decks, so its sensitivities follow the same balance.
+// 
+// Arguments:	firstDeck - the port of the bottom deck
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_Screen::UpdateDrainTangents(int firstDeck)
+{
+	C_FlowData* drain = d_Ports.GetFlowData(1);
+	for(unsigned short k = 0; k < d_usNumTangents; k++)
+	{
+		FlowValue t = d_Ports.GetFlowData(0)->FluidTangent(k);
+		if(d_AddWaterSeed)
+			t += d_AddWaterSeed[k];
+		for(short i = 0; i < d_NumDecks; i++)
+			t -= d_Ports.GetFlowData(firstDeck + i)->FluidTangent(k);
+		drain->FluidTangent(k) = t;
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetParameter - Public I_Screen
+// Description 
+//	Sets a named parameter.  Cut points are moved onto the nearest size
+//	fraction boundary since the screening only splits on boundaries.
+// 
+// Arguments:	name - the parameter, value - the new value
+// Returns:		true if the parameter was found.
+//-----------------------------------------------------------------------
+bool I_Screen::SetParameter(const std::string& name, const float& value)
+{
+	int deck;
+	if(name == "AddWater")
+		d_AddWater = WaterFromReport(value);
+	else if((deck = ParseIndex(name, "CutPoint", d_NumDecks)) >= 0)
+	{
+		d_DeckCutPoints[deck] = d_fspFSParams->d_sdSizeDistribution.GetNearestBoundary(value);
+		d_bPartitionValid = false;
+	}
+	else if((deck = ParseIndex(name, "DeckSM", d_NumDecks)) >= 0)
+		d_SMPerDeck[deck] = value;
+	else
+		return false;
+
+	return true;
+}
+
+bool I_Screen::GetParameter(const std::string& name, float& value) const
+{
+	int deck;
+	if(name == "AddWater")
+		value = WaterToReport(d_AddWater);
+	else if((deck = ParseIndex(name, "CutPoint", d_NumDecks)) >= 0)
+		value = d_DeckCutPoints[deck];
+	else if((deck = ParseIndex(name, "DeckSM", d_NumDecks)) >= 0)
+		value = d_SMPerDeck[deck];
+	else
+		return false;
+
+	return true;
+}
+
+void I_Screen::GetParameterNames(std::vector<std::string>& names) const
+{
+	names.push_back("AddWater");
+	for(short i = 0; i < d_NumDecks; i++)
+	{
+		char digit[2] = { (char)('0' + i), 0 };
+		names.push_back(std::string("CutPoint") + digit);
+		names.push_back(std::string("DeckSM") + digit);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+// SetSensitivity - Public I_Screen
+// Description 
+//	Sets up the seeds and looks up the ones the updates use.
+// 
+// Arguments:	numTangents - the number of parameters
+//				seeds - this block's parameters and their tangent numbers
+// Returns:		None.
+//-----------------------------------------------------------------------
+void I_Screen::SetSensitivity(const unsigned short& numTangents, 
+	const std::vector<std::pair<std::string, unsigned short> >& seeds)
+{
+	I_FSBlock::SetSensitivity(numTangents, seeds);
+
+	d_AddWaterSeed = GetSeed("AddWater");
+	for(short i = 0; i < d_NumDecks; i++)
+	{
+		char digit[2] = { (char)('0' + i), 0 };
+		d_SMSeeds[i] = GetSeed(std::string("DeckSM") + digit);
+	}
+}
@@ -17,6 +17,14 @@
 //
 // * The d_DeckCutPoint[] starts at 0 with the bottom deck
 // and then goes up
+//
+//	Every screen shares one screening kernel.  The chance of each size
+//	fraction ending up under the bottom deck or on each deck is worked
+//	out when the cut points or size distribution change, and an update
+//	is then one multiply pass per output stream.  A deck with a zero
+//	sharpness cuts exactly on its cut point; otherwise it retains
+//	(exp(a x / d) - 1) / (exp(a x / d) + exp(a) - 2) of size x, where d
+//	is the cut point and a the sharpness.
 //======================================================================
 
 #ifndef _SCREEN_
@@ -31,11 +39,38 @@ protected:
 	// PROTECTED DATA MEMBERS==================================================
 	float *d_DeckCutPoints;
 	float *d_SMPerDeck;
+	float *d_DeckSharpness;
 	short d_NumDecks;
 
+	// The fraction of each size fraction under the bottom deck, row 0, and
+	// on each deck, row 1 + deck.  Rebuilt when d_bPartitionValid is false
+	// or the size distribution changes.
+	bool d_bPartitionValid;
+	unsigned d_uiPartitionGridVersion;
+	std::vector<float> d_DeckPartition;
+
+	// Seeds for the deck surface moistures and add water, null when they
+	// are not being differentiated against
+	std::vector<const float*> d_SMSeeds;
+	const float* d_AddWaterSeed;
+
 	// PROTECTED METHODS=======================================================
+
+	// Puts the undersize on port start and each deck's oversize on the
+	// ports after it
 	void ScreenTheFeed(int start);
 
+	// Rebuilds d_DeckPartition if it is out of date
+	void UpdateDeckPartition();
+
+	// The screening kernel - splits the feed onto numPorts ports from
+	// firstPort, port firstPort + o getting factors[o * fractions + i] of
+	// size fraction i
+	void SplitFeed(const float* factors, int firstPort, int numPorts);
+
+	// The drain's fluid sensitivities from the add water, feed and decks
+	void UpdateDrainTangents(int firstDeck);
+
 public:
 
 	// PUBLIC DATA MEMBERS=====================================================
@@ -43,16 +78,21 @@ public:
 	// PUBLIC METHODS==========================================================
 
 	// Constructor
-	I_Screen(FSParamsPtr fsp, const BlockID& ID, short numDecks) : I_FSBlock(fsp, ID), d_NumDecks(numDecks)
+	I_Screen(FSParamsPtr fsp, const BlockID& ID, short numDecks) : I_FSBlock(fsp, ID), d_NumDecks(numDecks),
+		d_bPartitionValid(false), d_uiPartitionGridVersion(0), d_SMSeeds(numDecks, (const float*)0), d_AddWaterSeed(0)
 	{
 		d_SMPerDeck = new float[numDecks];
 		d_DeckCutPoints = new float[numDecks];
+		d_DeckSharpness = new float[numDecks];
+		for(short i = 0; i < numDecks; i++)
+			d_DeckSharpness[i] = 0.0f;
 	}
 
 	~I_Screen()
 	{
 		delete[] d_SMPerDeck;
 		delete[] d_DeckCutPoints;
+		delete[] d_DeckSharpness;
 	}
 
 	// The size distribution has been updated
@@ -64,6 +104,16 @@ public:
 
 	// Is called to pass the parameters to the block
 	virtual void OnParameters(BlockParamsPtr) = 0;
+
+	// Named parameters - "AddWater", "CutPoint<deck>" and "DeckSM<deck>"
+	virtual bool SetParameter(const std::string& name, const float& value);
+	virtual bool GetParameter(const std::string& name, float& value) const;
+	virtual void GetParameterNames(std::vector<std::string>& names) const;
+
+	// Cut points only move between size fraction boundaries so their sensitivities are zero.
+	// The deck sharpnesses have none either.
+	virtual void SetSensitivity(const unsigned short& numTangents, 
+		const std::vector<std::pair<std::string, unsigned short> >& seeds);
 };
 
 
@@ -18,7 +18,10 @@ enum
 	PROCID_HMC,
 	PROCID_CLASSIFYING,
 	PROCID_PRINTBLOCK,
-	PROCID_SUMPPUMP
+	PROCID_SUMPPUMP,
+	PROCID_SPLITTER,
+	PROCID_INLET,
+	PROCID_SUBFLOWSHEET
 };
 
 
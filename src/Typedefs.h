@@ -12,8 +12,17 @@
 typedef unsigned BlockID;		// The ID of the block
 typedef unsigned short PortNo;		// The port number on a block
 typedef unsigned short ProcessID;	// The type of process the block represents
-typedef float SolidsRate;			// The rate of solids
-typedef float FluidRate;			// The rate of fluids
-typedef float PercentSolids;		// The percent solids
+
+// The type the flows are stored in.  Build with FS_DOUBLE_PRECISION to
+// hold the size fractions, rates and sensitivities in double.
+#ifdef FS_DOUBLE_PRECISION
+typedef double FlowValue;
+#else
+typedef float FlowValue;
+#endif
+
+typedef FlowValue SolidsRate;		// The rate of solids
+typedef FlowValue FluidRate;		// The rate of fluids
+typedef FlowValue PercentSolids;	// The percent solids
 
 #endif // _TYPEDEFS_